@@ -385,9 +385,18 @@ int plcrash_async_strncmp(const char *s1, const char *s2, size_t n) {
 }
 
 /**
- * An intentionally naive async-safe implementation of memcpy(). memcpy() itself is not declared to be async-safe,
+ * @internal
+ * Word type used for the aligned bulk copy in plcrash_async_memcpy(). The may_alias attribute exempts accesses through
+ * this type from strict aliasing, allowing arbitrary buffers to be copied a word at a time.
+ */
+typedef uintptr_t __attribute__((may_alias)) plcrash_async_memcpy_word_t;
+
+/**
+ * A simple async-safe implementation of memcpy(). memcpy() itself is not declared to be async-safe,
  * though in reality, it is.
  *
+ * If @a dest and @a source share the same word alignment, the bulk of the copy is performed a word at a time.
+ *
  * @param dest Destination.
  * @param source Source.
  * @param n Number of bytes to copy.
@@ -396,6 +405,22 @@ void *plcrash_async_memcpy (void *dest, const void *source, size_t n) {
     uint8_t *s = (uint8_t *) source;
     uint8_t *d = (uint8_t *) dest;
 
+    if (((uintptr_t) s & (sizeof(uintptr_t) - 1)) == ((uintptr_t) d & (sizeof(uintptr_t) - 1))) {
+        /* Copy up to the first aligned word */
+        while (n > 0 && ((uintptr_t) s & (sizeof(uintptr_t) - 1)) != 0) {
+            *d++ = *s++;
+            n--;
+        }
+
+        /* Copy aligned words */
+        for (; n >= sizeof(uintptr_t); n -= sizeof(uintptr_t)) {
+            *(plcrash_async_memcpy_word_t *) d = *(const plcrash_async_memcpy_word_t *) s;
+            d += sizeof(uintptr_t);
+            s += sizeof(uintptr_t);
+        }
+    }
+
+    /* Copy any remaining bytes */
     for (size_t count = 0; count < n; count++)
         *d++ = *s++;
 
@@ -457,9 +482,51 @@ ssize_t plcrash_async_writen (int fd, const void *data, size_t len) {
     return written;
 }
 
+/**
+ * Write all bytes referenced by the @a iovcnt entries of @a iov to fd, looping until all bytes are
+ * written or an error occurs. For the local file system, only one call to writev() should be necessary.
+ *
+ * @param fd The target file descriptor.
+ * @param iov The gather list to be written. The entries will be modified to account for partial writes.
+ * @param iovcnt The number of entries in @a iov.
+ *
+ * @return The total number of bytes written, or -1 on error.
+ */
+ssize_t plcrash_async_writevn (int fd, struct iovec *iov, int iovcnt) {
+    ssize_t total = 0;
+    ssize_t written = 0;
+
+    while (iovcnt > 0) {
+        if ((written = writev(fd, iov, iovcnt)) <= 0) {
+            if (errno == EINTR) {
+                // Try again
+                written = 0;
+            } else {
+                return -1;
+            }
+        }
+
+        total += written;
+
+        /* Skip fully written entries, and advance past any partially written entry */
+        while (iovcnt > 0 && (size_t) written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+
+        if (iovcnt > 0) {
+            iov->iov_base = (uint8_t *) iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+
+    return total;
+}
+
 
 /**
- * Initialize the plcrash_async_file_t instance.
+ * Initialize the plcrash_async_file_t instance, using the embedded default output buffer.
  *
  * @param file File structure to initialize.
  * @param output_limit Maximum number of bytes that will be written to disk. Intended as a
@@ -468,12 +535,81 @@ ssize_t plcrash_async_writen (int fd, const void *data, size_t len) {
  * @param fd Open file descriptor.
  */
 void plcrash_async_file_init (plcrash_async_file_t *file, int fd, off_t output_limit) {
+    plcrash_async_file_init_with_buffer(file, fd, output_limit, file->default_buffer, sizeof(file->default_buffer));
+}
+
+/**
+ * Initialize the plcrash_async_file_t instance, using a caller-provided output buffer. Larger buffers
+ * reduce the number of system calls required to write the output.
+ *
+ * @param file File structure to initialize.
+ * @param fd Open file descriptor.
+ * @param output_limit Maximum number of bytes that will be written to disk. Specify 0 to disable any limits.
+ * @param buffer The output buffer to be used. This buffer must remain valid until the file is closed, and
+ * should generally be allocated prior to crash time (eg, via plcrash_async_allocator_alloc()).
+ * @param bufsize The size of @a buffer, in bytes.
+ */
+void plcrash_async_file_init_with_buffer (plcrash_async_file_t *file, int fd, off_t output_limit, void *buffer, size_t bufsize) {
     file->fd = fd;
     file->buflen = 0;
     file->total_bytes = 0;
     file->limit_bytes = output_limit;
+    file->buffer = buffer;
+    file->bufsize = bufsize;
+    file->iovcnt = 0;
+    file->iov_buf_offset = 0;
+    file->write_calls = 0;
+    file->mem = NULL;
+    file->mem_size = 0;
+    file->mem_overflow = false;
+}
+
+/**
+ * Initialize the plcrash_async_file_t instance to write to a fixed-size memory region, rather than
+ * a file descriptor. Any write that would overrun the region will fail, as will all writes that follow it;
+ * flushing and closing the file will then also fail. Otherwise, flushing and closing the file are no-ops.
+ *
+ * @param file File structure to initialize.
+ * @param buffer The target memory region.
+ * @param size The size of @a buffer, in bytes.
+ */
+void plcrash_async_file_init_memory (plcrash_async_file_t *file, void *buffer, size_t size) {
+    plcrash_async_file_init(file, -1, 0);
+    file->mem = buffer;
+    file->mem_size = size;
+}
+
+/**
+ * @internal
+ *
+ * Check and update the output limit for a write of @a len bytes.
+ */
+static bool plcrash_async_file_reserve (plcrash_async_file_t *file, size_t len) {
+    if (file->limit_bytes != 0 && len + file->total_bytes > file->limit_bytes) {
+        return false;
+    } else if (file->limit_bytes != 0) {
+        file->total_bytes += len;
+    }
+
+    return true;
 }
 
+/**
+ * @internal
+ *
+ * Append any buffered bytes not yet referenced by the gather list to the gather list.
+ */
+static void plcrash_async_file_iov_append_buffer (plcrash_async_file_t *file) {
+    if (file->buflen == file->iov_buf_offset)
+        return;
+
+    PLCF_ASSERT(file->iovcnt < PLCRASH_ASYNC_FILE_IOV_MAX);
+    file->iov[file->iovcnt].iov_base = file->buffer + file->iov_buf_offset;
+    file->iov[file->iovcnt].iov_len = file->buflen - file->iov_buf_offset;
+    file->iovcnt++;
+
+    file->iov_buf_offset = file->buflen;
+}
 
 /**
  * Write all bytes from @a data to the file buffer. Returns true on success,
@@ -481,25 +617,30 @@ void plcrash_async_file_init (plcrash_async_file_t *file, int fd, off_t output_l
  */
 bool plcrash_async_file_write (plcrash_async_file_t *file, const void *data, size_t len) {
     /* Check and update output limit */
-    if (file->limit_bytes != 0 && len + file->total_bytes > file->limit_bytes) {
+    if (!plcrash_async_file_reserve(file, len))
         return false;
-    } else if (file->limit_bytes != 0) {
-        file->total_bytes += len;
+
+    /* Memory-backed output is written in place; buflen tracks the current offset. */
+    if (file->mem != NULL) {
+        if (file->mem_overflow || len > file->mem_size - file->buflen) {
+            file->mem_overflow = true;
+            return false;
+        }
+
+        plcrash_async_memcpy(file->mem + file->buflen, data, len);
+        file->buflen += len;
+        return true;
     }
 
     /* Check if the buffer will fill */
-    if (file->buflen + len > sizeof(file->buffer)) {
-        /* Flush the buffer */
-        if (plcrash_async_writen(file->fd, file->buffer, file->buflen) < 0) {
-            PLCF_DEBUG("Error occured writing to crash log: %s", strerror(errno));
+    if (file->buflen + len > file->bufsize) {
+        /* Flush the buffer and any pending gather list entries */
+        if (!plcrash_async_file_flush(file))
             return false;
-        }
-        
-        file->buflen = 0;
     }
     
     /* Check if the new data fits within the buffer, if so, buffer it */
-    if (len + file->buflen <= sizeof(file->buffer)) {
+    if (len + file->buflen <= file->bufsize) {
         plcrash_async_memcpy(file->buffer + file->buflen, data, len);
         file->buflen += len;
         
@@ -507,6 +648,7 @@ bool plcrash_async_file_write (plcrash_async_file_t *file, const void *data, siz
         
     } else {
         /* Won't fit in the buffer, just write it */
+        file->write_calls++;
         if (plcrash_async_writen(file->fd, data, len) < 0) {
             PLCF_DEBUG("Error occured writing to crash log: %s", strerror(errno));
             return false;
@@ -516,22 +658,74 @@ bool plcrash_async_file_write (plcrash_async_file_t *file, const void *data, siz
     } 
 }
 
+/**
+ * Write all bytes from @a data to the file, without copying @a data into the file buffer. Instead, @a data is
+ * referenced from the file's gather list, and written along with any buffered data on the next flush. Small
+ * writes will be copied, as per plcrash_async_file_write().
+ *
+ * @param file The target file.
+ * @param data The data to be written. This data must remain valid and unmodified until the file has been flushed
+ * or closed.
+ * @param len The number of bytes to be written.
+ *
+ * @return Returns true on success, or false if an error occurs.
+ */
+bool plcrash_async_file_write_nocopy (plcrash_async_file_t *file, const void *data, size_t len) {
+    /* Copying is cheaper than referencing small writes, and memory-backed output is always copied */
+    if (file->mem != NULL || len < file->bufsize / 4 || len < 32)
+        return plcrash_async_file_write(file, data, len);
+
+    /* Check and update output limit */
+    if (!plcrash_async_file_reserve(file, len))
+        return false;
+
+    /* Two entries are required for the preceding buffer data and @a data, and one must remain available
+     * for the trailing buffer data when flushing. */
+    if (file->iovcnt + 3 > PLCRASH_ASYNC_FILE_IOV_MAX) {
+        if (!plcrash_async_file_flush(file))
+            return false;
+    }
+
+    plcrash_async_file_iov_append_buffer(file);
+
+    file->iov[file->iovcnt].iov_base = (void *) data;
+    file->iov[file->iovcnt].iov_len = len;
+    file->iovcnt++;
+
+    return true;
+}
+
 
 /**
- * Flush all buffered bytes from the file buffer.
+ * Flush all buffered bytes and pending gather list entries.
  */
 bool plcrash_async_file_flush (plcrash_async_file_t *file) {
+    /* Memory-backed output is written in place; report any failed write */
+    if (file->mem != NULL)
+        return !file->mem_overflow;
+
     /* Anything to do? */
-    if (file->buflen == 0)
+    if (file->buflen == 0 && file->iovcnt == 0)
         return true;
-    
+
     /* Write remaining */
-    if (plcrash_async_writen(file->fd, file->buffer, file->buflen) < 0) {
-        PLCF_DEBUG("Error occured writing to crash log: %s", strerror(errno));
-        return false;
+    file->write_calls++;
+    if (file->iovcnt == 0) {
+        if (plcrash_async_writen(file->fd, file->buffer, file->buflen) < 0) {
+            PLCF_DEBUG("Error occured writing to crash log: %s", strerror(errno));
+            return false;
+        }
+    } else {
+        plcrash_async_file_iov_append_buffer(file);
+        if (plcrash_async_writevn(file->fd, file->iov, file->iovcnt) < 0) {
+            PLCF_DEBUG("Error occured writing to crash log: %s", strerror(errno));
+            return false;
+        }
     }
-    
+
     file->buflen = 0;
+    file->iovcnt = 0;
+    file->iov_buf_offset = 0;
     
     return true;
 }
@@ -545,6 +739,10 @@ bool plcrash_async_file_close (plcrash_async_file_t *file) {
     if (!plcrash_async_file_flush(file))
         return false;
 
+    /* Memory-backed output has no descriptor to close */
+    if (file->mem != NULL)
+        return true;
+
     /* Close the file descriptor */
     if (close(file->fd) != 0) {
         PLCF_DEBUG("Error closing file: %s", strerror(errno));
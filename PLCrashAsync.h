@@ -35,12 +35,14 @@ extern "C" {
 
 #include <stdio.h> // for snprintf
 #include <unistd.h>
+#include <sys/uio.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <assert.h>
 
 #include <TargetConditionals.h>
 #include <mach/mach.h>
+#include <libkern/OSByteOrder.h>
 
 #if TARGET_OS_IPHONE
 
@@ -249,6 +251,50 @@ extern const plcrash_async_byteorder_t plcrash_async_byteorder_direct;
 extern const plcrash_async_byteorder_t *plcrash_async_byteorder_little_endian (void);
 extern const plcrash_async_byteorder_t *plcrash_async_byteorder_big_endian (void);
 
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * Return true if @a byteorder performs byte swapping.
+ *
+ * Hot parsing loops may use this to dispatch once to a byte order specialized implementation, rather than
+ * issuing an indirect plcrash_async_byteorder_t call for every field read. Within such an implementation, the
+ * plcrash_async_swap*_if() functions reduce to either a no-op or an inline byte swap.
+ */
+static inline bool plcrash_async_byteorder_is_swapped (const plcrash_async_byteorder_t *byteorder) {
+    return byteorder == &plcrash_async_byteorder_swapped;
+}
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * Byte swap @a v if @a swapped is true. @sa plcrash_async_byteorder_is_swapped()
+ */
+static inline uint16_t plcrash_async_swap16_if (bool swapped, uint16_t v) {
+    return swapped ? OSSwapInt16(v) : v;
+}
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * Byte swap @a v if @a swapped is true. @sa plcrash_async_byteorder_is_swapped()
+ */
+static inline uint32_t plcrash_async_swap32_if (bool swapped, uint32_t v) {
+    return swapped ? OSSwapInt32(v) : v;
+}
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ *
+ * Byte swap @a v if @a swapped is true. @sa plcrash_async_byteorder_is_swapped()
+ */
+static inline uint64_t plcrash_async_swap64_if (bool swapped, uint64_t v) {
+    return swapped ? OSSwapInt64(v) : v;
+}
+
 
 plcrash_error_t plcrash_async_task_memcpy (mach_port_t task, pl_vm_address_t address, pl_vm_off_t offset, void *dest, pl_vm_size_t len);
 
@@ -269,6 +315,24 @@ void *plcrash_async_memcpy(void *dest, const void *source, size_t n);
 void *plcrash_async_memset(void *dest, uint8_t value, size_t n);
 
 ssize_t plcrash_async_writen (int fd, const void *data, size_t len);
+ssize_t plcrash_async_writevn (int fd, struct iovec *iov, int iovcnt);
+
+/**
+ * @internal
+ * @ingroup plcrash_async_bufio
+ *
+ * Size of the default output buffer embedded in plcrash_async_file_t. Larger buffers may be supplied
+ * via plcrash_async_file_init_with_buffer().
+ */
+#define PLCRASH_ASYNC_FILE_DEFAULT_BUFSIZE 256
+
+/**
+ * @internal
+ * @ingroup plcrash_async_bufio
+ *
+ * Maximum number of pending entries in a plcrash_async_file_t gather list.
+ */
+#define PLCRASH_ASYNC_FILE_IOV_MAX 16
 
 /**
  * @internal
@@ -276,6 +340,10 @@ ssize_t plcrash_async_writen (int fd, const void *data, size_t len);
  *
  * Async-safe buffered file output. This implementation is only intended for use
  * within signal handler execution of crash log output.
+ *
+ * Small writes are copied into the output buffer. Large payloads with a sufficient lifetime may be
+ * written via plcrash_async_file_write_nocopy(), in which case they are referenced from a gather list
+ * and emitted together with the buffered data via a single writev() call.
  */
 typedef struct plcrash_async_file {
     /** Output file descriptor */
@@ -290,13 +358,46 @@ typedef struct plcrash_async_file {
     /** Current length of data in buffer */
     size_t buflen;
 
-    /** Buffered output */
-    char buffer[256];
+    /** Buffered output. Either the embedded @a default_buffer, or a caller-provided buffer. */
+    uint8_t *buffer;
+
+    /** Size of @a buffer, in bytes. */
+    size_t bufsize;
+
+    /** Default output buffer. */
+    uint8_t default_buffer[PLCRASH_ASYNC_FILE_DEFAULT_BUFSIZE];
+
+    /** Pending gather list; entries reference either @a buffer, or caller data written via plcrash_async_file_write_nocopy(). */
+    struct iovec iov[PLCRASH_ASYNC_FILE_IOV_MAX];
+
+    /** Number of pending entries in @a iov. */
+    int iovcnt;
+
+    /** Offset of the first byte within @a buffer that is not yet referenced by @a iov. */
+    size_t iov_buf_offset;
+
+    /** Total number of write(2)/writev(2) calls issued for this file. */
+    size_t write_calls;
+
+    /** If non-NULL, all output is written directly to this fixed-size memory region, and @a fd is unused. */
+    uint8_t *mem;
+
+    /** Size of the @a mem region. Writes that would exceed this size will fail. */
+    size_t mem_size;
+
+    /**
+     * True if a write to the @a mem region has failed. Once set, all subsequent writes will also fail, ensuring that
+     * the region never contains a partially omitted byte stream.
+     */
+    bool mem_overflow;
 } plcrash_async_file_t;
 
 
 void plcrash_async_file_init (plcrash_async_file_t *file, int fd, off_t output_limit);
+void plcrash_async_file_init_with_buffer (plcrash_async_file_t *file, int fd, off_t output_limit, void *buffer, size_t bufsize);
+void plcrash_async_file_init_memory (plcrash_async_file_t *file, void *buffer, size_t size);
 bool plcrash_async_file_write (plcrash_async_file_t *file, const void *data, size_t len);
+bool plcrash_async_file_write_nocopy (plcrash_async_file_t *file, const void *data, size_t len);
 bool plcrash_async_file_flush (plcrash_async_file_t *file);
 bool plcrash_async_file_close (plcrash_async_file_t *file);
     
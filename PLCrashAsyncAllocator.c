@@ -88,7 +88,6 @@ plcrash_error_t plcrash_async_allocator_new (plcrash_async_allocator_t **allocat
     alloc.total_size = round_page(size + sizeof(plcrash_async_allocator_t));
     alloc.usable_size = alloc.total_size;
     alloc.options = options;
-    fprintf(stderr, "allocated: %lu\n", (unsigned long) alloc.usable_size);
 
     /* Adjust total size to account for guard pages */
     if (options & PLCrashAsyncGuardLowPage)
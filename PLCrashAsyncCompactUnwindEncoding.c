@@ -33,6 +33,7 @@
 #include "PLCrashCompatConstants.h"
 
 #include <inttypes.h>
+#include <libkern/OSAtomic.h>
 
 #if PLCRASH_FEATURE_UNWIND_COMPACT
 
@@ -59,10 +60,13 @@
  * of the reader.
  * @param cpu_type The target architecture of the CFE data, encoded as a Mach-O CPU type. Interpreting CFE data is
  * architecture-specific, and Apple has not defined encodings for all supported architectures.
+ * @param page_cache A cache of decoded second-level pages to be used by the reader, or NULL. If non-NULL, this instance
+ * must survive for the lifetime of the reader.
  */
-plcrash_error_t plcrash_async_cfe_reader_init (plcrash_async_cfe_reader_t *reader, plcrash_async_mobject_t *mobj, cpu_type_t cputype) {
+plcrash_error_t plcrash_async_cfe_reader_init (plcrash_async_cfe_reader_t *reader, plcrash_async_mobject_t *mobj, cpu_type_t cputype, plcrash_async_cfe_page_cache_t *page_cache) {
     reader->mobj = mobj;
     reader->cpu_type = cputype;
+    reader->page_cache = page_cache;
 
     /* Determine the expected encoding */
     switch (cputype) {
@@ -142,10 +146,301 @@ plcrash_error_t plcrash_async_cfe_reader_init (plcrash_async_cfe_reader_t *reade
     } \
 } while (0)
 
+/**
+ * Byte order specialized variant of CFE_FUN_BINARY_SEARCH. The search is expanded once for each of the
+ * direct and swapped byte orders, with the branch selected once per search based on @a _byteorder.
+ *
+ * Within CFE_FUN_BINARY_SEARCH_ENTVAL, entry values should be swapped via CFE_SWAP32(), which reduces to either
+ * a no-op or an inline byte swap, rather than an indirect plcrash_async_byteorder_t call per comparison.
+ */
+#define CFE_FUN_BINARY_SEARCH_BYTEORDER(_byteorder, _pc, _table, _count, _result) do { \
+    if (plcrash_async_byteorder_is_swapped(_byteorder)) { \
+        const bool cfe_swapped = true; \
+        CFE_FUN_BINARY_SEARCH(_pc, _table, _count, _result); \
+    } else { \
+        const bool cfe_swapped = false; \
+        CFE_FUN_BINARY_SEARCH(_pc, _table, _count, _result); \
+    } \
+} while (0)
+
+/** Swap @a _v within CFE_FUN_BINARY_SEARCH_BYTEORDER(). */
+#define CFE_SWAP32(_v) plcrash_async_swap32_if(cfe_swapped, (_v))
+
 /* Evaluates to true if the length of @a _ecount * @a sizof(_etype) can not be represented
  * by size_t. */
 #define VERIFY_SIZE_T(_etype, _ecount) (SIZE_MAX / sizeof(_etype) < (size_t) _ecount)
 
+#pragma mark CFE Page Cache
+
+/**
+ * @internal
+ *
+ * Search the decoded second-level @a page for @a pc.
+ *
+ * @param page The page to search.
+ * @param pc The PC value to search for, relative to the target Mach-O image's __TEXT vmaddr.
+ * @param function_base On success, will be populated with the base address of the function.
+ * @param encoding On success, will be populated with the compact frame encoding entry.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_ENOTFOUND if the entry can not be found.
+ */
+static plcrash_error_t plcrash_async_cfe_page_find_pc (const plcrash_async_cfe_page_t *page, pl_vm_address_t pc, pl_vm_address_t *function_base, uint32_t *encoding) {
+    /* The page may be concurrently modified; while the caller will discard the result of a torn read, the search
+     * itself must remain in bounds. */
+    uint32_t count = page->count;
+    if (count == 0 || count > PLCRASH_ASYNC_CFE_PAGE_ENTRY_MAX)
+        return PLCRASH_ENOTFOUND;
+
+    const uint32_t *function_offsets = page->function_offsets;
+    const uint32_t *entry = NULL;
+
+#define CFE_FUN_BINARY_SEARCH_ENTVAL(_tval) (_tval)
+    CFE_FUN_BINARY_SEARCH(pc, function_offsets, count, entry);
+#undef CFE_FUN_BINARY_SEARCH_ENTVAL
+
+    if (entry == NULL) {
+        PLCF_DEBUG("Could not find a second level CFE entry for pc=%" PRIx64, (uint64_t) pc);
+        return PLCRASH_ENOTFOUND;
+    }
+
+    *function_base = *entry;
+    *encoding = page->encodings[entry - function_offsets];
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ *
+ * Look up @a pc in the decoded pages of @a cache. This method is async-safe.
+ *
+ * @param cache The cache to search.
+ * @param section_addr The task-relative address of the unwind info section.
+ * @param pc The PC value to search for, relative to the target Mach-O image's __TEXT vmaddr.
+ * @param result If a page covering @a pc is found, will be set to the result of searching the page.
+ * @param function_base On success, will be populated with the base address of the function.
+ * @param encoding On success, will be populated with the compact frame encoding entry.
+ *
+ * @return Returns true if a page covering @a pc was found, false otherwise.
+ */
+static bool plcrash_async_cfe_page_cache_lookup (plcrash_async_cfe_page_cache_t *cache,
+                                                 pl_vm_address_t section_addr,
+                                                 pl_vm_address_t pc,
+                                                 plcrash_error_t *result,
+                                                 pl_vm_address_t *function_base,
+                                                 uint32_t *encoding)
+{
+    for (size_t i = 0; i < PLCRASH_ASYNC_CFE_PAGE_CACHE_SIZE; i++) {
+        plcrash_async_cfe_page_t *page = &cache->pages[i];
+
+        int32_t sequence = page->sequence;
+        if (sequence & 1)
+            continue;
+        OSMemoryBarrier();
+
+        if (!page->valid || page->section_addr != section_addr || pc < page->function_start || pc >= page->function_end)
+            continue;
+
+        pl_vm_address_t found_base;
+        uint32_t found_encoding;
+        plcrash_error_t err = plcrash_async_cfe_page_find_pc(page, pc, &found_base, &found_encoding);
+
+        /* Verify that the page was not modified while being read */
+        OSMemoryBarrier();
+        if (page->sequence != sequence)
+            return false;
+
+        /* The use counter is only a replacement hint; lost updates from concurrent readers are harmless, and an
+         * atomic increment on every hit would cost more than the lookup itself. */
+        page->last_used = ++cache->clock;
+
+        *result = err;
+        if (err == PLCRASH_ESUCCESS) {
+            *function_base = found_base;
+            *encoding = found_encoding;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @internal
+ *
+ * Claim the least recently used page in @a cache for update. This method is async-safe. The page must be
+ * released via plcrash_async_cfe_page_cache_release().
+ *
+ * @param cache The cache from which a page will be claimed.
+ * @param sequence On success, will be set to the page's sequence number prior to being claimed.
+ *
+ * @return Returns the claimed page, or NULL if the page is concurrently being updated by another thread.
+ */
+static plcrash_async_cfe_page_t *plcrash_async_cfe_page_cache_claim (plcrash_async_cfe_page_cache_t *cache, int32_t *sequence) {
+    plcrash_async_cfe_page_t *victim = &cache->pages[0];
+    for (size_t i = 0; i < PLCRASH_ASYNC_CFE_PAGE_CACHE_SIZE; i++) {
+        plcrash_async_cfe_page_t *page = &cache->pages[i];
+        if (!page->valid) {
+            victim = page;
+            break;
+        }
+
+        if (page->last_used < victim->last_used)
+            victim = page;
+    }
+
+    int32_t current = victim->sequence;
+    if ((current & 1) || !OSAtomicCompareAndSwap32Barrier(current, current + 1, &victim->sequence))
+        return NULL;
+
+    victim->valid = false;
+    *sequence = current;
+    return victim;
+}
+
+/**
+ * @internal
+ *
+ * Release a page previously claimed via plcrash_async_cfe_page_cache_claim(). This method is async-safe.
+ *
+ * @param cache The cache from which @a page was claimed.
+ * @param page The claimed page.
+ * @param sequence The sequence number returned by plcrash_async_cfe_page_cache_claim().
+ * @param valid If true, the page has been populated and will be made visible to readers.
+ */
+static void plcrash_async_cfe_page_cache_release (plcrash_async_cfe_page_cache_t *cache, plcrash_async_cfe_page_t *page, int32_t sequence, bool valid) {
+    page->valid = valid;
+    if (valid)
+        page->last_used = OSAtomicIncrement32Barrier(&cache->clock);
+
+    OSAtomicCompareAndSwap32Barrier(sequence + 1, sequence + 2, &page->sequence);
+}
+
+/**
+ * @internal
+ *
+ * Decode the second-level page referenced by @a first_level_entry into @a page, resolving all entries to their
+ * native-endian function offsets and encodings.
+ *
+ * @param reader The CFE reader.
+ * @param common_enc The mapped common encodings table.
+ * @param common_enc_count The number of entries in @a common_enc.
+ * @param first_level_entry The mapped first-level index entry for the page.
+ * @param page The page to be populated.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success. If the page can not be decoded, or is too large to be cached, an
+ * appropriate error will be returned; in that case, the page should be searched directly.
+ */
+static plcrash_error_t plcrash_async_cfe_page_decode (plcrash_async_cfe_reader_t *reader,
+                                                      const uint32_t *common_enc,
+                                                      uint32_t common_enc_count,
+                                                      const struct unwind_info_section_header_index_entry *first_level_entry,
+                                                      plcrash_async_cfe_page_t *page)
+{
+    const plcrash_async_byteorder_t *byteorder = reader->byteorder;
+    const pl_vm_address_t base_addr = plcrash_async_mobject_base_address(reader->mobj);
+
+    uint32_t second_level_offset = byteorder->swap32(first_level_entry->secondLevelPagesSectionOffset);
+    uint32_t *second_level_kind = plcrash_async_mobject_remap_address(reader->mobj, base_addr, second_level_offset, sizeof(uint32_t));
+    if (second_level_kind == NULL)
+        return PLCRASH_EINVAL;
+
+    switch (byteorder->swap32(*second_level_kind)) {
+        case UNWIND_SECOND_LEVEL_REGULAR: {
+            struct unwind_info_regular_second_level_page_header *header;
+            header = plcrash_async_mobject_remap_address(reader->mobj, base_addr, second_level_offset, sizeof(*header));
+            if (header == NULL)
+                return PLCRASH_EINVAL;
+
+            uint32_t entries_offset = byteorder->swap16(header->entryPageOffset);
+            uint32_t entries_count = byteorder->swap16(header->entryCount);
+            if (entries_count > PLCRASH_ASYNC_CFE_PAGE_ENTRY_MAX)
+                return PLCRASH_ENOTSUP;
+
+            if (!plcrash_async_mobject_verify_local_pointer(reader->mobj, header, entries_offset, entries_count * sizeof(struct unwind_info_regular_second_level_entry)))
+                return PLCRASH_EINVAL;
+
+            struct unwind_info_regular_second_level_entry *entries = (struct unwind_info_regular_second_level_entry *) (((uintptr_t)header) + entries_offset);
+            for (uint32_t i = 0; i < entries_count; i++) {
+                page->function_offsets[i] = byteorder->swap32(entries[i].functionOffset);
+                page->encodings[i] = byteorder->swap32(entries[i].encoding);
+            }
+
+            page->count = entries_count;
+            return PLCRASH_ESUCCESS;
+        }
+
+        case UNWIND_SECOND_LEVEL_COMPRESSED: {
+            struct unwind_info_compressed_second_level_page_header *header;
+            header = plcrash_async_mobject_remap_address(reader->mobj, base_addr, second_level_offset, sizeof(*header));
+            if (header == NULL)
+                return PLCRASH_EINVAL;
+
+            uint32_t base_foffset = byteorder->swap32(first_level_entry->functionOffset);
+
+            uint32_t entries_offset = byteorder->swap16(header->entryPageOffset);
+            uint32_t entries_count = byteorder->swap16(header->entryCount);
+            if (entries_count > PLCRASH_ASYNC_CFE_PAGE_ENTRY_MAX)
+                return PLCRASH_ENOTSUP;
+
+            if (!plcrash_async_mobject_verify_local_pointer(reader->mobj, header, entries_offset, entries_count * sizeof(uint32_t)))
+                return PLCRASH_EINVAL;
+
+            uint32_t encodings_offset = byteorder->swap16(header->encodingsPageOffset);
+            uint32_t encodings_count = byteorder->swap16(header->encodingsCount);
+            if (!plcrash_async_mobject_verify_local_pointer(reader->mobj, header, encodings_offset, encodings_count * sizeof(uint32_t)))
+                return PLCRASH_EINVAL;
+
+            uint32_t *compressed_entries = (uint32_t *) (((uintptr_t)header) + entries_offset);
+            uint32_t *encodings = (uint32_t *) (((uintptr_t)header) + encodings_offset);
+
+            for (uint32_t i = 0; i < entries_count; i++) {
+                uint32_t c_entry = byteorder->swap32(compressed_entries[i]);
+                uint32_t c_encoding_idx = UNWIND_INFO_COMPRESSED_ENTRY_ENCODING_INDEX(c_entry);
+
+                page->function_offsets[i] = base_foffset + UNWIND_INFO_COMPRESSED_ENTRY_FUNC_OFFSET(c_entry);
+
+                if (c_encoding_idx < common_enc_count) {
+                    page->encodings[i] = byteorder->swap32(common_enc[c_encoding_idx]);
+                } else if (c_encoding_idx - common_enc_count < encodings_count) {
+                    page->encodings[i] = byteorder->swap32(encodings[c_encoding_idx - common_enc_count]);
+                } else {
+                    /* Invalid entries are reported by the direct search if they are actually referenced */
+                    return PLCRASH_EINVAL;
+                }
+            }
+
+            page->count = entries_count;
+            return PLCRASH_ESUCCESS;
+        }
+
+        default:
+            return PLCRASH_EINVAL;
+    }
+}
+
+/**
+ * Invalidate all pages in @a cache. This must be called when an image is unloaded, as a new image could later be
+ * loaded at the same address.
+ *
+ * @param cache The cache to invalidate.
+ *
+ * @warning This method is not async-safe.
+ */
+void plcrash_nasync_cfe_page_cache_invalidate (plcrash_async_cfe_page_cache_t *cache) {
+    for (size_t i = 0; i < PLCRASH_ASYNC_CFE_PAGE_CACHE_SIZE; i++) {
+        plcrash_async_cfe_page_t *page = &cache->pages[i];
+
+        /* Wait for any in-progress update to complete */
+        int32_t sequence;
+        do {
+            sequence = page->sequence;
+        } while ((sequence & 1) || !OSAtomicCompareAndSwap32Barrier(sequence, sequence + 1, &page->sequence));
+
+        page->valid = false;
+        OSAtomicCompareAndSwap32Barrier(sequence + 1, sequence + 2, &page->sequence);
+    }
+}
+
 /**
  * Return the compact frame encoding entry for @a pc via @a encoding, if available.
  *
@@ -162,6 +457,11 @@ plcrash_error_t plcrash_async_cfe_reader_init (plcrash_async_cfe_reader_t *reade
 plcrash_error_t plcrash_async_cfe_reader_find_pc (plcrash_async_cfe_reader_t *reader, pl_vm_address_t pc, pl_vm_address_t *function_base, uint32_t *encoding) {
     const plcrash_async_byteorder_t *byteorder = reader->byteorder;
     const pl_vm_address_t base_addr = plcrash_async_mobject_base_address(reader->mobj);
+    plcrash_error_t err;
+
+    /* Check for an already decoded second-level page */
+    if (reader->page_cache != NULL && plcrash_async_cfe_page_cache_lookup(reader->page_cache, base_addr, pc, &err, function_base, encoding))
+        return err;
 
     /* Find and map the common encodings table */
     uint32_t common_enc_count = byteorder->swap32(reader->header.commonEncodingsArrayCount);
@@ -182,11 +482,13 @@ plcrash_error_t plcrash_async_cfe_reader_find_pc (plcrash_async_cfe_reader_t *re
     }
 
     /* Find and load the first level entry */
+    struct unwind_info_section_header_index_entry *index_entries;
+    uint32_t index_count;
     struct unwind_info_section_header_index_entry *first_level_entry = NULL;
     {
         /* Find and map the index */
         uint32_t index_off = byteorder->swap32(reader->header.indexSectionOffset);
-        uint32_t index_count = byteorder->swap32(reader->header.indexCount);
+        index_count = byteorder->swap32(reader->header.indexCount);
         
         if (VERIFY_SIZE_T(sizeof(struct unwind_info_section_header_index_entry), index_count)) {
             PLCF_DEBUG("CFE index count extends beyond the range of size_t");
@@ -210,15 +512,15 @@ plcrash_error_t plcrash_async_cfe_reader_find_pc (plcrash_async_cfe_reader_t *re
         
         /* Load the index entries */
         size_t index_len = index_count * sizeof(struct unwind_info_section_header_index_entry);
-        struct unwind_info_section_header_index_entry *index_entries = plcrash_async_mobject_remap_address(reader->mobj, base_addr, index_off, index_len);
+        index_entries = plcrash_async_mobject_remap_address(reader->mobj, base_addr, index_off, index_len);
         if (index_entries == NULL) {
             PLCF_DEBUG("The declared entries table lies outside the mapped CFE range");
             return PLCRASH_EINVAL;
         }
         
         /* Binary search for the first-level entry */
-#define CFE_FUN_BINARY_SEARCH_ENTVAL(_tval) (byteorder->swap32(_tval.functionOffset))
-        CFE_FUN_BINARY_SEARCH(pc, index_entries, index_count, first_level_entry);
+#define CFE_FUN_BINARY_SEARCH_ENTVAL(_tval) (CFE_SWAP32(_tval.functionOffset))
+        CFE_FUN_BINARY_SEARCH_BYTEORDER(byteorder, pc, index_entries, index_count, first_level_entry);
 #undef CFE_FUN_BINARY_SEARCH_ENTVAL
         
         if (first_level_entry == NULL) {
@@ -227,6 +529,31 @@ plcrash_error_t plcrash_async_cfe_reader_find_pc (plcrash_async_cfe_reader_t *re
         }
     }
 
+    /* Decode and cache the second-level page. If the page can not be cached, fall back on searching the page directly. */
+    if (reader->page_cache != NULL) {
+        int32_t sequence;
+        plcrash_async_cfe_page_t *page = plcrash_async_cfe_page_cache_claim(reader->page_cache, &sequence);
+        if (page != NULL) {
+            uint32_t index = (uint32_t) (first_level_entry - index_entries);
+
+            page->section_addr = base_addr;
+            page->index = index;
+            page->function_start = byteorder->swap32(first_level_entry->functionOffset);
+            if (index + 1 < index_count)
+                page->function_end = byteorder->swap32(first_level_entry[1].functionOffset);
+            else
+                page->function_end = PL_VM_ADDRESS_MAX;
+
+            if (plcrash_async_cfe_page_decode(reader, common_enc, common_enc_count, first_level_entry, page) == PLCRASH_ESUCCESS) {
+                err = plcrash_async_cfe_page_find_pc(page, pc, function_base, encoding);
+                plcrash_async_cfe_page_cache_release(reader->page_cache, page, sequence, true);
+                return err;
+            }
+
+            plcrash_async_cfe_page_cache_release(reader->page_cache, page, sequence, false);
+        }
+    }
+
     /* Locate and decode the second-level entry */
     uint32_t second_level_offset = byteorder->swap32(first_level_entry->secondLevelPagesSectionOffset);
     uint32_t *second_level_kind = plcrash_async_mobject_remap_address(reader->mobj, base_addr, second_level_offset, sizeof(uint32_t));
@@ -257,8 +584,8 @@ plcrash_error_t plcrash_async_cfe_reader_find_pc (plcrash_async_cfe_reader_t *re
             struct unwind_info_regular_second_level_entry *entries = (struct unwind_info_regular_second_level_entry *) (((uintptr_t)header) + entries_offset);
             struct unwind_info_regular_second_level_entry *entry = NULL;
             
-#define CFE_FUN_BINARY_SEARCH_ENTVAL(_tval) (byteorder->swap32(_tval.functionOffset))
-            CFE_FUN_BINARY_SEARCH(pc, entries, entries_count, entry);
+#define CFE_FUN_BINARY_SEARCH_ENTVAL(_tval) (CFE_SWAP32(_tval.functionOffset))
+            CFE_FUN_BINARY_SEARCH_BYTEORDER(byteorder, pc, entries, entries_count, entry);
 #undef CFE_FUN_BINARY_SEARCH_ENTVAL
             
             if (entry == NULL) {
@@ -300,8 +627,8 @@ plcrash_error_t plcrash_async_cfe_reader_find_pc (plcrash_async_cfe_reader_t *re
             uint32_t *compressed_entries = (uint32_t *) (((uintptr_t)header) + entries_offset);
             uint32_t *c_entry_ptr = NULL;
 
-#define CFE_FUN_BINARY_SEARCH_ENTVAL(_tval) (base_foffset + UNWIND_INFO_COMPRESSED_ENTRY_FUNC_OFFSET(byteorder->swap32(_tval)))
-            CFE_FUN_BINARY_SEARCH(pc, compressed_entries, entries_count, c_entry_ptr);
+#define CFE_FUN_BINARY_SEARCH_ENTVAL(_tval) (base_foffset + UNWIND_INFO_COMPRESSED_ENTRY_FUNC_OFFSET(CFE_SWAP32(_tval)))
+            CFE_FUN_BINARY_SEARCH_BYTEORDER(byteorder, pc, compressed_entries, entries_count, c_entry_ptr);
 #undef CFE_FUN_BINARY_SEARCH_ENTVAL
             
             if (c_entry_ptr == NULL) {
@@ -968,7 +1295,7 @@ plcrash_async_cfe_entry_type_t plcrash_async_cfe_entry_type (plcrash_async_cfe_e
  *
  *   TODO: Need a mechanism to define the actual size of the offset. For x86-32/x86-64, it is defined as being
  *   encoded in a subl instruction.
- * - PLCRASH_ASYNC_CFE_ENTRY_TYPE_DWARF: Unused.
+ * - PLCRASH_ASYNC_CFE_ENTRY_TYPE_DWARF: The offset of the function's FDE within the image's __eh_frame section.
  *
  * @param entry The entry from which the stack offset value will be fetched.
  */
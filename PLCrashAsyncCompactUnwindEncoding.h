@@ -37,12 +37,81 @@
 
 #if PLCRASH_FEATURE_UNWIND_COMPACT
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * @internal
  * @ingroup plcrash_async_cfe
  * @{
  */
 
+/** The number of decoded second-level pages retained by a plcrash_async_cfe_page_cache_t. */
+#define PLCRASH_ASYNC_CFE_PAGE_CACHE_SIZE 4
+
+/**
+ * The maximum number of entries in a decoded second-level page. Second-level pages are 4KB in size, and compressed
+ * entries are 4 bytes; pages with more entries are not cached.
+ */
+#define PLCRASH_ASYNC_CFE_PAGE_ENTRY_MAX 1024
+
+/**
+ * @internal
+ * A decoded second-level CFE page, containing native-endian function offsets and their resolved encodings.
+ */
+typedef struct plcrash_async_cfe_page {
+    /**
+     * The page's update sequence number. Odd values designate an in-progress update; readers must verify that the
+     * sequence number is even, and unchanged after reading the page's contents.
+     */
+    volatile int32_t sequence;
+
+    /** The value of the cache's use counter at the time this page was last used. */
+    volatile int32_t last_used;
+
+    /** If true, the page contains valid data. */
+    bool valid;
+
+    /** The task-relative address of the unwind info section from which this page was decoded. */
+    pl_vm_address_t section_addr;
+
+    /** The first-level index of this page. */
+    uint32_t index;
+
+    /** The first function offset covered by this page's first-level index entry. */
+    pl_vm_address_t function_start;
+
+    /** The function offset at which the next first-level index entry begins, or PL_VM_ADDRESS_MAX if this is the last entry. */
+    pl_vm_address_t function_end;
+
+    /** The number of entries in @a function_offsets and @a encodings. */
+    uint32_t count;
+
+    /** The sorted function offsets, relative to the image's load address. */
+    uint32_t function_offsets[PLCRASH_ASYNC_CFE_PAGE_ENTRY_MAX];
+
+    /** The resolved encoding for each entry in @a function_offsets. */
+    uint32_t encodings[PLCRASH_ASYNC_CFE_PAGE_ENTRY_MAX];
+} plcrash_async_cfe_page_t;
+
+/**
+ * @internal
+ * A fixed-size, least-recently-used cache of decoded second-level CFE pages, shared by all readers. Lookups
+ * and insertions are lock-free and async-safe, and may be performed concurrently from multiple threads; insertions
+ * that would contend with a concurrent update are simply dropped.
+ *
+ * A zero-initialized instance is a valid, empty cache.
+ */
+typedef struct plcrash_async_cfe_page_cache {
+    /** Use counter, incremented on every cache hit or insertion. Updates are not atomic; the value is only used as a
+     * replacement hint. */
+    volatile int32_t clock;
+
+    /** Cached pages. */
+    plcrash_async_cfe_page_t pages[PLCRASH_ASYNC_CFE_PAGE_CACHE_SIZE];
+} plcrash_async_cfe_page_cache_t;
+
 /**
  * @internal
  * A CFE reader instance. Performs CFE data parsing from a backing memory object.
@@ -51,6 +120,9 @@ typedef struct plcrash_async_cfe_reader {
     /** A memory object containing the CFE data at the starting address. */
     plcrash_async_mobject_t *mobj;
 
+    /** The cache to be used for decoded second-level pages, or NULL. */
+    plcrash_async_cfe_page_cache_t *page_cache;
+
     /** The target CPU type. */
     cpu_type_t cpu_type;
 
@@ -189,12 +261,14 @@ typedef struct plcrash_async_cfe_entry {
     plcrash_regnum_t register_list[PLCRASH_ASYNC_CFE_SAVED_REGISTER_MAX];
 } plcrash_async_cfe_entry_t;
 
-plcrash_error_t plcrash_async_cfe_reader_init (plcrash_async_cfe_reader_t *reader, plcrash_async_mobject_t *mobj, cpu_type_t cputype);
+plcrash_error_t plcrash_async_cfe_reader_init (plcrash_async_cfe_reader_t *reader, plcrash_async_mobject_t *mobj, cpu_type_t cputype, plcrash_async_cfe_page_cache_t *page_cache);
 
 plcrash_error_t plcrash_async_cfe_reader_find_pc (plcrash_async_cfe_reader_t *reader, pl_vm_address_t pc, pl_vm_address_t *function_base, uint32_t *encoding);
 
 void plcrash_async_cfe_reader_free (plcrash_async_cfe_reader_t *reader);
 
+void plcrash_nasync_cfe_page_cache_invalidate (plcrash_async_cfe_page_cache_t *cache);
+
 
 plcrash_error_t plcrash_async_cfe_entry_init (plcrash_async_cfe_entry_t *entry, cpu_type_t cpu_type, uint32_t encoding);
 
@@ -220,6 +294,10 @@ plcrash_error_t plcrash_async_cfe_register_decode (uint32_t permutation, uint32_
  * @} plcrash_async_cfe
  */
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* PLCRASH_FEATURE_UNWIND_COMPACT */
 
 #endif /* PLCRASH_ASYNC_COMPACT_UNWIND_ENCODING_H */
@@ -29,6 +29,7 @@
 #include "PLCrashFeatureConfig.h"
 
 #include <inttypes.h>
+#include <libkern/OSAtomic.h>
 
 #if PLCRASH_FEATURE_UNWIND_DWARF
 
@@ -409,7 +410,153 @@ void plcrash::async::plcrash_async_dwarf_cie_info_free (plcrash_async_dwarf_cie_
     // No-op
 }
 
+#pragma mark CIE Cache
+
+/**
+ * Parse a DWARF CIE record and initialize @a info, returning a cached record from @a cache if available. Newly parsed
+ * records will be added to @a cache.
+ *
+ * Any resources held by a successfully initialized instance must be freed via plcrash_async_dwarf_cie_info_free();
+ *
+ * @param info The CIE info instance to initialize.
+ * @param cache The cache to be consulted and updated, or NULL to parse the record without caching.
+ * @param mobj The memory object containing frame data (eh_frame or debug_frame) at the start address.
+ * @param byteoder The byte order of the data referenced by @a mobj.
+ * @param ptr_state The pointer state to be used when decoding GNU eh_frame pointer values.
+ * @param address The task-relative address within @a mobj of the CIE to be decoded.
+ */
+template <typename machine_ptr>
+plcrash_error_t plcrash::async::plcrash_async_dwarf_cie_info_init_cached (plcrash_async_dwarf_cie_info_t *info,
+                                                                          dwarf_cie_cache *cache,
+                                                                          plcrash_async_mobject_t *mobj,
+                                                                          const plcrash_async_byteorder_t *byteorder,
+                                                                          gnu_ehptr_reader<machine_ptr> *ptr_reader,
+                                                                          pl_vm_address_t address)
+{
+    pl_vm_address_t section_addr = plcrash_async_mobject_base_address(mobj);
+    plcrash_error_t err;
+
+    if (cache == NULL)
+        return plcrash_async_dwarf_cie_info_init(info, mobj, byteorder, ptr_reader, address);
+
+    if (cache->lookup(section_addr, address, info))
+        return PLCRASH_ESUCCESS;
+
+    if ((err = plcrash_async_dwarf_cie_info_init(info, mobj, byteorder, ptr_reader, address)) != PLCRASH_ESUCCESS)
+        return err;
+
+    cache->insert(section_addr, address, info);
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Construct an empty CIE cache.
+ */
+dwarf_cie_cache::dwarf_cie_cache () {
+    plcrash_async_memset(_entries, 0, sizeof(_entries));
+}
+
+/**
+ * Return the entry to be used for the given key.
+ */
+dwarf_cie_cache::entry *dwarf_cie_cache::entry_for (pl_vm_address_t section_addr, pl_vm_address_t cie_addr) {
+    uint64_t hash = (uint64_t) (section_addr ^ (cie_addr * 0x9E3779B97F4A7C15ULL));
+    return &_entries[(hash >> 32) & (PLCRASH_ASYNC_DWARF_CIE_CACHE_SIZE - 1)];
+}
+
+/**
+ * Look up a cached CIE record. This method is async-safe.
+ *
+ * @param section_addr The task-relative address of the eh_frame/debug_frame section containing the CIE.
+ * @param cie_addr The task-relative address of the CIE.
+ * @param info On success, will be initialized with a copy of the cached record.
+ *
+ * @return Returns true if a cached record was found, false otherwise.
+ */
+bool dwarf_cie_cache::lookup (pl_vm_address_t section_addr, pl_vm_address_t cie_addr, plcrash_async_dwarf_cie_info_t *info) {
+    entry *e = entry_for(section_addr, cie_addr);
+
+    int32_t sequence = e->sequence;
+    if (sequence & 1)
+        return false;
+    OSMemoryBarrier();
+
+    if (!e->valid || e->section_addr != section_addr || e->cie_addr != cie_addr)
+        return false;
+
+    plcrash_async_memcpy(info, &e->info, sizeof(*info));
+
+    /* Verify that the entry was not modified while being read */
+    OSMemoryBarrier();
+    if (e->sequence != sequence)
+        return false;
+
+    return true;
+}
+
+/**
+ * Insert a parsed CIE record, replacing any existing entry with the same hash. This method is async-safe. If the
+ * entry is concurrently being updated by another thread, the record will not be inserted.
+ *
+ * @param section_addr The task-relative address of the eh_frame/debug_frame section containing the CIE.
+ * @param cie_addr The task-relative address of the CIE.
+ * @param info The record to be cached.
+ */
+void dwarf_cie_cache::insert (pl_vm_address_t section_addr, pl_vm_address_t cie_addr, const plcrash_async_dwarf_cie_info_t *info) {
+    entry *e = entry_for(section_addr, cie_addr);
+
+    /* Claim the entry */
+    int32_t sequence = e->sequence;
+    if ((sequence & 1) || !OSAtomicCompareAndSwap32Barrier(sequence, sequence + 1, &e->sequence))
+        return;
+
+    e->section_addr = section_addr;
+    e->cie_addr = cie_addr;
+    plcrash_async_memcpy(&e->info, info, sizeof(e->info));
+    e->valid = true;
+
+    /* Publish the entry */
+    OSAtomicCompareAndSwap32Barrier(sequence + 1, sequence + 2, &e->sequence);
+}
+
+/**
+ * Invalidate all cached records. This must be called when an image is unloaded, as a new image could later
+ * be loaded at the same address.
+ *
+ * @warning This method is not async-safe.
+ */
+void dwarf_cie_cache::nasync_invalidate () {
+    for (size_t i = 0; i < PLCRASH_ASYNC_DWARF_CIE_CACHE_SIZE; i++) {
+        entry *e = &_entries[i];
+
+        /* Wait for any in-progress update to complete */
+        int32_t sequence;
+        do {
+            sequence = e->sequence;
+        } while ((sequence & 1) || !OSAtomicCompareAndSwap32Barrier(sequence, sequence + 1, &e->sequence));
+
+        e->valid = false;
+        OSAtomicCompareAndSwap32Barrier(sequence + 1, sequence + 2, &e->sequence);
+    }
+}
+
 /* Provide explicit 32/64-bit instantiations */
+template
+plcrash_error_t plcrash_async_dwarf_cie_info_init_cached<uint32_t> (plcrash_async_dwarf_cie_info_t *info,
+                                                                    dwarf_cie_cache *cache,
+                                                                    plcrash_async_mobject_t *mobj,
+                                                                    const plcrash_async_byteorder_t *byteorder,
+                                                                    gnu_ehptr_reader<uint32_t> *ptr_reader,
+                                                                    pl_vm_address_t address);
+
+template
+plcrash_error_t plcrash_async_dwarf_cie_info_init_cached<uint64_t> (plcrash_async_dwarf_cie_info_t *info,
+                                                                    dwarf_cie_cache *cache,
+                                                                    plcrash_async_mobject_t *mobj,
+                                                                    const plcrash_async_byteorder_t *byteorder,
+                                                                    gnu_ehptr_reader<uint64_t> *ptr_reader,
+                                                                    pl_vm_address_t address);
+
 template
 plcrash_error_t plcrash_async_dwarf_cie_info_init<uint32_t> (plcrash_async_dwarf_cie_info_t *info,
                                                              plcrash_async_mobject_t *mobj,
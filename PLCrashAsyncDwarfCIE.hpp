@@ -173,6 +173,64 @@ pl_vm_size_t plcrash_async_dwarf_cie_info_initial_instructions_length (plcrash_a
 
 void plcrash_async_dwarf_cie_info_free (plcrash_async_dwarf_cie_info_t *info);
 
+/** The number of entries in a dwarf_cie_cache. Must be a power of two. */
+#define PLCRASH_ASYNC_DWARF_CIE_CACHE_SIZE 32
+
+/**
+ * @internal
+ *
+ * An async-safe, fixed-size cache of parsed CIE records, keyed by the task-relative address of the
+ * eh_frame/debug_frame section and the CIE's task-relative address.
+ *
+ * Nearly all FDEs within an image share one or two CIEs; caching the parsed CIE records allows CIE decoding
+ * to be performed once per image, rather than once for every FDE visited. Lookups and insertions are lock-free,
+ * and may be performed concurrently from multiple threads; insertions that would contend with a concurrent
+ * update are simply dropped.
+ */
+class dwarf_cie_cache {
+public:
+    dwarf_cie_cache ();
+
+    bool lookup (pl_vm_address_t section_addr, pl_vm_address_t cie_addr, plcrash_async_dwarf_cie_info_t *info);
+    void insert (pl_vm_address_t section_addr, pl_vm_address_t cie_addr, const plcrash_async_dwarf_cie_info_t *info);
+    void nasync_invalidate ();
+
+private:
+    /** A single cache entry. */
+    struct entry {
+        /**
+         * The entry's update sequence number. Odd values designate an in-progress update; readers must verify that the
+         * sequence number is even, and unchanged after reading the entry's contents.
+         */
+        volatile int32_t sequence;
+
+        /** If true, the entry contains a valid record. */
+        bool valid;
+
+        /** The task-relative address of the eh_frame/debug_frame section containing the CIE. */
+        pl_vm_address_t section_addr;
+
+        /** The task-relative address of the CIE. */
+        pl_vm_address_t cie_addr;
+
+        /** The parsed CIE record. */
+        plcrash_async_dwarf_cie_info_t info;
+    };
+
+    entry *entry_for (pl_vm_address_t section_addr, pl_vm_address_t cie_addr);
+
+    /** Cache entries, indexed by a hash of the section and CIE addresses. */
+    entry _entries[PLCRASH_ASYNC_DWARF_CIE_CACHE_SIZE];
+};
+
+template <typename machine_ptr>
+plcrash_error_t plcrash_async_dwarf_cie_info_init_cached (plcrash_async_dwarf_cie_info_t *info,
+                                                          dwarf_cie_cache *cache,
+                                                          plcrash_async_mobject_t *mobj,
+                                                          const plcrash_async_byteorder_t *byteorder,
+                                                          gnu_ehptr_reader<machine_ptr> *ptr_reader,
+                                                          pl_vm_address_t address);
+
 
 /**
  * @}
@@ -25,6 +25,7 @@
  */
 
 #include "PLCrashAsyncDwarfEncoding.hpp"
+#include "PLCrashAsyncMObjectSpan.hpp"
 #include "PLCrashFeatureConfig.h"
 
 #include <inttypes.h>
@@ -51,18 +52,22 @@ using namespace plcrash::async;
  * @param m64 True if the target system uses 64-bit pointers, false if it uses 32-bit pointers.
  * @param debug_frame If true, interpret the DWARF data as a debug_frame section. Otherwise, the
  * frame reader will assume eh_frame data.
+ * @param cie_cache A cache of parsed CIE records to be used by the reader, or NULL. If non-NULL, this instance must
+ * survive for the lifetime of the reader.
  *
  * @return Returns PLCRASH_ESUCCESS on success, or an appropriate plcrash_error_t value on error.
  */
 plcrash_error_t dwarf_frame_reader::init (plcrash_async_mobject_t *mobj,
                                           const plcrash_async_byteorder_t *byteorder,
                                           bool m64,
-                                          bool debug_frame)
+                                          bool debug_frame,
+                                          dwarf_cie_cache *cie_cache)
 {
     _mobj = mobj;
     _byteorder = byteorder;
     _debug_frame = debug_frame;
     _m64 = m64;
+    _cie_cache = cie_cache;
     
     return PLCRASH_ESUCCESS;
 }
@@ -103,33 +108,41 @@ plcrash_error_t dwarf_frame_reader::find_fde (pl_vm_off_t offset,
         PLCF_DEBUG("FDE base address + offset falls outside the mapped range");
         return PLCRASH_EINVAL;
     }
+
+    /* Validate the section once; entry headers are read directly from the validated span */
+    mobject_span section;
+    if ((err = section.init(_mobj, base_addr, 0, end_addr - base_addr)) != PLCRASH_ESUCCESS) {
+        PLCF_DEBUG("The DWARF section could not be mapped");
+        return err;
+    }
     
     /* Iterate over table entries */
     while (cfi_entry < end_addr) {
+        pl_vm_size_t entry_offset = cfi_entry - base_addr;
+
         /* Fetch the entry length (and determine wether it's 64-bit or 32-bit) */
         uint64_t length;
         pl_vm_size_t length_size;
         uint8_t dwarf_word_size;
         
         {
-            uint32_t *length32 = (uint32_t *) plcrash_async_mobject_remap_address(_mobj, cfi_entry, 0x0, sizeof(uint32_t));
-            if (length32 == NULL) {
+            if (!section.contains(entry_offset, sizeof(uint32_t))) {
                 PLCF_DEBUG("The current CFI entry 0x%" PRIx64 " header lies outside the mapped range", (uint64_t) cfi_entry);
                 return PLCRASH_EINVAL;
             }
             
-            if (byteorder->swap32(*length32) == UINT32_MAX) {
-                uint64_t *length64 = (uint64_t *) plcrash_async_mobject_remap_address(_mobj, cfi_entry, sizeof(uint32_t), sizeof(uint64_t));
-                if (length64 == NULL) {
+            uint32_t length32 = section.read<uint32_t>(byteorder, entry_offset);
+            if (length32 == UINT32_MAX) {
+                if (!section.contains(entry_offset + sizeof(uint32_t), sizeof(uint64_t))) {
                     PLCF_DEBUG("The current CFI entry 0x%" PRIx64 " header lies outside the mapped range", (uint64_t) cfi_entry);
                     return PLCRASH_EINVAL;
                 }
                 
-                length = byteorder->swap64(*length64);
+                length = section.read<uint64_t>(byteorder, entry_offset + sizeof(uint32_t));
                 length_size = sizeof(uint64_t) + sizeof(uint32_t);
                 dwarf_word_size = 8; // 64-bit DWARF
             } else {
-                length = byteorder->swap32(*length32);
+                length = length32;
                 length_size = sizeof(uint32_t);
                 dwarf_word_size = 4; // 32-bit DWARF
             }
@@ -159,14 +172,24 @@ plcrash_error_t dwarf_frame_reader::find_fde (pl_vm_off_t offset,
             PLCF_DEBUG("Entry length size overflows the CFI address");
             return PLCRASH_EINVAL;
         }
-        
+
+        if (next_cfi_entry > end_addr) {
+            PLCF_DEBUG("The current CFI entry 0x%" PRIx64 " length runs past the end of the mapped range", (uint64_t) cfi_entry);
+            return PLCRASH_EINVAL;
+        }
+
         /* Fetch the entry id */
         uint64_t cie_id;
         
-        if ((err = plcrash_async_dwarf_read_uintmax64(_mobj, byteorder, cfi_entry, length_size, dwarf_word_size, &cie_id)) != PLCRASH_ESUCCESS) {
+        if (!section.contains(entry_offset + length_size, dwarf_word_size)) {
             PLCF_DEBUG("The current CFI entry 0x%" PRIx64 " cie_id lies outside the mapped range", (uint64_t) cfi_entry);
             return PLCRASH_EINVAL;
         }
+
+        if (dwarf_word_size == 8)
+            cie_id = section.read<uint64_t>(byteorder, entry_offset + length_size);
+        else
+            cie_id = section.read<uint32_t>(byteorder, entry_offset + length_size);
         
         /* Check for (and skip) CIE entries. */
         {
@@ -190,9 +213,9 @@ plcrash_error_t dwarf_frame_reader::find_fde (pl_vm_off_t offset,
         
         /* Decode the FDE */
         if (_m64)
-            err = plcrash_async_dwarf_fde_info_init<uint64_t>(fde_info, _mobj, byteorder, cfi_entry, _debug_frame);
+            err = plcrash_async_dwarf_fde_info_init<uint64_t>(fde_info, _mobj, byteorder, cfi_entry, _debug_frame, _cie_cache);
         else
-            err = plcrash_async_dwarf_fde_info_init<uint32_t>(fde_info, _mobj, byteorder, cfi_entry, _debug_frame);
+            err = plcrash_async_dwarf_fde_info_init<uint32_t>(fde_info, _mobj, byteorder, cfi_entry, _debug_frame, _cie_cache);
         if (err != PLCRASH_ESUCCESS)
             return err;
         
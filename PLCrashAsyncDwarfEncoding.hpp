@@ -59,7 +59,8 @@ public:
     plcrash_error_t init (plcrash_async_mobject_t *mobj,
                           const plcrash_async_byteorder_t *byteorder,
                           bool m64,
-                          bool debug_frame);
+                          bool debug_frame,
+                          dwarf_cie_cache *cie_cache);
     
     plcrash_error_t find_fde (pl_vm_off_t offset,
                               pl_vm_address_t pc,
@@ -77,6 +78,9 @@ private:
     
     /** True if this is a debug_frame section */
     bool _debug_frame;
+
+    /** The cache to be used when parsing CIE records, or NULL. */
+    dwarf_cie_cache *_cie_cache;
 };
     
 }}
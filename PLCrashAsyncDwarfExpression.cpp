@@ -277,9 +277,14 @@ plcrash_error_t plcrash_async_dwarf_expression_eval (plcrash_async_mobject_t *mo
                 dw_expr_push(dw_thread_regval(opcode - DW_OP_breg0) + dw_expr_read_sleb128());
                 break;
                 
-            case DW_OP_bregx:
-                dw_expr_push(dw_thread_regval(dw_expr_read_sleb128()) + dw_expr_read_sleb128());
-                
+            case DW_OP_bregx: {
+                /* The register number is ULEB128-encoded, and must be read before the SLEB128 offset */
+                machine_ptr regnum = dw_expr_read_uleb128();
+                machine_ptr_s offset = dw_expr_read_sleb128();
+                dw_expr_push(dw_thread_regval(regnum) + offset);
+                break;
+            }
+
             case DW_OP_dup:
                 if (!stack.dup()) {
                     PLCF_DEBUG("DW_OP_dup on an empty stack");
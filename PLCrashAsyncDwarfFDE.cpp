@@ -55,13 +55,15 @@ using namespace plcrash::async;
  * the length field of the FDE.
  * @param debug_frame If true, interpret the DWARF data as a debug_frame section. Otherwise, the
  * frame reader will assume eh_frame data.
+ * @param cie_cache The cache to be used when parsing the FDE's CIE, or NULL.
  */
 template <typename machine_ptr>
 plcrash_error_t plcrash::async::plcrash_async_dwarf_fde_info_init (plcrash_async_dwarf_fde_info_t *info,
                                                                    plcrash_async_mobject_t *mobj,
                                                                    const plcrash_async_byteorder_t *byteorder,
                                                                    pl_vm_address_t fde_address,
-                                                                   bool debug_frame)
+                                                                   bool debug_frame,
+                                                                   dwarf_cie_cache *cie_cache)
 {
     const pl_vm_address_t sect_addr = plcrash_async_mobject_base_address(mobj);
     plcrash_error_t err;
@@ -145,7 +147,7 @@ plcrash_error_t plcrash::async::plcrash_async_dwarf_fde_info_init (plcrash_async
     
     /* Parse the CIE */
     plcrash_async_dwarf_cie_info_t cie;
-    if ((err = plcrash_async_dwarf_cie_info_init(&cie, mobj, byteorder, &ptr_reader, cie_target_address)) != PLCRASH_ESUCCESS) {
+    if ((err = plcrash_async_dwarf_cie_info_init_cached(&cie, cie_cache, mobj, byteorder, &ptr_reader, cie_target_address)) != PLCRASH_ESUCCESS) {
         PLCF_DEBUG("Failed to parse CFE for FDE");
         return err;
     }
@@ -248,14 +250,16 @@ plcrash_error_t plcrash_async_dwarf_fde_info_init<uint32_t> (plcrash_async_dwarf
                                                              plcrash_async_mobject_t *mobj,
                                                              const plcrash_async_byteorder_t *byteorder,
                                                              pl_vm_address_t fde_address,
-                                                             bool debug_frame);
+                                                             bool debug_frame,
+                                                             dwarf_cie_cache *cie_cache);
 
 template
 plcrash_error_t plcrash_async_dwarf_fde_info_init<uint64_t> (plcrash_async_dwarf_fde_info_t *info,
                                                              plcrash_async_mobject_t *mobj,
                                                              const plcrash_async_byteorder_t *byteorder,
                                                              pl_vm_address_t fde_address,
-                                                             bool debug_frame);
+                                                             bool debug_frame,
+                                                             dwarf_cie_cache *cie_cache);
 
 /**
  * @}
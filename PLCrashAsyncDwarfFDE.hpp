@@ -30,6 +30,7 @@
 #include "PLCrashAsync.h"
 #include "PLCrashAsyncImageList.h"
 #include "PLCrashAsyncThread.h"
+#include "PLCrashAsyncDwarfCIE.hpp"
 #include "PLCrashFeatureConfig.h"
 
 #if PLCRASH_FEATURE_UNWIND_DWARF
@@ -76,7 +77,8 @@ plcrash_error_t plcrash_async_dwarf_fde_info_init (plcrash_async_dwarf_fde_info_
                                                    plcrash_async_mobject_t *mobj,
                                                    const plcrash_async_byteorder_t *byteorder,
                                                    pl_vm_address_t fde_address,
-                                                   bool debug_frame);
+                                                   bool debug_frame,
+                                                   dwarf_cie_cache *cie_cache);
 
 pl_vm_address_t plcrash_async_dwarf_fde_info_instructions_offset (plcrash_async_dwarf_fde_info_t *info);
 pl_vm_size_t plcrash_async_dwarf_fde_info_instructions_length (plcrash_async_dwarf_fde_info_t *info);
@@ -26,6 +26,7 @@
 
 #include "PLCrashAsyncDwarfPrimitives.hpp"
 #include "PLCrashAsyncDwarfEncoding.hpp"
+#include "PLCrashAsyncMObjectSpan.hpp"
 
 #include "PLCrashFeatureConfig.h"
 
@@ -343,7 +344,13 @@ template <typename machine_ptr> plcrash_error_t gnu_ehptr_reader<machine_ptr>::r
          * indirect reads.
          *
          * TODO: This implementation should provide a resolvable GNUEHPtr value, rather than requiring resolution occur here.
+         *
+         * Memory objects that are not backed by a task (eg, file or snapshot data) can only resolve targets within
+         * their own range.
          */
+        if (plcrash_async_mobject_task(mobj) == MACH_PORT_NULL)
+            return plcrash_async_dwarf_read_uintmax64(mobj, _byteorder, *result, 0, sizeof(machine_ptr), result);
+
         return plcrash_async_dwarf_read_task_uintmax64(plcrash_async_mobject_task(mobj), _byteorder, *result, 0, sizeof(machine_ptr), result);
     }
     
@@ -446,13 +453,21 @@ plcrash_error_t plcrash::async::plcrash_async_dwarf_read_task_uleb128 (task_t ta
  */
 plcrash_error_t plcrash::async::plcrash_async_dwarf_read_uleb128 (plcrash_async_mobject_t *mobj, pl_vm_address_t location, pl_vm_off_t offset, uint64_t *result, pl_vm_size_t *size) {
     unsigned int shift = 0;
-    pl_vm_off_t position = 0;
+    pl_vm_size_t position = 0;
+    uint8_t byte = 0;
     *result = 0;
-    
-    uint8_t *p;
-    while ((p = (uint8_t *) plcrash_async_mobject_remap_address(mobj, location, position + offset, 1)) != NULL) {
+
+    /* Validate the remaining mapped range once, rather than per byte */
+    mobject_span span;
+    if (span.init_remaining(mobj, location, offset) != PLCRASH_ESUCCESS) {
+        PLCF_DEBUG("ULEB128 value did not terminate within mapped memory range");
+        return PLCRASH_EINVAL;
+    }
+
+    bool terminated = false;
+    while (span.contains(position, 1)) {
         /* LEB128 uses 7 bits for the number, the final bit to signal completion */
-        uint8_t byte = *p;
+        byte = span.read<uint8_t>(position);
         *result |= ((uint64_t) (byte & 0x7f)) << shift;
         shift += 7;
         
@@ -461,8 +476,10 @@ plcrash_error_t plcrash::async::plcrash_async_dwarf_read_uleb128 (plcrash_async_
         position++;
         
         /* Check for terminating bit */
-        if ((byte & 0x80) == 0)
+        if ((byte & 0x80) == 0) {
+            terminated = true;
             break;
+        }
         
         /* Check for a ULEB128 larger than 64-bits */
         if (shift >= 64) {
@@ -471,7 +488,7 @@ plcrash_error_t plcrash::async::plcrash_async_dwarf_read_uleb128 (plcrash_async_
         }
     }
     
-    if (p == NULL) {
+    if (!terminated) {
         PLCF_DEBUG("ULEB128 value did not terminate within mapped memory range");
         return PLCRASH_EINVAL;
     }
@@ -491,13 +508,21 @@ plcrash_error_t plcrash::async::plcrash_async_dwarf_read_uleb128 (plcrash_async_
  */
 plcrash_error_t plcrash::async::plcrash_async_dwarf_read_sleb128 (plcrash_async_mobject_t *mobj, pl_vm_address_t location, pl_vm_off_t offset, int64_t *result, pl_vm_size_t *size) {
     unsigned int shift = 0;
-    pl_vm_off_t position = 0;
+    pl_vm_size_t position = 0;
+    uint8_t byte = 0;
     *result = 0;
-    
-    uint8_t *p;
-    while ((p = (uint8_t *) plcrash_async_mobject_remap_address(mobj, location, position + offset, 1)) != NULL) {
+
+    /* Validate the remaining mapped range once, rather than per byte */
+    mobject_span span;
+    if (span.init_remaining(mobj, location, offset) != PLCRASH_ESUCCESS) {
+        PLCF_DEBUG("ULEB128 value did not terminate within mapped memory range");
+        return PLCRASH_EINVAL;
+    }
+
+    bool terminated = false;
+    while (span.contains(position, 1)) {
         /* LEB128 uses 7 bits for the number, the final bit to signal completion */
-        uint8_t byte = *p;
+        byte = span.read<uint8_t>(position);
         *result |= ((uint64_t) (byte & 0x7f)) << shift;
         shift += 7;
         
@@ -506,8 +531,10 @@ plcrash_error_t plcrash::async::plcrash_async_dwarf_read_sleb128 (plcrash_async_
         position++;
         
         /* Check for terminating bit */
-        if ((byte & 0x80) == 0)
+        if ((byte & 0x80) == 0) {
+            terminated = true;
             break;
+        }
         
         /* Check for a ULEB128 larger than 64-bits */
         if (shift >= 64) {
@@ -516,13 +543,13 @@ plcrash_error_t plcrash::async::plcrash_async_dwarf_read_sleb128 (plcrash_async_
         }
     }
     
-    if (p == NULL) {
+    if (!terminated) {
         PLCF_DEBUG("ULEB128 value did not terminate within mapped memory range");
         return PLCRASH_EINVAL;
     }
     
     /* Sign bit is 2nd high order bit */
-    if (shift < 64 && (*p & 0x40))
+    if (shift < 64 && (byte & 0x40))
         *result |= -(1ULL << shift);
     
     *size = position;
@@ -0,0 +1,396 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "GTMSenTestCase.h"
+
+#include "PLCrashAsyncDwarfCIE.hpp"
+#include "PLCrashAsyncDwarfEncoding.hpp"
+#include "PLCrashAsyncDwarfExpression.hpp"
+#include "PLCrashFeatureConfig.h"
+
+#include <mach/mach_time.h>
+
+#if PLCRASH_FEATURE_UNWIND_DWARF
+
+using namespace plcrash::async;
+
+@interface PLCrashAsyncDwarfTests : SenTestCase
+@end
+
+/**
+ * Tests for the async-safe DWARF parsing and evaluation support.
+ */
+@implementation PLCrashAsyncDwarfTests
+
+/**
+ * Initialize @a info with values derived from @a tag, allowing cached records to be distinguished.
+ */
+static void cie_cache_test_info (plcrash_async_dwarf_cie_info_t *info, uint64_t tag) {
+    memset(info, 0, sizeof(*info));
+    info->cie_offset = tag;
+    info->code_alignment_factor = tag + 1;
+    info->return_address_register = tag + 2;
+}
+
+/**
+ * Verify CIE cache hits and misses.
+ */
+- (void) testCIECacheLookup {
+    dwarf_cie_cache *cache = new dwarf_cie_cache();
+    plcrash_async_dwarf_cie_info_t info;
+    plcrash_async_dwarf_cie_info_t found;
+
+    /* An empty cache must miss */
+    STAssertFalse(cache->lookup(0x1000, 0x1010, &found), @"Empty cache returned a record");
+
+    /* A cached record must be returned unmodified */
+    cie_cache_test_info(&info, 0x10);
+    cache->insert(0x1000, 0x1010, &info);
+    STAssertTrue(cache->lookup(0x1000, 0x1010, &found), @"Cached record was not found");
+    STAssertEquals(memcmp(&found, &info, sizeof(info)), 0, @"Cached record was modified");
+
+    /* Neighbouring CIEs within the same section must miss */
+    STAssertFalse(cache->lookup(0x1000, 0x1020, &found), @"Lookup of an uncached CIE succeeded");
+
+    /* Invalidation must discard all records */
+    cache->nasync_invalidate();
+    STAssertFalse(cache->lookup(0x1000, 0x1010, &found), @"Record survived invalidation");
+
+    delete cache;
+}
+
+/**
+ * Verify that records are keyed by both the section and CIE address; identical CIE offsets within distinct
+ * images must not alias.
+ */
+- (void) testCIECacheCrossImageKeying {
+    dwarf_cie_cache *cache = new dwarf_cie_cache();
+    plcrash_async_dwarf_cie_info_t first;
+    plcrash_async_dwarf_cie_info_t second;
+    plcrash_async_dwarf_cie_info_t found;
+
+    cie_cache_test_info(&first, 1);
+    cie_cache_test_info(&second, 2);
+
+    /* The same CIE address within two different sections */
+    cache->insert(0x10000, 0x20000, &first);
+    STAssertFalse(cache->lookup(0x30000, 0x20000, &found), @"Record was returned for a different section");
+
+    cache->insert(0x30000, 0x20000, &second);
+    if (cache->lookup(0x10000, 0x20000, &found))
+        STAssertEquals(found.cie_offset, (uint64_t) 1, @"Record from a different section was returned");
+
+    STAssertTrue(cache->lookup(0x30000, 0x20000, &found), @"Cached record was not found");
+    STAssertEquals(found.cie_offset, (uint64_t) 2, @"Incorrect record returned");
+
+    delete cache;
+}
+
+/**
+ * Verify that inserting more records than the cache can hold evicts older records, while always
+ * retaining the most recent insertion and never returning a mismatched record.
+ */
+- (void) testCIECacheEviction {
+    dwarf_cie_cache *cache = new dwarf_cie_cache();
+    const uint64_t count = PLCRASH_ASYNC_DWARF_CIE_CACHE_SIZE * 4;
+    plcrash_async_dwarf_cie_info_t info;
+    plcrash_async_dwarf_cie_info_t found;
+
+    for (uint64_t i = 0; i < count; i++) {
+        cie_cache_test_info(&info, i);
+        cache->insert(0x1000, 0x2000 + (i * 0x40), &info);
+        STAssertTrue(cache->lookup(0x1000, 0x2000 + (i * 0x40), &found), @"Most recent insertion was not found");
+    }
+
+    uint64_t hits = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        if (!cache->lookup(0x1000, 0x2000 + (i * 0x40), &found))
+            continue;
+
+        STAssertEquals(found.cie_offset, i, @"Mismatched record returned");
+        hits++;
+    }
+
+    STAssertTrue(hits > 0, @"No records were retained");
+    STAssertTrue(hits <= PLCRASH_ASYNC_DWARF_CIE_CACHE_SIZE, @"More records were retained than the cache can hold");
+
+    delete cache;
+}
+
+/**
+ * Evaluate the 64-bit DWARF expression @a opcodes against @a thread_state.
+ */
+static plcrash_error_t expression_test_eval (const uint8_t *opcodes, size_t length, const plcrash_async_thread_state_t *thread_state, uint64_t *result) {
+    plcrash_async_mobject_t mobj;
+    plcrash_error_t err;
+
+    if ((err = plcrash_async_mobject_init_local(&mobj, (pl_vm_address_t) opcodes, length)) != PLCRASH_ESUCCESS)
+        return err;
+
+    err = plcrash_async_dwarf_expression_eval<uint64_t, int64_t>(&mobj, mach_task_self(), thread_state, plcrash_async_byteorder_little_endian(),
+                                                                  (pl_vm_address_t) opcodes, 0, length, NULL, 0, result);
+    plcrash_async_mobject_free(&mobj);
+    return err;
+}
+
+/**
+ * Initialize an x86-64 thread state with known stack and frame pointer values.
+ */
+static void expression_test_thread_state (plcrash_async_thread_state_t *thread_state) {
+    plcrash_async_thread_state_init(thread_state, CPU_TYPE_X86_64);
+    plcrash_async_thread_state_set_reg(thread_state, PLCRASH_X86_64_RSP, 0x10000);
+    plcrash_async_thread_state_set_reg(thread_state, PLCRASH_X86_64_RBP, 0x20000);
+}
+
+/**
+ * Verify evaluation of literal and arithmetic operations.
+ */
+- (void) testExpressionArithmetic {
+    plcrash_async_thread_state_t ts;
+    uint64_t result;
+
+    expression_test_thread_state(&ts);
+
+    uint8_t opcodes[] = { DW_OP_lit5, DW_OP_lit7, DW_OP_plus, DW_OP_lit2, DW_OP_minus, DW_OP_plus_uconst, 0x80, 0x01 };
+    STAssertEquals(expression_test_eval(opcodes, sizeof(opcodes), &ts, &result), PLCRASH_ESUCCESS, @"Evaluation failed");
+    STAssertEquals(result, (uint64_t) (5 + 7 - 2 + 128), @"Incorrect result");
+}
+
+/**
+ * Verify that DW_OP_bregx reads a ULEB128 register number followed by a SLEB128 offset, and does not fall through
+ * into the following operation.
+ */
+- (void) testExpressionBregx {
+    plcrash_async_thread_state_t ts;
+    uint64_t result;
+
+    expression_test_thread_state(&ts);
+
+    /* 0x30000 - (rsp - 8) */
+    uint8_t opcodes[] = { DW_OP_const4u, 0x00, 0x00, 0x03, 0x00, DW_OP_bregx, 0x07, 0x78, DW_OP_minus };
+    STAssertEquals(expression_test_eval(opcodes, sizeof(opcodes), &ts, &result), PLCRASH_ESUCCESS, @"Evaluation failed");
+    STAssertEquals(result, (uint64_t) (0x30000 - (0x10000 - 8)), @"Incorrect result");
+}
+
+/**
+ * Verify evaluation of DW_OP_skip and DW_OP_bra.
+ */
+- (void) testExpressionBranches {
+    plcrash_async_thread_state_t ts;
+    uint64_t result;
+
+    expression_test_thread_state(&ts);
+
+    /* Count down from 10, adding rbp-relative values to an accumulator */
+    uint8_t loop[] = {
+        DW_OP_lit0, DW_OP_lit10,
+        /* loop: */
+        DW_OP_swap, DW_OP_breg6, 0x01, DW_OP_plus, DW_OP_swap,
+        DW_OP_lit1, DW_OP_minus, DW_OP_dup, DW_OP_bra, 0xf5, 0xff,
+        DW_OP_drop
+    };
+    STAssertEquals(expression_test_eval(loop, sizeof(loop), &ts, &result), PLCRASH_ESUCCESS, @"Evaluation failed");
+    STAssertEquals(result, (uint64_t) (10 * 0x20001), @"Incorrect result");
+
+    /* A skipped unknown opcode must not be evaluated */
+    uint8_t skip[] = { DW_OP_lit1, DW_OP_skip, 0x01, 0x00, DW_OP_lo_user, DW_OP_lit2, DW_OP_plus };
+    STAssertEquals(expression_test_eval(skip, sizeof(skip), &ts, &result), PLCRASH_ESUCCESS, @"Evaluation failed");
+    STAssertEquals(result, (uint64_t) 3, @"Incorrect result");
+
+    /* A reached unknown opcode must be rejected */
+    uint8_t unknown[] = { DW_OP_lit1, DW_OP_lo_user };
+    STAssertEquals(expression_test_eval(unknown, sizeof(unknown), &ts, &result), PLCRASH_ENOTSUP, @"Unknown opcode was accepted");
+}
+
+/**
+ * Verify that long expressions are evaluated in full.
+ */
+- (void) testExpressionLength {
+    plcrash_async_thread_state_t ts;
+    uint64_t result;
+    uint8_t opcodes[1 + 2 * 200];
+
+    expression_test_thread_state(&ts);
+
+    opcodes[0] = DW_OP_lit0;
+    for (size_t i = 0; i < 200; i++) {
+        opcodes[1 + (i * 2)] = DW_OP_lit1;
+        opcodes[2 + (i * 2)] = DW_OP_plus;
+    }
+
+    STAssertEquals(expression_test_eval(opcodes, sizeof(opcodes), &ts, &result), PLCRASH_ESUCCESS, @"Evaluation failed");
+    STAssertEquals(result, (uint64_t) 200, @"Incorrect result");
+}
+
+/**
+ * Report the cost of evaluating representative DW_CFA_def_cfa_expression and DW_CFA_expression programs.
+ */
+- (void) testExpressionBenchmark {
+    const uint32_t iterations = 100000;
+    plcrash_async_thread_state_t ts;
+    mach_timebase_info_data_t timebase;
+
+    expression_test_thread_state(&ts);
+    plcrash_async_thread_state_set_reg(&ts, PLCRASH_X86_64_RIP, 0x1008);
+    mach_timebase_info(&timebase);
+
+    /* The x86-64 PLT CFA expression emitted by the GNU toolchain */
+    static const uint8_t plt[] = { DW_OP_breg7, 0x08, DW_OP_breg16, 0x00, DW_OP_lit15, DW_OP_and, DW_OP_lit11, DW_OP_ge, DW_OP_lit3, DW_OP_shl, DW_OP_plus };
+
+    /* A register-relative save location */
+    static const uint8_t save[] = { DW_OP_breg6, 0x70, DW_OP_plus_uconst, 0x08 };
+
+    /* A branch-heavy program */
+    static const uint8_t loop[] = { DW_OP_const1u, 0xff, DW_OP_lit1, DW_OP_minus, DW_OP_dup, DW_OP_bra, 0xfa, 0xff, DW_OP_lit1, DW_OP_plus };
+
+    struct {
+        const char *name;
+        const uint8_t *opcodes;
+        size_t length;
+    } programs[] = {
+        { "PLT CFA expression", plt, sizeof(plt) },
+        { "register save expression", save, sizeof(save) },
+        { "bra loop (x255)", loop, sizeof(loop) },
+    };
+
+    for (size_t p = 0; p < sizeof(programs) / sizeof(programs[0]); p++) {
+        uint64_t result;
+        uint64_t start = mach_absolute_time();
+        for (uint32_t i = 0; i < iterations; i++) {
+            if (expression_test_eval(programs[p].opcodes, programs[p].length, &ts, &result) != PLCRASH_ESUCCESS) {
+                STFail(@"Evaluation of %s failed", programs[p].name);
+                break;
+            }
+        }
+        uint64_t elapsed = (mach_absolute_time() - start) * timebase.numer / timebase.denom;
+
+        NSLog(@"%s: %" PRIu64 "ns per evaluation", programs[p].name, elapsed / iterations);
+    }
+}
+
+
+/**
+ * Verify that LEB128 values that run off the end of the memory object are rejected, and that values terminating on
+ * the final byte are accepted.
+ */
+- (void) testLEB128SpanBounds {
+    const pl_vm_address_t base = 0x1000;
+    plcrash_async_mobject_t mobj;
+    uint64_t ulebv;
+    int64_t slebv;
+    pl_vm_size_t size;
+
+    /* Continuation bit set on the final byte */
+    static const uint8_t unterminated[] = { 0x01, 0x80, 0x80 };
+    STAssertEquals(plcrash_async_mobject_init_buffer(&mobj, unterminated, base, sizeof(unterminated)), PLCRASH_ESUCCESS, @"Failed to initialize mobj");
+    STAssertEquals(plcrash_async_dwarf_read_uleb128(&mobj, base, 1, &ulebv, &size), PLCRASH_EINVAL, @"Accepted an unterminated ULEB128");
+    STAssertEquals(plcrash_async_dwarf_read_sleb128(&mobj, base, 1, &slebv, &size), PLCRASH_EINVAL, @"Accepted an unterminated SLEB128");
+
+    /* Starting at the end of the span */
+    STAssertEquals(plcrash_async_dwarf_read_uleb128(&mobj, base, sizeof(unterminated), &ulebv, &size), PLCRASH_EINVAL, @"Accepted a ULEB128 past the end of the span");
+    plcrash_async_mobject_free(&mobj);
+
+    /* Terminated on the final byte */
+    static const uint8_t terminated[] = { 0x00, 0x80, 0x01 };
+    STAssertEquals(plcrash_async_mobject_init_buffer(&mobj, terminated, base, sizeof(terminated)), PLCRASH_ESUCCESS, @"Failed to initialize mobj");
+    STAssertEquals(plcrash_async_dwarf_read_uleb128(&mobj, base, 1, &ulebv, &size), PLCRASH_ESUCCESS, @"Failed to read ULEB128");
+    STAssertEquals(ulebv, (uint64_t) 128, @"Incorrect ULEB128 value");
+    STAssertEquals(size, (pl_vm_size_t) 2, @"Incorrect ULEB128 size");
+
+    STAssertEquals(plcrash_async_dwarf_read_sleb128(&mobj, base, 1, &slebv, &size), PLCRASH_ESUCCESS, @"Failed to read SLEB128");
+    STAssertEquals(slebv, (int64_t) 128, @"Incorrect SLEB128 value");
+    STAssertEquals(size, (pl_vm_size_t) 2, @"Incorrect SLEB128 size");
+    plcrash_async_mobject_free(&mobj);
+}
+
+/**
+ * Verify that find_fde() rejects CFI entries whose length runs past the end of the section.
+ */
+- (void) testFindFDELengthOverrun {
+    const pl_vm_address_t base = 0x1000;
+    plcrash_async_mobject_t mobj;
+    plcrash_async_dwarf_fde_info_t info;
+    dwarf_frame_reader reader;
+
+    /* An FDE (non-zero CIE pointer) declaring 0x100 bytes within a 16 byte section */
+    static const uint8_t fde[] = {
+        0x00, 0x01, 0x00, 0x00,     /* length */
+        0x04, 0x00, 0x00, 0x00,     /* CIE pointer */
+        0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00,
+    };
+
+    STAssertEquals(plcrash_async_mobject_init_buffer(&mobj, fde, base, sizeof(fde)), PLCRASH_ESUCCESS, @"Failed to initialize mobj");
+    STAssertEquals(reader.init(&mobj, plcrash_async_byteorder_little_endian(), true, false, NULL), PLCRASH_ESUCCESS, @"Failed to initialize reader");
+    STAssertEquals(reader.find_fde(0, 0x0, &info), PLCRASH_EINVAL, @"Accepted an FDE that runs past the end of the section");
+    plcrash_async_mobject_free(&mobj);
+
+    /* A skipped CIE (zero CIE id) declaring 0x100 bytes must also be rejected, rather than terminating the search */
+    static const uint8_t cie[] = {
+        0x00, 0x01, 0x00, 0x00,     /* length */
+        0x00, 0x00, 0x00, 0x00,     /* CIE id */
+        0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00,
+    };
+
+    STAssertEquals(plcrash_async_mobject_init_buffer(&mobj, cie, base, sizeof(cie)), PLCRASH_ESUCCESS, @"Failed to initialize mobj");
+    STAssertEquals(reader.init(&mobj, plcrash_async_byteorder_little_endian(), true, false, NULL), PLCRASH_ESUCCESS, @"Failed to initialize reader");
+    STAssertEquals(reader.find_fde(0, 0x0, &info), PLCRASH_EINVAL, @"Accepted a CIE that runs past the end of the section");
+    plcrash_async_mobject_free(&mobj);
+}
+
+/**
+ * Verify that DW_EH_PE_indirect pointers are resolved against a memory object that is not backed by a task, and that
+ * targets outside of the memory object are rejected.
+ */
+- (void) testIndirectPointerNonTaskMObject {
+    const pl_vm_address_t base = 0x1000;
+    plcrash_async_mobject_t mobj;
+    gnu_ehptr_reader<uint64_t> reader(plcrash_async_byteorder_little_endian());
+    const DW_EH_PE_t encoding = (DW_EH_PE_t) (DW_EH_PE_indirect | DW_EH_PE_absptr);
+    uint64_t result;
+    size_t size;
+
+    static const uint8_t data[] = {
+        0x10, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,     /* 0x1000: pointer to 0x1010 */
+        0x00, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,     /* 0x1008: pointer to 0x2000, outside of the mobj */
+        0xef, 0xbe, 0xad, 0xde, 0x00, 0x00, 0x00, 0x00,     /* 0x1010: target value */
+    };
+
+    STAssertEquals(plcrash_async_mobject_init_buffer(&mobj, data, base, sizeof(data)), PLCRASH_ESUCCESS, @"Failed to initialize mobj");
+    STAssertEquals(plcrash_async_mobject_task(&mobj), (task_t) MACH_PORT_NULL, @"Buffer mobj should not be task-backed");
+
+    STAssertEquals(reader.read(&mobj, base, 0, encoding, &result, &size), PLCRASH_ESUCCESS, @"Failed to read indirect pointer");
+    STAssertEquals(result, (uint64_t) 0xdeadbeef, @"Incorrect indirect target value");
+    STAssertEquals(size, (size_t) 8, @"Size should cover the encoded pointer, not the indirect target");
+
+    STAssertTrue(reader.read(&mobj, base, 8, encoding, &result, &size) != PLCRASH_ESUCCESS, @"Accepted an indirect target outside of the mobj");
+    plcrash_async_mobject_free(&mobj);
+}
+
+@end
+
+#endif /* PLCRASH_FEATURE_UNWIND_DWARF */
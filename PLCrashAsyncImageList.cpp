@@ -29,10 +29,19 @@
 #include "PLCrashAsync.h"
 #include "PLCrashAsyncImageList.h"
 #include "PLCrashAsyncLinkedList.hpp"
+#include "PLCrashAsyncDwarfCIE.hpp"
+#include "PLCrashAsyncCompactUnwindEncoding.h"
+
+#include "PLCrashFeatureConfig.h"
 
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <dlfcn.h>
+#include <mach-o/dyld_images.h>
 
 using namespace plcrash::async;
 
@@ -47,9 +56,16 @@ using namespace plcrash::async;
  * Atomic compare and swap is used to ensure a consistent view of the list for readers. To simplify implementation, a
  * write mutex is held for all updates; the implementation is not designed for efficiency in the face of contention
  * between readers and writers, and it's assumed that no contention should realistically occur.
+ *
+ * Images may also be registered via plcrash_nasync_image_list_append_deferred(), in which case only the image's
+ * header address is recorded; the image's Mach-O data is parsed later via plcrash_nasync_image_list_init_pending(),
+ * or on demand by async-safe readers of the list.
  * @{
  */
 
+/** Name used for images initialized on demand for which no path could be found. */
+static const char *plcrash_async_image_unknown_name = "???";
+
 
 /**
  * Initialize a new binary image list and issue a memory barrier
@@ -63,6 +79,12 @@ void plcrash_nasync_image_list_init (plcrash_async_image_list_t *list, mach_port
     memset(list, 0, sizeof(*list));
 
     list->_list = new async_list<plcrash_async_image_t *>();
+#if PLCRASH_FEATURE_UNWIND_DWARF
+    list->_dwarf_cie_cache = new dwarf_cie_cache();
+#endif
+#if PLCRASH_FEATURE_UNWIND_COMPACT
+    list->_cfe_page_cache = (plcrash_async_cfe_page_cache_t *) calloc(1, sizeof(plcrash_async_cfe_page_cache_t));
+#endif
     list->task = task;
     mach_port_mod_refs(mach_task_self(), list->task, MACH_PORT_RIGHT_SEND, 1);
 }
@@ -80,7 +102,12 @@ void plcrash_nasync_image_list_free (plcrash_async_image_list_t *list) {
         plcrash_async_image_t *image = next->value();
         
         /* Deallocate the Mach-O reference. */
-        plcrash_nasync_macho_free(&image->macho_image);
+        if (image->state == PLCRASH_ASYNC_IMAGE_STATE_READY)
+            plcrash_nasync_macho_free(&image->macho_image);
+
+        /* Deallocate the pre-encoded record, if any */
+        if (image->report_record.data != NULL)
+            free(image->report_record.data);
         
         /* Deallocate the actual image value */
         free(image);
@@ -89,6 +116,13 @@ void plcrash_nasync_image_list_free (plcrash_async_image_list_t *list) {
 
     /* Free the backing list */
     delete list->_list;
+
+#if PLCRASH_FEATURE_UNWIND_DWARF
+    delete list->_dwarf_cie_cache;
+#endif
+#if PLCRASH_FEATURE_UNWIND_COMPACT
+    free(list->_cfe_page_cache);
+#endif
     
     mach_port_mod_refs(mach_task_self(), list->task, MACH_PORT_RIGHT_SEND, -1);
 }
@@ -100,9 +134,12 @@ void plcrash_nasync_image_list_free (plcrash_async_image_list_t *list) {
  * @param header The image's header address.
  * @param name The image's name.
  *
+ * @return Returns the newly appended image record, or NULL if the image could not be initialized. The record
+ * remains owned by @a list.
+ *
  * @warning This method is not async safe.
  */
-void plcrash_nasync_image_list_append (plcrash_async_image_list_t *list, pl_vm_address_t header, const char *name) {
+plcrash_async_image_t *plcrash_nasync_image_list_append (plcrash_async_image_list_t *list, pl_vm_address_t header, const char *name) {
     plcrash_error_t ret;
 
     /* Initialize the new entry. */
@@ -110,11 +147,436 @@ void plcrash_nasync_image_list_append (plcrash_async_image_list_t *list, pl_vm_a
     if ((ret = plcrash_nasync_macho_init(&new_entry->macho_image, list->task, name, header)) != PLCRASH_ESUCCESS) {
         PLCF_DEBUG("Unexpected failure initializing Mach-O structure for %s: %d", name, ret);
         free(new_entry);
-        return;
+        return NULL;
     }
 
+    new_entry->state = PLCRASH_ASYNC_IMAGE_STATE_READY;
+
+    /* Assign the image's index; this must be visible prior to the image being appended */
+    new_entry->index = (uint32_t) (OSAtomicIncrement32Barrier(&list->_next_index) - 1);
+
+    /* Append */
+    list->_list->nasync_append(new_entry);
+    return new_entry;
+}
+
+/**
+ * Append a new binary image record to @a list, deferring parsing of the image's Mach-O data. The image will be
+ * initialized by a later call to plcrash_nasync_image_list_init_pending(), or on demand when first returned
+ * by plcrash_async_image_list_next().
+ *
+ * This avoids the cost of mapping and parsing the image at registration time, which is otherwise paid for every
+ * image loaded at launch.
+ *
+ * @param list The list to which the image record should be appended.
+ * @param header The image's header address.
+ *
+ * @return Returns the newly appended image record, or NULL if the record could not be allocated. The record
+ * remains owned by @a list.
+ *
+ * @warning This method is not async safe.
+ */
+plcrash_async_image_t *plcrash_nasync_image_list_append_deferred (plcrash_async_image_list_t *list, pl_vm_address_t header) {
+    plcrash_async_image_t *new_entry = (plcrash_async_image_t *) calloc(1, sizeof(plcrash_async_image_t));
+    if (new_entry == NULL)
+        return NULL;
+
+    new_entry->macho_image.header_addr = header;
+    new_entry->state = PLCRASH_ASYNC_IMAGE_STATE_PENDING;
+
+    /* Assign the image's index; this must be visible prior to the image being appended */
+    new_entry->index = (uint32_t) (OSAtomicIncrement32Barrier(&list->_next_index) - 1);
+
     /* Append */
     list->_list->nasync_append(new_entry);
+    return new_entry;
+}
+
+/**
+ * Initialize up to @a max_count images registered via plcrash_nasync_image_list_append_deferred() that have
+ * not yet been initialized. Image names are resolved via dladdr().
+ *
+ * @param list The list to be initialized.
+ * @param max_count The maximum number of images to initialize.
+ * @param callback If non-NULL, the callback to be invoked for each successfully initialized image. The callback
+ * may attach a pre-encoded report record via plcrash_nasync_image_set_report_record().
+ * @param context The context to be supplied to @a callback.
+ *
+ * @return Returns the number of pending images that were processed, including any images that could not be
+ * initialized. A return value less than @a max_count indicates that no further pending images were found.
+ *
+ * @warning This method is not async safe.
+ */
+size_t plcrash_nasync_image_list_init_pending (plcrash_async_image_list_t *list, size_t max_count, plcrash_nasync_image_init_cb callback, void *context) {
+    size_t count = 0;
+
+    list->_list->set_reading(true); {
+        async_list<plcrash_async_image_t *>::node *next = NULL;
+        while (count < max_count && (next = list->_list->next(next)) != NULL) {
+            plcrash_async_image_t *image = next->value();
+
+            /* Claim the image; it may have already been claimed by an async-safe reader. */
+            if (!OSAtomicCompareAndSwap32Barrier(PLCRASH_ASYNC_IMAGE_STATE_PENDING, PLCRASH_ASYNC_IMAGE_STATE_INITIALIZING, &image->state))
+                continue;
+
+            count++;
+
+            /* Look up the image name */
+            pl_vm_address_t header = image->macho_image.header_addr;
+            Dl_info info;
+            if (dladdr((const void *) header, &info) == 0 || info.dli_fname == NULL) {
+                PLCF_DEBUG("dladdr(0x%" PRIx64 ", ...) failed", (uint64_t) header);
+                OSAtomicCompareAndSwap32Barrier(PLCRASH_ASYNC_IMAGE_STATE_INITIALIZING, PLCRASH_ASYNC_IMAGE_STATE_FAILED, &image->state);
+                continue;
+            }
+
+            /* The image is parsed into separate storage; an async-safe reader may claim the image from us while we're
+             * initializing it (see plcrash_async_image_list_ensure_ready()), in which case we must not write to it. */
+            plcrash_async_macho_t macho_image;
+            plcrash_error_t ret;
+            if ((ret = plcrash_nasync_macho_init(&macho_image, list->task, info.dli_fname, header)) != PLCRASH_ESUCCESS) {
+                PLCF_DEBUG("Unexpected failure initializing Mach-O structure for %s: %d", info.dli_fname, ret);
+                OSAtomicCompareAndSwap32Barrier(PLCRASH_ASYNC_IMAGE_STATE_INITIALIZING, PLCRASH_ASYNC_IMAGE_STATE_FAILED, &image->state);
+                continue;
+            }
+
+            if (!OSAtomicCompareAndSwap32Barrier(PLCRASH_ASYNC_IMAGE_STATE_INITIALIZING, PLCRASH_ASYNC_IMAGE_STATE_PUBLISHING, &image->state)) {
+                /* Initialized by an async-safe reader */
+                plcrash_nasync_macho_free(&macho_image);
+                continue;
+            }
+
+            /* Publish the initialized image */
+            image->macho_image = macho_image;
+            OSAtomicCompareAndSwap32Barrier(PLCRASH_ASYNC_IMAGE_STATE_PUBLISHING, PLCRASH_ASYNC_IMAGE_STATE_READY, &image->state);
+
+            if (callback != NULL)
+                callback(image, context);
+        }
+    } list->_list->set_reading(false);
+
+    return count;
+}
+
+/**
+ * Append records for all binary images currently loaded in the list's task, as reported by the task's
+ * dyld_all_image_infos. This may be used to populate an image list for a task other than the current task, such
+ * as when generating reports out-of-process.
+ *
+ * @param list The list to which the image records should be appended.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or an error if the task's image information could not be read. Only
+ * tasks with the same pointer size as the current process are supported; PLCRASH_ENOTSUP will be returned for
+ * any other task. Images that could not be initialized are skipped.
+ *
+ * @warning This method is not async safe.
+ */
+plcrash_error_t plcrash_nasync_image_list_append_task_images (plcrash_async_image_list_t *list) {
+    struct task_dyld_info dyld_info;
+    mach_msg_type_number_t count = TASK_DYLD_INFO_COUNT;
+    kern_return_t kt;
+
+    if ((kt = task_info(list->task, TASK_DYLD_INFO, (task_info_t) &dyld_info, &count)) != KERN_SUCCESS) {
+        PLCF_DEBUG("Fetching the task's dyld info failed: %d", kt);
+        return PLCRASH_EINTERNAL;
+    }
+
+#ifdef __LP64__
+    if (dyld_info.all_image_info_format != TASK_DYLD_ALL_IMAGE_INFO_64) {
+#else
+    if (dyld_info.all_image_info_format != TASK_DYLD_ALL_IMAGE_INFO_32) {
+#endif
+        PLCF_DEBUG("Unsupported dyld_all_image_infos format %d", (int) dyld_info.all_image_info_format);
+        return PLCRASH_ENOTSUP;
+    }
+
+    /* Only the leading version, count, and array fields are required */
+    struct dyld_all_image_infos infos;
+    size_t infos_len = offsetof(struct dyld_all_image_infos, infoArray) + sizeof(infos.infoArray);
+    if ((kt = plcrash_async_read_addr(list->task, (pl_vm_address_t) dyld_info.all_image_info_addr, &infos, infos_len)) != KERN_SUCCESS) {
+        PLCF_DEBUG("Reading dyld_all_image_infos failed: %d", kt);
+        return PLCRASH_EINTERNAL;
+    }
+
+    /* The array is NULL while dyld is modifying it */
+    if (infos.infoArray == NULL) {
+        PLCF_DEBUG("The dyld image array is being modified");
+        return PLCRASH_EINTERNAL;
+    }
+
+    for (uint32_t i = 0; i < infos.infoArrayCount; i++) {
+        struct dyld_image_info info;
+        char path[PATH_MAX];
+
+        if ((kt = plcrash_async_read_addr(list->task, (pl_vm_address_t) &infos.infoArray[i], &info, sizeof(info))) != KERN_SUCCESS) {
+            PLCF_DEBUG("Reading dyld image info %" PRIu32 " failed: %d", i, kt);
+            return PLCRASH_EINTERNAL;
+        }
+
+        /* Read the path a page at a time, as the string may terminate at the end of a mapping */
+        pl_vm_address_t path_addr = (pl_vm_address_t) info.imageFilePath;
+        size_t len = 0;
+        bool terminated = false;
+        while (!terminated && len < sizeof(path) - 1) {
+            size_t chunk = vm_page_size - ((path_addr + len) % vm_page_size);
+            if (chunk > sizeof(path) - 1 - len)
+                chunk = sizeof(path) - 1 - len;
+
+            if (plcrash_async_read_addr(list->task, path_addr + len, &path[len], chunk) != KERN_SUCCESS)
+                break;
+
+            for (size_t end = len + chunk; len < end; len++) {
+                if (path[len] == '\0') {
+                    terminated = true;
+                    break;
+                }
+            }
+        }
+        path[len] = '\0';
+
+        plcrash_nasync_image_list_append(list, (pl_vm_address_t) info.imageLoadAddress, len > 0 ? path : plcrash_async_image_unknown_name);
+    }
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ *
+ * Read the leading version, count, and array fields of the current task's dyld_all_image_infos into @a infos.
+ * This is only supported for the current task, as the image paths must be readable in-process.
+ * This method is async-safe.
+ *
+ * @return Returns true on success, or false if the image information is not available.
+ */
+static bool plcrash_async_image_list_read_dyld_infos (plcrash_async_image_list_t *list, struct dyld_all_image_infos *infos) {
+    if (list->task != mach_task_self())
+        return false;
+
+    struct task_dyld_info dyld_info;
+    mach_msg_type_number_t count = TASK_DYLD_INFO_COUNT;
+    if (task_info(list->task, TASK_DYLD_INFO, (task_info_t) &dyld_info, &count) != KERN_SUCCESS)
+        return false;
+
+    size_t infos_len = offsetof(struct dyld_all_image_infos, infoArray) + sizeof(infos->infoArray);
+    if (plcrash_async_read_addr(list->task, (pl_vm_address_t) dyld_info.all_image_info_addr, infos, infos_len) != KERN_SUCCESS)
+        return false;
+
+    /* The array is NULL while dyld is modifying it */
+    if (infos->infoArray == NULL)
+        return false;
+
+    return true;
+}
+
+/**
+ * @internal
+ *
+ * Look up the path of the image loaded at @a header via the task's dyld_all_image_infos, returning a borrowed
+ * reference to dyld's copy of the path, or NULL if the image is not found. This reads the task's image array, and
+ * should only be used to name images not found in a plcrash_async_image_paths_t snapshot. This method is async-safe.
+ */
+static const char *plcrash_async_image_list_dyld_path (plcrash_async_image_list_t *list, pl_vm_address_t header) {
+    struct dyld_all_image_infos infos;
+    if (!plcrash_async_image_list_read_dyld_infos(list, &infos))
+        return NULL;
+
+    for (uint32_t i = 0; i < infos.infoArrayCount; i++) {
+        struct dyld_image_info info;
+        if (plcrash_async_read_addr(list->task, (pl_vm_address_t) &infos.infoArray[i], &info, sizeof(info)) != KERN_SUCCESS)
+            return NULL;
+
+        if ((pl_vm_address_t) info.imageLoadAddress == header)
+            return info.imageFilePath;
+    }
+
+    return NULL;
+}
+
+/**
+ * Initialize an empty image path snapshot, preallocating storage for @a capacity images.
+ *
+ * @param paths The snapshot to be initialized.
+ * @param capacity The maximum number of image paths to be recorded by plcrash_async_image_paths_read().
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_ENOMEM if the storage could not be allocated. On failure,
+ * @a paths is left initialized with a capacity of 0, and may still be used and freed.
+ *
+ * @warning This method is not async safe.
+ */
+plcrash_error_t plcrash_nasync_image_paths_init (plcrash_async_image_paths_t *paths, uint32_t capacity) {
+    memset(paths, 0, sizeof(*paths));
+
+    paths->infos = (struct dyld_image_info *) calloc(capacity, sizeof(paths->infos[0]));
+    if (paths->infos == NULL)
+        return PLCRASH_ENOMEM;
+
+    paths->capacity = capacity;
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ *
+ * Return true if any image in @a list has not yet been initialized. This method is async-safe.
+ */
+static bool plcrash_async_image_list_has_pending (plcrash_async_image_list_t *list) {
+    bool pending = false;
+
+    list->_list->set_reading(true); {
+        async_list<plcrash_async_image_t *>::node *node = NULL;
+        while ((node = list->_list->next(node)) != NULL) {
+            int32_t state = node->value()->state;
+            if (state == PLCRASH_ASYNC_IMAGE_STATE_PENDING || state == PLCRASH_ASYNC_IMAGE_STATE_INITIALIZING) {
+                pending = true;
+                break;
+            }
+        }
+    } list->_list->set_reading(false);
+
+    return pending;
+}
+
+/**
+ * Replace the contents of @a paths with the image paths currently registered with dyld in @a list's task, reading
+ * the task's dyld_all_image_infos once. If the image information is not available (including for any task other
+ * than the current task), the snapshot is left empty, and images are instead named by individual lookups. This
+ * method is async-safe.
+ *
+ * If every image in @a list has already been initialized, no paths are required, and the task's image information
+ * is not read.
+ *
+ * @param paths The snapshot to be populated.
+ * @param list The image list for which the snapshot will be used.
+ */
+void plcrash_async_image_paths_read (plcrash_async_image_paths_t *paths, plcrash_async_image_list_t *list) {
+    struct dyld_all_image_infos infos;
+
+    paths->count = 0;
+    paths->hint = 0;
+
+    if (paths->capacity == 0 || !plcrash_async_image_list_has_pending(list))
+        return;
+
+    if (!plcrash_async_image_list_read_dyld_infos(list, &infos))
+        return;
+
+    uint32_t count = infos.infoArrayCount;
+    if (count > paths->capacity) {
+        PLCF_DEBUG("Recording %" PRIu32 " of %" PRIu32 " dyld image paths", paths->capacity, count);
+        count = paths->capacity;
+    }
+
+    if (plcrash_async_read_addr(list->task, (pl_vm_address_t) infos.infoArray, paths->infos, count * sizeof(paths->infos[0])) != KERN_SUCCESS) {
+        PLCF_DEBUG("Reading the dyld image array failed");
+        return;
+    }
+
+    paths->count = count;
+}
+
+/**
+ * Free all resources associated with @a paths.
+ *
+ * @warning This method is not async safe.
+ */
+void plcrash_nasync_image_paths_free (plcrash_async_image_paths_t *paths) {
+    if (paths->infos != NULL)
+        free(paths->infos);
+}
+
+/**
+ * @internal
+ *
+ * Return a borrowed reference to the dyld path of the image loaded at @a header, or NULL if the image is not
+ * found in @a paths. This method is async-safe.
+ */
+static const char *plcrash_async_image_paths_find (plcrash_async_image_paths_t *paths, pl_vm_address_t header) {
+    for (uint32_t n = 0; n < paths->count; n++) {
+        uint32_t i = (paths->hint + n) % paths->count;
+        if ((pl_vm_address_t) paths->infos[i].imageLoadAddress == header) {
+            paths->hint = i + 1;
+            return paths->infos[i].imageFilePath;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @internal
+ *
+ * Return true if @a image is fully initialized, initializing a pending image if necessary. Images that failed
+ * initialization, or that are being published or initialized by another async-safe reader, are not available.
+ * This method is async-safe.
+ *
+ * Images that plcrash_nasync_image_list_init_pending() is still initializing are claimed and initialized in place;
+ * that function parses images into separate storage, and discards its result if the image has been claimed. This
+ * ensures that an image is not dropped from a report if the initializing thread was interrupted by the crash.
+ *
+ * @param list The image's list.
+ * @param image The image to be initialized.
+ * @param paths If non-NULL, a snapshot from which the image's path will be fetched. If NULL, or if the image is
+ * not found in the snapshot, the path is looked up via the task's dyld_all_image_infos.
+ */
+static bool plcrash_async_image_list_ensure_ready (plcrash_async_image_list_t *list, plcrash_async_image_t *image, plcrash_async_image_paths_t *paths) {
+    /* Claim the image */
+    while (true) {
+        int32_t state = image->state;
+        if (state == PLCRASH_ASYNC_IMAGE_STATE_READY) {
+            /* Ensure that the image's initialized contents are visible */
+            OSMemoryBarrier();
+            return true;
+        }
+
+        if (state != PLCRASH_ASYNC_IMAGE_STATE_PENDING && state != PLCRASH_ASYNC_IMAGE_STATE_INITIALIZING)
+            return false;
+
+        if (OSAtomicCompareAndSwap32Barrier(state, PLCRASH_ASYNC_IMAGE_STATE_INITIALIZING_INLINE, &image->state))
+            break;
+    }
+
+    pl_vm_address_t header = image->macho_image.header_addr;
+    const char *name = NULL;
+    if (paths != NULL)
+        name = plcrash_async_image_paths_find(paths, header);
+
+    if (name == NULL)
+        name = plcrash_async_image_list_dyld_path(list, header);
+
+    if (name == NULL)
+        name = plcrash_async_image_unknown_name;
+
+    plcrash_error_t ret;
+    if ((ret = plcrash_async_macho_init(&image->macho_image, list->task, name, header)) != PLCRASH_ESUCCESS) {
+        PLCF_DEBUG("Unexpected failure initializing Mach-O structure for %s: %d", name, ret);
+        OSAtomicCompareAndSwap32Barrier(PLCRASH_ASYNC_IMAGE_STATE_INITIALIZING_INLINE, PLCRASH_ASYNC_IMAGE_STATE_FAILED, &image->state);
+        return false;
+    }
+
+    OSAtomicCompareAndSwap32Barrier(PLCRASH_ASYNC_IMAGE_STATE_INITIALIZING_INLINE, PLCRASH_ASYNC_IMAGE_STATE_READY, &image->state);
+    return true;
+}
+
+/**
+ * Attach a pre-encoded crash report record to @a image. Once set, the record is visible to async-safe
+ * readers of the image's list, and may be written directly rather than being encoded at crash time.
+ *
+ * @param image The image to which the record should be attached. A record must not already be set.
+ * @param data The encoded record. Ownership of this malloc()-allocated buffer is transfered to @a image.
+ * @param length The length of @a data, in bytes.
+ *
+ * @warning This method is not async safe.
+ */
+void plcrash_nasync_image_set_report_record (plcrash_async_image_t *image, void *data, size_t length) {
+    /* The length must be visible to readers prior to the data pointer */
+    image->report_record.length = length;
+    OSMemoryBarrier();
+
+    if (!OSAtomicCompareAndSwapPtrBarrier(NULL, data, (void * volatile *) &image->report_record.data)) {
+        PLCF_DEBUG("Attempted to replace an existing image report record");
+        free(data);
+    }
 }
 
 /**
@@ -146,6 +608,15 @@ void plcrash_nasync_image_list_remove (plcrash_async_image_list_t *list, pl_vm_a
 
         /* Delete the entry */
         list->_list->nasync_remove_node(found);
+
+#if PLCRASH_FEATURE_UNWIND_DWARF
+        /* A new image may be loaded at the removed image's address; discard any records parsed from the removed image. */
+        list->_dwarf_cie_cache->nasync_invalidate();
+#endif
+#if PLCRASH_FEATURE_UNWIND_COMPACT
+        if (list->_cfe_page_cache != NULL)
+            plcrash_nasync_cfe_page_cache_invalidate(list->_cfe_page_cache);
+#endif
     } list->_list->set_reading(false);
 }
 
@@ -171,12 +642,33 @@ void plcrash_async_image_list_set_reading (plcrash_async_image_list_t *list, boo
  * @warning The list must be retained for reading via plcrash_async_image_list_set_reading() before calling this function.
  */
 plcrash_async_image_t *plcrash_async_image_containing_address (plcrash_async_image_list_t *list, pl_vm_address_t address) {
-    plcrash_async_image_t *image = NULL;
-    while ((image = plcrash_async_image_list_next(list, image)) != NULL) {
-        if (plcrash_async_macho_contains_address(&image->macho_image, address))
-            return image;
+    plcrash_async_image_t *candidate = NULL;
+
+    async_list<plcrash_async_image_t *>::node *node = NULL;
+    while ((node = list->_list->next(node)) != NULL) {
+        plcrash_async_image_t *image = node->value();
+        OSAtomicCompareAndSwapPtrBarrier(NULL, (void *) node, (void * volatile *) &image->_node);
+
+        if (image->state == PLCRASH_ASYNC_IMAGE_STATE_READY) {
+            /* Ensure that the image's initialized contents are visible */
+            OSMemoryBarrier();
+            if (plcrash_async_macho_contains_address(&image->macho_image, address))
+                return image;
+
+            continue;
+        }
+
+        /* An image's __TEXT segment starts at its header, and images do not overlap; of the images that have not been
+         * initialized, only the image with the greatest header address at or below @a address may contain it. */
+        pl_vm_address_t header = image->macho_image.header_addr;
+        if (header <= address && (candidate == NULL || header > candidate->macho_image.header_addr))
+            candidate = image;
     }
 
+    /* Initialize only the candidate image */
+    if (candidate != NULL && plcrash_async_image_list_ensure_ready(list, candidate, NULL) && plcrash_async_macho_contains_address(&candidate->macho_image, address))
+        return candidate;
+
     /* Not found */
     return NULL;
 }
@@ -184,12 +676,31 @@ plcrash_async_image_t *plcrash_async_image_containing_address (plcrash_async_ima
 /**
  * Return the next image record. This method is async-safe. If no additional images are available, will return NULL;
  *
+ * Images registered via plcrash_nasync_image_list_append_deferred() that have not yet been initialized will be
+ * initialized on demand; images that are unavailable are skipped.
+ *
  * @param list The list to be iterated.
  * @param current The current image record, or NULL to start iteration.
  *
  * @warning The list must be retained for reading via plcrash_async_image_list_set_reading() before calling this function.
  */
 plcrash_async_image_t *plcrash_async_image_list_next (plcrash_async_image_list_t *list, plcrash_async_image_t *current) {
+    return plcrash_async_image_list_next_with_paths(list, current, NULL);
+}
+
+/**
+ * Return the next image record, naming any pending images initialized on demand via @a paths. This method is
+ * async-safe. If no additional images are available, will return NULL.
+ *
+ * When iterating the complete list, this avoids reading the task's dyld_all_image_infos once for every pending image.
+ *
+ * @param list The list to be iterated.
+ * @param current The current image record, or NULL to start iteration.
+ * @param paths A snapshot populated via plcrash_async_image_paths_read(), or NULL.
+ *
+ * @warning The list must be retained for reading via plcrash_async_image_list_set_reading() before calling this function.
+ */
+plcrash_async_image_t *plcrash_async_image_list_next_with_paths (plcrash_async_image_list_t *list, plcrash_async_image_t *current, plcrash_async_image_paths_t *paths) {
     /* We can assume that the caller enabled reading here; we can't gaurantee proper behavior otherwise. */
     async_list<plcrash_async_image_t *>::node *node;
 
@@ -200,15 +711,18 @@ plcrash_async_image_t *plcrash_async_image_list_next (plcrash_async_image_list_t
         node = list->_list->next(NULL);
     }
 
-    /* Handle end of list */
-    if (node == NULL)
-        return NULL;
-    
-    /* Lazily swap in the cyclic node reference. This is pessimestic, but there's really not a better time to do it. */
-    plcrash_async_image_t *image = node->value();
-    OSAtomicCompareAndSwapPtrBarrier(NULL, (void *) node, (void * volatile *) &image->_node);
+    for (; node != NULL; node = list->_list->next(node)) {
+        /* Lazily swap in the cyclic node reference. This is pessimestic, but there's really not a better time to do it. */
+        plcrash_async_image_t *image = node->value();
+        OSAtomicCompareAndSwapPtrBarrier(NULL, (void *) node, (void * volatile *) &image->_node);
+
+        /* Skip any images that are not available */
+        if (plcrash_async_image_list_ensure_ready(list, image, paths))
+            return image;
+    }
 
-    return node->value();
+    /* End of list */
+    return NULL;
 }
 
 /**
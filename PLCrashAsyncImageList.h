@@ -46,10 +46,54 @@ extern "C" {
  */
 #ifdef __cplusplus
 #include "PLCrashAsyncLinkedList.hpp"
+
+namespace plcrash { namespace async { class dwarf_cie_cache; }}
 #endif
+
+struct plcrash_async_cfe_page_cache;
+struct dyld_image_info;
     
 typedef struct plcrash_async_image plcrash_async_image_t;
 
+/**
+ * @internal
+ * @ingroup plcrash_async_image
+ *
+ * Binary image initialization state.
+ */
+typedef enum {
+    /** The image has been registered via plcrash_nasync_image_list_append_deferred(), but its Mach-O data has not
+     * yet been parsed. */
+    PLCRASH_ASYNC_IMAGE_STATE_PENDING = 0,
+
+    /** The image is being initialized. */
+    PLCRASH_ASYNC_IMAGE_STATE_INITIALIZING = 1,
+
+    /** The image has been fully initialized. */
+    PLCRASH_ASYNC_IMAGE_STATE_READY = 2,
+
+    /** Initialization of the image failed; the image will not be returned by the list. */
+    PLCRASH_ASYNC_IMAGE_STATE_FAILED = 3,
+
+    /** The image's Mach-O data has been parsed by plcrash_nasync_image_list_init_pending(), and is being copied
+     * into the image. */
+    PLCRASH_ASYNC_IMAGE_STATE_PUBLISHING = 4,
+
+    /** The image is being initialized in place by an async-safe reader. */
+    PLCRASH_ASYNC_IMAGE_STATE_INITIALIZING_INLINE = 5
+} plcrash_async_image_state_t;
+
+/**
+ * @internal
+ * @ingroup plcrash_async_image
+ *
+ * Callback issued by plcrash_nasync_image_list_init_pending() for each newly initialized image.
+ *
+ * @param image The initialized image.
+ * @param context The context supplied to plcrash_nasync_image_list_init_pending().
+ */
+typedef void (*plcrash_nasync_image_init_cb)(plcrash_async_image_t *image, void *context);
+
 /**
  * @internal
  * @ingroup plcrash_async_image
@@ -57,9 +101,30 @@ typedef struct plcrash_async_image plcrash_async_image_t;
  * Async-safe binary image list element.
  */
 struct plcrash_async_image {
-    /** The binary image. */
+    /** The binary image. Only the header address is valid prior to the image reaching
+     * PLCRASH_ASYNC_IMAGE_STATE_READY. */
     plcrash_async_macho_t macho_image;
 
+    /** The image's plcrash_async_image_state_t initialization state. */
+    volatile int32_t state;
+
+    /** The image's position within its list, in order of insertion. Indices are never reused, and may be used to
+     * track per-image state in a compact bitset. */
+    uint32_t index;
+
+    /**
+     * The image's pre-encoded crash report record, or a NULL @a data pointer if not yet available. Set via
+     * plcrash_nasync_image_set_report_record(); the data is owned by the image, and will be released when the
+     * image list is freed.
+     */
+    struct {
+        /** The encoded record. */
+        void *data;
+
+        /** The length of @a data, in bytes. */
+        size_t length;
+    } report_record;
+
     /** A borrowed, circular reference to the backing list node. */
 #ifdef __cplusplus
     plcrash::async::async_list<plcrash_async_image_t *>::node *_node;
@@ -85,17 +150,62 @@ typedef struct plcrash_async_image_list {
 #else
     void *_list;
 #endif
+
+    /** Parsed DWARF CIE records shared by all images in the list, or NULL if DWARF unwinding is not supported. */
+#ifdef __cplusplus
+    plcrash::async::dwarf_cie_cache *_dwarf_cie_cache;
+#else
+    void *_dwarf_cie_cache;
+#endif
+
+    /** Decoded compact unwind pages shared by all images in the list, or NULL if compact unwinding is not supported. */
+    struct plcrash_async_cfe_page_cache *_cfe_page_cache;
+
+    /** The index to be assigned to the next appended image. */
+    volatile int32_t _next_index;
 } plcrash_async_image_list_t;
 
+/**
+ * @internal
+ * @ingroup plcrash_async_image
+ *
+ * A snapshot of the image paths registered with dyld, used to name deferred images initialized at crash time
+ * without re-reading the task's dyld_all_image_infos for each image.
+ */
+typedef struct plcrash_async_image_paths {
+    /** Preallocated dyld image info storage. */
+    struct dyld_image_info *infos;
+
+    /** The total number of entries available in @a infos. */
+    uint32_t capacity;
+
+    /** The number of valid entries in @a infos. */
+    uint32_t count;
+
+    /** The entry following the most recent match. Images are generally looked up in dyld's load order, and
+     * searches start here. */
+    uint32_t hint;
+} plcrash_async_image_paths_t;
+
+plcrash_error_t plcrash_nasync_image_paths_init (plcrash_async_image_paths_t *paths, uint32_t capacity);
+void plcrash_async_image_paths_read (plcrash_async_image_paths_t *paths, plcrash_async_image_list_t *list);
+void plcrash_nasync_image_paths_free (plcrash_async_image_paths_t *paths);
+
 void plcrash_nasync_image_list_init (plcrash_async_image_list_t *list, mach_port_t task);
 void plcrash_nasync_image_list_free (plcrash_async_image_list_t *list);
-void plcrash_nasync_image_list_append (plcrash_async_image_list_t *list, pl_vm_address_t header, const char *name);
+plcrash_async_image_t *plcrash_nasync_image_list_append (plcrash_async_image_list_t *list, pl_vm_address_t header, const char *name);
+plcrash_async_image_t *plcrash_nasync_image_list_append_deferred (plcrash_async_image_list_t *list, pl_vm_address_t header);
+size_t plcrash_nasync_image_list_init_pending (plcrash_async_image_list_t *list, size_t max_count, plcrash_nasync_image_init_cb callback, void *context);
+plcrash_error_t plcrash_nasync_image_list_append_task_images (plcrash_async_image_list_t *list);
 void plcrash_nasync_image_list_remove (plcrash_async_image_list_t *list, pl_vm_address_t header);
 
+void plcrash_nasync_image_set_report_record (plcrash_async_image_t *image, void *data, size_t length);
+
 void plcrash_async_image_list_set_reading (plcrash_async_image_list_t *list, bool enable);
 
 plcrash_async_image_t *plcrash_async_image_containing_address (plcrash_async_image_list_t *list, pl_vm_address_t address);
 plcrash_async_image_t *plcrash_async_image_list_next (plcrash_async_image_list_t *list, plcrash_async_image_t *current);
+plcrash_async_image_t *plcrash_async_image_list_next_with_paths (plcrash_async_image_list_t *list, plcrash_async_image_t *current, plcrash_async_image_paths_t *paths);
     
 #ifdef __cplusplus
 }
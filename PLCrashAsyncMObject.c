@@ -30,6 +30,10 @@
 
 #import <stdint.h>
 #import <inttypes.h>
+#import <errno.h>
+#import <unistd.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
 
 /**
  * @internal
@@ -283,6 +287,130 @@ plcrash_error_t plcrash_async_mobject_init (plcrash_async_mobject_t *mobj, mach_
     mobj->task = task;
     mach_port_mod_refs(mach_task_self(), mobj->task, MACH_PORT_RIGHT_SEND, 1);
 
+    mobj->source = PLCRASH_ASYNC_MOBJECT_SOURCE_TASK;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Initialize a new memory object referencing @a length bytes at @a address within the current process. No pages
+ * are remapped; reads are performed directly against @a address.
+ *
+ * Unlike plcrash_async_mobject_init(), the availability of the referenced pages is not verified, nor is the
+ * memory protected against concurrent modification. This must only be used for memory that is known to remain
+ * mapped and unmodified for the lifetime of the memory object, such as the mapped segments of a loaded image.
+ *
+ * @param mobj Memory object to be initialized.
+ * @param address The address of the memory to be referenced.
+ * @param length The number of bytes to be referenced.
+ *
+ * @return On success, returns PLCRASH_ESUCCESS. Returns PLCRASH_EINVAL if the range overflows the address space.
+ */
+plcrash_error_t plcrash_async_mobject_init_local (plcrash_async_mobject_t *mobj, pl_vm_address_t address, pl_vm_size_t length) {
+    if ((uintptr_t) address != address || UINTPTR_MAX - address < length)
+        return PLCRASH_EINVAL;
+
+    mobj->source = PLCRASH_ASYNC_MOBJECT_SOURCE_LOCAL;
+    mobj->task = mach_task_self();
+    mobj->address = (uintptr_t) address;
+    mobj->task_address = address;
+    mobj->length = length;
+    mobj->vm_slide = 0;
+    mobj->vm_address = address;
+    mobj->vm_length = length;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Initialize a new memory object over a caller-owned buffer containing a copy of @a length bytes of target memory
+ * originally located at @a task_addr, such as a captured memory snapshot. Reads are performed directly against
+ * @a buffer, using @a task_addr-relative addresses.
+ *
+ * The memory object is not backed by a task; plcrash_async_mobject_task() will return MACH_PORT_NULL, and any
+ * reads that fall outside of @a buffer will fail.
+ *
+ * @param mobj Memory object to be initialized.
+ * @param buffer The buffer containing the target memory. This buffer must remain valid for the lifetime of the
+ * memory object.
+ * @param task_addr The target address corresponding to the start of @a buffer.
+ * @param length The size of @a buffer, in bytes.
+ *
+ * @return On success, returns PLCRASH_ESUCCESS. Returns PLCRASH_EINVAL if either range overflows its address space.
+ */
+plcrash_error_t plcrash_async_mobject_init_buffer (plcrash_async_mobject_t *mobj, const void *buffer, pl_vm_address_t task_addr, pl_vm_size_t length) {
+    if (UINTPTR_MAX - (uintptr_t) buffer < length || PL_VM_ADDRESS_MAX - task_addr < length)
+        return PLCRASH_EINVAL;
+
+    mobj->source = PLCRASH_ASYNC_MOBJECT_SOURCE_BUFFER;
+    mobj->task = MACH_PORT_NULL;
+    mobj->address = (uintptr_t) buffer;
+    mobj->task_address = task_addr;
+    mobj->length = length;
+    mobj->vm_slide = task_addr - mobj->address;
+    mobj->vm_address = mobj->address;
+    mobj->vm_length = length;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Initialize a new memory object by mapping @a length bytes of @a fd, starting at @a file_offset, read-only into
+ * the current process. The file data is treated as target memory originally located at @a task_addr; this may be
+ * used to parse an on-disk Mach-O binary, or a memory snapshot written to disk, without copying its contents.
+ *
+ * As with plcrash_async_mobject_init_buffer(), the memory object is not backed by a task.
+ *
+ * @param mobj Memory object to be initialized.
+ * @param fd An open file descriptor. The descriptor may be closed once the memory object has been initialized.
+ * @param file_offset The file offset of the data to be mapped. This is not required to fall on a page boundry.
+ * @param task_addr The target address corresponding to @a file_offset.
+ * @param length The number of bytes to be mapped.
+ *
+ * @return On success, returns PLCRASH_ESUCCESS. On failure, one of the plcrash_error_t error values will be returned, and no
+ * mapping will be performed. If the requested range extends past the end of the file, PLCRASH_EINVAL will be returned;
+ * pages mapped beyond the end of a file raise SIGBUS when accessed.
+ *
+ * @warning This method is not async-safe.
+ */
+plcrash_error_t plcrash_nasync_mobject_init_file (plcrash_async_mobject_t *mobj, int fd, off_t file_offset, pl_vm_address_t task_addr, pl_vm_size_t length) {
+    off_t page_size = sysconf(_SC_PAGESIZE);
+
+    if (file_offset < 0 || length == 0 || PL_VM_ADDRESS_MAX - task_addr < length)
+        return PLCRASH_EINVAL;
+
+    /* Verify that the requested range falls within the file */
+    struct stat sb;
+    if (fstat(fd, &sb) != 0) {
+        PLCF_DEBUG("fstat() failure: %d", errno);
+        return PLCRASH_EINVAL;
+    }
+
+    if (file_offset > sb.st_size || (uint64_t) (sb.st_size - file_offset) < length) {
+        PLCF_DEBUG("Requested range 0x%" PRIx64 "-0x%" PRIx64 " exceeds the file size 0x%" PRIx64,
+                   (uint64_t) file_offset, (uint64_t) file_offset + (uint64_t) length, (uint64_t) sb.st_size);
+        return PLCRASH_EINVAL;
+    }
+
+    /* The mapping must begin at a page-aligned file offset */
+    off_t map_offset = file_offset - (file_offset % page_size);
+    size_t map_length = (size_t) (length + (file_offset - map_offset));
+
+    void *mapping = mmap(NULL, map_length, PROT_READ, MAP_PRIVATE, fd, map_offset);
+    if (mapping == MAP_FAILED) {
+        PLCF_DEBUG("mmap() failure: %d", errno);
+        return PLCRASH_ENOMEM;
+    }
+
+    mobj->source = PLCRASH_ASYNC_MOBJECT_SOURCE_FILE;
+    mobj->task = MACH_PORT_NULL;
+    mobj->address = (uintptr_t) mapping + (uintptr_t) (file_offset - map_offset);
+    mobj->task_address = task_addr;
+    mobj->length = length;
+    mobj->vm_slide = task_addr - mobj->address;
+    mobj->vm_address = (pl_vm_address_t) (uintptr_t) mapping;
+    mobj->vm_length = map_length;
+
     return PLCRASH_ESUCCESS;
 }
 
@@ -306,7 +434,8 @@ pl_vm_address_t plcrash_async_mobject_length (plcrash_async_mobject_t *mobj) {
 }
 
 /**
- * Return a borrowed reference to the backing task for this mapping.
+ * Return a borrowed reference to the backing task for this mapping, or MACH_PORT_NULL if the mapping is not
+ * backed by a task.
  *
  * @param mobj An initialized memory object.
  */
@@ -470,6 +599,21 @@ plcrash_error_t plcrash_async_mobject_read_uint64 (plcrash_async_mobject_t *mobj
  */
 void plcrash_async_mobject_free (plcrash_async_mobject_t *mobj) {
     kern_return_t kt;
+
+    switch (mobj->source) {
+        case PLCRASH_ASYNC_MOBJECT_SOURCE_TASK:
+            break;
+
+        case PLCRASH_ASYNC_MOBJECT_SOURCE_FILE:
+            if (munmap((void *) (uintptr_t) mobj->vm_address, (size_t) mobj->vm_length) != 0)
+                PLCF_DEBUG("munmap() failure: %d", errno);
+            return;
+
+        case PLCRASH_ASYNC_MOBJECT_SOURCE_LOCAL:
+        case PLCRASH_ASYNC_MOBJECT_SOURCE_BUFFER:
+            /* Nothing is owned by the memory object */
+            return;
+    }
     
 #ifdef PL_HAVE_MACH_VM
     kt = mach_vm_deallocate(mach_task_self(), mobj->vm_address, mobj->vm_length);
@@ -34,16 +34,44 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include <sys/types.h>
 #include "PLCrashAsync.h"
 
+/**
+ * @ingroup plcrash_async
+ * @internal
+ *
+ * The memory source backing a plcrash_async_mobject_t.
+ */
+typedef enum {
+    /** Pages remapped from a (possibly remote) task; see plcrash_async_mobject_init(). */
+    PLCRASH_ASYNC_MOBJECT_SOURCE_TASK = 0,
+
+    /** Memory referenced directly within the current process, without remapping; see
+     * plcrash_async_mobject_init_local(). */
+    PLCRASH_ASYNC_MOBJECT_SOURCE_LOCAL = 1,
+
+    /** A caller-owned buffer, such as a captured memory snapshot; see plcrash_async_mobject_init_buffer(). */
+    PLCRASH_ASYNC_MOBJECT_SOURCE_BUFFER = 2,
+
+    /** A read-only file mapping owned by the memory object; see plcrash_nasync_mobject_init_file(). */
+    PLCRASH_ASYNC_MOBJECT_SOURCE_FILE = 3,
+} plcrash_async_mobject_source_t;
+
 /**
  * @ingroup plcrash_async
  * @internal
  *
  * An async-accessible memory mapped object.
+ *
+ * All readers access the object's contents through the local @a address and @a vm_slide values, regardless
+ * of the backing memory source.
  */
 typedef struct plcrash_async_mobject {
-    /** The task from which the memory was mapped */
+    /** The backing memory source. */
+    plcrash_async_mobject_source_t source;
+
+    /** The task from which the memory was mapped, or MACH_PORT_NULL if the object is not backed by a task. */
     task_t task;
 
     /** The in-memory address at which the target address has been mapped. This address is offset
@@ -62,7 +90,8 @@ typedef struct plcrash_async_mobject {
     int64_t vm_slide;
 
     /** The actual mapping start address. This may differ from the address pointer, as it must be
-     * page-aligned. */
+     * page-aligned. Only owned (and deallocated) by PLCRASH_ASYNC_MOBJECT_SOURCE_TASK and
+     * PLCRASH_ASYNC_MOBJECT_SOURCE_FILE objects. */
     pl_vm_address_t vm_address;
     
     /** The actual mapping size. This may differ from the user-requested size, as the base address has been page-aligned */
@@ -70,6 +99,9 @@ typedef struct plcrash_async_mobject {
 } plcrash_async_mobject_t;
 
 plcrash_error_t plcrash_async_mobject_init (plcrash_async_mobject_t *mobj, mach_port_t task, pl_vm_address_t task_addr, pl_vm_size_t length, bool require_full);
+plcrash_error_t plcrash_async_mobject_init_local (plcrash_async_mobject_t *mobj, pl_vm_address_t address, pl_vm_size_t length);
+plcrash_error_t plcrash_async_mobject_init_buffer (plcrash_async_mobject_t *mobj, const void *buffer, pl_vm_address_t task_addr, pl_vm_size_t length);
+plcrash_error_t plcrash_nasync_mobject_init_file (plcrash_async_mobject_t *mobj, int fd, off_t file_offset, pl_vm_address_t task_addr, pl_vm_size_t length);
 
 pl_vm_address_t plcrash_async_mobject_base_address (plcrash_async_mobject_t *mobj);
 pl_vm_address_t plcrash_async_mobject_length (plcrash_async_mobject_t *mobj);
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef PLCRASH_ASYNC_MOBJECT_SPAN_H
+#define PLCRASH_ASYNC_MOBJECT_SPAN_H
+
+#include <cstddef>
+
+#include "PLCrashAsync.h"
+#include "PLCrashAsyncMObject.h"
+
+/**
+ * @internal
+ * @ingroup plcrash_async
+ * @{
+ */
+
+namespace plcrash { namespace async {
+
+/**
+ * @internal
+ *
+ * A validated, read-only range within a plcrash_async_mobject_t.
+ *
+ * The range is verified against the backing memory object once, at initialization. Reads at offsets within the
+ * span are then performed directly, without repeating the overflow and range arithmetic of
+ * plcrash_async_mobject_remap_address(). Callers must verify that a read falls within the span via contains()
+ * before performing it; reads are additionally checked via PLCF_ASSERT in debug builds.
+ *
+ * The span borrows the memory object's mapping, and must not be used after the memory object has been freed.
+ */
+class mobject_span {
+    /** Locally mapped starting address, or NULL if uninitialized. */
+    const uint8_t *_local;
+
+    /** Target-relative starting address. */
+    pl_vm_address_t _address;
+
+    /** The length of the span, in bytes. */
+    pl_vm_size_t _length;
+
+public:
+    mobject_span (void) : _local(NULL), _address(0), _length(0) {}
+
+    inline plcrash_error_t init (plcrash_async_mobject_t *mobj, pl_vm_address_t address, pl_vm_off_t offset, pl_vm_size_t length);
+    inline plcrash_error_t init_remaining (plcrash_async_mobject_t *mobj, pl_vm_address_t address, pl_vm_off_t offset);
+
+    /** Return the target-relative starting address of the span. */
+    pl_vm_address_t address (void) const { return _address; }
+
+    /** Return the length of the span, in bytes. */
+    pl_vm_size_t length (void) const { return _length; }
+
+    /**
+     * Return true if @a length bytes at @a offset fall entirely within the span.
+     *
+     * @param offset The offset from the start of the span.
+     * @param length The number of bytes.
+     */
+    bool contains (pl_vm_size_t offset, pl_vm_size_t length) const {
+        return offset <= _length && length <= _length - offset;
+    }
+
+    /**
+     * Return the locally mapped address of @a offset. The offset must fall within the span.
+     *
+     * @param offset The offset from the start of the span.
+     */
+    const void *local_address (pl_vm_size_t offset) const {
+        PLCF_ASSERT(offset <= _length);
+        return _local + offset;
+    }
+
+    /**
+     * Read a value of type @a V at @a offset, without byte swapping. The caller must have verified that the value
+     * falls within the span via contains().
+     *
+     * @param offset The offset from the start of the span.
+     */
+    template <typename V> V read (pl_vm_size_t offset) const {
+        PLCF_ASSERT(contains(offset, sizeof(V)));
+        return *((const V *) (_local + offset));
+    }
+
+    /**
+     * Read a 2, 4, or 8 byte value of type @a V at @a offset, byte swapping via @a byteorder. The caller must have
+     * verified that the value falls within the span via contains().
+     *
+     * @param byteorder The byte order of the target data.
+     * @param offset The offset from the start of the span.
+     */
+    template <typename V> V read (const plcrash_async_byteorder_t *byteorder, pl_vm_size_t offset) const {
+        return byteorder->swap(read<V>(offset));
+    }
+};
+
+/**
+ * Initialize the span to cover @a length bytes at @a address + @a offset within @a mobj.
+ *
+ * @param mobj The backing memory object.
+ * @param address The target-relative base address.
+ * @param offset The offset to be applied to @a address.
+ * @param length The length of the span, in bytes.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_EINVAL if the range does not fall within @a mobj.
+ */
+inline plcrash_error_t mobject_span::init (plcrash_async_mobject_t *mobj, pl_vm_address_t address, pl_vm_off_t offset, pl_vm_size_t length) {
+    void *local = plcrash_async_mobject_remap_address(mobj, address, offset, length);
+    if (local == NULL)
+        return PLCRASH_EINVAL;
+
+    _local = (const uint8_t *) local;
+    _address = address + offset;
+    _length = length;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Initialize the span to cover all bytes from @a address + @a offset to the end of @a mobj.
+ *
+ * @param mobj The backing memory object.
+ * @param address The target-relative base address.
+ * @param offset The offset to be applied to @a address.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_EINVAL if the starting address does not fall within
+ * @a mobj, or no bytes remain.
+ */
+inline plcrash_error_t mobject_span::init_remaining (plcrash_async_mobject_t *mobj, pl_vm_address_t address, pl_vm_off_t offset) {
+    pl_vm_address_t start;
+    if (!plcrash_async_address_apply_offset(address, offset, &start))
+        return PLCRASH_EINVAL;
+
+    pl_vm_address_t base = plcrash_async_mobject_base_address(mobj);
+    pl_vm_address_t end = base + plcrash_async_mobject_length(mobj);
+    if (start < base || start >= end)
+        return PLCRASH_EINVAL;
+
+    return init(mobj, start, 0, end - start);
+}
+
+}}
+
+/**
+ * @}
+ */
+
+#endif /* PLCRASH_ASYNC_MOBJECT_SPAN_H */
@@ -45,6 +45,190 @@
  * @{
  */
 
+/**
+ * @internal
+ * Names of the segments indexed by plcrash_async_macho_index_seg_t.
+ */
+static const char *plcrash_async_macho_index_segnames[PLCRASH_ASYNC_MACHO_INDEX_SEG_COUNT] = {
+    SEG_TEXT,
+    "__DATA",
+    "__LINKEDIT",
+    "__OBJC",
+    "__DWARF"
+};
+
+/**
+ * @internal
+ * Segments and names of the sections indexed by plcrash_async_macho_index_sect_t.
+ */
+static const struct {
+    /** The section's segment. */
+    plcrash_async_macho_index_seg_t segment;
+
+    /** The section name. */
+    const char *sectname;
+} plcrash_async_macho_index_sections[PLCRASH_ASYNC_MACHO_INDEX_SECT_COUNT] = {
+    { PLCRASH_ASYNC_MACHO_INDEX_SEG_TEXT,   "__unwind_info" },
+    { PLCRASH_ASYNC_MACHO_INDEX_SEG_TEXT,   "__eh_frame" },
+    { PLCRASH_ASYNC_MACHO_INDEX_SEG_DWARF,  "__debug_frame" },
+    { PLCRASH_ASYNC_MACHO_INDEX_SEG_DATA,   "__objc_const" },
+    { PLCRASH_ASYNC_MACHO_INDEX_SEG_DATA,   "__objc_classlist" },
+    { PLCRASH_ASYNC_MACHO_INDEX_SEG_DATA,   "__objc_catlist" },
+    { PLCRASH_ASYNC_MACHO_INDEX_SEG_DATA,   "__objc_data" },
+    { PLCRASH_ASYNC_MACHO_INDEX_SEG_OBJC,   "__module_info" },
+};
+
+/**
+ * @internal
+ *
+ * Return the index slot for @a segname, or PLCRASH_ASYNC_MACHO_INDEX_SEG_COUNT if the segment is not indexed.
+ */
+static plcrash_async_macho_index_seg_t plcrash_async_macho_index_find_seg (const char *segname) {
+    for (int i = 0; i < PLCRASH_ASYNC_MACHO_INDEX_SEG_COUNT; i++) {
+        if (plcrash_async_strncmp(segname, plcrash_async_macho_index_segnames[i], sizeof(((struct segment_command *) NULL)->segname)) == 0)
+            return (plcrash_async_macho_index_seg_t) i;
+    }
+
+    return PLCRASH_ASYNC_MACHO_INDEX_SEG_COUNT;
+}
+
+/**
+ * @internal
+ *
+ * Return the index slot for the section @a sectname within @a segment, or PLCRASH_ASYNC_MACHO_INDEX_SECT_COUNT if
+ * the section is not indexed.
+ */
+static plcrash_async_macho_index_sect_t plcrash_async_macho_index_find_sect (plcrash_async_macho_index_seg_t segment, const char *sectname) {
+    for (int i = 0; i < PLCRASH_ASYNC_MACHO_INDEX_SECT_COUNT; i++) {
+        if (plcrash_async_macho_index_sections[i].segment != segment)
+            continue;
+
+        if (plcrash_async_strncmp(sectname, plcrash_async_macho_index_sections[i].sectname, sizeof(((struct section *) NULL)->sectname)) == 0)
+            return (plcrash_async_macho_index_sect_t) i;
+    }
+
+    return PLCRASH_ASYNC_MACHO_INDEX_SECT_COUNT;
+}
+
+/**
+ * @internal
+ *
+ * Return the mapped address of an indexed load command or section entry, or NULL if @a offset is
+ * PLCRASH_ASYNC_MACHO_INDEX_NONE.
+ */
+static void *plcrash_async_macho_index_address (plcrash_async_macho_t *image, uint32_t offset) {
+    if (offset == PLCRASH_ASYNC_MACHO_INDEX_NONE)
+        return NULL;
+
+    return (void *) (image->load_cmds.address + offset);
+}
+
+/**
+ * @internal
+ *
+ * Populate @a image's load command index and capabilities. The load commands must have already been mapped.
+ *
+ * If a segment load command is too short to be indexed, the index is marked as invalid, all capabilities are
+ * conservatively enabled, and lookups fall back on a linear walk of the load commands.
+ */
+static void plcrash_async_macho_build_index (plcrash_async_macho_t *image) {
+    plcrash_async_macho_cmd_index_t *index = &image->cmd_index;
+    uint32_t segment_cmd = image->m64 ? LC_SEGMENT_64 : LC_SEGMENT;
+    struct load_command *cmd = NULL;
+
+    /* Mark all entries as not present (PLCRASH_ASYNC_MACHO_INDEX_NONE) */
+    plcrash_async_memset(index, 0xFF, sizeof(*index));
+    index->valid = false;
+
+    while ((cmd = plcrash_async_macho_next_command(image, cmd)) != NULL) {
+        uint32_t offset = (uint32_t) ((uintptr_t) cmd - image->load_cmds.address);
+        uint32_t type = image->byteorder->swap32(cmd->cmd);
+
+        /* Only the first instance of any command is indexed, matching the behavior of plcrash_async_macho_find_command() */
+        if (type == LC_SYMTAB && index->symtab == PLCRASH_ASYNC_MACHO_INDEX_NONE) {
+            index->symtab = offset;
+        } else if (type == LC_DYSYMTAB && index->dysymtab == PLCRASH_ASYNC_MACHO_INDEX_NONE) {
+            index->dysymtab = offset;
+        } else if (type == LC_UUID && index->uuid == PLCRASH_ASYNC_MACHO_INDEX_NONE) {
+            index->uuid = offset;
+        }
+
+        if (type != segment_cmd)
+            continue;
+
+        /* Fetch the segment name and section table */
+        const char *segname;
+        uint32_t nsects;
+        uintptr_t cursor = (uintptr_t) cmd;
+        size_t sect_size;
+
+        if (image->m64) {
+            struct segment_command_64 *segment = (struct segment_command_64 *) cmd;
+            if (!plcrash_async_mobject_verify_local_pointer(&image->load_cmds, (uintptr_t) segment, 0, sizeof(*segment))) {
+                PLCF_DEBUG("LC_SEGMENT command was too short in %s; falling back on unindexed lookups", image->name);
+                image->capabilities = PLCRASH_ASYNC_MACHO_CAP_COMPACT_UNWIND | PLCRASH_ASYNC_MACHO_CAP_DWARF_UNWIND |
+                                      PLCRASH_ASYNC_MACHO_CAP_OBJC1 | PLCRASH_ASYNC_MACHO_CAP_OBJC2;
+                return;
+            }
+
+            segname = segment->segname;
+            nsects = image->byteorder->swap32(segment->nsects);
+            cursor += sizeof(*segment);
+            sect_size = sizeof(struct section_64);
+        } else {
+            struct segment_command *segment = (struct segment_command *) cmd;
+            if (!plcrash_async_mobject_verify_local_pointer(&image->load_cmds, (uintptr_t) segment, 0, sizeof(*segment))) {
+                PLCF_DEBUG("LC_SEGMENT command was too short in %s; falling back on unindexed lookups", image->name);
+                image->capabilities = PLCRASH_ASYNC_MACHO_CAP_COMPACT_UNWIND | PLCRASH_ASYNC_MACHO_CAP_DWARF_UNWIND |
+                                      PLCRASH_ASYNC_MACHO_CAP_OBJC1 | PLCRASH_ASYNC_MACHO_CAP_OBJC2;
+                return;
+            }
+
+            segname = segment->segname;
+            nsects = image->byteorder->swap32(segment->nsects);
+            cursor += sizeof(*segment);
+            sect_size = sizeof(struct section);
+        }
+
+        plcrash_async_macho_index_seg_t seg_slot = plcrash_async_macho_index_find_seg(segname);
+        if (seg_slot == PLCRASH_ASYNC_MACHO_INDEX_SEG_COUNT || index->segments[seg_slot] != PLCRASH_ASYNC_MACHO_INDEX_NONE)
+            continue;
+
+        index->segments[seg_slot] = offset;
+
+        /* Index the segment's sections. The section name is the first field of both section and section_64. */
+        for (uint32_t i = 0; i < nsects; i++, cursor += sect_size) {
+            if (!plcrash_async_mobject_verify_local_pointer(&image->load_cmds, cursor, 0, sect_size)) {
+                PLCF_DEBUG("Section table entry outside of expected range in segment %.16s of %s", segname, image->name);
+                break;
+            }
+
+            plcrash_async_macho_index_sect_t sect_slot = plcrash_async_macho_index_find_sect(seg_slot, ((struct section *) cursor)->sectname);
+            if (sect_slot != PLCRASH_ASYNC_MACHO_INDEX_SECT_COUNT && index->sections[sect_slot] == PLCRASH_ASYNC_MACHO_INDEX_NONE)
+                index->sections[sect_slot] = (uint32_t) (cursor - image->load_cmds.address);
+        }
+    }
+
+    index->valid = true;
+
+    /* Derive the image's capabilities */
+#define PL_HAS_SECT(_slot) (index->sections[PLCRASH_ASYNC_MACHO_INDEX_SECT_ ## _slot] != PLCRASH_ASYNC_MACHO_INDEX_NONE)
+    image->capabilities = 0;
+
+    if (PL_HAS_SECT(UNWIND_INFO))
+        image->capabilities |= PLCRASH_ASYNC_MACHO_CAP_COMPACT_UNWIND;
+
+    if (PL_HAS_SECT(EH_FRAME) || PL_HAS_SECT(DEBUG_FRAME))
+        image->capabilities |= PLCRASH_ASYNC_MACHO_CAP_DWARF_UNWIND;
+
+    if (PL_HAS_SECT(OBJC_MODULE_INFO))
+        image->capabilities |= PLCRASH_ASYNC_MACHO_CAP_OBJC1;
+
+    if (PL_HAS_SECT(OBJC_CONST) && PL_HAS_SECT(OBJC_CLASSLIST) && PL_HAS_SECT(OBJC_CATLIST) && PL_HAS_SECT(OBJC_DATA))
+        image->capabilities |= PLCRASH_ASYNC_MACHO_CAP_OBJC2;
+#undef PL_HAS_SECT
+}
+
 /**
  * Initialize a new Mach-O binary image parser.
  *
@@ -53,22 +237,51 @@
  * @param header The task-local address of the image's Mach-O header.
  *
  * @return PLCRASH_ESUCCESS on success. PLCRASH_EINVAL will be returned in the Mach-O file can not be parsed,
- * or PLCRASH_EINTERNAL if an error occurs reading from the target task.
+ * PLCRASH_ENOMEM if the name could not be copied, or PLCRASH_EINTERNAL if an error occurs reading from the target task.
  *
  * @warning This method is not async safe.
  */
 plcrash_error_t plcrash_nasync_macho_init (plcrash_async_macho_t *image, mach_port_t task, const char *name, pl_vm_address_t header) {
     plcrash_error_t ret;
+    char *name_copy = strdup(name);
+    if (name_copy == NULL)
+        return PLCRASH_ENOMEM;
+
+    if ((ret = plcrash_async_macho_init(image, task, name_copy, header)) != PLCRASH_ESUCCESS) {
+        free(name_copy);
+        return ret;
+    }
+
+    image->owns_name = true;
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Initialize a new Mach-O binary image parser, borrowing a reference to the image's name. Unlike
+ * plcrash_nasync_macho_init(), this function is async-safe, and may be used to initialize images at crash time.
+ *
+ * @param image The image structure to be initialized.
+ * @param name The file name or path for the Mach-O image. This is a borrowed reference, and must remain valid for
+ * the lifetime of @a image.
+ * @param header The task-local address of the image's Mach-O header.
+ *
+ * @return PLCRASH_ESUCCESS on success. PLCRASH_EINVAL will be returned in the Mach-O file can not be parsed,
+ * or PLCRASH_EINTERNAL if an error occurs reading from the target task.
+ *
+ * @note The image must be freed with plcrash_nasync_macho_free(), which is not async-safe.
+ */
+plcrash_error_t plcrash_async_macho_init (plcrash_async_macho_t *image, mach_port_t task, const char *name, pl_vm_address_t header) {
+    plcrash_error_t ret;
 
     /* Defaults checked in the  error cleanup handler */
     bool mobj_initialized = false;
     bool task_initialized = false;
-    image->name = NULL;
 
     /* Basic initialization */
     image->task = task;
     image->header_addr = header;
-    image->name = strdup(name);
+    image->name = (char *) name;
+    image->owns_name = false;
 
     mach_port_mod_refs(mach_task_self(), image->task, MACH_PORT_RIGHT_SEND, 1);
     task_initialized = true;
@@ -109,12 +322,13 @@ plcrash_error_t plcrash_nasync_macho_init (plcrash_async_macho_t *image, mach_po
         case FAT_CIGAM:
         case FAT_MAGIC:
             PLCF_DEBUG("%s called with an unsupported universal Mach-O archive in: %s", __func__, image->name);
-            return PLCRASH_EINVAL;
-            break;
+            ret = PLCRASH_EINVAL;
+            goto error;
 
         default:
             PLCF_DEBUG("Unknown Mach-O magic: 0x%" PRIx32 " in: %s", image->header.magic, image->name);
-            return PLCRASH_EINVAL;
+            ret = PLCRASH_EINVAL;
+            goto error;
     }
 
     /* Save the header size */
@@ -137,50 +351,27 @@ plcrash_error_t plcrash_nasync_macho_init (plcrash_async_macho_t *image, mach_po
         mobj_initialized = true;
     }
 
-    /* Now that the image has been sufficiently initialized, determine the __TEXT segment size */
-    void *cmdptr = NULL;
-    image->text_size = 0x0;
-    bool found_text_seg = false;
-    while ((cmdptr = plcrash_async_macho_next_command_type(image, cmdptr, image->m64 ? LC_SEGMENT_64 : LC_SEGMENT)) != 0) {
-        if (image->m64) {
-            struct segment_command_64 *segment = cmdptr;
-            if (!plcrash_async_mobject_verify_local_pointer(&image->load_cmds, (uintptr_t) segment, 0, sizeof(*segment))) {
-                PLCF_DEBUG("LC_SEGMENT command was too short");
-                ret = PLCRASH_EINVAL;
-                goto error;
-            }
-            
-            if (plcrash_async_strncmp(segment->segname, SEG_TEXT, sizeof(segment->segname)) != 0)
-                continue;
-
-            image->text_size = image->byteorder->swap64(segment->vmsize);
-            image->text_vmaddr = image->byteorder->swap64(segment->vmaddr);
-            found_text_seg = true;
-            break;
-        } else {
-            struct segment_command *segment = cmdptr;
-            if (!plcrash_async_mobject_verify_local_pointer(&image->load_cmds, (uintptr_t) segment, 0, sizeof(*segment))) {
-                PLCF_DEBUG("LC_SEGMENT command was too short");
-                ret = PLCRASH_EINVAL;
-                goto error;
-            }
-            
-            if (plcrash_async_strncmp(segment->segname, SEG_TEXT, sizeof(segment->segname)) != 0)
-                continue;
-            
-            image->text_size = image->byteorder->swap32(segment->vmsize);
-            image->text_vmaddr = image->byteorder->swap32(segment->vmaddr);
-            found_text_seg = true;
-            break;
-        }
-    }
+    /* Now that the image has been sufficiently initialized, index the load commands used at crash time */
+    plcrash_async_macho_build_index(image);
 
-    if (!found_text_seg) {
+    /* Determine the __TEXT segment size */
+    void *cmdptr = plcrash_async_macho_find_indexed_segment_cmd(image, PLCRASH_ASYNC_MACHO_INDEX_SEG_TEXT);
+    if (cmdptr == NULL) {
         PLCF_DEBUG("Could not find __TEXT segment!");
         ret = PLCRASH_EINVAL;
         goto error;
     }
 
+    if (image->m64) {
+        struct segment_command_64 *segment = cmdptr;
+        image->text_size = image->byteorder->swap64(segment->vmsize);
+        image->text_vmaddr = image->byteorder->swap64(segment->vmaddr);
+    } else {
+        struct segment_command *segment = cmdptr;
+        image->text_size = image->byteorder->swap32(segment->vmsize);
+        image->text_vmaddr = image->byteorder->swap32(segment->vmaddr);
+    }
+
     /* Compute the vmaddr slide */
     if (image->text_vmaddr < header) {
         image->vmaddr_slide = header - image->text_vmaddr;
@@ -196,9 +387,6 @@ error:
     if (mobj_initialized)
         plcrash_async_mobject_free(&image->load_cmds);
     
-    if (image->name != NULL)
-        free(image->name);
-    
     if (task_initialized)
         mach_port_mod_refs(mach_task_self(), image->task, MACH_PORT_RIGHT_SEND, -1);
 
@@ -250,6 +438,16 @@ bool plcrash_async_macho_contains_address (plcrash_async_macho_t *image, pl_vm_a
     return false;
 }
 
+/**
+ * Return true if @a image provides @a capability, false otherwise.
+ *
+ * @param image The Mach-O image.
+ * @param capability The capability to be checked.
+ */
+bool plcrash_async_macho_has_capability (plcrash_async_macho_t *image, plcrash_async_macho_cap_t capability) {
+    return (image->capabilities & capability) == (uint32_t) capability;
+}
+
 /**
  * Return the Mach CPU type of @a image.
  *
@@ -367,6 +565,23 @@ void *plcrash_async_macho_next_command_type (plcrash_async_macho_t *image, void
 void *plcrash_async_macho_find_command (plcrash_async_macho_t *image, uint32_t expectedCommand) {
     struct load_command *cmd = NULL;
 
+    /* Use the index, if available */
+    if (image->cmd_index.valid) {
+        switch (expectedCommand) {
+            case LC_SYMTAB:
+                return plcrash_async_macho_index_address(image, image->cmd_index.symtab);
+
+            case LC_DYSYMTAB:
+                return plcrash_async_macho_index_address(image, image->cmd_index.dysymtab);
+
+            case LC_UUID:
+                return plcrash_async_macho_index_address(image, image->cmd_index.uuid);
+
+            default:
+                break;
+        }
+    }
+
     /* Iterate commands until we either find a match, or reach the end */
     while ((cmd = plcrash_async_macho_next_command(image, cmd)) != NULL) {
         /* Read the load command type */
@@ -401,6 +616,10 @@ void *plcrash_async_macho_find_segment_cmd (plcrash_async_macho_t *image, const
 
     while ((seg = plcrash_async_macho_next_command_type(image, seg, image->m64 ? LC_SEGMENT_64 : LC_SEGMENT)) != 0) {
 
+        /* Skip truncated segment commands; these are only reachable if the image's load commands could not be indexed */
+        if (!plcrash_async_mobject_verify_local_pointer(&image->load_cmds, (uintptr_t) seg, 0, image->m64 ? sizeof(struct segment_command_64) : sizeof(struct segment_command)))
+            continue;
+
         /* Read the load command */
         if (image->m64) {
             struct segment_command_64 *cmd_64 = seg;
@@ -416,6 +635,55 @@ void *plcrash_async_macho_find_segment_cmd (plcrash_async_macho_t *image, const
     return NULL;
 }
 
+/**
+ * Find an indexed segment. Unlike plcrash_async_macho_find_segment_cmd(), this performs a constant-time lookup in
+ * the image's load command index, falling back on a linear search only if the load commands could not be indexed.
+ *
+ * @param image The image to search for @a segment.
+ * @param segment The segment to search for.
+ *
+ * @return Returns a mapped pointer to the segment on success, or NULL on failure.
+ */
+void *plcrash_async_macho_find_indexed_segment_cmd (plcrash_async_macho_t *image, plcrash_async_macho_index_seg_t segment) {
+    PLCF_ASSERT(segment < PLCRASH_ASYNC_MACHO_INDEX_SEG_COUNT);
+
+    if (image->cmd_index.valid)
+        return plcrash_async_macho_index_address(image, image->cmd_index.segments[segment]);
+
+    return plcrash_async_macho_find_segment_cmd(image, plcrash_async_macho_index_segnames[segment]);
+}
+
+/**
+ * @internal
+ *
+ * Map the segment described by the segment load command @a segment, which must be a verified pointer into
+ * @a image's mapped load commands.
+ */
+static plcrash_error_t plcrash_async_macho_map_segment_cmd (plcrash_async_macho_t *image, void *segment, pl_async_macho_mapped_segment_t *seg) {
+    struct segment_command *cmd_32 = segment;
+    struct segment_command_64 *cmd_64 = segment;
+
+    /* Calculate the in-memory address and size */
+    pl_vm_address_t segaddr;
+    pl_vm_size_t segsize;
+    if (image->m64) {
+        segaddr = image->byteorder->swap64(cmd_64->vmaddr) + image->vmaddr_slide;
+        segsize = image->byteorder->swap64(cmd_64->vmsize);
+
+        seg->fileoff = image->byteorder->swap64(cmd_64->fileoff);
+        seg->filesize = image->byteorder->swap64(cmd_64->filesize);
+    } else {
+        segaddr = image->byteorder->swap32(cmd_32->vmaddr) + image->vmaddr_slide;
+        segsize = image->byteorder->swap32(cmd_32->vmsize);
+        
+        seg->fileoff = image->byteorder->swap32(cmd_32->fileoff);
+        seg->filesize = image->byteorder->swap32(cmd_32->filesize);
+    }
+
+    /* Perform and return the mapping (permitting shorter mappings, as documented in plcrash_async_macho_map_segment()). */
+    return plcrash_async_mobject_init(&seg->mobj, image->task, segaddr, segsize, false);
+}
+
 /**
  * Find and map a named segment, initializing @a mobj. It is the caller's responsibility to dealloc @a mobj after
  * a successful initialization
@@ -435,35 +703,54 @@ void *plcrash_async_macho_find_segment_cmd (plcrash_async_macho_t *image, const
  * @return Returns PLCRASH_ESUCCESS on success, or an error result on failure.
  */
 plcrash_error_t plcrash_async_macho_map_segment (plcrash_async_macho_t *image, const char *segname, pl_async_macho_mapped_segment_t *seg) {
-    struct segment_command *cmd_32;
-    struct segment_command_64 *cmd_64;
-    
     void *segment =  plcrash_async_macho_find_segment_cmd(image, segname);
     if (segment == NULL)
         return PLCRASH_ENOTFOUND;
 
-    cmd_32 = segment;
-    cmd_64 = segment;
+    return plcrash_async_macho_map_segment_cmd(image, segment, seg);
+}
+
+/**
+ * Find and map an indexed segment, initializing @a seg. This is equivalent to plcrash_async_macho_map_segment(),
+ * but uses a constant-time lookup in the image's load command index.
+ *
+ * @param image The image to search for @a segment.
+ * @param segment The segment to be mapped.
+ * @param seg The segment data to be initialized. It is the caller's responsibility to dealloc @a seg after
+ * a successful initialization.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or an error result on failure.
+ */
+plcrash_error_t plcrash_async_macho_map_indexed_segment (plcrash_async_macho_t *image, plcrash_async_macho_index_seg_t segment, pl_async_macho_mapped_segment_t *seg) {
+    void *cmd = plcrash_async_macho_find_indexed_segment_cmd(image, segment);
+    if (cmd == NULL)
+        return PLCRASH_ENOTFOUND;
+
+    return plcrash_async_macho_map_segment_cmd(image, cmd, seg);
+}
 
+/**
+ * @internal
+ *
+ * Map the section described by the section table entry @a sect, which must be a verified pointer into
+ * @a image's mapped load commands.
+ */
+static plcrash_error_t plcrash_async_macho_map_section_entry (plcrash_async_macho_t *image, void *sect, plcrash_async_mobject_t *mobj) {
     /* Calculate the in-memory address and size */
-    pl_vm_address_t segaddr;
-    pl_vm_size_t segsize;
+    pl_vm_address_t sectaddr;
+    pl_vm_size_t sectsize;
     if (image->m64) {
-        segaddr = image->byteorder->swap64(cmd_64->vmaddr) + image->vmaddr_slide;
-        segsize = image->byteorder->swap64(cmd_64->vmsize);
-
-        seg->fileoff = image->byteorder->swap64(cmd_64->fileoff);
-        seg->filesize = image->byteorder->swap64(cmd_64->filesize);
+        struct section_64 *sect_64 = sect;
+        sectaddr = image->byteorder->swap64(sect_64->addr) + image->vmaddr_slide;
+        sectsize = image->byteorder->swap64(sect_64->size);
     } else {
-        segaddr = image->byteorder->swap32(cmd_32->vmaddr) + image->vmaddr_slide;
-        segsize = image->byteorder->swap32(cmd_32->vmsize);
-        
-        seg->fileoff = image->byteorder->swap32(cmd_32->fileoff);
-        seg->filesize = image->byteorder->swap32(cmd_32->filesize);
+        struct section *sect_32 = sect;
+        sectaddr = image->byteorder->swap32(sect_32->addr) + image->vmaddr_slide;
+        sectsize = image->byteorder->swap32(sect_32->size);
     }
 
-    /* Perform and return the mapping (permitting shorter mappings, as documented above). */
-    return plcrash_async_mobject_init(&seg->mobj, image->task, segaddr, segsize, false);
+    /* Perform and return the mapping */
+    return plcrash_async_mobject_init(mobj, image->task, sectaddr, sectsize, true);
 }
 
 /**
@@ -482,7 +769,7 @@ plcrash_error_t plcrash_async_macho_map_segment (plcrash_async_macho_t *image, c
 plcrash_error_t plcrash_async_macho_map_section (plcrash_async_macho_t *image, const char *segname, const char *sectname, plcrash_async_mobject_t *mobj) {
     struct segment_command *cmd_32;
     struct segment_command_64 *cmd_64;
-    
+
     void *segment =  plcrash_async_macho_find_segment_cmd(image, segname);
     if (segment == NULL)
         return PLCRASH_ENOTFOUND;
@@ -524,27 +811,42 @@ plcrash_error_t plcrash_async_macho_map_section (plcrash_async_macho_t *image, c
         }
         
         const char *image_sectname = image->m64 ? sect_64->sectname : sect_32->sectname;
-        if (plcrash_async_strncmp(sectname, image_sectname, sizeof(sect_64->sectname)) == 0) {
-            /* Calculate the in-memory address and size */
-            pl_vm_address_t sectaddr;
-            pl_vm_size_t sectsize;
-            if (image->m64) {
-                sectaddr = image->byteorder->swap64(sect_64->addr) + image->vmaddr_slide;
-                sectsize = image->byteorder->swap64(sect_64->size);
-            } else {
-                sectaddr = image->byteorder->swap32(sect_32->addr) + image->vmaddr_slide;
-                sectsize = image->byteorder->swap32(sect_32->size);
-            }
-            
-            
-            /* Perform and return the mapping */
-            return plcrash_async_mobject_init(mobj, image->task, sectaddr, sectsize, true);
-        }
+        if (plcrash_async_strncmp(sectname, image_sectname, sizeof(sect_64->sectname)) == 0)
+            return plcrash_async_macho_map_section_entry(image, image->m64 ? (void *) sect_64 : (void *) sect_32, mobj);
     }
     
     return PLCRASH_ENOTFOUND;
 }
 
+/**
+ * Find and map an indexed section, initializing @a mobj. This is equivalent to plcrash_async_macho_map_section(),
+ * but uses a constant-time lookup in the image's load command index, falling back on a linear search only if the
+ * load commands could not be indexed.
+ *
+ * @param image The image to search for @a section.
+ * @param section The section to map.
+ * @param mobj The mobject to be initialized with a mapping of the section's data. It is the caller's responsibility to dealloc @a mobj after
+ * a successful initialization.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_ENOTFOUND if the section is not found, or an error result on failure.
+ */
+plcrash_error_t plcrash_async_macho_map_indexed_section (plcrash_async_macho_t *image, plcrash_async_macho_index_sect_t section, plcrash_async_mobject_t *mobj) {
+    PLCF_ASSERT(section < PLCRASH_ASYNC_MACHO_INDEX_SECT_COUNT);
+
+    if (!image->cmd_index.valid) {
+        return plcrash_async_macho_map_section(image,
+                                               plcrash_async_macho_index_segnames[plcrash_async_macho_index_sections[section].segment],
+                                               plcrash_async_macho_index_sections[section].sectname,
+                                               mobj);
+    }
+
+    void *sect = plcrash_async_macho_index_address(image, image->cmd_index.sections[section]);
+    if (sect == NULL)
+        return PLCRASH_ENOTFOUND;
+
+    return plcrash_async_macho_map_section_entry(image, sect, mobj);
+}
+
 /**
  * @internal
  * Common wrapper of nlist/nlist_64. We verify that this union is valid for our purposes in pl_async_macho_find_symtab_symbol().
@@ -625,7 +927,7 @@ plcrash_error_t plcrash_async_macho_symtab_reader_init (plcrash_async_macho_symt
     }
     
     /* Map in the __LINKEDIT segment, which includes the symbol and string tables */
-    plcrash_error_t err = plcrash_async_macho_map_segment(image, "__LINKEDIT", &reader->linkedit);
+    plcrash_error_t err = plcrash_async_macho_map_indexed_segment(image, PLCRASH_ASYNC_MACHO_INDEX_SEG_LINKEDIT, &reader->linkedit);
     if (err != PLCRASH_ESUCCESS) {
         PLCF_DEBUG("plcrash_async_mobject_init() failure: %d in %s", err, image->name);
         return PLCRASH_EINTERNAL;
@@ -775,23 +1077,24 @@ plcrash_async_macho_symtab_entry_t plcrash_async_macho_symtab_reader_read (plcra
  */
 const char *plcrash_async_macho_symtab_reader_symbol_name (plcrash_async_macho_symtab_reader_t *reader, uint32_t n_strx) {
     /* 
-     * It's possible, though unlikely, that the n_strx index value is invalid. To handle this,
-     * we walk the string until \0 is hit, verifying that it can be found in its entirety within
-     *
-     * TODO: Evaluate effeciency of per-byte calling of plcrash_async_mobject_verify_local_pointer(). We should
-     * probably validate whole pages at a time instead.
+     * It's possible, though unlikely, that the n_strx index value is invalid. To handle this, we verify the
+     * string's starting address once, and then walk the string until \0 is hit, bounded by the end of the
+     * mapped LINKEDIT segment.
      */
     const char *sym_name = reader->string_table + n_strx;
-    const char *p = sym_name;
-    do {
-        if (!plcrash_async_mobject_verify_local_pointer(&reader->linkedit.mobj, (uintptr_t) p, 0, 1)) {
-            PLCF_DEBUG("End of mobject reached while walking string\n");
-            return NULL;
-        }
-        p++;
-    } while (*p != '\0');
+    if (!plcrash_async_mobject_verify_local_pointer(&reader->linkedit.mobj, (uintptr_t) sym_name, 0, 1)) {
+        PLCF_DEBUG("String table index %" PRIu32 " lies outside the mapped LINKEDIT segment", n_strx);
+        return NULL;
+    }
 
-    return sym_name;
+    const char *end = (const char *) (reader->linkedit.mobj.address + reader->linkedit.mobj.length);
+    for (const char *p = sym_name; p < end; p++) {
+        if (*p == '\0')
+            return sym_name;
+    }
+
+    PLCF_DEBUG("End of mobject reached while walking string\n");
+    return NULL;
 }
 
 /**
@@ -803,6 +1106,48 @@ void plcrash_async_macho_symtab_reader_free (plcrash_async_macho_symtab_reader_t
     plcrash_async_macho_mapped_segment_free(&reader->linkedit);
 }
 
+/*
+ * Byte order and word size specialized implementation of plcrash_async_macho_find_best_symbol(). This is always
+ * inlined with constant @a m64 and @a swapped arguments, producing a specialized loop for each combination in which
+ * all field reads are performed inline, rather than via the image's plcrash_async_byteorder_t functions.
+ */
+static inline __attribute__((always_inline)) void plcrash_async_macho_find_best_symbol_impl (plcrash_async_macho_symtab_reader_t *reader,
+                                                                                             pl_vm_address_t slide_pc,
+                                                                                             pl_nlist_common *symtab, uint32_t nsyms,
+                                                                                             plcrash_async_macho_symtab_entry_t *found_symbol,
+                                                                                             plcrash_async_macho_symtab_entry_t *prev_symbol,
+                                                                                             bool *did_find_symbol,
+                                                                                             bool m64,
+                                                                                             bool swapped)
+{
+    /* Walk the symbol table. We know that symbols[i] is valid, since we fetched a pointer+len based on the value using
+     * plcrash_async_mobject_remap_address() above. */
+    for (uint32_t i = 0; i < nsyms; i++) {
+        pl_nlist_common *symbol;
+        if (m64) {
+            symbol = (pl_nlist_common *) &(((struct nlist_64 *) symtab)[i]);
+        } else {
+            symbol = (pl_nlist_common *) &(((struct nlist *) symtab)[i]);
+        }
+
+        /* Symbol must be within a section, and must not be a debugging entry. */
+        uint8_t n_type = symbol->n32.n_type;
+        if ((n_type & N_TYPE) != N_SECT || ((n_type & N_STAB) != 0))
+            continue;
+
+        /* Search for the best match. We're looking for the closest symbol occuring before PC. */
+        uint64_t n_value = m64 ? plcrash_async_swap64_if(swapped, symbol->n64.n_value) : plcrash_async_swap32_if(swapped, symbol->n32.n_value);
+        if (n_value <= slide_pc && (!*did_find_symbol || prev_symbol->n_value < n_value)) {
+            /* Only the matching entries are fully decoded */
+            *found_symbol = plcrash_async_macho_symtab_reader_read(reader, symtab, i);
+
+            /* The newly found symbol is now the symbol to be matched against */
+            prev_symbol = found_symbol;
+            *did_find_symbol = true;
+        }
+    }
+}
+
 /*
  * Locate a symtab entry for @a slide_pc within @a symbtab. This is performed using best-guess heuristics, and may
  * be incorrect.
@@ -826,29 +1171,22 @@ static void plcrash_async_macho_find_best_symbol (plcrash_async_macho_symtab_rea
                                                   plcrash_async_macho_symtab_entry_t *prev_symbol,
                                                   bool *did_find_symbol)
 {
-    plcrash_async_macho_symtab_entry_t new_entry;
-    
     /* Set did_find_symbol to false by default */
     if (prev_symbol == NULL)
         *did_find_symbol = false;
 
-    /* Walk the symbol table. We know that symbols[i] is valid, since we fetched a pointer+len based on the value using
-     * plcrash_async_mobject_remap_address() above. */
-    for (uint32_t i = 0; i < nsyms; i++) {
-        new_entry = plcrash_async_macho_symtab_reader_read(reader, symtab, i);
-        
-        /* Symbol must be within a section, and must not be a debugging entry. */
-        if ((new_entry.n_type & N_TYPE) != N_SECT || ((new_entry.n_type & N_STAB) != 0))
-            continue;
-
-        /* Search for the best match. We're looking for the closest symbol occuring before PC. */
-        if (new_entry.n_value <= slide_pc && (!*did_find_symbol || prev_symbol->n_value < new_entry.n_value)) {
-            *found_symbol = new_entry;
-
-            /* The newly found symbol is now the symbol to be matched against */
-            prev_symbol = found_symbol;
-            *did_find_symbol = true;
-        }
+    /* Dispatch once to the specialized implementation for the image's word size and byte order */
+    bool swapped = plcrash_async_byteorder_is_swapped(reader->image->byteorder);
+    if (reader->image->m64) {
+        if (swapped)
+            plcrash_async_macho_find_best_symbol_impl(reader, slide_pc, symtab, nsyms, found_symbol, prev_symbol, did_find_symbol, true, true);
+        else
+            plcrash_async_macho_find_best_symbol_impl(reader, slide_pc, symtab, nsyms, found_symbol, prev_symbol, did_find_symbol, true, false);
+    } else {
+        if (swapped)
+            plcrash_async_macho_find_best_symbol_impl(reader, slide_pc, symtab, nsyms, found_symbol, prev_symbol, did_find_symbol, false, true);
+        else
+            plcrash_async_macho_find_best_symbol_impl(reader, slide_pc, symtab, nsyms, found_symbol, prev_symbol, did_find_symbol, false, false);
     }
 }
 
@@ -931,7 +1269,7 @@ void plcrash_async_macho_mapped_segment_free (pl_async_macho_mapped_segment_t *s
  * @warning This method is not async safe.
  */
 void plcrash_nasync_macho_free (plcrash_async_macho_t *image) {
-    if (image->name != NULL)
+    if (image->owns_name && image->name != NULL)
         free(image->name);
     
     plcrash_async_mobject_free(&image->load_cmds);
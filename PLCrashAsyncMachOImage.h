@@ -46,6 +46,122 @@ extern "C" {
  * @{
  */
 
+/**
+ * @internal
+ *
+ * Sentinel offset used within plcrash_async_macho_cmd_index_t to mark an indexed load command, segment, or section
+ * as not present within the image.
+ */
+#define PLCRASH_ASYNC_MACHO_INDEX_NONE UINT32_MAX
+
+/**
+ * @internal
+ *
+ * Segments indexed by plcrash_nasync_macho_init().
+ */
+typedef enum {
+    /** __TEXT */
+    PLCRASH_ASYNC_MACHO_INDEX_SEG_TEXT = 0,
+
+    /** __DATA */
+    PLCRASH_ASYNC_MACHO_INDEX_SEG_DATA,
+
+    /** __LINKEDIT */
+    PLCRASH_ASYNC_MACHO_INDEX_SEG_LINKEDIT,
+
+    /** __OBJC */
+    PLCRASH_ASYNC_MACHO_INDEX_SEG_OBJC,
+
+    /** __DWARF */
+    PLCRASH_ASYNC_MACHO_INDEX_SEG_DWARF,
+
+    /** The number of indexed segments. */
+    PLCRASH_ASYNC_MACHO_INDEX_SEG_COUNT
+} plcrash_async_macho_index_seg_t;
+
+/**
+ * @internal
+ *
+ * Sections indexed by plcrash_nasync_macho_init().
+ */
+typedef enum {
+    /** __TEXT,__unwind_info */
+    PLCRASH_ASYNC_MACHO_INDEX_SECT_UNWIND_INFO = 0,
+
+    /** __TEXT,__eh_frame */
+    PLCRASH_ASYNC_MACHO_INDEX_SECT_EH_FRAME,
+
+    /** __DWARF,__debug_frame */
+    PLCRASH_ASYNC_MACHO_INDEX_SECT_DEBUG_FRAME,
+
+    /** __DATA,__objc_const */
+    PLCRASH_ASYNC_MACHO_INDEX_SECT_OBJC_CONST,
+
+    /** __DATA,__objc_classlist */
+    PLCRASH_ASYNC_MACHO_INDEX_SECT_OBJC_CLASSLIST,
+
+    /** __DATA,__objc_catlist */
+    PLCRASH_ASYNC_MACHO_INDEX_SECT_OBJC_CATLIST,
+
+    /** __DATA,__objc_data */
+    PLCRASH_ASYNC_MACHO_INDEX_SECT_OBJC_DATA,
+
+    /** __OBJC,__module_info */
+    PLCRASH_ASYNC_MACHO_INDEX_SECT_OBJC_MODULE_INFO,
+
+    /** The number of indexed sections. */
+    PLCRASH_ASYNC_MACHO_INDEX_SECT_COUNT
+} plcrash_async_macho_index_sect_t;
+
+/**
+ * @internal
+ *
+ * Index of the load commands, segments, and sections accessed at crash time. Each entry is the offset of the
+ * first matching load command (or section table entry) relative to the start of the mapped load commands, or
+ * PLCRASH_ASYNC_MACHO_INDEX_NONE if not present. All indexed entries have been validated to be fully contained
+ * within the mapped load commands.
+ */
+typedef struct plcrash_async_macho_cmd_index {
+    /** If false, the load commands could not be indexed, and all lookups fall back on a linear walk of the
+     * load commands. */
+    bool valid;
+
+    /** LC_SYMTAB */
+    uint32_t symtab;
+
+    /** LC_DYSYMTAB */
+    uint32_t dysymtab;
+
+    /** LC_UUID */
+    uint32_t uuid;
+
+    /** LC_SEGMENT/LC_SEGMENT_64 commands, indexed by plcrash_async_macho_index_seg_t. */
+    uint32_t segments[PLCRASH_ASYNC_MACHO_INDEX_SEG_COUNT];
+
+    /** section/section_64 entries, indexed by plcrash_async_macho_index_sect_t. */
+    uint32_t sections[PLCRASH_ASYNC_MACHO_INDEX_SECT_COUNT];
+} plcrash_async_macho_cmd_index_t;
+
+/**
+ * @internal
+ *
+ * Image capability flags, derived from the load command index by plcrash_nasync_macho_init(). Readers may use these
+ * to skip images that cannot provide the data they require, without repeatedly probing for absent sections.
+ */
+typedef enum {
+    /** The image contains a __TEXT,__unwind_info compact unwind section. */
+    PLCRASH_ASYNC_MACHO_CAP_COMPACT_UNWIND = 1 << 0,
+
+    /** The image contains a __TEXT,__eh_frame or __DWARF,__debug_frame DWARF unwind section. */
+    PLCRASH_ASYNC_MACHO_CAP_DWARF_UNWIND = 1 << 1,
+
+    /** The image contains ObjC1 __OBJC,__module_info class data. */
+    PLCRASH_ASYNC_MACHO_CAP_OBJC1 = 1 << 2,
+
+    /** The image contains the full set of ObjC2 __DATA sections required for class parsing. */
+    PLCRASH_ASYNC_MACHO_CAP_OBJC2 = 1 << 3,
+} plcrash_async_macho_cap_t;
+
 /**
  * @internal
  *
@@ -64,6 +180,9 @@ typedef struct plcrash_async_macho {
     /** The binary image's name/path. */
     char *name;
 
+    /** If true, @a name is owned by the image, and will be freed by plcrash_nasync_macho_free(). */
+    bool owns_name;
+
     /** The Mach-O header. For our purposes, the 32-bit and 64-bit headers are identical. Note that the header
      * values may require byte-swapping for the local process' use. */
     struct mach_header header;
@@ -78,6 +197,12 @@ typedef struct plcrash_async_macho {
     /** Mapped Mach-O load commands */
     plcrash_async_mobject_t load_cmds;
 
+    /** Index of the load commands, segments, and sections used at crash time. */
+    plcrash_async_macho_cmd_index_t cmd_index;
+
+    /** The image's capabilities, as a bitwise OR of plcrash_async_macho_cap_t flags. */
+    uint32_t capabilities;
+
     /** The Mach-O image's __TEXT segment, as defined by the LC_SEGMENT/LC_SEGMENT_64 load command. */
     pl_vm_address_t text_vmaddr;
 
@@ -187,12 +312,14 @@ typedef struct plcrash_async_macho_symtab_reader {
 typedef void (*pl_async_macho_found_symbol_cb)(pl_vm_address_t address, const char *name, void *ctx);
 
 plcrash_error_t plcrash_nasync_macho_init (plcrash_async_macho_t *image, mach_port_t task, const char *name, pl_vm_address_t header);
+plcrash_error_t plcrash_async_macho_init (plcrash_async_macho_t *image, mach_port_t task, const char *name, pl_vm_address_t header);
 
 const plcrash_async_byteorder_t *plcrash_async_macho_byteorder (plcrash_async_macho_t *image);
 const struct mach_header *plcrash_async_macho_header (plcrash_async_macho_t *image);
 pl_vm_size_t plcrash_async_macho_header_size (plcrash_async_macho_t *image);
     
 bool plcrash_async_macho_contains_address (plcrash_async_macho_t *image, pl_vm_address_t address);
+bool plcrash_async_macho_has_capability (plcrash_async_macho_t *image, plcrash_async_macho_cap_t capability);
 
 cpu_type_t plcrash_async_macho_cpu_type (plcrash_async_macho_t *image);
 cpu_subtype_t plcrash_async_macho_cpu_subtype (plcrash_async_macho_t *image);
@@ -201,9 +328,12 @@ void *plcrash_async_macho_next_command (plcrash_async_macho_t *image, void *prev
 void *plcrash_async_macho_next_command_type (plcrash_async_macho_t *image, void *previous, uint32_t expectedCommand);
 void *plcrash_async_macho_find_command (plcrash_async_macho_t *image, uint32_t cmd);
 void *plcrash_async_macho_find_segment_cmd (plcrash_async_macho_t *image, const char *segname);
+void *plcrash_async_macho_find_indexed_segment_cmd (plcrash_async_macho_t *image, plcrash_async_macho_index_seg_t segment);
 
 plcrash_error_t plcrash_async_macho_map_segment (plcrash_async_macho_t *image, const char *segname, pl_async_macho_mapped_segment_t *seg);
 plcrash_error_t plcrash_async_macho_map_section (plcrash_async_macho_t *image, const char *segname, const char *sectname, plcrash_async_mobject_t *mobj);
+plcrash_error_t plcrash_async_macho_map_indexed_segment (plcrash_async_macho_t *image, plcrash_async_macho_index_seg_t segment, pl_async_macho_mapped_segment_t *seg);
+plcrash_error_t plcrash_async_macho_map_indexed_section (plcrash_async_macho_t *image, plcrash_async_macho_index_sect_t section, plcrash_async_mobject_t *mobj);
 
 plcrash_error_t plcrash_async_macho_find_symbol_by_pc (plcrash_async_macho_t *image, pl_vm_address_t pc, pl_async_macho_found_symbol_cb symbol_cb, void *context);
 plcrash_error_t plcrash_async_macho_find_symbol_by_name (plcrash_async_macho_t *image, const char *symbol, pl_vm_address_t *pc);
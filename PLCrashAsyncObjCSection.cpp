@@ -332,7 +332,7 @@ static plcrash_error_t map_sections (plcrash_async_macho_t *image, plcrash_async
     plcrash_error_t err;
     
     /* Map in the __objc_const section, which is where all the read-only class data lives. */
-    err = plcrash_async_macho_map_section(image, kDataSegmentName, kObjCConstSectionName, &context->objcConstMobj);
+    err = plcrash_async_macho_map_indexed_section(image, PLCRASH_ASYNC_MACHO_INDEX_SECT_OBJC_CONST, &context->objcConstMobj);
     if (err != PLCRASH_ESUCCESS) {
         if (err != PLCRASH_ENOTFOUND)
             PLCF_DEBUG("pl_async_macho_map_section(%p, %s, %s, %p) failure %d", image, kDataSegmentName, kObjCConstSectionName, &context->objcConstMobj, err);
@@ -341,7 +341,7 @@ static plcrash_error_t map_sections (plcrash_async_macho_t *image, plcrash_async
     context->objcConstMobjInitialized = true;
     
     /* Map in the class list section.  */
-    err = plcrash_async_macho_map_section(image, kDataSegmentName, kClassListSectionName, &context->classMobj);
+    err = plcrash_async_macho_map_indexed_section(image, PLCRASH_ASYNC_MACHO_INDEX_SECT_OBJC_CLASSLIST, &context->classMobj);
     if (err != PLCRASH_ESUCCESS) {
         if (err != PLCRASH_ENOTFOUND)
             PLCF_DEBUG("pl_async_macho_map_section(%s, %s, %s, %p) failure %d", image->name, kDataSegmentName, kClassListSectionName, &context->classMobj, err);
@@ -350,7 +350,7 @@ static plcrash_error_t map_sections (plcrash_async_macho_t *image, plcrash_async
     context->classMobjInitialized = true;
     
     /* Map in the category list section.  */
-    err = plcrash_async_macho_map_section(image, kDataSegmentName, kCategoryListSectionName, &context->catMobj);
+    err = plcrash_async_macho_map_indexed_section(image, PLCRASH_ASYNC_MACHO_INDEX_SECT_OBJC_CATLIST, &context->catMobj);
     if (err != PLCRASH_ESUCCESS) {
         if (err != PLCRASH_ENOTFOUND)
             PLCF_DEBUG("pl_async_macho_map_section(%s, %s, %s, %p) failure %d", image->name, kDataSegmentName, kCategoryListSectionName, &context->catMobj, err);
@@ -359,7 +359,7 @@ static plcrash_error_t map_sections (plcrash_async_macho_t *image, plcrash_async
     context->catMobjInitialized = true;
     
     /* Map in the __objc_data section, which is where the actual classes live. */
-    err = plcrash_async_macho_map_section(image, kDataSegmentName, kObjCDataSectionName, &context->objcDataMobj);
+    err = plcrash_async_macho_map_indexed_section(image, PLCRASH_ASYNC_MACHO_INDEX_SECT_OBJC_DATA, &context->objcDataMobj);
     if (err != PLCRASH_ESUCCESS) {
         /* If the class list was found, the data section must also be found */
         PLCF_DEBUG("pl_async_macho_map_section(%s, %s, %s, %p) failure %d", image->name, kDataSegmentName, kObjCDataSectionName, &context->objcDataMobj, err);
@@ -506,7 +506,7 @@ static plcrash_error_t pl_async_objc_parse_from_module_info (plcrash_async_macho
     bool moduleMobjInitialized = false;
     plcrash_async_mobject_t moduleMobj;
 
-    err = plcrash_async_macho_map_section(image, kObjCSegmentName, kObjCModuleInfoSectionName, &moduleMobj);
+    err = plcrash_async_macho_map_indexed_section(image, PLCRASH_ASYNC_MACHO_INDEX_SECT_OBJC_MODULE_INFO, &moduleMobj);
     if (err != PLCRASH_ESUCCESS) {
         if (err != PLCRASH_ENOTFOUND)
             PLCF_DEBUG("pl_async_macho_map_section(%p, %s, %s, %p) failure %d", image, kObjCSegmentName, kObjCModuleInfoSectionName, &moduleMobj, err);
@@ -1070,16 +1070,16 @@ static plcrash_error_t plcrash_async_objc_parse (plcrash_async_macho_t *image, p
     if (cache == NULL)
         return PLCRASH_EACCESS;
    
-    if (!cache->gotObjC2Info) {
+    if (!cache->gotObjC2Info && plcrash_async_macho_has_capability(image, PLCRASH_ASYNC_MACHO_CAP_OBJC1)) {
         /* Try ObjC1 data. */
         err = pl_async_objc_parse_from_module_info(image, callback, ctx);
     } else {
-        /* If it couldn't be found before, don't even bother to try again. */
+        /* If it couldn't be found before, or the image has no ObjC1 data, don't even bother to try. */
         err = PLCRASH_ENOTFOUND;
     }
     
     /* If there wasn't any, try ObjC2 data. */
-    if (err == PLCRASH_ENOTFOUND) {
+    if (err == PLCRASH_ENOTFOUND && plcrash_async_macho_has_capability(image, PLCRASH_ASYNC_MACHO_CAP_OBJC2)) {
         if (image->m64)
             err = pl_async_objc_parse_from_data_section<pl_objc2_class_64, pl_objc2_class_data_ro_64, pl_objc2_class_data_rw_64, pl_objc2_category_64, uint64_t>(image, cache, callback, ctx);
         else
@@ -54,17 +54,49 @@ static void macho_symbol_callback (pl_vm_address_t address, const char *name, vo
 static void objc_symbol_callback (bool isClassMethod, plcrash_async_macho_string_t *className, plcrash_async_macho_string_t *methodName, pl_vm_address_t imp, void *ctx);
 
 /**
- * Initialize a symbol-finding context object.
+ * Initialize a symbol-finding context object. Found symbols are not memoized.
  *
  * @param cache A pointer to the cache object to initialize.
  * @return An error code.
  */
 plcrash_error_t plcrash_async_symbol_cache_init (plcrash_async_symbol_cache_t *cache) {
+    return plcrash_async_symbol_cache_init_with_memo(cache, NULL);
+}
+
+/**
+ * Initialize a symbol-finding context object, memoizing found symbols in @a memo. This performs no allocation,
+ * and may be used at crash time.
+ *
+ * @param cache A pointer to the cache object to initialize.
+ * @param memo The memo table storage to be used by @a cache, or NULL to disable memoization. Any existing contents
+ * are discarded. This is a borrowed reference, and must remain valid until @a cache is freed.
+ * @return An error code.
+ */
+plcrash_error_t plcrash_async_symbol_cache_init_with_memo (plcrash_async_symbol_cache_t *cache, plcrash_async_symbol_memo_t *memo) {
+    cache->memo = memo;
+    if (memo != NULL) {
+        memo->count = 0;
+        memo->names_used = 0;
+    }
+
+    cache->stats.lookup_count = 0;
+    cache->stats.memo_hit_count = 0;
+
     return plcrash_async_objc_cache_init(&cache->objc_cache);
 }
 
 /**
- * Free a symbol-finding context object.
+ * Fetch the lookup statistics of @a cache.
+ *
+ * @param cache The cache.
+ * @param stats On return, the cache's statistics.
+ */
+void plcrash_async_symbol_cache_get_stats (plcrash_async_symbol_cache_t *cache, plcrash_async_symbol_cache_stats_t *stats) {
+    *stats = cache->stats;
+}
+
+/**
+ * Free a symbol-finding context object. The cache's memo table storage, if any, is borrowed and is not freed.
  *
  * @param cache A pointer to the cache object to free.
  */
@@ -72,6 +104,99 @@ void plcrash_async_symbol_cache_free (plcrash_async_symbol_cache_t *cache) {
     plcrash_async_objc_cache_free(&cache->objc_cache);
 }
 
+/**
+ * @internal
+ *
+ * Return the position within @a memo's sorted index of the first entry with a symbol address greater than
+ * @a address.
+ */
+static uint32_t symbol_memo_upper_bound (plcrash_async_symbol_memo_t *memo, pl_vm_address_t address) {
+    uint32_t low = 0;
+    uint32_t high = memo->count;
+
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (memo->entries[memo->sorted[mid]].symbol_address <= address)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+/**
+ * @internal
+ *
+ * Look up the memoized function containing @a pc.
+ *
+ * @return Returns the memoized entry, or NULL if no function containing @a pc has been memoized.
+ */
+static plcrash_async_symbol_memo_entry_t *symbol_memo_get (plcrash_async_symbol_memo_t *memo, plcrash_async_symbol_strategy_t strategy, pl_vm_address_t pc) {
+    if (memo == NULL)
+        return NULL;
+
+    uint32_t pos = symbol_memo_upper_bound(memo, pc);
+    if (pos == 0)
+        return NULL;
+
+    plcrash_async_symbol_memo_entry_t *entry = &memo->entries[memo->sorted[pos - 1]];
+    if (pc > entry->max_pc || entry->strategy != strategy)
+        return NULL;
+
+    return entry;
+}
+
+/**
+ * @internal
+ *
+ * Memoize the symbol found for @a pc. The memo table is a cache; insertion may silently fail if the table or name
+ * storage is exhausted.
+ */
+static void symbol_memo_set (plcrash_async_symbol_memo_t *memo, plcrash_async_symbol_strategy_t strategy, pl_vm_address_t pc, pl_vm_address_t symbol_address, const char *name) {
+    if (memo == NULL || pc < symbol_address)
+        return;
+
+    /* PCs within an already memoized function extend its range */
+    uint32_t pos = symbol_memo_upper_bound(memo, symbol_address);
+    if (pos > 0) {
+        plcrash_async_symbol_memo_entry_t *entry = &memo->entries[memo->sorted[pos - 1]];
+        if (entry->symbol_address == symbol_address) {
+            if (entry->strategy == strategy && pc > entry->max_pc)
+                entry->max_pc = pc;
+            return;
+        }
+    }
+
+    if (memo->count == PLCRASH_ASYNC_SYMBOL_MEMO_ENTRIES)
+        return;
+
+    /* Copy the name into the name storage */
+    size_t length = 1;
+    for (const char *p = name; *p != '\0'; p++)
+        length++;
+
+    if (length > PLCRASH_ASYNC_SYMBOL_MEMO_NAME_BYTES - memo->names_used)
+        return;
+
+    plcrash_async_memcpy(memo->names + memo->names_used, name, length);
+
+    uint16_t index = (uint16_t) memo->count;
+    plcrash_async_symbol_memo_entry_t *entry = &memo->entries[index];
+    entry->symbol_address = symbol_address;
+    entry->max_pc = pc;
+    entry->name_offset = memo->names_used;
+    entry->strategy = strategy;
+    memo->names_used += (uint32_t) length;
+
+    /* Insert into the sorted index; only the 16-bit indices following the insertion point are moved */
+    for (uint32_t i = memo->count; i > pos; i--)
+        memo->sorted[i] = memo->sorted[i - 1];
+    memo->sorted[pos] = index;
+
+    memo->count++;
+}
+
 /**
  * Find the best-guess matching symbol name for a given @a pc address, using heuristics based on symbol and @a pc address locality.
  *
@@ -96,6 +221,17 @@ plcrash_error_t plcrash_async_find_symbol (plcrash_async_macho_t *image,
     plcrash_error_t machoErr = PLCRASH_ENOTFOUND;
     plcrash_error_t objcErr = PLCRASH_ENOTFOUND;
 
+    /* PCs within the same function are common across threads and frames (and each frame is looked up twice by the
+     * log writer); answer these from the memo table */
+    cache->stats.lookup_count++;
+
+    plcrash_async_symbol_memo_entry_t *memo = symbol_memo_get(cache->memo, strategy, pc);
+    if (memo != NULL) {
+        cache->stats.memo_hit_count++;
+        callback(memo->symbol_address, cache->memo->names + memo->name_offset, ctx);
+        return PLCRASH_ESUCCESS;
+    }
+
     lookup_ctx.symbol_address = 0x0;
     lookup_ctx.found = false;
 
@@ -120,6 +256,8 @@ plcrash_error_t plcrash_async_find_symbol (plcrash_async_macho_t *image,
         return PLCRASH_EINTERNAL;
     }
 
+    symbol_memo_set(cache->memo, strategy, pc, lookup_ctx.symbol_address, lookup_ctx.buffer);
+
     callback(lookup_ctx.symbol_address, lookup_ctx.buffer, ctx);
     return PLCRASH_ESUCCESS;
 }
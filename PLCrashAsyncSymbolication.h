@@ -78,6 +78,68 @@ typedef enum {
     PLCRASH_ASYNC_SYMBOL_STRATEGY_ALL = (PLCRASH_ASYNC_SYMBOL_STRATEGY_SYMBOL_TABLE|PLCRASH_ASYNC_SYMBOL_STRATEGY_OBJC)
 } plcrash_async_symbol_strategy_t;
 
+/** The number of functions recorded by a symbol memo table. */
+#define PLCRASH_ASYNC_SYMBOL_MEMO_ENTRIES 512
+
+/** The size, in bytes, of a symbol memo table's name storage. */
+#define PLCRASH_ASYNC_SYMBOL_MEMO_NAME_BYTES (32 * 1024)
+
+/**
+ * @internal
+ *
+ * A memoized function symbol.
+ */
+typedef struct plcrash_async_symbol_memo_entry {
+    /** The address of the function's symbol. */
+    pl_vm_address_t symbol_address;
+
+    /** The greatest PC known to resolve to @a symbol_address. Symbol lookups return the closest symbol at or below
+     * a PC, and so all PCs within [symbol_address, max_pc] resolve to this symbol. */
+    pl_vm_address_t max_pc;
+
+    /** The offset of the symbol's NUL-terminated name within the memo table's name storage. */
+    uint32_t name_offset;
+
+    /** The strategy used to perform the lookup. */
+    plcrash_async_symbol_strategy_t strategy;
+} plcrash_async_symbol_memo_entry_t;
+
+/**
+ * @internal
+ *
+ * Fixed-size storage for a symbol cache's memo table, keyed by function start address. The storage must be
+ * allocated prior to crash time, and may be reused by any number of sequential caches.
+ */
+typedef struct plcrash_async_symbol_memo {
+    /** Memoized functions, in insertion order. */
+    plcrash_async_symbol_memo_entry_t entries[PLCRASH_ASYNC_SYMBOL_MEMO_ENTRIES];
+
+    /** Indices into @a entries, sorted by symbol address. */
+    uint16_t sorted[PLCRASH_ASYNC_SYMBOL_MEMO_ENTRIES];
+
+    /** The number of valid entries. */
+    uint32_t count;
+
+    /** Memoized name storage. */
+    char names[PLCRASH_ASYNC_SYMBOL_MEMO_NAME_BYTES];
+
+    /** The number of bytes of @a names in use. */
+    uint32_t names_used;
+} plcrash_async_symbol_memo_t;
+
+/**
+ * @internal
+ *
+ * Symbol cache statistics.
+ */
+typedef struct plcrash_async_symbol_cache_stats {
+    /** The number of symbol lookups performed. */
+    uint64_t lookup_count;
+
+    /** The number of symbol lookups answered from the memo table. */
+    uint64_t memo_hit_count;
+} plcrash_async_symbol_cache_stats_t;
+
 /**
  * @internal
  *
@@ -90,9 +152,17 @@ typedef enum {
 typedef struct plcrash_async_symbol_cache {
     /** Objective-C look-up cache. */
     plcrash_async_objc_cache_t objc_cache;
+
+    /** Borrowed memo table storage, or NULL if lookups are not memoized. */
+    plcrash_async_symbol_memo_t *memo;
+
+    /** Lookup statistics. */
+    plcrash_async_symbol_cache_stats_t stats;
 } plcrash_async_symbol_cache_t;
 
 plcrash_error_t plcrash_async_symbol_cache_init (plcrash_async_symbol_cache_t *cache);
+plcrash_error_t plcrash_async_symbol_cache_init_with_memo (plcrash_async_symbol_cache_t *cache, plcrash_async_symbol_memo_t *memo);
+void plcrash_async_symbol_cache_get_stats (plcrash_async_symbol_cache_t *cache, plcrash_async_symbol_cache_stats_t *stats);
 void plcrash_async_symbol_cache_free (plcrash_async_symbol_cache_t *cache);
 
 
@@ -97,6 +97,16 @@
 #    define PLCRASH_FEATURE_UNWIND_COMPACT 1
 #endif
 
+#ifndef PLCRASH_FEATURE_DEFERRED_IMAGE_INIT
+/**
+ * If true, binary images reported by dyld are only recorded at load time; parsing of each image's Mach-O data is
+ * deferred to a background queue, or performed on demand at crash time for any image that has not yet been
+ * initialized. This reduces the launch-time cost of image registration, at the cost of additional work at crash
+ * time for images loaded immediately prior to a crash.
+ */
+#    define PLCRASH_FEATURE_DEFERRED_IMAGE_INIT 0
+#endif
+
 /**
  * @}
  */
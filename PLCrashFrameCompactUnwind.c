@@ -27,11 +27,12 @@
 
 #include "PLCrashFrameCompactUnwind.h"
 #include "PLCrashAsyncCompactUnwindEncoding.h"
+#include "PLCrashFrameDWARFUnwind.h"
 #include "PLCrashFeatureConfig.h"
 
 #include <inttypes.h>
 
-#if PLCRASH_FEATURE_UNWIND_DWARF
+#if PLCRASH_FEATURE_UNWIND_COMPACT
 
 /**
  * Attempt to fetch next frame using compact frame unwinding data from @a image_list.
@@ -51,7 +52,6 @@ plframe_error_t plframe_cursor_read_compact_unwind (task_t task,
                                                     plframe_stackframe_t *next_frame)
 {
     plframe_error_t result;
-    plcrash_error_t err;
 
     /* Fetch the IP. It should always be available */
     if (!plcrash_async_thread_state_has_reg(&current_frame->thread_state, PLCRASH_REG_IP)) {
@@ -65,13 +65,50 @@ plframe_error_t plframe_cursor_read_compact_unwind (task_t task,
     plcrash_async_image_t *image = plcrash_async_image_containing_address(image_list, pc);
     if (image == NULL) {
         PLCF_DEBUG("Could not find a loaded image for the current frame pc: 0x%" PRIx64, (uint64_t) pc);
-        result = PLFRAME_ENOTSUP;
-        goto cleanup;
+        plcrash_async_image_list_set_reading(image_list, false);
+        return PLFRAME_ENOTSUP;
     }
-    
+
+    result = plframe_cursor_read_compact_unwind_with_image(task, image_list, image, current_frame, previous_frame, next_frame);
+
+    plcrash_async_image_list_set_reading(image_list, false);
+    return result;
+}
+
+/**
+ * Attempt to fetch next frame using compact frame unwinding data from @a image, which has already been resolved
+ * by the caller.
+ *
+ * @param task The task containing the target frame stack.
+ * @param image_list The list of images loaded in the target @a task. The caller must have marked the list as being
+ * read via plcrash_async_image_list_set_reading() for the duration of this call.
+ * @param image The image containing the current frame's PC.
+ * @param current_frame The current stack frame.
+ * @param previous_frame The previous stack frame, or NULL if this is the first frame.
+ * @param next_frame The new frame to be initialized.
+ *
+ * @return Returns PLFRAME_ESUCCESS on success, PLFRAME_ENOFRAME is no additional frames are available, or a standard plframe_error_t code if an error occurs.
+ */
+plframe_error_t plframe_cursor_read_compact_unwind_with_image (task_t task,
+                                                               plcrash_async_image_list_t *image_list,
+                                                               plcrash_async_image_t *image,
+                                                               const plframe_stackframe_t *current_frame,
+                                                               const plframe_stackframe_t *previous_frame,
+                                                               plframe_stackframe_t *next_frame)
+{
+    plframe_error_t result;
+    plcrash_error_t err;
+
+    /* Fetch the IP. It should always be available */
+    if (!plcrash_async_thread_state_has_reg(&current_frame->thread_state, PLCRASH_REG_IP)) {
+        PLCF_DEBUG("Frame is missing a valid IP register, skipping compact unwind encoding");
+        return PLFRAME_EBADFRAME;
+    }
+    plcrash_greg_t pc = plcrash_async_thread_state_get_reg(&current_frame->thread_state, PLCRASH_REG_IP);
+
     /* Map the unwind section */
     plcrash_async_mobject_t unwind_mobj;
-    err = plcrash_async_macho_map_section(&image->macho_image, SEG_TEXT, "__unwind_info", &unwind_mobj);
+    err = plcrash_async_macho_map_indexed_section(&image->macho_image, PLCRASH_ASYNC_MACHO_INDEX_SECT_UNWIND_INFO, &unwind_mobj);
     if (err != PLCRASH_ESUCCESS) {
         if (err != PLCRASH_ENOTFOUND)
             PLCF_DEBUG("Could not map the compact unwind info section for image %s: %d", image->macho_image.name, err);
@@ -83,7 +120,7 @@ plframe_error_t plframe_cursor_read_compact_unwind (task_t task,
     cpu_type_t cputype = image->macho_image.byteorder->swap32(image->macho_image.header.cputype);
     plcrash_async_cfe_reader_t reader;
 
-    err = plcrash_async_cfe_reader_init(&reader, &unwind_mobj, cputype);
+    err = plcrash_async_cfe_reader_init(&reader, &unwind_mobj, cputype, image_list->_cfe_page_cache);
     if (err != PLCRASH_ESUCCESS) {
         PLCF_DEBUG("Could not parse the compact unwind info section for image '%s': %d", image->macho_image.name, err);
         result = PLFRAME_EINVAL;
@@ -118,6 +155,24 @@ plframe_error_t plframe_cursor_read_compact_unwind (task_t task,
         goto cleanup;
     }
     
+    /*
+     * If the encoding defers to DWARF, hand the provided FDE offset directly to the DWARF reader; this avoids
+     * repeating the image lookup and the linear FDE search that would otherwise be performed by the DWARF frame reader.
+     */
+    if (plcrash_async_cfe_entry_type(&entry) == PLCRASH_ASYNC_CFE_ENTRY_TYPE_DWARF) {
+#if PLCRASH_FEATURE_UNWIND_DWARF
+        result = plframe_cursor_read_dwarf_unwind_fde(task, image_list, image, plcrash_async_cfe_entry_stack_offset(&entry), current_frame, previous_frame, next_frame);
+        if (result != PLFRAME_ESUCCESS)
+            PLCF_DEBUG("Failed to apply DWARF FDE at offset 0x%" PRIx64 " for PC 0x%" PRIx64 ": %d", (uint64_t) plcrash_async_cfe_entry_stack_offset(&entry), (uint64_t) pc, result);
+#else
+        /* DWARF unwinding is not available */
+        result = PLFRAME_ENOTSUP;
+#endif
+
+        plcrash_async_cfe_entry_free(&entry);
+        goto cleanup;
+    }
+
     /* Compute the in-core function address */
     pl_vm_address_t function_address;
     if (!plcrash_async_address_apply_offset(image->macho_image.header_addr, function_base, &function_address)) {
@@ -140,8 +195,7 @@ plframe_error_t plframe_cursor_read_compact_unwind (task_t task,
     plcrash_async_cfe_entry_free(&entry);
 
 cleanup:
-    plcrash_async_image_list_set_reading(image_list, false);
     return result;
 }
 
-#endif /* PLCRASH_FEATURE_UNWIND_DWARF */
+#endif /* PLCRASH_FEATURE_UNWIND_COMPACT */
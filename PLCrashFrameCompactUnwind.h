@@ -31,7 +31,7 @@
 #include "PLCrashFrameWalker.h"
 #include "PLCrashAsyncCompactUnwindEncoding.h"
 
-#if PLCRASH_FEATURE_UNWIND_DWARF
+#if PLCRASH_FEATURE_UNWIND_COMPACT
 
 #ifdef __cplusplus
 extern "C" {
@@ -42,10 +42,17 @@ plframe_error_t plframe_cursor_read_compact_unwind (task_t task,
                                                     const plframe_stackframe_t *current_frame,
                                                     const plframe_stackframe_t *previous_frame,
                                                     plframe_stackframe_t *next_frame);
+
+plframe_error_t plframe_cursor_read_compact_unwind_with_image (task_t task,
+                                                               plcrash_async_image_list_t *image_list,
+                                                               plcrash_async_image_t *image,
+                                                               const plframe_stackframe_t *current_frame,
+                                                               const plframe_stackframe_t *previous_frame,
+                                                               plframe_stackframe_t *next_frame);
     
 #ifdef __cplusplus
 }
 #endif
 
-#endif /* PLCRASH_FEATURE_UNWIND_DWARF */
+#endif /* PLCRASH_FEATURE_UNWIND_COMPACT */
 #endif /* PLCRASH_FRAME_COMPACTUNWIND_H */
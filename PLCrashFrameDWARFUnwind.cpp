@@ -50,6 +50,9 @@ using namespace plcrash::async;
  * @param task The task containing the target frame stack.
  * @param pc The current frame's PC value.
  * @param image The Mach-O image for the current stack frame.
+ * @param cie_cache The cache to be used when parsing CIE records, or NULL.
+ * @param fde_offset The __eh_frame section-relative offset of the FDE for @a pc, as provided by the image's compact unwind
+ * encoding, or NULL if the FDE should be located by searching the image's DWARF frame data.
  * @param current_frame The current stack frame.
  * @param previous_frame The previous stack frame, or NULL if this is the first frame.
  * @param next_frame The new frame to be initialized.
@@ -63,6 +66,8 @@ template<typename machine_ptr, typename machine_ptr_s>
 static plframe_error_t plframe_cursor_read_dwarf_unwind_int (task_t task,
                                                              machine_ptr pc,
                                                              plcrash_async_macho_t *image,
+                                                             dwarf_cie_cache *cie_cache,
+                                                             const pl_vm_off_t *fde_offset,
                                                              const plframe_stackframe_t *current_frame,
                                                              const plframe_stackframe_t *previous_frame,
                                                              plframe_stackframe_t *next_frame)
@@ -95,13 +100,14 @@ static plframe_error_t plframe_cursor_read_dwarf_unwind_int (task_t task,
      * as such, we prefer eh_frame, but allow falling back on debug_frame.
      */
     {
-        err = plcrash_async_macho_map_section(image, "__TEXT", "__eh_frame", &eh_frame);
+        err = plcrash_async_macho_map_indexed_section(image, PLCRASH_ASYNC_MACHO_INDEX_SECT_EH_FRAME, &eh_frame);
         if (err == PLCRASH_ESUCCESS) {
             dwarf_section = &eh_frame;
         }
         
-        if (dwarf_section == NULL) {
-            err = plcrash_async_macho_map_section(image, "__DWARF", "__debug_frame", &debug_frame);
+        /* Compact unwind FDE offsets are only meaningful relative to eh_frame */
+        if (dwarf_section == NULL && fde_offset == NULL) {
+            err = plcrash_async_macho_map_indexed_section(image, PLCRASH_ASYNC_MACHO_INDEX_SECT_DEBUG_FRAME, &debug_frame);
             if (err == PLCRASH_ESUCCESS) {
                 dwarf_section = &debug_frame;
                 is_debug_frame = true;
@@ -117,15 +123,16 @@ static plframe_error_t plframe_cursor_read_dwarf_unwind_int (task_t task,
     }
     
     /* Initialize the reader. */
-    if ((err = reader.init(dwarf_section, image->byteorder, image->m64, is_debug_frame)) != PLCRASH_ESUCCESS) {
+    if ((err = reader.init(dwarf_section, image->byteorder, image->m64, is_debug_frame, cie_cache)) != PLCRASH_ESUCCESS) {
         PLCF_DEBUG("Could not initialize a %s DWARF parser for the current frame pc: 0x%" PRIx64 " %d", (is_debug_frame ? "debug_frame" : "eh_frame"), (uint64_t) pc, err);
         result = PLFRAME_EINVAL;
         goto cleanup;
     }
     
-    /* Find the FDE (if any) */
+    /* Find the FDE (if any). If the FDE offset is known, the search begins (and in the common case, ends) at the
+     * provided offset */
     {
-        err = reader.find_fde(0x0 /* offset hint */, pc, &fde_info);
+        err = reader.find_fde(fde_offset != NULL ? *fde_offset : 0x0, pc, &fde_info);
         
         if (err != PLCRASH_ESUCCESS) {
             result = PLFRAME_ENOTSUP;
@@ -141,7 +148,7 @@ static plframe_error_t plframe_cursor_read_dwarf_unwind_int (task_t task,
     
     /* Parse CIE info */
     {
-        err = plcrash_async_dwarf_cie_info_init(&cie_info, dwarf_section, image->byteorder, &ptr_state, plcrash_async_mobject_base_address(dwarf_section) + fde_info.cie_offset);
+        err = plcrash_async_dwarf_cie_info_init_cached(&cie_info, cie_cache, dwarf_section, image->byteorder, &ptr_state, plcrash_async_mobject_base_address(dwarf_section) + fde_info.cie_offset);
         if (err != PLCRASH_ESUCCESS) {
             PLCF_DEBUG("Failed to parse CIE at offset of 0x%" PRIx64 ": %d", (uint64_t) fde_info.cie_offset, err);
             result = PLFRAME_ENOTSUP;
@@ -198,6 +205,45 @@ cleanup:
     return result;
 }
 
+/**
+ * @internal
+ *
+ * Attempt to fetch next frame using DWARF frame unwinding data from @a image.
+ *
+ * @param task The task containing the target frame stack.
+ * @param pc The current frame's PC value.
+ * @param image The image containing @a pc. The caller is responsible for marking @a image_list as being read.
+ * @param image_list The list of images loaded in the target @a task.
+ * @param fde_offset The __eh_frame section-relative offset of the FDE for @a pc, or NULL if the FDE should be located by
+ * searching the image's DWARF frame data.
+ * @param current_frame The current stack frame.
+ * @param previous_frame The previous stack frame, or NULL if this is the first frame.
+ * @param next_frame The new frame to be initialized.
+ *
+ * @return Returns PLFRAME_ESUCCESS on success, PLFRAME_ENOFRAME is no additional frames are available, or a standard plframe_error_t code if an error occurs.
+ */
+static plframe_error_t plframe_cursor_read_dwarf_unwind_image (task_t task,
+                                                               plcrash_greg_t pc,
+                                                               plcrash_async_image_t *image,
+                                                               plcrash_async_image_list_t *image_list,
+                                                               const pl_vm_off_t *fde_offset,
+                                                               const plframe_stackframe_t *current_frame,
+                                                               const plframe_stackframe_t *previous_frame,
+                                                               plframe_stackframe_t *next_frame)
+{
+    if (image->macho_image.m64) {
+        /* Could only happen due to programmer error; eg, an image that doesn't actually match our thread state */
+        PLCF_ASSERT(pc <= UINT64_MAX);
+
+        return plframe_cursor_read_dwarf_unwind_int<uint64_t, int64_t>(task, pc, &image->macho_image, image_list->_dwarf_cie_cache, fde_offset, current_frame, previous_frame, next_frame);
+    } else {
+        /* Could only happen due to programmer error; eg, an image that doesn't actually match our thread state */
+        PLCF_ASSERT(pc <= UINT32_MAX);
+
+        return plframe_cursor_read_dwarf_unwind_int<uint32_t, int32_t>(task, pc, &image->macho_image, image_list->_dwarf_cie_cache, fde_offset, current_frame, previous_frame, next_frame);
+    }
+}
+
 /**
  * Attempt to fetch next frame using compact frame unwinding data from @a image_list.
  *
@@ -239,20 +285,77 @@ plframe_error_t plframe_cursor_read_dwarf_unwind (task_t task,
     }
     
     /* Perform the actual read */
-    if (image->macho_image.m64) {
-        /* Could only happen due to programmer error; eg, an image that doesn't actually match our thread state */
-        PLCF_ASSERT(pc <= UINT64_MAX);
-
-        ferr = plframe_cursor_read_dwarf_unwind_int<uint64_t, int64_t>(task, pc, &image->macho_image, current_frame, previous_frame, next_frame);
-    } else {
-        /* Could only happen due to programmer error; eg, an image that doesn't actually match our thread state */
-        PLCF_ASSERT(pc <= UINT32_MAX);
-
-        ferr = plframe_cursor_read_dwarf_unwind_int<uint32_t, int32_t>(task, pc, &image->macho_image, current_frame, previous_frame, next_frame);
-    }
+    ferr = plframe_cursor_read_dwarf_unwind_image(task, pc, image, image_list, NULL, current_frame, previous_frame, next_frame);
     
     plcrash_async_image_list_set_reading(image_list, false);
     return ferr;
 }
 
+/**
+ * Attempt to fetch next frame using DWARF frame unwinding data from @a image, which has already been resolved by
+ * the caller.
+ *
+ * @param task The task containing the target frame stack.
+ * @param image_list The list of images loaded in the target @a task. The caller must have marked the list as being
+ * read via plcrash_async_image_list_set_reading() for the duration of this call.
+ * @param image The image containing the current frame's PC.
+ * @param current_frame The current stack frame.
+ * @param previous_frame The previous stack frame, or NULL if this is the first frame.
+ * @param next_frame The new frame to be initialized.
+ *
+ * @return Returns PLFRAME_ESUCCESS on success, PLFRAME_ENOFRAME is no additional frames are available, or a standard plframe_error_t code if an error occurs.
+ */
+plframe_error_t plframe_cursor_read_dwarf_unwind_with_image (task_t task,
+                                                             plcrash_async_image_list_t *image_list,
+                                                             plcrash_async_image_t *image,
+                                                             const plframe_stackframe_t *current_frame,
+                                                             const plframe_stackframe_t *previous_frame,
+                                                             plframe_stackframe_t *next_frame)
+{
+    /* Fetch the IP. It should always be available */
+    if (!plcrash_async_thread_state_has_reg(&current_frame->thread_state, PLCRASH_REG_IP)) {
+        PLCF_DEBUG("Frame is missing a valid IP register, skipping DWARF unwind");
+        return PLFRAME_EBADFRAME;
+    }
+    plcrash_greg_t pc = plcrash_async_thread_state_get_reg(&current_frame->thread_state, PLCRASH_REG_IP);
+
+    return plframe_cursor_read_dwarf_unwind_image(task, pc, image, image_list, NULL, current_frame, previous_frame, next_frame);
+}
+
+/**
+ * Attempt to fetch next frame using the DWARF FDE at @a fde_offset within @a image's __eh_frame section.
+ *
+ * This is used by the compact unwind frame reader when an image's compact unwind encoding defers to DWARF; the
+ * encoding provides the FDE offset, and the image has already been resolved, avoiding both the image lookup and the
+ * linear FDE search performed by plframe_cursor_read_dwarf_unwind().
+ *
+ * @param task The task containing the target frame stack.
+ * @param image_list The list of images loaded in the target @a task. The caller must have marked the list as being
+ * read via plcrash_async_image_list_set_reading() for the duration of this call.
+ * @param image The image containing the current frame's PC.
+ * @param fde_offset The __eh_frame section-relative offset of the FDE for the current frame's PC.
+ * @param current_frame The current stack frame.
+ * @param previous_frame The previous stack frame, or NULL if this is the first frame.
+ * @param next_frame The new frame to be initialized.
+ *
+ * @return Returns PLFRAME_ESUCCESS on success, PLFRAME_ENOFRAME is no additional frames are available, or a standard plframe_error_t code if an error occurs.
+ */
+plframe_error_t plframe_cursor_read_dwarf_unwind_fde (task_t task,
+                                                      plcrash_async_image_list_t *image_list,
+                                                      plcrash_async_image_t *image,
+                                                      pl_vm_off_t fde_offset,
+                                                      const plframe_stackframe_t *current_frame,
+                                                      const plframe_stackframe_t *previous_frame,
+                                                      plframe_stackframe_t *next_frame)
+{
+    /* Fetch the IP. It should always be available */
+    if (!plcrash_async_thread_state_has_reg(&current_frame->thread_state, PLCRASH_REG_IP)) {
+        PLCF_DEBUG("Frame is missing a valid IP register, skipping DWARF unwind");
+        return PLFRAME_EBADFRAME;
+    }
+    plcrash_greg_t pc = plcrash_async_thread_state_get_reg(&current_frame->thread_state, PLCRASH_REG_IP);
+
+    return plframe_cursor_read_dwarf_unwind_image(task, pc, image, image_list, &fde_offset, current_frame, previous_frame, next_frame);
+}
+
 #endif /* PLCRASH_FEATURE_UNWIND_DWARF */
@@ -43,6 +43,21 @@ plframe_error_t plframe_cursor_read_dwarf_unwind (task_t task,
                                                   const plframe_stackframe_t *previous_frame,
                                                   plframe_stackframe_t *next_frame);
 
+plframe_error_t plframe_cursor_read_dwarf_unwind_with_image (task_t task,
+                                                             plcrash_async_image_list_t *image_list,
+                                                             plcrash_async_image_t *image,
+                                                             const plframe_stackframe_t *current_frame,
+                                                             const plframe_stackframe_t *previous_frame,
+                                                             plframe_stackframe_t *next_frame);
+
+plframe_error_t plframe_cursor_read_dwarf_unwind_fde (task_t task,
+                                                      plcrash_async_image_list_t *image_list,
+                                                      plcrash_async_image_t *image,
+                                                      pl_vm_off_t fde_offset,
+                                                      const plframe_stackframe_t *current_frame,
+                                                      const plframe_stackframe_t *previous_frame,
+                                                      plframe_stackframe_t *next_frame);
+
     
 #ifdef __cplusplus
 }
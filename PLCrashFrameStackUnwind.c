@@ -29,21 +29,19 @@
 #include "PLCrashFrameStackUnwind.h"
 #include "PLCrashAsync.h"
 
+#include <inttypes.h>
+
 /**
- * Fetch the next frame, assuming a valid frame pointer in @a cursor's current frame.
- *
- * @param task The task containing the target frame stack.
- * @param current_frame The current stack frame.
- * @param previous_frame The previous stack frame, or NULL if this is the first frame.
- * @param next_frame The new frame to be initialized.
+ * @internal
  *
- * @return Returns PLFRAME_ESUCCESS on success, PLFRAME_ENOFRAME is no additional frames are available, or a standard plframe_error_t code if an error occurs.
+ * Shared frame pointer reader implementation. The saved frame pointer and return address are read from @a memory if
+ * non-NULL, or from @a task otherwise.
  */
-plframe_error_t plframe_cursor_read_frame_ptr (task_t task,
-                                               plcrash_async_image_list_t *image_list,
-                                               const plframe_stackframe_t *current_frame,
-                                               const plframe_stackframe_t *previous_frame,
-                                               plframe_stackframe_t *next_frame)
+static plframe_error_t plframe_cursor_read_frame_ptr_int (task_t task,
+                                                          plcrash_async_mobject_t *memory,
+                                                          const plframe_stackframe_t *current_frame,
+                                                          const plframe_stackframe_t *previous_frame,
+                                                          plframe_stackframe_t *next_frame)
 {
     /* Determine the appropriate type width for the target thread */
     bool x64 = plcrash_async_thread_state_get_greg_size(&current_frame->thread_state) == sizeof(uint64_t);
@@ -91,14 +89,21 @@ plframe_error_t plframe_cursor_read_frame_ptr (task_t task,
     /* Read the registers off the stack via the frame pointer */
     plcrash_greg_t new_fp;
     plcrash_greg_t new_pc;
-    kern_return_t kr;
-    
 
+    if (memory != NULL) {
+        void *src = plcrash_async_mobject_remap_address(memory, (pl_vm_address_t) fp, 0, len);
+        if (src == NULL) {
+            PLCF_DEBUG("Frame 0x%" PRIx64 " lies outside the captured stack memory", (uint64_t) fp);
+            return PLFRAME_EBADFRAME;
+        }
 
-    kr = plcrash_async_read_addr(task, (pl_vm_address_t) fp, dest, len);
-    if (kr != KERN_SUCCESS) {
-        PLCF_DEBUG("Failed to read frame: %d", kr);
-        return PLFRAME_EBADFRAME;
+        plcrash_async_memcpy(dest, src, len);
+    } else {
+        kern_return_t kr = plcrash_async_read_addr(task, (pl_vm_address_t) fp, dest, len);
+        if (kr != KERN_SUCCESS) {
+            PLCF_DEBUG("Failed to read frame: %d", kr);
+            return PLFRAME_EBADFRAME;
+        }
     }
 
     if (x64) {
@@ -118,3 +123,43 @@ plframe_error_t plframe_cursor_read_frame_ptr (task_t task,
 
     return PLFRAME_ESUCCESS;
 }
+
+/**
+ * Fetch the next frame, assuming a valid frame pointer in @a cursor's current frame.
+ *
+ * @param task The task containing the target frame stack.
+ * @param current_frame The current stack frame.
+ * @param previous_frame The previous stack frame, or NULL if this is the first frame.
+ * @param next_frame The new frame to be initialized.
+ *
+ * @return Returns PLFRAME_ESUCCESS on success, PLFRAME_ENOFRAME is no additional frames are available, or a standard plframe_error_t code if an error occurs.
+ */
+plframe_error_t plframe_cursor_read_frame_ptr (task_t task,
+                                               plcrash_async_image_list_t *image_list,
+                                               const plframe_stackframe_t *current_frame,
+                                               const plframe_stackframe_t *previous_frame,
+                                               plframe_stackframe_t *next_frame)
+{
+    return plframe_cursor_read_frame_ptr_int(task, NULL, current_frame, previous_frame, next_frame);
+}
+
+/**
+ * Fetch the next frame from captured stack memory, assuming a valid frame pointer in @a cursor's current frame. This
+ * may be used to unwind a stack post-mortem, without access to the original task.
+ *
+ * @param stack_memory The captured stack memory.
+ * @param current_frame The current stack frame.
+ * @param previous_frame The previous stack frame, or NULL if this is the first frame.
+ * @param next_frame The new frame to be initialized.
+ *
+ * @return Returns PLFRAME_ESUCCESS on success, PLFRAME_ENOFRAME is no additional frames are available, or a standard
+ * plframe_error_t code if an error occurs. PLFRAME_EBADFRAME will be returned if the frame lies outside of
+ * @a stack_memory.
+ */
+plframe_error_t plframe_cursor_read_frame_ptr_memory (plcrash_async_mobject_t *stack_memory,
+                                                      const plframe_stackframe_t *current_frame,
+                                                      const plframe_stackframe_t *previous_frame,
+                                                      plframe_stackframe_t *next_frame)
+{
+    return plframe_cursor_read_frame_ptr_int(MACH_PORT_NULL, stack_memory, current_frame, previous_frame, next_frame);
+}
@@ -40,6 +40,11 @@ plframe_error_t plframe_cursor_read_frame_ptr (task_t task,
                                                const plframe_stackframe_t *current_frame,
                                                const plframe_stackframe_t *previous_frame,
                                                plframe_stackframe_t *next_frame);
+
+plframe_error_t plframe_cursor_read_frame_ptr_memory (plcrash_async_mobject_t *stack_memory,
+                                                      const plframe_stackframe_t *current_frame,
+                                                      const plframe_stackframe_t *previous_frame,
+                                                      plframe_stackframe_t *next_frame);
     
 #ifdef __cplusplus
 }
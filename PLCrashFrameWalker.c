@@ -121,7 +121,9 @@ static void plframe_cursor_internal_init (plframe_cursor_t *cursor, task_t task,
     cursor->depth = 0;
     cursor->task = task;
     cursor->image_list = image_list;
-    mach_port_mod_refs(mach_task_self(), cursor->task, MACH_PORT_RIGHT_SEND, 1);    
+    cursor->stack_memory = NULL;
+    if (cursor->task != MACH_PORT_NULL)
+        mach_port_mod_refs(mach_task_self(), cursor->task, MACH_PORT_RIGHT_SEND, 1);
 }
 
 /**
@@ -145,6 +147,32 @@ plframe_error_t plframe_cursor_init (plframe_cursor_t *cursor, task_t task, plcr
     return PLFRAME_ESUCCESS;
 }
 
+/**
+ * Initialize a post-mortem frame cursor, unwinding @a thread_state over previously captured stack memory rather than
+ * a live task; for example, the stack memory and registers recorded in a crash report's thread.
+ *
+ * Frames are read via the thread's frame pointers; unwinding will terminate at the first frame that does not fall
+ * within @a stack_memory. Compact unwind and DWARF data are not consulted, as they may reference memory outside of
+ * the captured stack.
+ *
+ * @param cursor Cursor record to be initialized.
+ * @param stack_memory The captured stack memory. This is a borrowed reference, and must remain valid for the lifetime of the cursor.
+ * @param thread_state The thread state at the time the stack memory was captured.
+ *
+ * @return Returns PLFRAME_ESUCCESS on success, or standard plframe_error_t code if an error occurs.
+ *
+ * @warn Callers must call plframe_cursor_free() on @a cursor to free any associated resources, even if initialization
+ * fails.
+ */
+plframe_error_t plframe_cursor_init_post_mortem (plframe_cursor_t *cursor, plcrash_async_mobject_t *stack_memory, plcrash_async_thread_state_t *thread_state) {
+    plframe_cursor_internal_init(cursor, MACH_PORT_NULL, NULL);
+    cursor->stack_memory = stack_memory;
+
+    plcrash_async_memcpy(&cursor->frame.thread_state, thread_state, sizeof(cursor->frame.thread_state));
+
+    return PLFRAME_ESUCCESS;
+}
+
 /**
  * Initialize the frame cursor by acquiring state from the provided mach thread. If the thread is not suspended,
  * the fetched state may be inconsistent.
@@ -166,6 +194,41 @@ plframe_error_t plframe_cursor_thread_init (plframe_cursor_t *cursor, task_t tas
     return plcrash_async_thread_state_mach_thread_init(&cursor->frame.thread_state, thread);
 }
 
+/**
+ * @internal
+ *
+ * Validate a frame read by one of @a cursor's frame readers, and on success, advance @a cursor to the frame.
+ *
+ * @param cursor The cursor from which @a frame was read.
+ * @param ferr The result of reading @a frame.
+ * @param frame The newly read frame.
+ *
+ * @return Returns PLFRAME_ESUCCESS on success, PLFRAME_ENOFRAME is no additional frames are available, or a standard plframe_error_t code if an error occurs.
+ */
+static plframe_error_t plframe_cursor_advance (plframe_cursor_t *cursor, plframe_error_t ferr, const plframe_stackframe_t *frame) {
+    if (ferr != PLFRAME_ESUCCESS) {
+        return ferr;
+    }
+
+    /* Check for completion */
+    if (!plcrash_async_thread_state_has_reg(&frame->thread_state, PLCRASH_REG_IP)) {
+        PLCF_DEBUG("Missing expected IP value in successfully read frame");
+        return PLFRAME_ENOFRAME;
+    }
+    
+    /* A pc within the NULL page is a terminating frame */
+    plcrash_greg_t ip = plcrash_async_thread_state_get_reg(&frame->thread_state, PLCRASH_REG_IP);
+    if (ip <= PAGE_SIZE)
+        return PLFRAME_ENOFRAME;
+    
+    /* Save the newly fetched frame */
+    cursor->prev_frame = cursor->frame;
+    cursor->frame = *frame;
+    cursor->depth++;
+    
+    return PLFRAME_ESUCCESS;
+}
+
 /**
  * Fetch the next frame using the provided frame readers.
  *
@@ -190,58 +253,69 @@ plframe_error_t plframe_cursor_next_with_readers (plframe_cursor_t *cursor, plfr
     plframe_stackframe_t frame;
     plframe_error_t ferr = PLFRAME_EINVAL; // default return value if reader_count is 0.
     
-    for (size_t i = 0; i < reader_count; i++) {
-        ferr = readers[i](cursor->task, cursor->image_list, &cursor->frame, prev_frame, &frame);
-        if (ferr == PLFRAME_ESUCCESS)
-            break;
-    }
-    
-    if (ferr != PLFRAME_ESUCCESS) {
-        return ferr;
+    if (cursor->stack_memory != NULL) {
+        /* Post-mortem cursors may only read frames from the captured stack memory */
+        ferr = plframe_cursor_read_frame_ptr_memory(cursor->stack_memory, &cursor->frame, prev_frame, &frame);
+    } else {
+        for (size_t i = 0; i < reader_count; i++) {
+            ferr = readers[i](cursor->task, cursor->image_list, &cursor->frame, prev_frame, &frame);
+            if (ferr == PLFRAME_ESUCCESS)
+                break;
+        }
     }
-
-    /* Check for completion */
-    if (!plcrash_async_thread_state_has_reg(&frame.thread_state, PLCRASH_REG_IP)) {
-        PLCF_DEBUG("Missing expected IP value in successfully read frame");
-        return PLFRAME_ENOFRAME;
-    }
-    
-    /* A pc within the NULL page is a terminating frame */
-    plcrash_greg_t ip = plcrash_async_thread_state_get_reg(&frame.thread_state, PLCRASH_REG_IP);
-    if (ip <= PAGE_SIZE)
-        return PLFRAME_ENOFRAME;
     
-    /* Save the newly fetched frame */
-    cursor->prev_frame = cursor->frame;
-    cursor->frame = frame;
-    cursor->depth++;
-    
-    return PLFRAME_ESUCCESS;
+    return plframe_cursor_advance(cursor, ferr, &frame);
 }
 
 /**
  * Fetch the next frame.
  *
+ * The image containing the current PC is resolved once, and handed to each reader that requires it. Readers that
+ * require unwind data not present in that image are skipped.
+ *
  * @param cursor A cursor instance initialized with plframe_cursor_init();
  * @return Returns PLFRAME_ESUCCESS on success, PLFRAME_ENOFRAME is no additional frames are available, or a standard plframe_error_t code if an error occurs.
  */
 plframe_error_t plframe_cursor_next (plframe_cursor_t *cursor) {
-    plframe_cursor_frame_reader_t *readers[] = {
+    /* The first frame is already available via existing thread state; no readers are required. Post-mortem cursors
+     * only read from the captured stack memory. */
+    if (cursor->depth == 0 || cursor->stack_memory != NULL || cursor->image_list == NULL || !plcrash_async_thread_state_has_reg(&cursor->frame.thread_state, PLCRASH_REG_IP)) {
+        plframe_cursor_frame_reader_t *readers[] = { plframe_cursor_read_frame_ptr };
+        return plframe_cursor_next_with_readers(cursor, readers, 1);
+    }
+
+    /* A previous frame is only available if we're on the second frame */
+    plframe_stackframe_t *prev_frame = NULL;
+    if (cursor->depth >= 2)
+        prev_frame = &cursor->prev_frame;
+
+    /* Resolve the image once; the list must remain marked as being read while the image is referenced. */
+    plcrash_greg_t pc = plcrash_async_thread_state_get_reg(&cursor->frame.thread_state, PLCRASH_REG_IP);
+    plcrash_async_image_list_set_reading(cursor->image_list, true);
+    plcrash_async_image_t *image = plcrash_async_image_containing_address(cursor->image_list, pc);
+    uint32_t capabilities = (image != NULL) ? image->macho_image.capabilities : 0;
+
+    /* Read in the next frame using the first successful frame reader. */
+    plframe_stackframe_t frame;
+    plframe_error_t ferr = PLFRAME_ENOTSUP;
 
 #if PLCRASH_FEATURE_UNWIND_COMPACT
-        plframe_cursor_read_compact_unwind,
+    if (capabilities & PLCRASH_ASYNC_MACHO_CAP_COMPACT_UNWIND)
+        ferr = plframe_cursor_read_compact_unwind_with_image(cursor->task, cursor->image_list, image, &cursor->frame, prev_frame, &frame);
 #endif
 
 #if PLCRASH_FEATURE_UNWIND_DWARF
-        plframe_cursor_read_dwarf_unwind,
+    if (ferr != PLFRAME_ESUCCESS && (capabilities & PLCRASH_ASYNC_MACHO_CAP_DWARF_UNWIND))
+        ferr = plframe_cursor_read_dwarf_unwind_with_image(cursor->task, cursor->image_list, image, &cursor->frame, prev_frame, &frame);
 #endif
 
-        plframe_cursor_read_frame_ptr
-    };
+    plcrash_async_image_list_set_reading(cursor->image_list, false);
 
-    return plframe_cursor_next_with_readers(cursor, readers, sizeof(readers)/sizeof(readers[0]));
-}
+    if (ferr != PLFRAME_ESUCCESS)
+        ferr = plframe_cursor_read_frame_ptr(cursor->task, cursor->image_list, &cursor->frame, prev_frame, &frame);
 
+    return plframe_cursor_advance(cursor, ferr, &frame);
+}
 
 /**
  * Get a register value. Returns PLFRAME_ENOTSUP if the given register is unavailable within the current frame.
@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashHangWatchdog.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <mach/mach_time.h>
+#include <libkern/OSAtomic.h>
+
+/** The number of polls performed per stall threshold interval. */
+#define PLCRASH_HANG_WATCHDOG_POLLS_PER_THRESHOLD 4
+
+/** The minimum poll interval, in microseconds. */
+#define PLCRASH_HANG_WATCHDOG_MIN_POLL_USEC (10 * 1000)
+
+/** The maximum poll interval, in microseconds. */
+#define PLCRASH_HANG_WATCHDOG_MAX_POLL_USEC (500 * 1000)
+
+/**
+ * Release a reference to @a ping, freeing it once the last reference has been released.
+ */
+static void plcrash_hang_watchdog_ping_release (plcrash_hang_watchdog_ping_t *ping) {
+    if (OSAtomicDecrement32Barrier(&ping->refcount) == 0)
+        free(ping);
+}
+
+/**
+ * Ping handler, executed on the monitored queue.
+ */
+static void plcrash_hang_watchdog_ping_handler (void *context) {
+    plcrash_hang_watchdog_ping_t *ping = context;
+
+    OSAtomicCompareAndSwap32Barrier(1, 0, &ping->pending);
+    plcrash_hang_watchdog_ping_release(ping);
+}
+
+/**
+ * Initialize a new hang watchdog.
+ *
+ * @param watchdog The watchdog to initialize.
+ * @param thread The thread to be monitored. A reference to this port will be held for the lifetime of the watchdog.
+ * @param queue A serial queue serviced by @a thread, to which pings will be dispatched. This is generally the main queue.
+ * @param threshold_ns The time, in nanoseconds, after which an unanswered ping is considered a stall.
+ * @param min_report_interval_ns The minimum time between reported stalls, in nanoseconds. Stalls detected within this
+ * interval of a previously reported stall are counted, but not reported. Stalls for which @a callback returns false
+ * do not start a new interval.
+ * @param callback The callback to be invoked on the watchdog thread when a stall is detected. The callback is
+ * invoked at most once per stall.
+ * @param context The context to be supplied to @a callback.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_ENOMEM if the watchdog state could not be allocated.
+ *
+ * @warning This method is not async-safe.
+ */
+plcrash_error_t plcrash_nasync_hang_watchdog_init (plcrash_hang_watchdog_t *watchdog,
+                                                   thread_t thread,
+                                                   dispatch_queue_t queue,
+                                                   uint64_t threshold_ns,
+                                                   uint64_t min_report_interval_ns,
+                                                   plcrash_hang_watchdog_callback_t callback,
+                                                   void *context)
+{
+    mach_timebase_info_data_t timebase;
+
+    memset(watchdog, 0, sizeof(*watchdog));
+
+    if ((watchdog->ping = calloc(1, sizeof(*watchdog->ping))) == NULL)
+        return PLCRASH_ENOMEM;
+    watchdog->ping->refcount = 1;
+
+    if (mach_timebase_info(&timebase) != KERN_SUCCESS || timebase.numer == 0) {
+        timebase.numer = 1;
+        timebase.denom = 1;
+    }
+
+    /* Poll several times per threshold interval, bounding the detection latency to a fraction of the threshold */
+    uint64_t poll_usec = threshold_ns / 1000 / PLCRASH_HANG_WATCHDOG_POLLS_PER_THRESHOLD;
+    if (poll_usec < PLCRASH_HANG_WATCHDOG_MIN_POLL_USEC)
+        poll_usec = PLCRASH_HANG_WATCHDOG_MIN_POLL_USEC;
+    else if (poll_usec > PLCRASH_HANG_WATCHDOG_MAX_POLL_USEC)
+        poll_usec = PLCRASH_HANG_WATCHDOG_MAX_POLL_USEC;
+
+    mach_port_mod_refs(mach_task_self(), thread, MACH_PORT_RIGHT_SEND, 1);
+    dispatch_retain(queue);
+
+    watchdog->thread = thread;
+    watchdog->queue = queue;
+    watchdog->threshold = threshold_ns * timebase.denom / timebase.numer;
+    watchdog->min_report_interval = min_report_interval_ns * timebase.denom / timebase.numer;
+    watchdog->poll_interval_usec = (useconds_t) poll_usec;
+    watchdog->callback = callback;
+    watchdog->context = context;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Fetch @a thread's total CPU time, in microseconds.
+ */
+static uint64_t plcrash_hang_watchdog_thread_cpu_usec (thread_t thread) {
+    thread_basic_info_data_t info;
+    mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+
+    if (thread_info(thread, THREAD_BASIC_INFO, (thread_info_t) &info, &count) != KERN_SUCCESS)
+        return 0;
+
+    return ((uint64_t) info.user_time.seconds + info.system_time.seconds) * 1000000 +
+        info.user_time.microseconds + info.system_time.microseconds;
+}
+
+/**
+ * Perform a single watchdog poll.
+ */
+static void plcrash_hang_watchdog_poll (plcrash_hang_watchdog_t *watchdog) {
+    uint64_t now = mach_absolute_time();
+
+    OSAtomicIncrement64(&watchdog->stats.poll_count);
+
+    /* If the previous ping was answered, issue a new ping */
+    if (watchdog->ping->pending == 0) {
+        watchdog->ping->pending = 1;
+        watchdog->ping_time = now;
+        watchdog->stall_handled = false;
+
+        OSAtomicIncrement32Barrier(&watchdog->ping->refcount);
+        dispatch_async_f(watchdog->queue, watchdog->ping, plcrash_hang_watchdog_ping_handler);
+        return;
+    }
+
+    /* Otherwise, check for a stall */
+    if (watchdog->stall_handled || now - watchdog->ping_time < watchdog->threshold)
+        return;
+
+    watchdog->stall_handled = true;
+    OSAtomicIncrement64(&watchdog->stats.hang_count);
+
+    /* Apply rate limiting */
+    if (watchdog->last_report_time != 0 && now - watchdog->last_report_time < watchdog->min_report_interval) {
+        OSAtomicIncrement64(&watchdog->stats.suppressed_count);
+        return;
+    }
+
+    mach_timebase_info_data_t timebase;
+    if (mach_timebase_info(&timebase) != KERN_SUCCESS || timebase.denom == 0) {
+        timebase.numer = 1;
+        timebase.denom = 1;
+    }
+
+    /* A dropped report does not start a new rate limiting interval */
+    if (!watchdog->callback(watchdog->thread, (now - watchdog->ping_time) * timebase.numer / timebase.denom, watchdog->context))
+        return;
+
+    watchdog->last_report_time = now;
+    OSAtomicIncrement64(&watchdog->stats.report_count);
+}
+
+/**
+ * The watchdog thread's entry point.
+ */
+static void *plcrash_hang_watchdog_thread (void *arg) {
+    plcrash_hang_watchdog_t *watchdog = arg;
+
+    while (!watchdog->stop_requested) {
+        usleep(watchdog->poll_interval_usec);
+        if (watchdog->stop_requested)
+            break;
+
+        plcrash_hang_watchdog_poll(watchdog);
+    }
+
+    /* Record the thread's final CPU usage */
+    watchdog->stats.cpu_time_usec = (int64_t) plcrash_hang_watchdog_thread_cpu_usec(pl_mach_thread_self());
+    return NULL;
+}
+
+/**
+ * Start monitoring on a new background thread.
+ *
+ * @param watchdog The watchdog to start. The watchdog must not already be running.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_EINTERNAL if the watchdog thread could not be started.
+ *
+ * @warning This method is not async-safe.
+ */
+plcrash_error_t plcrash_nasync_hang_watchdog_start (plcrash_hang_watchdog_t *watchdog) {
+    PLCF_ASSERT(!watchdog->running);
+
+    watchdog->stop_requested = false;
+    OSMemoryBarrier();
+
+    if (pthread_create(&watchdog->pthread, NULL, plcrash_hang_watchdog_thread, watchdog) != 0) {
+        PLCF_DEBUG("Failed to start the hang watchdog thread");
+        return PLCRASH_EINTERNAL;
+    }
+
+    watchdog->running = true;
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Stop monitoring, waiting for the watchdog thread to exit. If the watchdog is not running, this is a no-op.
+ *
+ * @param watchdog The watchdog to stop.
+ *
+ * @warning This method is not async-safe, and must not be called from the watchdog's hang callback.
+ */
+void plcrash_nasync_hang_watchdog_stop (plcrash_hang_watchdog_t *watchdog) {
+    if (!watchdog->running)
+        return;
+
+    watchdog->stop_requested = true;
+    OSMemoryBarrier();
+
+    pthread_join(watchdog->pthread, NULL);
+    watchdog->running = false;
+}
+
+/**
+ * Fetch the watchdog's statistics. The reported CPU time may be used to measure the watchdog's steady-state overhead.
+ *
+ * @param watchdog The watchdog.
+ * @param stats On return, the watchdog's current statistics.
+ */
+void plcrash_hang_watchdog_get_stats (plcrash_hang_watchdog_t *watchdog, plcrash_hang_watchdog_stats_t *stats) {
+    stats->poll_count = (uint64_t) watchdog->stats.poll_count;
+    stats->hang_count = (uint64_t) watchdog->stats.hang_count;
+    stats->report_count = (uint64_t) watchdog->stats.report_count;
+    stats->suppressed_count = (uint64_t) watchdog->stats.suppressed_count;
+
+    if (watchdog->running) {
+        mach_port_t port = pthread_mach_thread_np(watchdog->pthread);
+        stats->cpu_time_usec = plcrash_hang_watchdog_thread_cpu_usec(port);
+    } else {
+        stats->cpu_time_usec = (uint64_t) watchdog->stats.cpu_time_usec;
+    }
+}
+
+/**
+ * Free all resources associated with @a watchdog, stopping the watchdog thread if it is running. Any ping still
+ * pending on the monitored queue will complete without referencing @a watchdog.
+ *
+ * @warning This method is not async-safe.
+ */
+void plcrash_nasync_hang_watchdog_free (plcrash_hang_watchdog_t *watchdog) {
+    plcrash_nasync_hang_watchdog_stop(watchdog);
+
+    plcrash_hang_watchdog_ping_release(watchdog->ping);
+    dispatch_release(watchdog->queue);
+    mach_port_mod_refs(mach_task_self(), watchdog->thread, MACH_PORT_RIGHT_SEND, -1);
+}
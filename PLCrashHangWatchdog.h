@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_HANG_WATCHDOG_H
+#define PLCRASH_HANG_WATCHDOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <mach/mach.h>
+#include <dispatch/dispatch.h>
+
+#include "PLCrashAsync.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @internal
+ * @ingroup plcrash_internal
+ * @defgroup plcrash_hang_watchdog Hang Watchdog
+ *
+ * Detects stalls of a monitored thread by periodically dispatching a lightweight ping to a queue serviced by
+ * that thread. If a ping remains unanswered beyond the configured threshold, a client-supplied callback is invoked
+ * from the watchdog thread, and may be used to capture the stalled thread's state.
+ *
+ * In the steady state, the watchdog's cost is a single timed sleep and dispatch_async_f() per poll interval.
+ * @{
+ */
+
+/**
+ * @internal
+ *
+ * Hang notification callback, invoked on the watchdog thread.
+ *
+ * @param thread The stalled thread.
+ * @param stall_ns The time elapsed since the unanswered ping was issued, in nanoseconds.
+ * @param context The context supplied to plcrash_nasync_hang_watchdog_init().
+ *
+ * @return Returns true if the stall was reported, or false if the report was dropped. Only reported stalls are
+ * subject to the watchdog's minimum report interval.
+ */
+typedef bool (*plcrash_hang_watchdog_callback_t)(thread_t thread, uint64_t stall_ns, void *context);
+
+/**
+ * @internal
+ *
+ * Watchdog statistics.
+ */
+typedef struct plcrash_hang_watchdog_stats {
+    /** The number of polls performed. */
+    uint64_t poll_count;
+
+    /** The number of stalls detected. */
+    uint64_t hang_count;
+
+    /** The number of stalls successfully reported via the hang callback. */
+    uint64_t report_count;
+
+    /** The number of stalls that were not reported due to rate limiting. */
+    uint64_t suppressed_count;
+
+    /** The total CPU time consumed by the watchdog thread, in microseconds, including any time spent within the
+     * hang callback. */
+    uint64_t cpu_time_usec;
+} plcrash_hang_watchdog_stats_t;
+
+/**
+ * @internal
+ *
+ * Ping state shared between the watchdog and in-flight pings. Reference counted, as a ping may still be enqueued
+ * on a stalled queue after the watchdog itself has been freed.
+ */
+typedef struct plcrash_hang_watchdog_ping {
+    /** Reference count. */
+    volatile int32_t refcount;
+
+    /** Non-zero while a ping is awaiting a response. */
+    volatile int32_t pending;
+} plcrash_hang_watchdog_ping_t;
+
+/**
+ * @internal
+ *
+ * A hang watchdog.
+ */
+typedef struct plcrash_hang_watchdog {
+    /** The monitored thread. A send right is held for the lifetime of the watchdog. */
+    thread_t thread;
+
+    /** The queue serviced by the monitored thread, to which pings are dispatched. */
+    dispatch_queue_t queue;
+
+    /** The stall threshold, in mach_absolute_time() units. */
+    uint64_t threshold;
+
+    /** The minimum time between reported stalls, in mach_absolute_time() units. */
+    uint64_t min_report_interval;
+
+    /** The poll interval, in microseconds. */
+    useconds_t poll_interval_usec;
+
+    /** Hang callback. */
+    plcrash_hang_watchdog_callback_t callback;
+
+    /** Hang callback context. */
+    void *context;
+
+    /** Shared ping state. */
+    plcrash_hang_watchdog_ping_t *ping;
+
+    /** The time at which the pending ping was issued, in mach_absolute_time() units. Only accessed from the
+     * watchdog thread. */
+    uint64_t ping_time;
+
+    /** True if the current stall has already been handled. Only accessed from the watchdog thread. */
+    bool stall_handled;
+
+    /** The time of the last successfully reported stall, or 0. Only accessed from the watchdog thread. */
+    uint64_t last_report_time;
+
+    /** Statistics. */
+    struct {
+        volatile int64_t poll_count;
+        volatile int64_t hang_count;
+        volatile int64_t report_count;
+        volatile int64_t suppressed_count;
+
+        /** Final watchdog thread CPU time, recorded when the thread exits. */
+        volatile int64_t cpu_time_usec;
+    } stats;
+
+    /** The watchdog thread, valid if @a running is true. */
+    pthread_t pthread;
+
+    /** True if the watchdog thread is running. */
+    bool running;
+
+    /** Set to request termination of the watchdog thread. */
+    volatile bool stop_requested;
+} plcrash_hang_watchdog_t;
+
+plcrash_error_t plcrash_nasync_hang_watchdog_init (plcrash_hang_watchdog_t *watchdog,
+                                                   thread_t thread,
+                                                   dispatch_queue_t queue,
+                                                   uint64_t threshold_ns,
+                                                   uint64_t min_report_interval_ns,
+                                                   plcrash_hang_watchdog_callback_t callback,
+                                                   void *context);
+
+plcrash_error_t plcrash_nasync_hang_watchdog_start (plcrash_hang_watchdog_t *watchdog);
+void plcrash_nasync_hang_watchdog_stop (plcrash_hang_watchdog_t *watchdog);
+
+void plcrash_hang_watchdog_get_stats (plcrash_hang_watchdog_t *watchdog, plcrash_hang_watchdog_stats_t *stats);
+
+void plcrash_nasync_hang_watchdog_free (plcrash_hang_watchdog_t *watchdog);
+
+/**
+ * @} plcrash_hang_watchdog
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_HANG_WATCHDOG_H */
@@ -41,6 +41,7 @@ extern "C" {
 #import "PLCrashFrameWalker.h"
     
 #import "PLCrashAsyncSymbolication.h"
+#import "PLCrashFeatureConfig.h"
 
 #include <uuid/uuid.h>
 
@@ -55,6 +56,88 @@ extern "C" {
  * @{
  */
 
+/**
+ * @internal
+ *
+ * Report detail levels, in order of decreasing detail. If a report can not be written within the writer's
+ * time budget, the writer steps through these levels as the deadline approaches. The values match
+ * the CrashReport.DetailLevel protobuf enumeration.
+ */
+typedef enum {
+    /** All available detail is written. */
+    PLCRASH_LOG_WRITER_DETAIL_FULL = 0,
+
+    /** Symbolication is restricted to the image symbol tables. */
+    PLCRASH_LOG_WRITER_DETAIL_SYMBOL_TABLE_ONLY = 1,
+
+    /** Symbolication is disabled; only frame PC values are written. */
+    PLCRASH_LOG_WRITER_DETAIL_PC_ONLY = 2,
+
+    /** Only the crashed thread is written. */
+    PLCRASH_LOG_WRITER_DETAIL_CRASHED_THREAD_ONLY = 3,
+} plcrash_log_writer_detail_t;
+
+/**
+ * @internal
+ *
+ * Maximum number of frames that will be written to the crash report for a single thread. Used as a safety measure
+ * to avoid overrunning our output limit when writing a crash report triggered by frame recursion.
+ */
+#define PLCRASH_LOG_WRITER_MAX_THREAD_FRAMES 512 // matches Apple's crash reporting on Snow Leopard
+
+/**
+ * @internal
+ *
+ * The number of binary images that may be tracked as referenced by a single report. Images beyond this limit are
+ * always written.
+ */
+#define PLCRASH_LOG_WRITER_MAX_TRACKED_IMAGES 2048
+
+/**
+ * @internal
+ *
+ * The number of distinct thread stacks that may be tracked for deduplication by a single report.
+ */
+#define PLCRASH_LOG_WRITER_MAX_TRACKED_STACKS 64
+
+/**
+ * @internal
+ *
+ * The total number of PC values that may be retained across all tracked thread stacks.
+ */
+#define PLCRASH_LOG_WRITER_MAX_TRACKED_STACK_PCS 2048
+
+/**
+ * @internal
+ *
+ * The maximum number of bytes of stack memory captured for a single thread when report_info.capture_stack_memory is
+ * enabled.
+ */
+#define PLCRASH_LOG_WRITER_MAX_STACK_MEMORY_BYTES (16 * 1024)
+
+/**
+ * @internal
+ *
+ * The total number of bytes of stack memory captured for a single report. The crashed thread's capture is reserved
+ * from this budget, and the remainder is shared by the other threads in the order they are written. This keeps the
+ * captured memory well within the 64KB report size limit used by PLCrashReporter, leaving room for the frames and
+ * binary images.
+ */
+#define PLCRASH_LOG_WRITER_MAX_TOTAL_STACK_MEMORY_BYTES (24 * 1024)
+
+/**
+ * @internal
+ *
+ * Commit callback, invoked by the writer after each commit marker has been written and flushed. This may be used
+ * to publish the committed length of a memory-backed report.
+ *
+ * @param file The output file. All data written prior to the commit marker has been flushed.
+ * @param context The context supplied to the writer.
+ *
+ * @warning The callback will be called from within the crash handler, and must be async-safe.
+ */
+typedef void (*plcrash_log_writer_commit_callback_t)(plcrash_async_file_t *file, void *context);
+
 /**
  * @internal
  *
@@ -64,6 +147,19 @@ typedef struct plcrash_log_writer {
     /** The strategy to use for symbolication */
     plcrash_async_symbol_strategy_t symbol_strategy;
 
+    /** Time budget state */
+    struct {
+        /** The time budget for writing a report, in mach_absolute_time() units, or 0 if unlimited. */
+        uint64_t budget;
+
+        /** The time at which the report currently being written was started, in mach_absolute_time() units. */
+        uint64_t start_time;
+
+        /** The detail level in effect for the report currently being written. The level only ever decreases
+         * in detail over the course of a single report. */
+        plcrash_log_writer_detail_t level;
+    } time_budget;
+
     /** Report data */
     struct {
         /** If true, the report should be marked as a 'generated' user-requested report, rather than as a true crash
@@ -72,8 +168,113 @@ typedef struct plcrash_log_writer {
 
         /** Report UUID */
         uuid_t uuid_bytes;
+
+        /** If true, only the crashed thread will be suspended and written to the report. This may be used to capture
+         * a single thread's state (eg, that of a stalled thread) without interrupting the remainder of the process. */
+        bool crashed_thread_only;
+
+        /** If true, the signal, the crashed thread, and the binary images referenced by the crashed thread are
+         * written ahead of all other report data, and each top-level message is followed by a commit marker and
+         * a flush of the output file. A report truncated at any commit marker may be decoded. */
+        bool crashed_thread_first;
+
+        /** If true, only the binary images containing a written stack frame (or uncaught exception frame) are
+         * written, along with a count of the omitted images. */
+        bool referenced_images_only;
+
+        /** If true, a thread whose stack is identical to that of a previously written thread references that
+         * thread's frames, rather than including its own. */
+        bool dedup_identical_stacks;
+
+        /** If true, registers and a bounded raw copy of the stack are written for every thread, allowing the
+         * stacks to be unwound post-mortem. */
+        bool capture_stack_memory;
+
+        /** If true, consecutive repetitions of a group of stack frames (eg, from deep recursion) are written once,
+         * along with their repeat count. Decoders that predate folding will see only the first repetition. */
+        bool fold_repeated_frames;
     } report_info;
 
+    /** The PC values of the thread currently being written. Kept in the writer, rather than on the stack, to
+     * limit the crash handler's stack usage. */
+    plcrash_greg_t thread_pcs[PLCRASH_LOG_WRITER_MAX_THREAD_FRAMES];
+
+    /** The binary images referenced by the report currently being written, indexed by plcrash_async_image_t::index.
+     * Used by report_info.referenced_images_only, and to select the crashed thread's images when
+     * report_info.crashed_thread_first is set. */
+    uint32_t referenced_images[PLCRASH_LOG_WRITER_MAX_TRACKED_IMAGES / 32];
+
+    /** The binary images referenced by the crashed thread's frames, indexed by plcrash_async_image_t::index. Only
+     * populated if report_info.crashed_thread_first is set. */
+    uint32_t crashed_thread_images[PLCRASH_LOG_WRITER_MAX_TRACKED_IMAGES / 32];
+
+    /** The thread stacks written by the report currently being written. Only populated if
+     * report_info.dedup_identical_stacks is set. */
+    struct {
+        /** The number of valid entries in @a entries. */
+        uint32_t count;
+
+        /** The number of valid values in @a pcs. */
+        uint32_t pc_count;
+
+        /** Tracked stacks. */
+        struct {
+            /** Hash of the stack's PC values. */
+            uint64_t hash;
+
+            /** The number of the thread whose frames were written. */
+            uint32_t thread_number;
+
+            /** The index of the stack's first PC value within @a pcs. */
+            uint32_t pc_index;
+
+            /** The number of PC values in the stack. */
+            uint32_t frame_count;
+        } entries[PLCRASH_LOG_WRITER_MAX_TRACKED_STACKS];
+
+        /** The PC values of all tracked stacks. */
+        plcrash_greg_t pcs[PLCRASH_LOG_WRITER_MAX_TRACKED_STACK_PCS];
+    } written_stacks;
+
+#if PLCRASH_FEATURE_DEFERRED_IMAGE_INIT
+    /** The dyld image paths of the report currently being written, used to name deferred images initialized at
+     * crash time. Storage for PLCRASH_LOG_WRITER_MAX_TRACKED_IMAGES paths is allocated by plcrash_log_writer_init(). */
+    plcrash_async_image_paths_t image_paths;
+#endif /* PLCRASH_FEATURE_DEFERRED_IMAGE_INIT */
+
+    /** Symbol memo table storage, allocated by plcrash_log_writer_init(), or NULL if the allocation failed. Reused
+     * by each report. */
+    plcrash_async_symbol_memo_t *symbol_memo;
+
+    /** Symbol lookup statistics of the most recently written report. */
+    plcrash_async_symbol_cache_stats_t symbol_cache_stats;
+
+    /** Stack memory of the thread currently being written. Only populated if report_info.capture_stack_memory is set. */
+    struct {
+        /** Capture buffer of PLCRASH_LOG_WRITER_MAX_STACK_MEMORY_BYTES, allocated by plcrash_log_writer_init(), or
+         * NULL if the allocation failed. */
+        void *buffer;
+
+        /** The number of bytes of the current report's capture budget that remain available to threads other than
+         * the crashed thread. */
+        size_t remaining;
+
+        /** The target address of the captured memory. */
+        pl_vm_address_t address;
+
+        /** The number of bytes captured, or 0 if no memory was captured. */
+        size_t length;
+    } stack_memory;
+
+    /** Commit notification, used when report_info.crashed_thread_first is enabled */
+    struct {
+        /** Callback to be invoked after each commit, or NULL. */
+        plcrash_log_writer_commit_callback_t callback;
+
+        /** Callback context. */
+        void *context;
+    } commit;
+
     /** System data */
     struct {
         /** The host OS version. */
@@ -150,7 +351,34 @@ typedef struct plcrash_log_writer {
         
         /** Call stack frame count, or 0 if the call stack is unavailable */
         size_t callstack_count;
+
+        /** The call stack's encoded CrashReport.Exception.frames fields, resolved and symbolicated when the exception
+         * was set. If NULL, the frames will be encoded at crash time. */
+        uint8_t *frames_data;
+
+        /** Length of @a frames_data, in bytes. */
+        size_t frames_length;
     } uncaught_exception;
+
+    /**
+     * Pre-encoded report, system, machine, application, and process info messages. These values are fixed once
+     * the writer has been initialized, and are encoded once by plcrash_log_writer_init() rather than at crash time.
+     */
+    struct {
+        /** The encoded messages, or NULL if pre-encoding failed; in that case the messages will be encoded at crash time. */
+        uint8_t *data;
+
+        /** Length of @a data, in bytes. */
+        size_t length;
+
+        /** Offset of the fixed-width system_info timestamp field within @a data. The placeholder value at this
+         * offset is replaced with the actual timestamp when the report is written. */
+        size_t timestamp_offset;
+
+        /** Offset of the report info UUID's bytes within @a data. Used to assign a new UUID without re-encoding
+         * the messages. */
+        size_t uuid_offset;
+    } static_sections;
 } plcrash_log_writer_t;
 
 /**
@@ -214,7 +442,12 @@ plcrash_error_t plcrash_log_writer_init (plcrash_log_writer_t *writer,
                                          NSString *app_version,
                                          plcrash_async_symbol_strategy_t symbol_strategy,
                                          BOOL user_requested);
-void plcrash_log_writer_set_exception (plcrash_log_writer_t *writer, NSException *exception);
+void plcrash_log_writer_set_exception (plcrash_log_writer_t *writer, NSException *exception, plcrash_async_image_list_t *image_list);
+void plcrash_log_writer_set_time_budget (plcrash_log_writer_t *writer, uint64_t budget_ns);
+void plcrash_log_writer_regenerate_uuid (plcrash_log_writer_t *writer);
+plcrash_error_t plcrash_log_writer_set_target_process (plcrash_log_writer_t *writer, pid_t pid);
+
+plcrash_error_t plcrash_log_writer_encode_binary_image (plcrash_async_macho_t *image, void **data, size_t *length);
 
 plcrash_error_t plcrash_log_writer_write (plcrash_log_writer_t *writer,
                                           thread_t crashed_thread,
@@ -223,6 +456,15 @@ plcrash_error_t plcrash_log_writer_write (plcrash_log_writer_t *writer,
                                           plcrash_log_signal_info_t *siginfo,
                                           plcrash_async_thread_state_t *current_state);
 
+plcrash_error_t plcrash_log_writer_write_task (plcrash_log_writer_t *writer,
+                                               task_t task,
+                                               thread_t crashed_thread,
+                                               plcrash_async_image_list_t *image_list,
+                                               plcrash_async_file_t *file,
+                                               plcrash_log_signal_info_t *siginfo,
+                                               thread_t state_thread,
+                                               plcrash_async_thread_state_t *current_state);
+
 plcrash_error_t plcrash_log_writer_close (plcrash_log_writer_t *writer);
 void plcrash_log_writer_free (plcrash_log_writer_t *writer);
 
@@ -33,10 +33,13 @@
 #import <stdbool.h>
 #import <dlfcn.h>
 
+#import <inttypes.h>
 #import <sys/sysctl.h>
 #import <sys/time.h>
 
 #import <mach-o/dyld.h>
+#import <mach/mach_time.h>
+#import <libproc.h>
 
 #import <libkern/OSAtomic.h>
 
@@ -55,10 +58,28 @@
 
 /**
  * @internal
- * Maximum number of frames that will be written to the crash report for a single thread. Used as a safety measure
- * to avoid overrunning our output limit when writing a crash report triggered by frame recursion.
+ * Maximum number of frames that will be written to the crash report for a single thread.
  */
-#define MAX_THREAD_FRAMES 512 // matches Apple's crash reporting on Snow Leopard
+#define MAX_THREAD_FRAMES PLCRASH_LOG_WRITER_MAX_THREAD_FRAMES
+
+/**
+ * @internal
+ * Maximum number of frames in a repeated group that will be folded into a single group of frames.
+ */
+#define MAX_REPEAT_FRAMES 16
+
+/**
+ * @internal
+ * The number of bytes below the stack pointer included in captured stack memory. Covers the 128 byte red zone
+ * defined by the x86-64 ABI.
+ */
+#define PLCRASH_WRITER_STACK_RED_ZONE 128
+
+/**
+ * @internal
+ * The minimum stack memory capture length attempted before stack capture is abandoned.
+ */
+#define PLCRASH_WRITER_MIN_STACK_MEMORY_BYTES 1024
 
 /**
  * @internal
@@ -116,6 +137,19 @@ enum {
     /** CrashReport.thread.crashed */
     PLCRASH_PROTO_THREAD_CRASHED_ID = 3,
 
+    /** CrashReport.thread.frames_thread_number */
+    PLCRASH_PROTO_THREAD_FRAMES_THREAD_NUMBER_ID = 5,
+
+    /** CrashReport.thread.stack_memory */
+    PLCRASH_PROTO_THREAD_STACK_MEMORY_ID = 6,
+
+
+    /** CrashReport.memory_region.address */
+    PLCRASH_PROTO_MEMORY_REGION_ADDRESS_ID = 1,
+
+    /** CrashReport.memory_region.data */
+    PLCRASH_PROTO_MEMORY_REGION_DATA_ID = 2,
+
 
     /** CrashReport.thread.frame.pc */
     PLCRASH_PROTO_THREAD_FRAME_PC_ID = 3,
@@ -123,6 +157,12 @@ enum {
     /** CrashReport.thread.frame.symbol */
     PLCRASH_PROTO_THREAD_FRAME_SYMBOL_ID = 6,
 
+    /** CrashReport.thread.frame.repeat_count */
+    PLCRASH_PROTO_THREAD_FRAME_REPEAT_COUNT_ID = 7,
+
+    /** CrashReport.thread.frame.repeat_length */
+    PLCRASH_PROTO_THREAD_FRAME_REPEAT_LENGTH_ID = 8,
+
 
     /** CrashReport.thread.registers */
     PLCRASH_PROTO_THREAD_REGISTERS_ID = 4,
@@ -248,8 +288,40 @@ enum {
 
     /** CrashReport.report_info.uuid */
     PLCRASH_PROTO_REPORT_INFO_UUID_ID = 2,
+
+
+    /** CrashReport.detail_level */
+    PLCRASH_PROTO_DETAIL_LEVEL_ID = 10,
+
+    /** CrashReport.commit_marker */
+    PLCRASH_PROTO_COMMIT_MARKER_ID = 11,
+
+    /** CrashReport.complete */
+    PLCRASH_PROTO_COMPLETE_ID = 12,
+
+    /** CrashReport.omitted_binary_image_count */
+    PLCRASH_PROTO_OMITTED_BINARY_IMAGE_COUNT_ID = 13,
 };
 
+static size_t plcrash_writer_write_static_sections (plcrash_async_file_t *file, plcrash_log_writer_t *writer, int64_t timestamp, size_t *timestamp_offset);
+static void plcrash_writer_preencode_static_sections (plcrash_log_writer_t *writer);
+static size_t plcrash_writer_write_exception_frames (plcrash_async_file_t *file, plcrash_log_writer_t *writer, plcrash_async_image_list_t *image_list, plcrash_async_symbol_strategy_t strategy, plcrash_async_symbol_cache_t *findContext);
+static size_t plcrash_writer_write_report_info (plcrash_async_file_t *file, plcrash_log_writer_t *writer);
+
+/**
+ * @internal
+ *
+ * Generate a new report UUID. CFUUID is used in favor of NSUUID as to maintain compatibility
+ * with (Mac OS X 10.7|iOS 5) and earlier.
+ */
+static void plcrash_writer_generate_uuid (plcrash_log_writer_t *writer) {
+    CFUUIDRef uuid = CFUUIDCreate(NULL);
+    CFUUIDBytes bytes = CFUUIDGetUUIDBytes(uuid);
+    PLCF_ASSERT(sizeof(bytes) == sizeof(writer->report_info.uuid_bytes));
+    memcpy(writer->report_info.uuid_bytes, &bytes, sizeof(writer->report_info.uuid_bytes));
+    CFRelease(uuid);
+}
+
 /**
  * Initialize a new crash log writer instance and issue a memory barrier upon completion. This fetches all necessary
  * environment information.
@@ -281,15 +353,8 @@ plcrash_error_t plcrash_log_writer_init (plcrash_log_writer_t *writer,
     /* Default to false */
     writer->report_info.user_requested = user_requested;
 
-    /* Generate a UUID for this incident; CFUUID is used in favor of NSUUID as to maintain compatibility
-     * with (Mac OS X 10.7|iOS 5) and earlier. */
-    {
-        CFUUIDRef uuid = CFUUIDCreate(NULL);
-        CFUUIDBytes bytes = CFUUIDGetUUIDBytes(uuid);
-        PLCF_ASSERT(sizeof(bytes) == sizeof(writer->report_info.uuid_bytes));
-        memcpy(writer->report_info.uuid_bytes, &bytes, sizeof(writer->report_info.uuid_bytes));
-        CFRelease(uuid);
-    }
+    /* Generate a UUID for this incident */
+    plcrash_writer_generate_uuid(writer);
 
     /* Fetch the application information */
     {
@@ -446,19 +511,167 @@ plcrash_error_t plcrash_log_writer_init (plcrash_log_writer_t *writer,
 #error Unsupported Platform
 #endif
 
+    /* Pre-encode the static report sections. If this fails, the sections will be encoded at crash time. */
+    plcrash_writer_preencode_static_sections(writer);
+
+#if PLCRASH_FEATURE_DEFERRED_IMAGE_INIT
+    /* Allocate the image path snapshot. If this fails, deferred images are named by individual dyld lookups. */
+    if (plcrash_nasync_image_paths_init(&writer->image_paths, PLCRASH_LOG_WRITER_MAX_TRACKED_IMAGES) != PLCRASH_ESUCCESS)
+        PLCF_DEBUG("Could not allocate the image path snapshot");
+#endif /* PLCRASH_FEATURE_DEFERRED_IMAGE_INIT */
+
+    /* Allocate the symbol memo table. If this fails, symbol lookups are not memoized. */
+    writer->symbol_memo = malloc(sizeof(*writer->symbol_memo));
+    if (writer->symbol_memo == NULL)
+        PLCF_DEBUG("Could not allocate the symbol memo table: %s", strerror(errno));
+
+    /* Allocate the stack memory capture buffer. The report options are configured after initialization, so the
+     * buffer is always reserved; its zero-fill pages are not touched unless stack memory is captured. If this fails,
+     * stack memory is not captured. */
+    {
+        vm_address_t addr;
+        kern_return_t kt = vm_allocate(mach_task_self(), &addr, PLCRASH_LOG_WRITER_MAX_STACK_MEMORY_BYTES, VM_FLAGS_ANYWHERE);
+        if (kt == KERN_SUCCESS) {
+            writer->stack_memory.buffer = (void *) addr;
+        } else {
+            PLCF_DEBUG("vm_allocate failed with error %x, stack memory will not be captured", kt);
+        }
+    }
+
     /* Ensure that any signal handler has a consistent view of the above initialization. */
     OSMemoryBarrier();
 
     return PLCRASH_ESUCCESS;
 }
 
+/**
+ * @internal
+ *
+ * Pre-encode the static report sections, replacing any previously encoded sections. If this fails, the sections
+ * will be encoded at crash time.
+ */
+static void plcrash_writer_preencode_static_sections (plcrash_log_writer_t *writer) {
+    plcrash_async_file_t file;
+    size_t length;
+
+    if (writer->static_sections.data != NULL) {
+        free(writer->static_sections.data);
+        writer->static_sections.data = NULL;
+    }
+
+    length = plcrash_writer_write_static_sections(NULL, writer, 0, NULL);
+    writer->static_sections.data = malloc(length);
+    if (writer->static_sections.data != NULL) {
+        plcrash_async_file_init_memory(&file, writer->static_sections.data, length);
+        writer->static_sections.length = plcrash_writer_write_static_sections(&file, writer, 0, &writer->static_sections.timestamp_offset);
+        PLCF_ASSERT(writer->static_sections.length == length);
+
+        /* The report info message is written first, and ends with the UUID's bytes */
+        uint32_t report_info_size = (uint32_t) plcrash_writer_write_report_info(NULL, writer);
+        writer->static_sections.uuid_offset = plcrash_writer_pack(NULL, PLCRASH_PROTO_REPORT_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, &report_info_size) +
+            report_info_size - sizeof(writer->report_info.uuid_bytes);
+    } else {
+        PLCF_DEBUG("Could not allocate pre-encoded report sections: %s", strerror(errno));
+    }
+}
+
+/**
+ * Replace the writer's process information with that of the process identified by @a pid. This may be used to
+ * write reports on behalf of another process, such as when generating reports out-of-process via
+ * plcrash_log_writer_write_task().
+ *
+ * @param writer The writer.
+ * @param pid The target process.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_EINVAL if the process information could not be fetched.
+ *
+ * @warning This function is not async safe, and must be called outside of a signal handler.
+ */
+plcrash_error_t plcrash_log_writer_set_target_process (plcrash_log_writer_t *writer, pid_t pid) {
+    PLCrashProcessInfo *pinfo = [[[PLCrashProcessInfo alloc] initWithProcessID: pid] autorelease];
+    if (pinfo == nil) {
+        PLCF_DEBUG("Could not retreive process info for target %d", (int) pid);
+        return PLCRASH_EINVAL;
+    }
+
+    if (writer->process_info.process_name != NULL)
+        free(writer->process_info.process_name);
+    if (writer->process_info.process_path != NULL)
+        free(writer->process_info.process_path);
+    if (writer->process_info.parent_process_name != NULL)
+        free(writer->process_info.parent_process_name);
+
+    writer->process_info.process_id = pinfo.processID;
+    writer->process_info.process_name = strdup([pinfo.processName UTF8String]);
+    writer->process_info.start_time = pinfo.startTime.tv_sec;
+
+    /* Retrieve path */
+    char process_path[PROC_PIDPATHINFO_MAXSIZE];
+    if (proc_pidpath(pid, process_path, sizeof(process_path)) > 0) {
+        writer->process_info.process_path = strdup(process_path);
+    } else {
+        writer->process_info.process_path = NULL;
+    }
+
+    /* Parent process */
+    writer->process_info.parent_process_id = pinfo.parentProcessID;
+    writer->process_info.parent_process_name = NULL;
+
+    PLCrashProcessInfo *parentInfo = [[[PLCrashProcessInfo alloc] initWithProcessID: pinfo.parentProcessID] autorelease];
+    if (parentInfo != nil) {
+        writer->process_info.parent_process_name = strdup([parentInfo.processName UTF8String]);
+    } else {
+        PLCF_DEBUG("Could not retreive parent process name: %s", strerror(errno));
+    }
+
+    /* The pre-encoded sections include the process information */
+    plcrash_writer_preencode_static_sections(writer);
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ *
+ * Resolve, symbolicate, and encode the uncaught exception's call stack frames. If this fails, the frames
+ * will be encoded at crash time.
+ */
+static void plcrash_writer_preencode_exception_frames (plcrash_log_writer_t *writer, plcrash_async_image_list_t *image_list) {
+    plcrash_async_symbol_cache_t findContext;
+    plcrash_async_file_t file;
+    size_t length;
+
+    /* Memoize lookups; each frame is resolved by both the sizing and the writing pass. The memo table is reset
+     * when a report is started. */
+    if (plcrash_async_symbol_cache_init_with_memo(&findContext, writer->symbol_memo) != PLCRASH_ESUCCESS)
+        return;
+
+    /* Symbolicate using the writer's full strategy; the crash-time time budget does not apply here. */
+    length = plcrash_writer_write_exception_frames(NULL, writer, image_list, writer->symbol_strategy, &findContext);
+    writer->uncaught_exception.frames_data = malloc(length);
+    if (writer->uncaught_exception.frames_data != NULL) {
+        plcrash_async_file_init_memory(&file, writer->uncaught_exception.frames_data, length);
+        writer->uncaught_exception.frames_length = plcrash_writer_write_exception_frames(&file, writer, image_list, writer->symbol_strategy, &findContext);
+        PLCF_ASSERT(writer->uncaught_exception.frames_length == length);
+    } else {
+        PLCF_DEBUG("Could not allocate pre-encoded exception frames: %s", strerror(errno));
+    }
+
+    plcrash_async_symbol_cache_free(&findContext);
+}
+
 /**
  * Set the uncaught exception for this writer. Once set, this exception will be used to
  * provide exception data for the crash log output.
  *
+ * @param writer The writer.
+ * @param exception The uncaught exception.
+ * @param image_list The list of images loaded in the current process, or NULL. If non-NULL, the exception's
+ * call stack will be symbolicated and encoded immediately, rather than from within the crash handler.
+ *
  * @warning This function is not async safe, and must be called outside of a signal handler.
  */
-void plcrash_log_writer_set_exception (plcrash_log_writer_t *writer, NSException *exception) {
+void plcrash_log_writer_set_exception (plcrash_log_writer_t *writer, NSException *exception, plcrash_async_image_list_t *image_list) {
     assert(writer->uncaught_exception.has_exception == false);
 
     /* Save the exception data */
@@ -479,8 +692,61 @@ void plcrash_log_writer_set_exception (plcrash_log_writer_t *writer, NSException
             writer->uncaught_exception.callstack[i] = (void *)(uintptr_t)[num unsignedLongLongValue];
             i++;
         }
+
+        /* Encode the frames while it is still safe to allocate and symbolicate without async-safety constraints */
+        if (image_list != NULL)
+            plcrash_writer_preencode_exception_frames(writer, image_list);
+    }
+
+    /* Ensure that any signal handler has a consistent view of the above initialization. */
+    OSMemoryBarrier();
+}
+
+/**
+ * Set the time budget for writing a report. If writing a report approaches the budget, the writer will progressively
+ * reduce the level of detail written -- first restricting symbolication to the image symbol tables, then disabling
+ * symbolication, and finally omitting all but the crashed thread. The level reached is recorded in the report.
+ *
+ * The remaining report sections (binary images, exception, and signal data) are always written, and the budget is
+ * therefore a target rather than a hard limit.
+ *
+ * @param writer The writer.
+ * @param budget_ns The time budget, in nanoseconds, or 0 to disable the time budget.
+ *
+ * @warning This function is not async safe, and must be called outside of a signal handler.
+ */
+void plcrash_log_writer_set_time_budget (plcrash_log_writer_t *writer, uint64_t budget_ns) {
+    mach_timebase_info_data_t timebase;
+
+    if (mach_timebase_info(&timebase) != KERN_SUCCESS || timebase.numer == 0) {
+        timebase.numer = 1;
+        timebase.denom = 1;
     }
 
+    writer->time_budget.budget = budget_ns * timebase.denom / timebase.numer;
+
+    /* A non-zero budget must never round down to the 'unlimited' value */
+    if (budget_ns > 0 && writer->time_budget.budget == 0)
+        writer->time_budget.budget = 1;
+
+    /* Ensure that any signal handler has a consistent view of the above initialization. */
+    OSMemoryBarrier();
+}
+
+/**
+ * Assign a new report UUID, allowing a single writer to be reused for multiple reports. The pre-encoded report
+ * sections are updated in place.
+ *
+ * @param writer The writer.
+ *
+ * @warning This function is not async safe, and must be called outside of a signal handler.
+ */
+void plcrash_log_writer_regenerate_uuid (plcrash_log_writer_t *writer) {
+    plcrash_writer_generate_uuid(writer);
+
+    if (writer->static_sections.data != NULL)
+        memcpy(writer->static_sections.data + writer->static_sections.uuid_offset, writer->report_info.uuid_bytes, sizeof(writer->report_info.uuid_bytes));
+
     /* Ensure that any signal handler has a consistent view of the above initialization. */
     OSMemoryBarrier();
 }
@@ -525,6 +791,10 @@ void plcrash_log_writer_free (plcrash_log_writer_t *writer) {
     if (writer->machine_info.model != NULL)
         free(writer->machine_info.model);
 
+    /* Free the pre-encoded report sections */
+    if (writer->static_sections.data != NULL)
+        free(writer->static_sections.data);
+
     /* Free the exception data */
     if (writer->uncaught_exception.has_exception) {
         if (writer->uncaught_exception.name != NULL)
@@ -535,7 +805,23 @@ void plcrash_log_writer_free (plcrash_log_writer_t *writer) {
         
         if (writer->uncaught_exception.callstack != NULL)
             free(writer->uncaught_exception.callstack);
+
+        if (writer->uncaught_exception.frames_data != NULL)
+            free(writer->uncaught_exception.frames_data);
     }
+
+#if PLCRASH_FEATURE_DEFERRED_IMAGE_INIT
+    /* Free the image path snapshot */
+    plcrash_nasync_image_paths_free(&writer->image_paths);
+#endif /* PLCRASH_FEATURE_DEFERRED_IMAGE_INIT */
+
+    /* Free the symbol memo table */
+    if (writer->symbol_memo != NULL)
+        free(writer->symbol_memo);
+
+    /* Free the stack memory capture buffer */
+    if (writer->stack_memory.buffer != NULL)
+        vm_deallocate(mach_task_self(), (vm_address_t) writer->stack_memory.buffer, PLCRASH_LOG_WRITER_MAX_STACK_MEMORY_BYTES);
 }
 
 /**
@@ -544,9 +830,11 @@ void plcrash_log_writer_free (plcrash_log_writer_t *writer) {
  * Write the system info message.
  *
  * @param file Output file
- * @param timestamp Timestamp to use (seconds since epoch). Must be same across calls, as varint encoding.
+ * @param timestamp Timestamp to use (seconds since epoch). The timestamp is written as a fixed-width field, and the
+ * message size does not depend on its value.
+ * @param timestamp_offset If non-NULL, will be set to the offset of the timestamp field within the message.
  */
-static size_t plcrash_writer_write_system_info (plcrash_async_file_t *file, plcrash_log_writer_t *writer, int64_t timestamp) {
+static size_t plcrash_writer_write_system_info (plcrash_async_file_t *file, plcrash_log_writer_t *writer, int64_t timestamp, size_t *timestamp_offset) {
     size_t rv = 0;
     uint32_t enumval;
 
@@ -565,7 +853,9 @@ static size_t plcrash_writer_write_system_info (plcrash_async_file_t *file, plcr
     rv += plcrash_writer_pack(file, PLCRASH_PROTO_SYSTEM_INFO_ARCHITECTURE_TYPE_ID, PLPROTOBUF_C_TYPE_ENUM, &enumval);
 
     /* Timestamp */
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_SYSTEM_INFO_TIMESTAMP_ID, PLPROTOBUF_C_TYPE_INT64, &timestamp);
+    if (timestamp_offset != NULL)
+        *timestamp_offset = rv;
+    rv += plcrash_writer_pack_padded_uint64(file, PLCRASH_PROTO_SYSTEM_INFO_TIMESTAMP_ID, (uint64_t) timestamp);
 
     return rv;
 }
@@ -823,6 +1113,78 @@ static void plcrash_writer_write_thread_frame_symbol_cb (pl_vm_address_t address
     cb_ctx->msgsize = plcrash_writer_write_symbol(cb_ctx->file, name, address);
 }
 
+/**
+ * @internal
+ *
+ * Reduce the writer's detail level according to the time elapsed since the current report was started. The detail
+ * level is never increased.
+ *
+ * This must only be called between top-level report messages, as each message is sized and then written in two
+ * separate passes that must produce identical output.
+ */
+static void plcrash_writer_update_detail_level (plcrash_log_writer_t *writer) {
+    uint64_t budget = writer->time_budget.budget;
+    plcrash_log_writer_detail_t level;
+
+    if (budget == 0)
+        return;
+
+    uint64_t elapsed = mach_absolute_time() - writer->time_budget.start_time;
+    if (elapsed >= budget - budget / 10) {
+        level = PLCRASH_LOG_WRITER_DETAIL_CRASHED_THREAD_ONLY;
+    } else if (elapsed >= budget - budget / 4) {
+        level = PLCRASH_LOG_WRITER_DETAIL_PC_ONLY;
+    } else if (elapsed >= budget / 2) {
+        level = PLCRASH_LOG_WRITER_DETAIL_SYMBOL_TABLE_ONLY;
+    } else {
+        level = PLCRASH_LOG_WRITER_DETAIL_FULL;
+    }
+
+    if (level > writer->time_budget.level)
+        writer->time_budget.level = level;
+}
+
+/**
+ * @internal
+ *
+ * Return the symbolication strategy permitted by the writer's current detail level.
+ */
+static plcrash_async_symbol_strategy_t plcrash_writer_symbol_strategy (plcrash_log_writer_t *writer) {
+    switch (writer->time_budget.level) {
+        case PLCRASH_LOG_WRITER_DETAIL_FULL:
+            return writer->symbol_strategy;
+
+        case PLCRASH_LOG_WRITER_DETAIL_SYMBOL_TABLE_ONLY:
+            return writer->symbol_strategy & PLCRASH_ASYNC_SYMBOL_STRATEGY_SYMBOL_TABLE;
+
+        default:
+            return PLCRASH_ASYNC_SYMBOL_STRATEGY_NONE;
+    }
+}
+
+/**
+ * @internal
+ *
+ * Mark @a image as referenced by the report currently being written.
+ */
+static void plcrash_writer_mark_image (plcrash_log_writer_t *writer, plcrash_async_image_t *image) {
+    if (image->index < PLCRASH_LOG_WRITER_MAX_TRACKED_IMAGES)
+        writer->referenced_images[image->index / 32] |= (1U << (image->index % 32));
+}
+
+/**
+ * @internal
+ *
+ * Return true if @a image is a member of the referenced image @a set (either plcrash_log_writer_t::referenced_images
+ * or plcrash_log_writer_t::crashed_thread_images). Images that can not be tracked are always considered to be members.
+ */
+static bool plcrash_writer_image_in_set (const uint32_t *set, plcrash_async_image_t *image) {
+    if (image->index >= PLCRASH_LOG_WRITER_MAX_TRACKED_IMAGES)
+        return true;
+
+    return (set[image->index / 32] & (1U << (image->index % 32))) != 0;
+}
+
 /**
  * @internal
  *
@@ -830,16 +1192,28 @@ static void plcrash_writer_write_thread_frame_symbol_cb (pl_vm_address_t address
  *
  * @param file Output file
  * @param pcval The frame PC value.
+ * @param repeat_count If greater than 1, the number of consecutive times the group of @a repeat_length frames
+ * beginning with this frame occurred in the original stack.
+ * @param repeat_length The number of frames in the repeated group. Ignored if @a repeat_count is 1.
+ * @param strategy The symbolication strategy to use for this frame.
  */
-static size_t plcrash_writer_write_thread_frame (plcrash_async_file_t *file, plcrash_log_writer_t *writer, uint64_t pcval, plcrash_async_image_list_t *image_list, plcrash_async_symbol_cache_t *findContext) {
+static size_t plcrash_writer_write_thread_frame (plcrash_async_file_t *file, plcrash_log_writer_t *writer, uint64_t pcval, uint32_t repeat_count, uint32_t repeat_length, plcrash_async_image_list_t *image_list, plcrash_async_symbol_strategy_t strategy, plcrash_async_symbol_cache_t *findContext) {
     size_t rv = 0;
 
     rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_FRAME_PC_ID, PLPROTOBUF_C_TYPE_UINT64, &pcval);
+
+    if (repeat_count > 1) {
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_FRAME_REPEAT_COUNT_ID, PLPROTOBUF_C_TYPE_UINT32, &repeat_count);
+        if (repeat_length > 1)
+            rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_FRAME_REPEAT_LENGTH_ID, PLPROTOBUF_C_TYPE_UINT32, &repeat_length);
+    }
     
     plcrash_async_image_list_set_reading(image_list, true);
     plcrash_async_image_t *image = plcrash_async_image_containing_address(image_list, (pl_vm_address_t) pcval);
-    
-    if (image != NULL && writer->symbol_strategy != PLCRASH_ASYNC_SYMBOL_STRATEGY_NONE) {
+    if (image != NULL)
+        plcrash_writer_mark_image(writer, image);
+
+    if (image != NULL && strategy != PLCRASH_ASYNC_SYMBOL_STRATEGY_NONE) {
         struct pl_symbol_cb_ctx ctx;
         plcrash_error_t ret;
         
@@ -847,13 +1221,13 @@ static size_t plcrash_writer_write_thread_frame (plcrash_async_file_t *file, plc
          * our callback is called and PLCRASH_ESUCCESS is returned. */
         ctx.file = NULL;
         ctx.msgsize = 0x0;
-        ret = plcrash_async_find_symbol(&image->macho_image, writer->symbol_strategy, findContext, (pl_vm_address_t) pcval, plcrash_writer_write_thread_frame_symbol_cb, &ctx);
+        ret = plcrash_async_find_symbol(&image->macho_image, strategy, findContext, (pl_vm_address_t) pcval, plcrash_writer_write_thread_frame_symbol_cb, &ctx);
         if (ret == PLCRASH_ESUCCESS) {
             /* Write the header and message */
             rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_FRAME_SYMBOL_ID, PLPROTOBUF_C_TYPE_MESSAGE, &ctx.msgsize);
 
             ctx.file = file;
-            ret = plcrash_async_find_symbol(&image->macho_image, writer->symbol_strategy, findContext, (pl_vm_address_t) pcval, plcrash_writer_write_thread_frame_symbol_cb, &ctx);
+            ret = plcrash_async_find_symbol(&image->macho_image, strategy, findContext, (pl_vm_address_t) pcval, plcrash_writer_write_thread_frame_symbol_cb, &ctx);
             if (ret == PLCRASH_ESUCCESS) {
                 rv += ctx.msgsize;
             } else {
@@ -869,6 +1243,153 @@ static size_t plcrash_writer_write_thread_frame (plcrash_async_file_t *file, plc
     return rv;
 }
 
+/**
+ * @internal
+ *
+ * Find the repeated group of frames beginning at @a pcs that covers the largest number of frames; this is used to
+ * fold the repeated frames produced by deep recursion.
+ *
+ * @param pcs The frame PC values.
+ * @param count The number of elements in @a pcs.
+ * @param[out] repeat_length On return, the number of frames in the repeated group, or 1 if no group was found.
+ * @param[out] repeat_count On return, the number of consecutive occurrences of the group, or 1 if no group was found.
+ */
+static void plcrash_writer_find_repeat (const plcrash_greg_t *pcs, uint32_t count, uint32_t *repeat_length, uint32_t *repeat_count) {
+    *repeat_length = 1;
+    *repeat_count = 1;
+
+    for (uint32_t length = 1; length <= MAX_REPEAT_FRAMES && length * 2 <= count; length++) {
+        /* Count the consecutive occurrences of the first length frames */
+        uint32_t matched = length;
+        while (matched < count && pcs[matched] == pcs[matched % length])
+            matched++;
+
+        uint32_t occurrences = matched / length;
+
+        if (occurrences > 1 && occurrences * length > *repeat_count * *repeat_length) {
+            *repeat_length = length;
+            *repeat_count = occurrences;
+        }
+    }
+}
+
+/**
+ * @internal
+ *
+ * Compute the hash of a thread's PC values (FNV-1a).
+ */
+static uint64_t plcrash_writer_hash_stack (const plcrash_greg_t *pcs, uint32_t count) {
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (uint32_t i = 0; i < count; i++) {
+        hash ^= (uint64_t) pcs[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/**
+ * @internal
+ *
+ * Search the stacks written by the current report for a stack identical to @a pcs.
+ *
+ * @param writer The writer context.
+ * @param hash The hash of @a pcs, as returned by plcrash_writer_hash_stack().
+ * @param pcs The PC values to search for.
+ * @param count The number of elements in @a pcs.
+ * @param[out] thread_number On success, the number of the thread whose frames were written.
+ *
+ * @return Returns true if an identical stack was found.
+ */
+static bool plcrash_writer_find_written_stack (plcrash_log_writer_t *writer, uint64_t hash, const plcrash_greg_t *pcs, uint32_t count, uint32_t *thread_number) {
+    for (uint32_t i = 0; i < writer->written_stacks.count; i++) {
+        if (writer->written_stacks.entries[i].hash != hash || writer->written_stacks.entries[i].frame_count != count)
+            continue;
+
+        /* Verify the match; the hash alone is not sufficient */
+        const plcrash_greg_t *written = &writer->written_stacks.pcs[writer->written_stacks.entries[i].pc_index];
+        bool match = true;
+        for (uint32_t j = 0; j < count && match; j++)
+            match = (written[j] == pcs[j]);
+
+        if (match) {
+            *thread_number = writer->written_stacks.entries[i].thread_number;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @internal
+ *
+ * Record the stack written for @a thread_number, allowing later threads with identical stacks to reference its
+ * frames. The stack is silently dropped if the tracked stack storage is exhausted.
+ */
+static void plcrash_writer_record_written_stack (plcrash_log_writer_t *writer, uint64_t hash, const plcrash_greg_t *pcs, uint32_t count, uint32_t thread_number) {
+    if (writer->written_stacks.count == PLCRASH_LOG_WRITER_MAX_TRACKED_STACKS)
+        return;
+
+    if (count > PLCRASH_LOG_WRITER_MAX_TRACKED_STACK_PCS - writer->written_stacks.pc_count)
+        return;
+
+    uint32_t pc_index = writer->written_stacks.pc_count;
+    plcrash_async_memcpy(&writer->written_stacks.pcs[pc_index], pcs, sizeof(pcs[0]) * count);
+    writer->written_stacks.pc_count += count;
+
+    writer->written_stacks.entries[writer->written_stacks.count].hash = hash;
+    writer->written_stacks.entries[writer->written_stacks.count].thread_number = thread_number;
+    writer->written_stacks.entries[writer->written_stacks.count].pc_index = pc_index;
+    writer->written_stacks.entries[writer->written_stacks.count].frame_count = count;
+    writer->written_stacks.count++;
+}
+
+/**
+ * @internal
+ *
+ * Write the stack memory captured for the current thread as a CrashReport.MemoryRegion message.
+ *
+ * @param file Output file
+ * @param writer Writer containing the captured stack memory.
+ */
+static size_t plcrash_writer_write_stack_memory (plcrash_async_file_t *file, plcrash_log_writer_t *writer) {
+    PLProtobufCBinaryData binary;
+    uint64_t address;
+    size_t rv = 0;
+
+    address = writer->stack_memory.address;
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_MEMORY_REGION_ADDRESS_ID, PLPROTOBUF_C_TYPE_UINT64, &address);
+
+    binary.len = writer->stack_memory.length;
+    binary.data = writer->stack_memory.buffer;
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_MEMORY_REGION_DATA_ID, PLPROTOBUF_C_TYPE_BYTES, &binary);
+
+    return rv;
+}
+
+/**
+ * @internal
+ *
+ * Write the stack memory captured for the current thread, if any, as a CrashReport.Thread.stack_memory field.
+ *
+ * @param file Output file
+ * @param writer Writer containing the captured stack memory.
+ */
+static size_t plcrash_writer_write_thread_stack_memory (plcrash_async_file_t *file, plcrash_log_writer_t *writer) {
+    size_t rv = 0;
+
+    if (writer->stack_memory.length == 0)
+        return 0;
+
+    uint32_t size = plcrash_writer_write_stack_memory(NULL, writer);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_STACK_MEMORY_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+    rv += plcrash_writer_write_stack_memory(file, writer);
+
+    return rv;
+}
+
 /**
  * @internal
  *
@@ -911,8 +1432,8 @@ static size_t plcrash_writer_write_thread (plcrash_async_file_t *file,
         rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_CRASHED_ID, PLPROTOBUF_C_TYPE_BOOL, &crashed);
     }
 
-
-    /* Write out the stack frames. */
+    /* Write out the stack frames. The captured stack memory, if any, is written after the frames, ensuring that the
+     * frames are retained if the report is truncated. */
     {
         /* Set up the frame cursor. */
         {            
@@ -929,35 +1450,70 @@ static size_t plcrash_writer_write_thread (plcrash_async_file_t *file,
             ferr = plframe_cursor_init(&cursor, task, &cursor_thr_state, image_list);
             if (ferr != PLFRAME_ESUCCESS) {
                 PLCF_DEBUG("An error occured initializing the frame cursor: %s", plframe_strerror(ferr));
+                rv += plcrash_writer_write_thread_stack_memory(file, writer);
                 return rv;
             }
         }
 
-        /* Walk the stack, limiting the total number of frames that are output. */
+        /* Walk the stack, limiting the total number of frames that are recorded. The PCs are gathered prior to
+         * writing, allowing repeated groups of frames to be folded. */
+        plcrash_greg_t *pcs = writer->thread_pcs;
         uint32_t frame_count = 0;
         while ((ferr = plframe_cursor_next(&cursor)) == PLFRAME_ESUCCESS && frame_count < MAX_THREAD_FRAMES) {
-            uint32_t frame_size;
-            
-            /* On the first frame, dump registers for the crashed thread */
-            if (frame_count == 0 && crashed) {
+            /* On the first frame, dump registers for the crashed thread, or for all threads if their stacks have
+             * been captured for post-mortem unwinding */
+            if (frame_count == 0 && (crashed || writer->stack_memory.length > 0)) {
                 rv += plcrash_writer_write_thread_registers(file, task, &cursor);
             }
 
             /* Fetch the PC value */
-            plcrash_greg_t pc = 0;
-            if ((ferr = plframe_cursor_get_reg(&cursor, PLCRASH_REG_IP, &pc)) != PLFRAME_ESUCCESS) {
+            if ((ferr = plframe_cursor_get_reg(&cursor, PLCRASH_REG_IP, &pcs[frame_count])) != PLFRAME_ESUCCESS) {
                 PLCF_DEBUG("Could not retrieve frame PC register: %s", plframe_strerror(ferr));
                 break;
             }
 
-            /* Determine the size */
-            frame_size = plcrash_writer_write_thread_frame(NULL, writer, pc, image_list, findContext);
-            
-            rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_FRAMES_ID, PLPROTOBUF_C_TYPE_MESSAGE, &frame_size);
-            rv += plcrash_writer_write_thread_frame(file, writer, pc, image_list, findContext);
             frame_count++;
         }
 
+        /* If enabled, threads with a stack identical to that of a previously written thread reference that thread's
+         * frames. The crashed thread always includes its own frames. */
+        if (writer->report_info.dedup_identical_stacks && frame_count > 0) {
+            uint64_t stack_hash = plcrash_writer_hash_stack(pcs, frame_count);
+            uint32_t frames_thread_number;
+
+            if (!crashed && plcrash_writer_find_written_stack(writer, stack_hash, pcs, frame_count, &frames_thread_number)) {
+                rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_FRAMES_THREAD_NUMBER_ID, PLPROTOBUF_C_TYPE_UINT32, &frames_thread_number);
+                frame_count = 0;
+            } else if (file != NULL) {
+                /* Only recorded once the frames are actually written, ensuring that the sizing pass produces
+                 * identical output */
+                plcrash_writer_record_written_stack(writer, stack_hash, pcs, frame_count, thread_number);
+            }
+        }
+
+        /* Write the frames. If folding is enabled, each repeated group is written (and symbolicated) only once. */
+        plcrash_async_symbol_strategy_t strategy = plcrash_writer_symbol_strategy(writer);
+        for (uint32_t i = 0; i < frame_count;) {
+            uint32_t repeat_length = 1;
+            uint32_t repeat_count = 1;
+
+            if (writer->report_info.fold_repeated_frames)
+                plcrash_writer_find_repeat(&pcs[i], frame_count - i, &repeat_length, &repeat_count);
+
+            for (uint32_t j = 0; j < repeat_length; j++) {
+                uint32_t frame_repeat_count = (j == 0) ? repeat_count : 1;
+                uint32_t frame_size;
+
+                /* Determine the size */
+                frame_size = plcrash_writer_write_thread_frame(NULL, writer, pcs[i + j], frame_repeat_count, repeat_length, image_list, strategy, findContext);
+
+                rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_FRAMES_ID, PLPROTOBUF_C_TYPE_MESSAGE, &frame_size);
+                rv += plcrash_writer_write_thread_frame(file, writer, pcs[i + j], frame_repeat_count, repeat_length, image_list, strategy, findContext);
+            }
+
+            i += repeat_length * repeat_count;
+        }
+
         /* Did we reach the end successfully? */
         if (ferr != PLFRAME_ENOFRAME) {
             /* This is non-fatal, and in some circumstances -could- be caused by reaching the end of the stack if the
@@ -966,6 +1522,9 @@ static size_t plcrash_writer_write_thread (plcrash_async_file_t *file,
         }
     }
 
+    /* Write the captured stack memory, if any */
+    rv += plcrash_writer_write_thread_stack_memory(file, writer);
+
     plframe_cursor_free(&cursor);
     return rv;
 }
@@ -1027,33 +1586,65 @@ static size_t plcrash_writer_write_binary_image (plcrash_async_file_t *file, plc
     return rv;
 }
 
+/**
+ * Encode @a image as a complete CrashReport.images record, including the field tag and length prefix. The result
+ * may be attached to the image via plcrash_nasync_image_set_report_record(), in which case it will be written
+ * as-is by plcrash_log_writer_write(), rather than re-encoding the image at crash time.
+ *
+ * @param image The image to be encoded.
+ * @param data On success, will be set to a malloc()-allocated buffer containing the encoded record. The caller is
+ * responsible for freeing this buffer.
+ * @param length On success, will be set to the length of @a data, in bytes.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_ENOMEM if the record could not be allocated.
+ *
+ * @warning This function is not async-safe.
+ */
+plcrash_error_t plcrash_log_writer_encode_binary_image (plcrash_async_macho_t *image, void **data, size_t *length) {
+    plcrash_async_file_t file;
+    uint32_t size;
+    size_t total;
+    void *buffer;
+
+    /* Determine the record size */
+    size = plcrash_writer_write_binary_image(NULL, image);
+    total = plcrash_writer_pack(NULL, PLCRASH_PROTO_BINARY_IMAGES_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size) + size;
+
+    if ((buffer = malloc(total)) == NULL)
+        return PLCRASH_ENOMEM;
+
+    /* Write the header and message */
+    plcrash_async_file_init_memory(&file, buffer, total);
+    plcrash_writer_pack(&file, PLCRASH_PROTO_BINARY_IMAGES_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+    plcrash_writer_write_binary_image(&file, image);
+
+    *data = buffer;
+    *length = total;
+    return PLCRASH_ESUCCESS;
+}
+
 
 /**
  * @internal
  *
- * Write the crash Exception message
+ * Write the crash Exception message's stack frames, if any.
  *
  * @param file Output file
  * @param writer Writer containing exception data
+ * @param strategy The symbolication strategy to use for the frames.
  */
-static size_t plcrash_writer_write_exception (plcrash_async_file_t *file, plcrash_log_writer_t *writer, plcrash_async_image_list_t *image_list, plcrash_async_symbol_cache_t *findContext) {
+static size_t plcrash_writer_write_exception_frames (plcrash_async_file_t *file, plcrash_log_writer_t *writer, plcrash_async_image_list_t *image_list, plcrash_async_symbol_strategy_t strategy, plcrash_async_symbol_cache_t *findContext) {
     size_t rv = 0;
 
-    /* Write the name and reason */
-    assert(writer->uncaught_exception.has_exception);
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_EXCEPTION_NAME_ID, PLPROTOBUF_C_TYPE_STRING, writer->uncaught_exception.name);
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_EXCEPTION_REASON_ID, PLPROTOBUF_C_TYPE_STRING, writer->uncaught_exception.reason);
-    
-    /* Write the stack frames, if any */
     uint32_t frame_count = 0;
     for (size_t i = 0; i < writer->uncaught_exception.callstack_count && frame_count < MAX_THREAD_FRAMES; i++) {
         uint64_t pc = (uint64_t)(uintptr_t) writer->uncaught_exception.callstack[i];
         
         /* Determine the size */
-        uint32_t frame_size = plcrash_writer_write_thread_frame(NULL, writer, pc, image_list, findContext);
+        uint32_t frame_size = plcrash_writer_write_thread_frame(NULL, writer, pc, 1, 1, image_list, strategy, findContext);
         
         rv += plcrash_writer_pack(file, PLCRASH_PROTO_EXCEPTION_FRAMES_ID, PLPROTOBUF_C_TYPE_MESSAGE, &frame_size);
-        rv += plcrash_writer_write_thread_frame(file, writer, pc, image_list, findContext);
+        rv += plcrash_writer_write_thread_frame(file, writer, pc, 1, 1, image_list, strategy, findContext);
         frame_count++;
     }
 
@@ -1063,12 +1654,50 @@ static size_t plcrash_writer_write_exception (plcrash_async_file_t *file, plcras
 /**
  * @internal
  *
- * Write the crash signal's mach exception info.
+ * Write the crash Exception message
  *
  * @param file Output file
- * @param siginfo The signal information
+ * @param writer Writer containing exception data
  */
-static size_t plcrash_writer_write_mach_signal (plcrash_async_file_t *file, plcrash_log_mach_signal_info_t *siginfo) {
+static size_t plcrash_writer_write_exception (plcrash_async_file_t *file, plcrash_log_writer_t *writer, plcrash_async_image_list_t *image_list, plcrash_async_symbol_cache_t *findContext) {
+    size_t rv = 0;
+
+    /* Write the name and reason */
+    assert(writer->uncaught_exception.has_exception);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_EXCEPTION_NAME_ID, PLPROTOBUF_C_TYPE_STRING, writer->uncaught_exception.name);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_EXCEPTION_REASON_ID, PLPROTOBUF_C_TYPE_STRING, writer->uncaught_exception.reason);
+
+    /* Write the stack frames, copying out the pre-encoded frames if available */
+    if (writer->uncaught_exception.frames_data == NULL) {
+        rv += plcrash_writer_write_exception_frames(file, writer, image_list, plcrash_writer_symbol_strategy(writer), findContext);
+        return rv;
+    }
+
+    if (file != NULL)
+        plcrash_async_file_write_nocopy(file, writer->uncaught_exception.frames_data, writer->uncaught_exception.frames_length);
+    rv += writer->uncaught_exception.frames_length;
+
+    /* The frames' images are not marked when encoded; mark them here */
+    plcrash_async_image_list_set_reading(image_list, true);
+    for (size_t i = 0; i < writer->uncaught_exception.callstack_count && i < MAX_THREAD_FRAMES; i++) {
+        plcrash_async_image_t *image = plcrash_async_image_containing_address(image_list, (pl_vm_address_t) writer->uncaught_exception.callstack[i]);
+        if (image != NULL)
+            plcrash_writer_mark_image(writer, image);
+    }
+    plcrash_async_image_list_set_reading(image_list, false);
+
+    return rv;
+}
+
+/**
+ * @internal
+ *
+ * Write the crash signal's mach exception info.
+ *
+ * @param file Output file
+ * @param siginfo The signal information
+ */
+static size_t plcrash_writer_write_mach_signal (plcrash_async_file_t *file, plcrash_log_mach_signal_info_t *siginfo) {
     size_t rv = 0;
 
     /* Type */
@@ -1164,6 +1793,355 @@ static size_t plcrash_writer_write_report_info (plcrash_async_file_t *file, plcr
     return rv;
 }
 
+/**
+ * @internal
+ *
+ * Write the report, system, machine, application, and process info messages. The contents of these messages are
+ * fixed once the writer has been initialized, with the exception of the system info timestamp; this is used by
+ * plcrash_log_writer_init() to pre-encode the messages.
+ *
+ * @param file Output file
+ * @param writer Writer containing report data
+ * @param timestamp Timestamp to use (seconds since epoch).
+ * @param timestamp_offset If non-NULL, will be set to the offset of the fixed-width timestamp field within the output.
+ */
+static size_t plcrash_writer_write_static_sections (plcrash_async_file_t *file, plcrash_log_writer_t *writer, int64_t timestamp, size_t *timestamp_offset) {
+    size_t rv = 0;
+
+    /* Report Info */
+    {
+        uint32_t size;
+        
+        /* Determine size */
+        size = plcrash_writer_write_report_info(NULL, writer);
+        
+        /* Write message */
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_REPORT_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+        rv += plcrash_writer_write_report_info(file, writer);
+    }
+
+    /* System Info */
+    {
+        size_t ts_offset;
+        uint32_t size;
+
+        /* Determine size */
+        size = plcrash_writer_write_system_info(NULL, writer, timestamp, NULL);
+        
+        /* Write message */
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_SYSTEM_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+        rv += plcrash_writer_write_system_info(file, writer, timestamp, &ts_offset);
+
+        if (timestamp_offset != NULL)
+            *timestamp_offset = rv - size + ts_offset;
+    }
+    
+    /* Machine Info */
+    {
+        uint32_t size;
+
+        /* Determine size */
+        size = plcrash_writer_write_machine_info(NULL, writer);
+
+        /* Write message */
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_MACHINE_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+        rv += plcrash_writer_write_machine_info(file, writer);
+    }
+
+    /* App info */
+    {
+        uint32_t size;
+
+        /* Determine size */
+        size = plcrash_writer_write_app_info(NULL, writer->application_info.app_identifier, writer->application_info.app_version);
+        
+        /* Write message */
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_APP_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+        rv += plcrash_writer_write_app_info(file, writer->application_info.app_identifier, writer->application_info.app_version);
+    }
+    
+    /* Process info */
+    {
+        uint32_t size;
+        
+        /* Determine size */
+        size = plcrash_writer_write_process_info(NULL, writer->process_info.process_name, writer->process_info.process_id, 
+                                                 writer->process_info.process_path, writer->process_info.parent_process_name,
+                                                 writer->process_info.parent_process_id, writer->process_info.native,
+                                                 writer->process_info.start_time);
+        
+        /* Write message */
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROCESS_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+        rv += plcrash_writer_write_process_info(file, writer->process_info.process_name, writer->process_info.process_id, 
+                                                writer->process_info.process_path, writer->process_info.parent_process_name, 
+                                                writer->process_info.parent_process_id, writer->process_info.native,
+                                                writer->process_info.start_time);
+    }
+
+    return rv;
+}
+
+/**
+ * @internal
+ *
+ * Binary image selection, used when writing binary image messages.
+ */
+typedef enum {
+    /** Write all images. */
+    PLCRASH_WRITER_IMAGES_ALL,
+
+    /** Write only the images referenced by the crashed thread's frames. */
+    PLCRASH_WRITER_IMAGES_REFERENCED,
+
+    /** Write only the images not referenced by the crashed thread's frames. */
+    PLCRASH_WRITER_IMAGES_UNREFERENCED,
+} plcrash_writer_image_selection_t;
+
+/**
+ * @internal
+ *
+ * Write a commit marker and flush the output file, if crashed-thread-first output is enabled. Otherwise, this is a
+ * no-op.
+ *
+ * @param writer The writer context.
+ * @param file The output file.
+ * @param sequence The number of commit markers previously written to the report; incremented on return.
+ */
+static void plcrash_writer_commit (plcrash_log_writer_t *writer, plcrash_async_file_t *file, uint32_t *sequence) {
+    if (!writer->report_info.crashed_thread_first)
+        return;
+
+    (*sequence)++;
+    plcrash_writer_pack(file, PLCRASH_PROTO_COMMIT_MARKER_ID, PLPROTOBUF_C_TYPE_UINT32, sequence);
+
+    if (!plcrash_async_file_flush(file)) {
+        PLCF_DEBUG("Failed to flush the report at a commit marker");
+        return;
+    }
+
+    if (writer->commit.callback != NULL)
+        writer->commit.callback(file, writer->commit.context);
+}
+
+/**
+ * @internal
+ *
+ * Return true if @a thread is to be written to the report.
+ *
+ * @param writer The writer context.
+ * @param thread The thread to check.
+ * @param crashed_thread The crashed thread.
+ * @param state_thread The thread described by @a current_state.
+ * @param current_state The state of @a state_thread, or NULL if unavailable.
+ */
+static bool plcrash_writer_thread_writable (plcrash_log_writer_t *writer, thread_t thread, thread_t crashed_thread, thread_t state_thread, plcrash_async_thread_state_t *current_state) {
+    /* Can't log a report for the state thread (generally, the current thread) without a valid context. */
+    if (state_thread == thread && current_state == NULL)
+        return false;
+
+    if (writer->report_info.crashed_thread_only && thread != crashed_thread)
+        return false;
+
+    return true;
+}
+
+/**
+ * @internal
+ *
+ * Copy up to @a max_length bytes of stack memory at @a start within @a task to the writer's capture buffer. The end
+ * of the stack is not known; if the read extends past the stack's mapping, it is retried with a smaller length.
+ *
+ * @return Returns the number of bytes copied, or 0 if no memory could be read at @a start.
+ */
+static size_t plcrash_writer_read_stack_memory (plcrash_log_writer_t *writer, task_t task, pl_vm_address_t start, size_t max_length) {
+    for (size_t length = max_length; length >= PLCRASH_WRITER_MIN_STACK_MEMORY_BYTES; length /= 2) {
+        if (plcrash_async_task_memcpy(task, start, 0, writer->stack_memory.buffer, length) == PLCRASH_ESUCCESS)
+            return length;
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ *
+ * Capture a bounded copy of @a thread's stack into the writer's stack memory buffer, using a single bulk read. If
+ * report_info.capture_stack_memory is not enabled, the report's capture budget has been exhausted, or the stack could
+ * not be read, the captured length is reset to 0.
+ *
+ * @param writer The writer context.
+ * @param task The task in which @a thread is executing.
+ * @param thread The thread whose stack should be captured.
+ * @param thr_ctx The thread's state, or NULL if the state should be fetched from @a thread.
+ * @param crashed If true, @a thread is the crashed thread, and its capture is reserved from the report's budget.
+ * Otherwise, the capture is drawn from the budget shared by the remaining threads.
+ */
+static void plcrash_writer_capture_stack_memory (plcrash_log_writer_t *writer, task_t task, thread_t thread, plcrash_async_thread_state_t *thr_ctx, bool crashed) {
+    plcrash_async_thread_state_t state;
+
+    writer->stack_memory.length = 0;
+
+    if (!writer->report_info.capture_stack_memory || writer->stack_memory.buffer == NULL)
+        return;
+
+    /* Apply the report's capture budget */
+    size_t max_length = PLCRASH_LOG_WRITER_MAX_STACK_MEMORY_BYTES;
+    if (!crashed && writer->stack_memory.remaining < max_length)
+        max_length = writer->stack_memory.remaining;
+
+    if (max_length < PLCRASH_WRITER_MIN_STACK_MEMORY_BYTES)
+        return;
+
+    /* Fetch the stack pointer */
+    if (thr_ctx != NULL) {
+        state = *thr_ctx;
+    } else if (plcrash_async_thread_state_mach_thread_init(&state, thread) != PLCRASH_ESUCCESS) {
+        return;
+    }
+
+    if (!plcrash_async_thread_state_has_reg(&state, PLCRASH_REG_SP) ||
+        plcrash_async_thread_state_get_stack_direction(&state) != PLCRASH_ASYNC_THREAD_STACK_DIRECTION_DOWN)
+        return;
+
+    /* Include the red zone below the stack pointer, which may hold live data in a leaf function */
+    pl_vm_address_t sp = plcrash_async_thread_state_get_reg(&state, PLCRASH_REG_SP);
+    pl_vm_address_t start = (sp > PLCRASH_WRITER_STACK_RED_ZONE) ? sp - PLCRASH_WRITER_STACK_RED_ZONE : 0;
+    size_t length = plcrash_writer_read_stack_memory(writer, task, start, max_length);
+
+    /* Following a stack overflow, the red zone lies within the stack's guard page; retry from the first page
+     * boundary above the red zone, or the stack pointer itself. */
+    if (length == 0 && start != sp) {
+        pl_vm_address_t page_start = (start + PAGE_SIZE) & ~((pl_vm_address_t) PAGE_SIZE - 1);
+        start = (page_start > start && page_start < sp) ? page_start : sp;
+        length = plcrash_writer_read_stack_memory(writer, task, start, max_length);
+    }
+
+    if (length == 0) {
+        PLCF_DEBUG("Failed to capture stack memory at 0x%" PRIx64, (uint64_t) sp);
+        return;
+    }
+
+    writer->stack_memory.address = start;
+    writer->stack_memory.length = length;
+    if (!crashed)
+        writer->stack_memory.remaining -= length;
+}
+
+/**
+ * @internal
+ *
+ * Write a complete CrashReport.threads message. Refer to plcrash_writer_write_thread() for a description of the
+ * parameters.
+ */
+static void plcrash_writer_write_thread_message (plcrash_async_file_t *file,
+                                                 plcrash_log_writer_t *writer,
+                                                 task_t task,
+                                                 thread_t thread,
+                                                 uint32_t thread_number,
+                                                 plcrash_async_thread_state_t *thr_ctx,
+                                                 plcrash_async_image_list_t *image_list,
+                                                 plcrash_async_symbol_cache_t *findContext,
+                                                 bool crashed)
+{
+    uint32_t size;
+
+    /* Capture the thread's stack; the same captured data is used by both the sizing and writing passes */
+    plcrash_writer_capture_stack_memory(writer, task, thread, thr_ctx, crashed);
+
+    /* Determine the size */
+    size = plcrash_writer_write_thread(NULL, writer, task, thread, thread_number, thr_ctx, image_list, findContext, crashed);
+
+    /* Write message */
+    plcrash_writer_pack(file, PLCRASH_PROTO_THREADS_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+    plcrash_writer_write_thread(file, writer, task, thread, thread_number, thr_ctx, image_list, findContext, crashed);
+}
+
+/**
+ * @internal
+ *
+ * Write the CrashReport.binary_images messages for the images selected by @a selection. If the writer is configured
+ * to write only referenced images, images that have not been marked as referenced are also omitted.
+ *
+ * @param file The output file.
+ * @param writer The writer context.
+ * @param image_list The current list of loaded binary images.
+ * @param selection The images to be written. The crashed thread's referenced images are those recorded in
+ * plcrash_log_writer_t::crashed_thread_images.
+ * @param[in,out] omitted_count Incremented for each image omitted as unreferenced.
+ */
+static void plcrash_writer_write_binary_images (plcrash_async_file_t *file,
+                                                plcrash_log_writer_t *writer,
+                                                plcrash_async_image_list_t *image_list,
+                                                plcrash_writer_image_selection_t selection,
+                                                uint32_t *omitted_count)
+{
+    plcrash_async_image_list_set_reading(image_list, true);
+
+#if PLCRASH_FEATURE_DEFERRED_IMAGE_INIT
+    plcrash_async_image_paths_t *paths = &writer->image_paths;
+#else
+    plcrash_async_image_paths_t *paths = NULL;
+#endif
+
+    plcrash_async_image_t *image = NULL;
+    while ((image = plcrash_async_image_list_next_with_paths(image_list, image, paths)) != NULL) {
+        uint32_t size;
+
+        if (selection != PLCRASH_WRITER_IMAGES_ALL) {
+            bool referenced = plcrash_writer_image_in_set(writer->crashed_thread_images, image);
+            if (referenced != (selection == PLCRASH_WRITER_IMAGES_REFERENCED))
+                continue;
+        }
+
+        if (writer->report_info.referenced_images_only && !plcrash_writer_image_in_set(writer->referenced_images, image)) {
+            (*omitted_count)++;
+            continue;
+        }
+
+        /* Use the pre-encoded record, if available */
+        void *record = image->report_record.data;
+        if (record != NULL) {
+            plcrash_async_file_write_nocopy(file, record, image->report_record.length);
+            continue;
+        }
+
+        /* Calculate the message size */
+        size = plcrash_writer_write_binary_image(NULL, &image->macho_image);
+        plcrash_writer_pack(file, PLCRASH_PROTO_BINARY_IMAGES_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+        plcrash_writer_write_binary_image(file, &image->macho_image);
+    }
+
+    plcrash_async_image_list_set_reading(image_list, false);
+}
+
+/**
+ * @internal
+ *
+ * Write the complete CrashReport.exception message.
+ */
+static void plcrash_writer_write_exception_message (plcrash_async_file_t *file, plcrash_log_writer_t *writer, plcrash_async_image_list_t *image_list, plcrash_async_symbol_cache_t *findContext) {
+    uint32_t size;
+
+    /* Calculate the message size */
+    size = plcrash_writer_write_exception(NULL, writer, image_list, findContext);
+    plcrash_writer_pack(file, PLCRASH_PROTO_EXCEPTION_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+    plcrash_writer_write_exception(file, writer, image_list, findContext);
+}
+
+/**
+ * @internal
+ *
+ * Write the complete CrashReport.signal message.
+ */
+static void plcrash_writer_write_signal_message (plcrash_async_file_t *file, plcrash_log_signal_info_t *siginfo) {
+    uint32_t size;
+
+    /* Calculate the message size */
+    size = plcrash_writer_write_signal(NULL, siginfo);
+    plcrash_writer_pack(file, PLCRASH_PROTO_SIGNAL_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+    plcrash_writer_write_signal(file, siginfo);
+}
+
 /**
  * Write the crash report. All other running threads are suspended while the crash report is generated.
  *
@@ -1184,6 +2162,37 @@ plcrash_error_t plcrash_log_writer_write (plcrash_log_writer_t *writer,
                                           plcrash_async_file_t *file,
                                           plcrash_log_signal_info_t *siginfo,
                                           plcrash_async_thread_state_t *current_state)
+{
+    return plcrash_log_writer_write_task(writer, mach_task_self(), crashed_thread, image_list, file, siginfo, pl_mach_thread_self(), current_state);
+}
+
+/**
+ * Write a crash report for @a task, which may be a task other than the current task. All threads of @a task other
+ * than the current thread are suspended while the crash report is generated.
+ *
+ * @param writer The writer context.
+ * @param task The task for which the report will be written.
+ * @param crashed_thread The crashed thread.
+ * @param image_list The list of binary images loaded in @a task.
+ * @param file The output file.
+ * @param siginfo Signal information.
+ * @param state_thread The thread described by @a current_state. For the current task, this is generally the
+ * current thread. The state of any other thread is fetched via the Mach thread APIs.
+ * @param current_state If non-NULL, the thread state to be used when walking @a state_thread. If NULL,
+ * @a state_thread will not be written. If @a crashed_thread is @a state_thread and @a state_thread is the current
+ * thread, this value <em>must</em> be provided.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success. If @a task is not the current task and its threads can not be
+ * fetched (eg, as the task has terminated), PLCRASH_EINTERNAL is returned and no report is written.
+ */
+plcrash_error_t plcrash_log_writer_write_task (plcrash_log_writer_t *writer,
+                                               task_t task,
+                                               thread_t crashed_thread,
+                                               plcrash_async_image_list_t *image_list,
+                                               plcrash_async_file_t *file,
+                                               plcrash_log_signal_info_t *siginfo,
+                                               thread_t state_thread,
+                                               plcrash_async_thread_state_t *current_state)
 {
     thread_act_array_t threads;
     mach_msg_type_number_t thread_count;
@@ -1192,21 +2201,53 @@ plcrash_error_t plcrash_log_writer_write (plcrash_log_writer_t *writer,
      * the thread's stack can not be safely walked. */
     PLCF_ASSERT(pl_mach_thread_self() != crashed_thread || current_state != NULL);
 
-    /* Get a list of all threads */
-    if (task_threads(mach_task_self(), &threads, &thread_count) != KERN_SUCCESS) {
+    /* Start the time budget */
+    writer->time_budget.start_time = mach_absolute_time();
+    writer->time_budget.level = PLCRASH_LOG_WRITER_DETAIL_FULL;
+
+    /* Reset the referenced image sets */
+    plcrash_async_memset(writer->referenced_images, 0, sizeof(writer->referenced_images));
+    plcrash_async_memset(writer->crashed_thread_images, 0, sizeof(writer->crashed_thread_images));
+
+    /* Reset the written stack set */
+    writer->written_stacks.count = 0;
+    writer->written_stacks.pc_count = 0;
+
+    /* Reset the stack memory budget, reserving the crashed thread's share */
+    writer->stack_memory.remaining = PLCRASH_LOG_WRITER_MAX_TOTAL_STACK_MEMORY_BYTES - PLCRASH_LOG_WRITER_MAX_STACK_MEMORY_BYTES;
+
+#if PLCRASH_FEATURE_DEFERRED_IMAGE_INIT
+    /* Snapshot the dyld image paths once, rather than once for every deferred image */
+    plcrash_async_image_paths_read(&writer->image_paths, image_list);
+#endif /* PLCRASH_FEATURE_DEFERRED_IMAGE_INIT */
+
+    /* Get a list of all threads. A task other than our own may have terminated; rather than writing a report
+     * without any threads, fail. */
+    if (task_threads(task, &threads, &thread_count) != KERN_SUCCESS) {
         PLCF_DEBUG("Fetching thread list failed");
+        if (task != mach_task_self())
+            return PLCRASH_EINTERNAL;
+
         thread_count = 0;
+    } else if (thread_count == 0 && task != mach_task_self()) {
+        PLCF_DEBUG("The target task has no threads");
+        vm_deallocate(mach_task_self(), (vm_address_t) threads, 0);
+        return PLCRASH_EINTERNAL;
     }
     
-    /* Suspend all but the current thread. */
+    /* Suspend all but the current thread. If only the crashed thread is to be written, the remaining threads
+     * are left running. */
     for (mach_msg_type_number_t i = 0; i < thread_count; i++) {
+        if (writer->report_info.crashed_thread_only && threads[i] != crashed_thread)
+            continue;
+
         if (threads[i] != pl_mach_thread_self())
             thread_suspend(threads[i]);
     }
 
     /* Set up a symbol-finding context. */
     plcrash_async_symbol_cache_t findContext;
-    plcrash_error_t err = plcrash_async_symbol_cache_init(&findContext);
+    plcrash_error_t err = plcrash_async_symbol_cache_init_with_memo(&findContext, writer->symbol_memo);
     /* Abort if it failed, although that should never actually happen, ever. */
     if (err != PLCRASH_ESUCCESS)
         return err;
@@ -1221,151 +2262,165 @@ plcrash_error_t plcrash_log_writer_write (plcrash_log_writer_t *writer,
     }
     
     
-    /* Report Info */
-    {
-        uint32_t size;
-        
-        /* Determine size */
-        size = plcrash_writer_write_report_info(NULL, writer);
-        
-        /* Write message */
-        plcrash_writer_pack(file, PLCRASH_PROTO_REPORT_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
-        plcrash_writer_write_report_info(file, writer);
-    }
-
-    /* System Info */
+    /* Report, system, machine, application, and process info */
     {
         time_t timestamp;
-        uint32_t size;
 
-        /* Must stay the same across both calls, so get the timestamp here */
         if (time(&timestamp) == (time_t)-1) {
             PLCF_DEBUG("Failed to fetch timestamp: %s", strerror(errno));
             timestamp = 0;
         }
 
-        /* Determine size */
-        size = plcrash_writer_write_system_info(NULL, writer, timestamp);
-        
-        /* Write message */
-        plcrash_writer_pack(file, PLCRASH_PROTO_SYSTEM_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
-        plcrash_writer_write_system_info(file, writer, timestamp);
+        if (writer->static_sections.data != NULL) {
+            /* Copy out the pre-encoded messages, filling in the timestamp slot */
+            size_t ts_offset = writer->static_sections.timestamp_offset;
+            size_t ts_size = plcrash_writer_pack_padded_uint64(NULL, PLCRASH_PROTO_SYSTEM_INFO_TIMESTAMP_ID, 0);
+
+            plcrash_async_file_write_nocopy(file, writer->static_sections.data, ts_offset);
+            plcrash_writer_pack_padded_uint64(file, PLCRASH_PROTO_SYSTEM_INFO_TIMESTAMP_ID, (uint64_t) timestamp);
+            plcrash_async_file_write_nocopy(file, writer->static_sections.data + ts_offset + ts_size, writer->static_sections.length - ts_offset - ts_size);
+        } else {
+            /* Pre-encoding failed; fall back on encoding the messages directly */
+            plcrash_writer_write_static_sections(file, writer, timestamp, NULL);
+        }
     }
     
-    /* Machine Info */
-    {
-        uint32_t size;
+    /* In crashed-thread-first order, the required signal message is written immediately after the static
+     * sections, ensuring that a report truncated at the first commit marker may still be decoded. */
+    bool crashed_first = writer->report_info.crashed_thread_first;
+    uint32_t commit_sequence = 0;
+    uint32_t omitted_image_count = 0;
 
-        /* Determine size */
-        size = plcrash_writer_write_machine_info(NULL, writer);
-
-        /* Write message */
-        plcrash_writer_pack(file, PLCRASH_PROTO_MACHINE_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
-        plcrash_writer_write_machine_info(file, writer);
+    if (crashed_first) {
+        plcrash_writer_write_signal_message(file, siginfo);
+        plcrash_writer_commit(writer, file, &commit_sequence);
     }
 
-    /* App info */
-    {
-        uint32_t size;
+    /* In crashed-thread-first order, write the crashed thread, the images referenced by its frames, and the
+     * uncaught exception (if any) before all other threads. */
+    if (crashed_first) {
+        uint32_t thread_number = 0;
+        for (mach_msg_type_number_t i = 0; i < thread_count; i++) {
+            thread_t thread = threads[i];
 
-        /* Determine size */
-        size = plcrash_writer_write_app_info(NULL, writer->application_info.app_identifier, writer->application_info.app_version);
-        
-        /* Write message */
-        plcrash_writer_pack(file, PLCRASH_PROTO_APP_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
-        plcrash_writer_write_app_info(file, writer->application_info.app_identifier, writer->application_info.app_version);
-    }
-    
-    /* Process info */
-    {
-        uint32_t size;
-        
-        /* Determine size */
-        size = plcrash_writer_write_process_info(NULL, writer->process_info.process_name, writer->process_info.process_id, 
-                                                 writer->process_info.process_path, writer->process_info.parent_process_name,
-                                                 writer->process_info.parent_process_id, writer->process_info.native,
-                                                 writer->process_info.start_time);
-        
-        /* Write message */
-        plcrash_writer_pack(file, PLCRASH_PROTO_PROCESS_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
-        plcrash_writer_write_process_info(file, writer->process_info.process_name, writer->process_info.process_id, 
-                                          writer->process_info.process_path, writer->process_info.parent_process_name, 
-                                          writer->process_info.parent_process_id, writer->process_info.native,
-                                          writer->process_info.start_time);
+            if (!plcrash_writer_thread_writable(writer, thread, crashed_thread, state_thread, current_state))
+                continue;
+
+            /* The thread numbers match those assigned below */
+            if (thread != crashed_thread) {
+                thread_number++;
+                continue;
+            }
+
+            plcrash_async_thread_state_t *thr_ctx = (state_thread == thread) ? current_state : NULL;
+            plcrash_writer_write_thread_message(file, writer, task, thread, thread_number, thr_ctx, image_list, &findContext, true);
+            plcrash_writer_commit(writer, file, &commit_sequence);
+            break;
+        }
+
+        /* Only the crashed thread has been written; its frames have marked exactly the images it references */
+        plcrash_async_memcpy(writer->crashed_thread_images, writer->referenced_images, sizeof(writer->crashed_thread_images));
+
+        plcrash_writer_write_binary_images(file, writer, image_list, PLCRASH_WRITER_IMAGES_REFERENCED, &omitted_image_count);
+        plcrash_writer_commit(writer, file, &commit_sequence);
+
+        if (writer->uncaught_exception.has_exception) {
+            /* Reduce the level of detail if required to meet the time budget */
+            plcrash_writer_update_detail_level(writer);
+
+            plcrash_writer_write_exception_message(file, writer, image_list, &findContext);
+            plcrash_writer_commit(writer, file, &commit_sequence);
+        }
     }
-    
+
     /* Threads */
     uint32_t thread_number = 0;
     for (mach_msg_type_number_t i = 0; i < thread_count; i++) {
         thread_t thread = threads[i];
         plcrash_async_thread_state_t *thr_ctx = NULL;
-        bool crashed = false;
-        uint32_t size;
+        bool crashed = (crashed_thread == thread);
+
+        if (!plcrash_writer_thread_writable(writer, thread, crashed_thread, state_thread, current_state))
+            continue;
 
         /* If executing on the target thread, we need to a valid context to walk */
-        if (pl_mach_thread_self() == thread) {
-            /* Can't log a report for the current thread without a valid context. */
-            if (current_state == NULL)
-                continue;
-        
+        if (state_thread == thread)
             thr_ctx = current_state;
-        }
-        
-        /* Check if this is the crashed thread */
-        if (crashed_thread == thread) {
-            crashed = true;
+
+        /* Skip the crashed thread if it has already been written */
+        if (crashed && crashed_first) {
+            thread_number++;
+            continue;
         }
 
-        /* Determine the size */
-        size = plcrash_writer_write_thread(NULL, writer, mach_task_self(), thread, thread_number, thr_ctx, image_list, &findContext, crashed);
+        /* Reduce the level of detail if required to meet the time budget */
+        plcrash_writer_update_detail_level(writer);
+        if (!crashed && writer->time_budget.level >= PLCRASH_LOG_WRITER_DETAIL_CRASHED_THREAD_ONLY) {
+            thread_number++;
+            continue;
+        }
 
-        /* Write message */
-        plcrash_writer_pack(file, PLCRASH_PROTO_THREADS_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
-        plcrash_writer_write_thread(file, writer, mach_task_self(), thread, thread_number, thr_ctx, image_list, &findContext, crashed);
+        plcrash_writer_write_thread_message(file, writer, task, thread, thread_number, thr_ctx, image_list, &findContext, crashed);
+        plcrash_writer_commit(writer, file, &commit_sequence);
 
         thread_number++;
     }
 
+    /* The uncaught exception is written after the binary images; mark any images referenced by its frames */
+    if (!crashed_first && writer->report_info.referenced_images_only && writer->uncaught_exception.has_exception) {
+        plcrash_async_image_list_set_reading(image_list, true);
+        for (size_t i = 0; i < writer->uncaught_exception.callstack_count; i++) {
+            plcrash_async_image_t *image = plcrash_async_image_containing_address(image_list, (pl_vm_address_t) writer->uncaught_exception.callstack[i]);
+            if (image != NULL)
+                plcrash_writer_mark_image(writer, image);
+        }
+        plcrash_async_image_list_set_reading(image_list, false);
+    }
+
     /* Binary Images */
-    plcrash_async_image_list_set_reading(image_list, true);
+    if (crashed_first) {
+        plcrash_writer_write_binary_images(file, writer, image_list, PLCRASH_WRITER_IMAGES_UNREFERENCED, &omitted_image_count);
+    } else {
+        plcrash_writer_write_binary_images(file, writer, image_list, PLCRASH_WRITER_IMAGES_ALL, &omitted_image_count);
+    }
 
-    plcrash_async_image_t *image = NULL;
-    while ((image = plcrash_async_image_list_next(image_list, image)) != NULL) {
-        uint32_t size;
+    if (omitted_image_count > 0)
+        plcrash_writer_pack(file, PLCRASH_PROTO_OMITTED_BINARY_IMAGE_COUNT_ID, PLPROTOBUF_C_TYPE_UINT32, &omitted_image_count);
 
-        /* Calculate the message size */
-        size = plcrash_writer_write_binary_image(NULL, &image->macho_image);
-        plcrash_writer_pack(file, PLCRASH_PROTO_BINARY_IMAGES_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
-        plcrash_writer_write_binary_image(file, &image->macho_image);
-    }
+    plcrash_writer_commit(writer, file, &commit_sequence);
 
-    plcrash_async_image_list_set_reading(image_list, false);
+    /* Exception and signal; these have already been written in crashed-thread-first order */
+    if (!crashed_first) {
+        if (writer->uncaught_exception.has_exception) {
+            /* Reduce the level of detail if required to meet the time budget */
+            plcrash_writer_update_detail_level(writer);
 
-    /* Exception */
-    if (writer->uncaught_exception.has_exception) {
-        uint32_t size;
+            plcrash_writer_write_exception_message(file, writer, image_list, &findContext);
+        }
 
-        /* Calculate the message size */
-        size = plcrash_writer_write_exception(NULL, writer, image_list, &findContext);
-        plcrash_writer_pack(file, PLCRASH_PROTO_EXCEPTION_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
-        plcrash_writer_write_exception(file, writer, image_list, &findContext);
+        plcrash_writer_write_signal_message(file, siginfo);
     }
-    
-    /* Signal */
-    {
-        uint32_t size;
-        
-        /* Calculate the message size */
-        size = plcrash_writer_write_signal(NULL, siginfo);
-        plcrash_writer_pack(file, PLCRASH_PROTO_SIGNAL_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
-        plcrash_writer_write_signal(file, siginfo);
+
+    /* Detail level; only written if detail was omitted */
+    if (writer->time_budget.level != PLCRASH_LOG_WRITER_DETAIL_FULL) {
+        uint32_t level = writer->time_budget.level;
+        plcrash_writer_pack(file, PLCRASH_PROTO_DETAIL_LEVEL_ID, PLPROTOBUF_C_TYPE_ENUM, &level);
+    }
+
+    /* Mark the report as complete */
+    if (crashed_first) {
+        bool complete = true;
+        plcrash_writer_pack(file, PLCRASH_PROTO_COMPLETE_ID, PLPROTOBUF_C_TYPE_BOOL, &complete);
+        plcrash_writer_commit(writer, file, &commit_sequence);
     }
     
+    plcrash_async_symbol_cache_get_stats(&findContext, &writer->symbol_cache_stats);
     plcrash_async_symbol_cache_free(&findContext);
     
     /* Clean up the thread array */
     for (mach_msg_type_number_t i = 0; i < thread_count; i++) {
-        if (threads[i] != pl_mach_thread_self())
+        bool suspended = !writer->report_info.crashed_thread_only || threads[i] == crashed_thread;
+        if (suspended && threads[i] != pl_mach_thread_self())
             thread_resume(threads[i]);
 
         mach_port_deallocate(mach_task_self(), threads[i]);
@@ -366,3 +366,33 @@ size_t plcrash_writer_pack (plcrash_async_file_t *file, uint32_t field_id, PLPro
     }
     return rv;
 }
+
+/**
+ * Pack a varint-encoded uint64 (or non-negative int64) field, padding the value to the maximum
+ * encoded varint width. The encoded size is independent of @a value, which allows a field to be
+ * reserved as a fixed-width slot within a pre-computed message and filled in at a later time.
+ *
+ * Non-minimal varint encodings are accepted by all conforming protobuf decoders.
+ *
+ * @param file Output file; may be NULL, in which case only the encoded size is returned.
+ * @param field_id The field ID.
+ * @param value The value to encode.
+ */
+size_t plcrash_writer_pack_padded_uint64 (plcrash_async_file_t *file, uint32_t field_id, uint64_t value) {
+    uint8_t scratch[MAX_UINT64_ENCODED_SIZE * 2];
+    size_t rv;
+
+    rv = tag_pack (field_id, scratch);
+    scratch[0] |= PLPROTOBUF_C_WIRE_TYPE_VARINT;
+
+    for (unsigned i = 0; i < MAX_UINT64_ENCODED_SIZE - 1; i++) {
+        scratch[rv++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    scratch[rv++] = value & 0x01;
+
+    if (file != NULL)
+        plcrash_async_file_write(file, scratch, rv);
+
+    return rv;
+}
@@ -50,6 +50,7 @@ typedef struct PLProtobufCBinaryData {
 } PLProtobufCBinaryData;
 
 size_t plcrash_writer_pack (plcrash_async_file_t *file, uint32_t field_id, PLProtobufCType field_type, const void *value);
+size_t plcrash_writer_pack_padded_uint64 (plcrash_async_file_t *file, uint32_t field_id, uint64_t value);
     
 #ifdef __cplusplus
 }
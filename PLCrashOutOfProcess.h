@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef PLCRASH_OUT_OF_PROCESS_H
+#define PLCRASH_OUT_OF_PROCESS_H
+
+#import <mach/mach.h>
+#import <limits.h>
+
+#import "PLCrashAsync.h"
+#import "PLCrashAsyncThread.h"
+#import "PLCrashLogWriter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @internal
+ * @defgroup plcrash_oop Out-of-Process Reporting
+ * @ingroup plcrash_internal
+ *
+ * Supports generating crash reports from a separate helper process. At crash time, the crashed process sends its
+ * task port, the crashed thread, and the signal and thread state to the helper's service port, and blocks until the
+ * helper replies. The helper suspends the crashed task's threads, and unwinds, symbolicates, and writes the report
+ * using the same writer used in-process, but without async-safety constraints and with a larger report size limit.
+ *
+ * Spawning the helper and transfering a send right for its service port to the crashed process are the
+ * responsibility of the host application; the mechanism available (eg, XPC, launchd, or bootstrap registration)
+ * varies by platform and application. Out-of-process reporting is not available on iOS, where helper processes
+ * may not be spawned.
+ *
+ * @{
+ */
+
+/** The maximum number of Mach exception codes supplied in a request. */
+#define PLCRASH_OOP_MAX_EXCEPTION_CODES 4
+
+/** The maximum length of the application identifier and version strings supplied in a request, including the
+ * trailing NUL. Longer values are truncated. */
+#define PLCRASH_OOP_MAX_APP_STRING 256
+
+/** Mach message ID of a report request. */
+#define PLCRASH_OOP_REQUEST_ID 0x504c4352
+
+/** Mach message ID of a report reply. */
+#define PLCRASH_OOP_REPLY_ID (PLCRASH_OOP_REQUEST_ID + 100)
+
+/**
+ * @internal
+ *
+ * Report options supplied in a request, mirroring the crashed process' writer configuration.
+ */
+typedef enum {
+    /** plcrash_log_writer_t::report_info.crashed_thread_first */
+    PLCRASH_OOP_FLAG_CRASHED_THREAD_FIRST = 1 << 0,
+
+    /** plcrash_log_writer_t::report_info.referenced_images_only */
+    PLCRASH_OOP_FLAG_REFERENCED_IMAGES_ONLY = 1 << 1,
+
+    /** plcrash_log_writer_t::report_info.dedup_identical_stacks */
+    PLCRASH_OOP_FLAG_DEDUP_IDENTICAL_STACKS = 1 << 2,
+
+    /** plcrash_log_writer_t::report_info.capture_stack_memory */
+    PLCRASH_OOP_FLAG_CAPTURE_STACK_MEMORY = 1 << 3,
+
+    /** plcrash_log_writer_t::report_info.fold_repeated_frames */
+    PLCRASH_OOP_FLAG_FOLD_REPEATED_FRAMES = 1 << 4,
+} plcrash_oop_flags_t;
+
+/**
+ * @internal
+ *
+ * Report request message, sent from the crashed process to the helper.
+ */
+typedef struct plcrash_oop_request {
+    /** Message header. The reply port is a send-once right to which a plcrash_oop_reply_t will be sent. */
+    mach_msg_header_t header;
+
+    /** Message body. */
+    mach_msg_body_t body;
+
+    /** The crashed task. */
+    mach_msg_port_descriptor_t task;
+
+    /** The crashed thread. */
+    mach_msg_port_descriptor_t crashed_thread;
+
+    /** The thread described by @a thread_state; generally, the thread sending the request. */
+    mach_msg_port_descriptor_t state_thread;
+
+    /** The BSD signal number. */
+    int32_t signo;
+
+    /** The BSD signal code. */
+    int32_t si_code;
+
+    /** The BSD signal address. */
+    uint64_t si_addr;
+
+    /** If non-zero, the Mach exception fields are valid. */
+    uint32_t has_mach_info;
+
+    /** The Mach exception type. */
+    exception_type_t exception_type;
+
+    /** The number of valid values in @a exception_codes. */
+    mach_msg_type_number_t exception_code_count;
+
+    /** The Mach exception codes. */
+    mach_exception_data_type_t exception_codes[PLCRASH_OOP_MAX_EXCEPTION_CODES];
+
+    /** If non-zero, @a thread_state is valid. */
+    uint32_t has_thread_state;
+
+    /** The state of @a state_thread. */
+    plcrash_async_thread_state_t thread_state;
+
+    /** The symbolication strategy to be used. */
+    plcrash_async_symbol_strategy_t symbol_strategy;
+
+    /** Report options; a combination of plcrash_oop_flags_t values. */
+    uint32_t flags;
+
+    /** The NUL-terminated application identifier. */
+    char app_identifier[PLCRASH_OOP_MAX_APP_STRING];
+
+    /** The NUL-terminated application version. */
+    char app_version[PLCRASH_OOP_MAX_APP_STRING];
+
+    /** The NUL-terminated path to which the report should be written. */
+    char path[PATH_MAX];
+} plcrash_oop_request_t;
+
+/**
+ * @internal
+ *
+ * Report reply message, sent from the helper once the report has been written.
+ */
+typedef struct plcrash_oop_reply {
+    /** Message header. */
+    mach_msg_header_t header;
+
+    /** The plcrash_error_t result of writing the report. */
+    int32_t result;
+} plcrash_oop_reply_t;
+
+/**
+ * @internal
+ *
+ * Crashed process state.
+ */
+typedef struct plcrash_oop_client {
+    /** A send right for the helper's service port, or MACH_PORT_NULL if out-of-process reporting is disabled. */
+    mach_port_t service_port;
+
+    /** Receive right on which the helper's reply is received. Allocated ahead of time, as port allocation is not
+     * async-safe. */
+    mach_port_t reply_port;
+
+    /** The maximum time to wait for the helper to receive the request and write the report, in milliseconds. This
+     * bounds the complete exchange; time spent sending the request is deducted from the time available for the
+     * reply. */
+    mach_msg_timeout_t timeout_ms;
+
+    /** The mach_absolute_time() timebase, fetched ahead of time. */
+    mach_timebase_info_data_t timebase;
+} plcrash_oop_client_t;
+
+/**
+ * @internal
+ *
+ * Helper process state.
+ */
+typedef struct plcrash_oop_server {
+    /** Receive right for the service port. A send right for this port must be supplied to the crashed process. */
+    mach_port_t service_port;
+
+    /** The maximum report size, in bytes. */
+    size_t max_report_bytes;
+} plcrash_oop_server_t;
+
+plcrash_error_t plcrash_nasync_oop_client_init (plcrash_oop_client_t *client, mach_port_t service_port, mach_msg_timeout_t timeout_ms);
+plcrash_error_t plcrash_async_oop_client_report (plcrash_oop_client_t *client,
+                                                 plcrash_log_writer_t *writer,
+                                                 const char *path,
+                                                 thread_t crashed_thread,
+                                                 plcrash_log_signal_info_t *siginfo,
+                                                 thread_t state_thread,
+                                                 plcrash_async_thread_state_t *thread_state);
+void plcrash_nasync_oop_client_free (plcrash_oop_client_t *client);
+
+plcrash_error_t plcrash_nasync_oop_server_init (plcrash_oop_server_t *server, size_t max_report_bytes);
+plcrash_error_t plcrash_nasync_oop_server_handle_request (plcrash_oop_server_t *server, mach_msg_timeout_t timeout_ms);
+void plcrash_nasync_oop_server_free (plcrash_oop_server_t *server);
+
+/**
+ * @} plcrash_oop
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_OUT_OF_PROCESS_H */
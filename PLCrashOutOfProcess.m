@@ -0,0 +1,491 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#import "PLCrashOutOfProcess.h"
+
+#import <stdio.h>
+#import <stdlib.h>
+#import <string.h>
+#import <fcntl.h>
+#import <errno.h>
+#import <unistd.h>
+
+#import "PLCrashAsyncImageList.h"
+
+/**
+ * @internal
+ * @ingroup plcrash_oop
+ * @{
+ */
+
+/**
+ * @internal
+ *
+ * Copy the NUL-terminated string @a src to @a dest, truncating to @a size bytes (including the trailing NUL).
+ * @a src may be NULL, in which case @a dest is set to the empty string. This function is async-safe.
+ */
+static void plcrash_oop_strlcpy (char *dest, const char *src, size_t size) {
+    size_t i = 0;
+
+    if (src != NULL) {
+        for (; i < size - 1 && src[i] != '\0'; i++)
+            dest[i] = src[i];
+    }
+
+    dest[i] = '\0';
+}
+
+/**
+ * Initialize the crashed process' out-of-process reporting state.
+ *
+ * @param client The client state to initialize.
+ * @param service_port A send right for the helper's service port. An additional reference to this right will be held
+ * for the lifetime of @a client.
+ * @param timeout_ms The maximum time to wait for the helper to receive the request and write the report, in
+ * milliseconds.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_EINTERNAL if the reply port could not be allocated.
+ *
+ * @warning This method is not async-safe.
+ */
+plcrash_error_t plcrash_nasync_oop_client_init (plcrash_oop_client_t *client, mach_port_t service_port, mach_msg_timeout_t timeout_ms) {
+    kern_return_t kt;
+
+    memset(client, 0, sizeof(*client));
+
+    if ((kt = mach_port_allocate(mach_task_self(), MACH_PORT_RIGHT_RECEIVE, &client->reply_port)) != KERN_SUCCESS) {
+        PLCF_DEBUG("Failed to allocate the reply port: %d", kt);
+        return PLCRASH_EINTERNAL;
+    }
+
+    if ((kt = mach_port_mod_refs(mach_task_self(), service_port, MACH_PORT_RIGHT_SEND, 1)) != KERN_SUCCESS) {
+        PLCF_DEBUG("Failed to retain the service port: %d", kt);
+        mach_port_mod_refs(mach_task_self(), client->reply_port, MACH_PORT_RIGHT_RECEIVE, -1);
+        client->reply_port = MACH_PORT_NULL;
+        return PLCRASH_EINTERNAL;
+    }
+
+    client->service_port = service_port;
+    client->timeout_ms = timeout_ms;
+
+    if (mach_timebase_info(&client->timebase) != KERN_SUCCESS || client->timebase.numer == 0) {
+        client->timebase.numer = 1;
+        client->timebase.denom = 1;
+    }
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Request that the helper write a report for the current task, blocking until the report has been written or the
+ * client's timeout elapses. The helper suspends all other threads of the current task while the report is written.
+ *
+ * The uncaught exception recorded by @a writer, if any, is not supplied to the helper; reports for uncaught
+ * exceptions should be written in-process.
+ *
+ * @param client The client state.
+ * @param writer The crashed process' writer; the application information, symbolication strategy, and report
+ * options are supplied to the helper.
+ * @param path The path to which the report should be written.
+ * @param crashed_thread The crashed thread.
+ * @param siginfo Signal information.
+ * @param state_thread The thread described by @a thread_state; generally, the current thread.
+ * @param thread_state The state of @a state_thread, or NULL if unavailable.
+ *
+ * @return Returns the helper's result on success, or PLCRASH_EINTERNAL if the helper could not be reached or did not
+ * reply within the client's timeout. In the latter case, the report should be written in-process; the helper writes
+ * to a temporary file that is atomically linked to @a path only if no report exists at @a path, and so may safely
+ * complete its report concurrently without replacing the in-process report.
+ *
+ * Any existing report at @a path is removed before the request is sent.
+ */
+plcrash_error_t plcrash_async_oop_client_report (plcrash_oop_client_t *client,
+                                                 plcrash_log_writer_t *writer,
+                                                 const char *path,
+                                                 thread_t crashed_thread,
+                                                 plcrash_log_signal_info_t *siginfo,
+                                                 thread_t state_thread,
+                                                 plcrash_async_thread_state_t *thread_state)
+{
+    plcrash_oop_request_t request;
+    mach_msg_return_t mr;
+
+    plcrash_async_memset(&request, 0, sizeof(request));
+
+    /* Header; the reply is delivered to a send-once right for our reply port */
+    request.header.msgh_bits = MACH_MSGH_BITS(MACH_MSG_TYPE_COPY_SEND, MACH_MSG_TYPE_MAKE_SEND_ONCE) | MACH_MSGH_BITS_COMPLEX;
+    request.header.msgh_size = sizeof(request);
+    request.header.msgh_remote_port = client->service_port;
+    request.header.msgh_local_port = client->reply_port;
+    request.header.msgh_id = PLCRASH_OOP_REQUEST_ID;
+
+    /* Port rights */
+    request.body.msgh_descriptor_count = 3;
+
+    request.task.name = mach_task_self();
+    request.task.disposition = MACH_MSG_TYPE_COPY_SEND;
+    request.task.type = MACH_MSG_PORT_DESCRIPTOR;
+
+    request.crashed_thread.name = crashed_thread;
+    request.crashed_thread.disposition = MACH_MSG_TYPE_COPY_SEND;
+    request.crashed_thread.type = MACH_MSG_PORT_DESCRIPTOR;
+
+    request.state_thread.name = state_thread;
+    request.state_thread.disposition = MACH_MSG_TYPE_COPY_SEND;
+    request.state_thread.type = MACH_MSG_PORT_DESCRIPTOR;
+
+    /* Signal info */
+    request.signo = siginfo->bsd_info->signo;
+    request.si_code = siginfo->bsd_info->code;
+    request.si_addr = (uint64_t) (uintptr_t) siginfo->bsd_info->address;
+
+    if (siginfo->mach_info != NULL) {
+        request.has_mach_info = 1;
+        request.exception_type = siginfo->mach_info->type;
+        request.exception_code_count = siginfo->mach_info->code_count;
+        if (request.exception_code_count > PLCRASH_OOP_MAX_EXCEPTION_CODES)
+            request.exception_code_count = PLCRASH_OOP_MAX_EXCEPTION_CODES;
+
+        for (mach_msg_type_number_t i = 0; i < request.exception_code_count; i++)
+            request.exception_codes[i] = siginfo->mach_info->code[i];
+    }
+
+    /* Thread state */
+    if (thread_state != NULL) {
+        request.has_thread_state = 1;
+        request.thread_state = *thread_state;
+    }
+
+    /* Report configuration */
+    request.symbol_strategy = writer->symbol_strategy;
+    if (writer->report_info.crashed_thread_first)
+        request.flags |= PLCRASH_OOP_FLAG_CRASHED_THREAD_FIRST;
+    if (writer->report_info.referenced_images_only)
+        request.flags |= PLCRASH_OOP_FLAG_REFERENCED_IMAGES_ONLY;
+    if (writer->report_info.dedup_identical_stacks)
+        request.flags |= PLCRASH_OOP_FLAG_DEDUP_IDENTICAL_STACKS;
+    if (writer->report_info.capture_stack_memory)
+        request.flags |= PLCRASH_OOP_FLAG_CAPTURE_STACK_MEMORY;
+    if (writer->report_info.fold_repeated_frames)
+        request.flags |= PLCRASH_OOP_FLAG_FOLD_REPEATED_FRAMES;
+
+    plcrash_oop_strlcpy(request.app_identifier, writer->application_info.app_identifier, sizeof(request.app_identifier));
+    plcrash_oop_strlcpy(request.app_version, writer->application_info.app_version, sizeof(request.app_version));
+    plcrash_oop_strlcpy(request.path, path, sizeof(request.path));
+
+    /* The helper never replaces an existing report; remove any stale report, as an in-process write would */
+    unlink(path);
+
+    /* Send the request */
+    uint64_t start = mach_absolute_time();
+    mr = mach_msg(&request.header, MACH_SEND_MSG | MACH_SEND_TIMEOUT, sizeof(request), 0, MACH_PORT_NULL, client->timeout_ms, MACH_PORT_NULL);
+    if (mr != MACH_MSG_SUCCESS) {
+        PLCF_DEBUG("Failed to send the report request: %d", mr);
+        return PLCRASH_EINTERNAL;
+    }
+
+    /* The timeout bounds the complete exchange; deduct the time spent sending */
+    uint64_t elapsed_ms = (mach_absolute_time() - start) * client->timebase.numer / client->timebase.denom / NSEC_PER_MSEC;
+    if (elapsed_ms >= client->timeout_ms) {
+        PLCF_DEBUG("Timed out sending the report request");
+        return PLCRASH_EINTERNAL;
+    }
+    mach_msg_timeout_t reply_timeout_ms = client->timeout_ms - (mach_msg_timeout_t) elapsed_ms;
+
+    /* Wait for the report to be written */
+    struct {
+        plcrash_oop_reply_t reply;
+        mach_msg_trailer_t trailer;
+    } reply;
+
+    mr = mach_msg(&reply.reply.header, MACH_RCV_MSG | MACH_RCV_TIMEOUT, 0, sizeof(reply), client->reply_port, reply_timeout_ms, MACH_PORT_NULL);
+    if (mr != MACH_MSG_SUCCESS) {
+        PLCF_DEBUG("Failed to receive the report reply: %d", mr);
+        return PLCRASH_EINTERNAL;
+    }
+
+    if (reply.reply.header.msgh_id != PLCRASH_OOP_REPLY_ID || reply.reply.header.msgh_size != sizeof(reply.reply)) {
+        PLCF_DEBUG("Received an unexpected report reply");
+        return PLCRASH_EINTERNAL;
+    }
+
+    return (plcrash_error_t) reply.reply.result;
+}
+
+/**
+ * Free all resources associated with @a client.
+ *
+ * @warning This method is not async-safe.
+ */
+void plcrash_nasync_oop_client_free (plcrash_oop_client_t *client) {
+    if (client->service_port != MACH_PORT_NULL)
+        mach_port_deallocate(mach_task_self(), client->service_port);
+
+    if (client->reply_port != MACH_PORT_NULL)
+        mach_port_mod_refs(mach_task_self(), client->reply_port, MACH_PORT_RIGHT_RECEIVE, -1);
+}
+
+/**
+ * Initialize the helper's out-of-process reporting state, allocating a new service port.
+ *
+ * @param server The server state to initialize.
+ * @param max_report_bytes The maximum report size, in bytes. As the helper is not subject to the crashed process'
+ * constraints, this may be substantially larger than the in-process limit.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_EINTERNAL if the service port could not be allocated.
+ *
+ * @warning This method is not async-safe.
+ */
+plcrash_error_t plcrash_nasync_oop_server_init (plcrash_oop_server_t *server, size_t max_report_bytes) {
+    kern_return_t kt;
+
+    memset(server, 0, sizeof(*server));
+
+    if ((kt = mach_port_allocate(mach_task_self(), MACH_PORT_RIGHT_RECEIVE, &server->service_port)) != KERN_SUCCESS) {
+        PLCF_DEBUG("Failed to allocate the service port: %d", kt);
+        return PLCRASH_EINTERNAL;
+    }
+
+    /* Provide a send right that may be transfered to the crashed process */
+    if ((kt = mach_port_insert_right(mach_task_self(), server->service_port, server->service_port, MACH_MSG_TYPE_MAKE_SEND)) != KERN_SUCCESS) {
+        PLCF_DEBUG("Failed to insert the service port send right: %d", kt);
+        mach_port_mod_refs(mach_task_self(), server->service_port, MACH_PORT_RIGHT_RECEIVE, -1);
+        return PLCRASH_EINTERNAL;
+    }
+
+    server->max_report_bytes = max_report_bytes;
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ *
+ * Write the report described by @a request.
+ */
+static plcrash_error_t plcrash_oop_server_write_report (plcrash_oop_server_t *server, plcrash_oop_request_t *request) {
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    task_t task = request->task.name;
+    plcrash_async_image_list_t image_list;
+    plcrash_async_file_t file;
+    plcrash_error_t err;
+    pid_t pid;
+
+    if (pid_for_task(task, &pid) != KERN_SUCCESS) {
+        PLCF_DEBUG("Could not determine the crashed task's pid");
+        [pool drain];
+        return PLCRASH_EINVAL;
+    }
+
+    /* Configure a writer matching that of the crashed process */
+    plcrash_log_writer_t *writer = malloc(sizeof(*writer));
+    if (writer == NULL) {
+        [pool drain];
+        return PLCRASH_ENOMEM;
+    }
+
+    err = plcrash_log_writer_init(writer,
+                                  [NSString stringWithUTF8String: request->app_identifier],
+                                  [NSString stringWithUTF8String: request->app_version],
+                                  request->symbol_strategy,
+                                  false);
+    if (err != PLCRASH_ESUCCESS || (err = plcrash_log_writer_set_target_process(writer, pid)) != PLCRASH_ESUCCESS) {
+        PLCF_DEBUG("Failed to initialize the log writer: %d", err);
+        plcrash_log_writer_free(writer);
+        free(writer);
+        [pool drain];
+        return err;
+    }
+
+    writer->report_info.crashed_thread_first = (request->flags & PLCRASH_OOP_FLAG_CRASHED_THREAD_FIRST) != 0;
+    writer->report_info.referenced_images_only = (request->flags & PLCRASH_OOP_FLAG_REFERENCED_IMAGES_ONLY) != 0;
+    writer->report_info.dedup_identical_stacks = (request->flags & PLCRASH_OOP_FLAG_DEDUP_IDENTICAL_STACKS) != 0;
+    writer->report_info.capture_stack_memory = (request->flags & PLCRASH_OOP_FLAG_CAPTURE_STACK_MEMORY) != 0;
+    writer->report_info.fold_repeated_frames = (request->flags & PLCRASH_OOP_FLAG_FOLD_REPEATED_FRAMES) != 0;
+
+    /* Fetch the crashed task's images */
+    plcrash_nasync_image_list_init(&image_list, task);
+    if ((err = plcrash_nasync_image_list_append_task_images(&image_list)) != PLCRASH_ESUCCESS)
+        PLCF_DEBUG("Failed to fetch the crashed task's images: %d", err);
+
+    /* Reconstruct the signal info */
+    plcrash_log_bsd_signal_info_t bsd_info;
+    plcrash_log_mach_signal_info_t mach_info;
+    plcrash_log_signal_info_t siginfo;
+
+    bsd_info.signo = request->signo;
+    bsd_info.code = request->si_code;
+    bsd_info.address = (void *) (uintptr_t) request->si_addr;
+
+    siginfo.bsd_info = &bsd_info;
+    siginfo.mach_info = NULL;
+
+    if (request->has_mach_info) {
+        mach_info.type = request->exception_type;
+        mach_info.code = request->exception_codes;
+        mach_info.code_count = request->exception_code_count;
+        siginfo.mach_info = &mach_info;
+    }
+
+    /* Write the report to a temporary file, linking it into place once complete. If the crashed process times out
+     * waiting for our reply, it writes the report to the requested path in-process; writing to a distinct file
+     * ensures that the two writers never interleave their output, and linking (rather than renaming) ensures that
+     * our report never replaces the in-process report. */
+    char temp_path[PATH_MAX + 32];
+    snprintf(temp_path, sizeof(temp_path), "%s.%d.tmp", request->path, (int) getpid());
+
+    int fd = open(temp_path, O_RDWR|O_CREAT|O_TRUNC, 0644);
+    if (fd < 0) {
+        PLCF_DEBUG("Could not open the crashlog output file: %s", strerror(errno));
+        err = PLCRASH_EINTERNAL;
+    } else {
+        plcrash_async_file_init(&file, fd, server->max_report_bytes);
+
+        err = plcrash_log_writer_write_task(writer, task, request->crashed_thread.name, &image_list, &file, &siginfo,
+                                            request->state_thread.name, request->has_thread_state ? &request->thread_state : NULL);
+
+        if (plcrash_log_writer_close(writer) != PLCRASH_ESUCCESS || !plcrash_async_file_flush(&file)) {
+            PLCF_DEBUG("Failed to complete the crash report");
+            err = PLCRASH_EINTERNAL;
+        }
+
+        plcrash_async_file_close(&file);
+
+        if (err == PLCRASH_ESUCCESS && link(temp_path, request->path) != 0) {
+            if (errno == EEXIST) {
+                PLCF_DEBUG("The crashed process has already written its report; discarding ours");
+            } else {
+                PLCF_DEBUG("Could not move the crashlog into place: %s", strerror(errno));
+            }
+            err = PLCRASH_EINTERNAL;
+        }
+
+        unlink(temp_path);
+    }
+
+    plcrash_nasync_image_list_free(&image_list);
+    plcrash_log_writer_free(writer);
+    free(writer);
+
+    [pool drain];
+    return err;
+}
+
+/**
+ * Receive and handle a single report request, replying to the crashed process once the report has been written.
+ *
+ * @param server The server state.
+ * @param timeout_ms The maximum time to wait for a request, in milliseconds, or MACH_MSG_TIMEOUT_NONE to wait
+ * indefinitely.
+ *
+ * @return Returns the result of writing the report, PLCRASH_ENOTFOUND if no request was received within
+ * @a timeout_ms, or PLCRASH_EINVAL if an invalid request was received.
+ *
+ * @warning This method is not async-safe.
+ */
+plcrash_error_t plcrash_nasync_oop_server_handle_request (plcrash_oop_server_t *server, mach_msg_timeout_t timeout_ms) {
+    struct {
+        plcrash_oop_request_t request;
+        mach_msg_trailer_t trailer;
+    } msg;
+    mach_msg_return_t mr;
+    plcrash_error_t err;
+
+    mach_msg_option_t options = MACH_RCV_MSG;
+    if (timeout_ms != MACH_MSG_TIMEOUT_NONE)
+        options |= MACH_RCV_TIMEOUT;
+
+    mr = mach_msg(&msg.request.header, options, 0, sizeof(msg), server->service_port, timeout_ms, MACH_PORT_NULL);
+    if (mr == MACH_RCV_TIMED_OUT) {
+        return PLCRASH_ENOTFOUND;
+    } else if (mr != MACH_MSG_SUCCESS) {
+        PLCF_DEBUG("Failed to receive a report request: %d", mr);
+        return PLCRASH_EINTERNAL;
+    }
+
+    /* Validate the request */
+    plcrash_oop_request_t *request = &msg.request;
+    if (request->header.msgh_id != PLCRASH_OOP_REQUEST_ID ||
+        request->header.msgh_size != sizeof(*request) ||
+        !(request->header.msgh_bits & MACH_MSGH_BITS_COMPLEX) ||
+        request->body.msgh_descriptor_count != 3 ||
+        request->task.type != MACH_MSG_PORT_DESCRIPTOR ||
+        request->crashed_thread.type != MACH_MSG_PORT_DESCRIPTOR ||
+        request->state_thread.type != MACH_MSG_PORT_DESCRIPTOR ||
+        request->exception_code_count > PLCRASH_OOP_MAX_EXCEPTION_CODES)
+    {
+        PLCF_DEBUG("Received an invalid report request");
+        mach_msg_destroy(&request->header);
+        return PLCRASH_EINVAL;
+    }
+
+    request->app_identifier[sizeof(request->app_identifier) - 1] = '\0';
+    request->app_version[sizeof(request->app_version) - 1] = '\0';
+    request->path[sizeof(request->path) - 1] = '\0';
+
+    err = plcrash_oop_server_write_report(server, request);
+
+    /* Reply; the crashed process is blocked until the reply is received */
+    plcrash_oop_reply_t reply;
+    memset(&reply, 0, sizeof(reply));
+
+    reply.header.msgh_bits = MACH_MSGH_BITS(MACH_MSGH_BITS_REMOTE(request->header.msgh_bits), 0);
+    reply.header.msgh_size = sizeof(reply);
+    reply.header.msgh_remote_port = request->header.msgh_remote_port;
+    reply.header.msgh_local_port = MACH_PORT_NULL;
+    reply.header.msgh_id = PLCRASH_OOP_REPLY_ID;
+    reply.result = err;
+
+    mr = mach_msg(&reply.header, MACH_SEND_MSG | MACH_SEND_TIMEOUT, sizeof(reply), 0, MACH_PORT_NULL, 0, MACH_PORT_NULL);
+    if (mr != MACH_MSG_SUCCESS) {
+        PLCF_DEBUG("Failed to send the report reply: %d", mr);
+        mach_port_deallocate(mach_task_self(), request->header.msgh_remote_port);
+    }
+
+    /* Release the received rights */
+    mach_port_deallocate(mach_task_self(), request->task.name);
+    mach_port_deallocate(mach_task_self(), request->crashed_thread.name);
+    mach_port_deallocate(mach_task_self(), request->state_thread.name);
+
+    return err;
+}
+
+/**
+ * Free all resources associated with @a server, including the service port.
+ *
+ * @warning This method is not async-safe.
+ */
+void plcrash_nasync_oop_server_free (plcrash_oop_server_t *server) {
+    if (server->service_port == MACH_PORT_NULL)
+        return;
+
+    mach_port_deallocate(mach_task_self(), server->service_port);
+    mach_port_mod_refs(mach_task_self(), server->service_port, MACH_PORT_RIGHT_RECEIVE, -1);
+}
+
+/**
+ * @} plcrash_oop
+ */
@@ -0,0 +1,667 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashProfiler.h"
+#include "PLCrashFrameWalker.h"
+#include "PLCrashLogWriterEncoding.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <mach/mach_time.h>
+#include <libkern/OSAtomic.h>
+
+/**
+ * @internal
+ * @ingroup plcrash_profiler
+ *
+ * Profile message field IDs (see crash_report.proto).
+ */
+enum {
+    /** Profile.sample_count */
+    PLCRASH_PROTO_PROFILE_SAMPLE_COUNT_ID = 1,
+
+    /** Profile.sample_interval_usec */
+    PLCRASH_PROTO_PROFILE_SAMPLE_INTERVAL_ID = 2,
+
+    /** Profile.nodes */
+    PLCRASH_PROTO_PROFILE_NODES_ID = 3,
+
+    /** Profile.images */
+    PLCRASH_PROTO_PROFILE_IMAGES_ID = 4,
+
+    /** Profile.dropped_sample_count */
+    PLCRASH_PROTO_PROFILE_DROPPED_COUNT_ID = 5,
+
+    /** Profile.truncated_sample_count */
+    PLCRASH_PROTO_PROFILE_TRUNCATED_COUNT_ID = 6,
+
+
+    /** Profile.Node.parent */
+    PLCRASH_PROTO_PROFILE_NODE_PARENT_ID = 1,
+
+    /** Profile.Node.image */
+    PLCRASH_PROTO_PROFILE_NODE_IMAGE_ID = 2,
+
+    /** Profile.Node.offset */
+    PLCRASH_PROTO_PROFILE_NODE_OFFSET_ID = 3,
+
+    /** Profile.Node.samples */
+    PLCRASH_PROTO_PROFILE_NODE_SAMPLES_ID = 4,
+
+
+    /** CrashReport.BinaryImage.base_address */
+    PLCRASH_PROTO_PROFILE_IMAGE_ADDR_ID = 1,
+
+    /** CrashReport.BinaryImage.size */
+    PLCRASH_PROTO_PROFILE_IMAGE_SIZE_ID = 2,
+
+    /** CrashReport.BinaryImage.name */
+    PLCRASH_PROTO_PROFILE_IMAGE_NAME_ID = 3,
+};
+
+/**
+ * @internal
+ * @ingroup plcrash_profiler
+ * @defgroup plcrash_profiler_profile Sample Call Tree
+ *
+ * The call tree is stored as a preallocated array of nodes. Each node holds the head of a singly-linked list of its
+ * children, and new children are published by atomically replacing the list head; nodes are never unlinked or
+ * reused, and so readers may walk the tree without synchronizing with writers.
+ *
+ * @{
+ */
+
+/**
+ * Initialize a new, empty call tree.
+ *
+ * @param profile The call tree to initialize.
+ * @param node_capacity The maximum number of call tree nodes, including the root node.
+ * @param image_capacity The maximum number of distinct images to be recorded. Frames within additional images will
+ * be recorded using their absolute PC.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_ENOMEM if the call tree storage could not be allocated.
+ *
+ * @warning This method is not async-safe.
+ */
+plcrash_error_t plcrash_nasync_profile_init (plcrash_async_profile_t *profile, uint32_t node_capacity, uint32_t image_capacity) {
+    memset(profile, 0, sizeof(*profile));
+
+    /* The root node must always be available */
+    if (node_capacity == 0)
+        node_capacity = 1;
+
+    profile->nodes = calloc(node_capacity, sizeof(profile->nodes[0]));
+    profile->images = calloc(image_capacity, sizeof(profile->images[0]));
+    if (profile->nodes == NULL || (profile->images == NULL && image_capacity > 0)) {
+        free(profile->nodes);
+        free((void *) profile->images);
+        return PLCRASH_ENOMEM;
+    }
+
+    profile->node_capacity = node_capacity;
+    profile->image_capacity = image_capacity;
+
+    /* Initialize the root node */
+    plcrash_async_profile_node_t *root = &profile->nodes[0];
+    root->parent = PLCRASH_PROFILE_NODE_NONE;
+    root->image_index = PLCRASH_PROFILE_NODE_NONE;
+    root->first_child = PLCRASH_PROFILE_NODE_NONE;
+    root->next_sibling = PLCRASH_PROFILE_NODE_NONE;
+    root->linked = true;
+    profile->node_count = 1;
+
+    OSMemoryBarrier();
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Return the index of @a image within @a profile's image table, adding it if necessary.
+ *
+ * @param profile The call tree.
+ * @param image The image to look up.
+ *
+ * @return Returns the image's table index, or PLCRASH_PROFILE_NODE_NONE if the table is full.
+ */
+static uint32_t plcrash_async_profile_image_index (plcrash_async_profile_t *profile, plcrash_async_image_t *image) {
+    /* Entries are claimed in order, and are never cleared; the first empty slot terminates the search. */
+    for (uint32_t i = 0; i < profile->image_capacity; i++) {
+        plcrash_async_image_t *entry = profile->images[i];
+        if (entry == image)
+            return i;
+
+        if (entry == NULL) {
+            if (OSAtomicCompareAndSwapPtrBarrier(NULL, image, (void * volatile *) &profile->images[i]))
+                return i;
+
+            /* Lost the race; the slot may have been claimed for this same image */
+            if (profile->images[i] == image)
+                return i;
+        }
+    }
+
+    return PLCRASH_PROFILE_NODE_NONE;
+}
+
+/**
+ * Return the index of the child of @a parent with the given key, inserting a new child if necessary.
+ *
+ * @param profile The call tree.
+ * @param parent The index of the parent node.
+ * @param image The child's image, or NULL.
+ * @param offset The child's offset.
+ *
+ * @return Returns the child's index, or PLCRASH_PROFILE_NODE_NONE if the node storage has been exhausted.
+ */
+static uint32_t plcrash_async_profile_child (plcrash_async_profile_t *profile, uint32_t parent, plcrash_async_image_t *image, pl_vm_address_t offset) {
+    plcrash_async_profile_node_t *nodes = profile->nodes;
+    uint32_t new_idx = PLCRASH_PROFILE_NODE_NONE;
+
+    while (true) {
+        uint32_t head = nodes[parent].first_child;
+
+        /* Ensure that the node contents are visible prior to reading them */
+        OSMemoryBarrier();
+
+        for (uint32_t idx = head; idx != PLCRASH_PROFILE_NODE_NONE; idx = nodes[idx].next_sibling) {
+            if (nodes[idx].offset == offset && nodes[idx].image == image) {
+                /* If we allocated a node and then lost a race to insert the same key, the allocated node
+                 * is simply abandoned; it will never be linked. */
+                return idx;
+            }
+        }
+
+        /* Allocate and initialize a new node. */
+        if (new_idx == PLCRASH_PROFILE_NODE_NONE) {
+            /* Check the capacity prior to incrementing, to avoid overflowing the counter once the storage is full */
+            if ((uint32_t) profile->node_count >= profile->node_capacity)
+                return PLCRASH_PROFILE_NODE_NONE;
+
+            new_idx = (uint32_t) OSAtomicIncrement32Barrier(&profile->node_count) - 1;
+            if (new_idx >= profile->node_capacity)
+                return PLCRASH_PROFILE_NODE_NONE;
+
+            plcrash_async_profile_node_t *node = &nodes[new_idx];
+            node->image = image;
+            node->offset = offset;
+            node->parent = parent;
+            node->image_index = (image != NULL) ? plcrash_async_profile_image_index(profile, image) : PLCRASH_PROFILE_NODE_NONE;
+            node->first_child = PLCRASH_PROFILE_NODE_NONE;
+            node->samples = 0;
+        }
+
+        /* Publish the node */
+        nodes[new_idx].next_sibling = head;
+        if (OSAtomicCompareAndSwap32Barrier((int32_t) head, (int32_t) new_idx, (volatile int32_t *) &nodes[parent].first_child)) {
+            nodes[new_idx].linked = true;
+            return new_idx;
+        }
+
+        /* The child list changed; re-scan for a concurrently inserted match */
+    }
+}
+
+/**
+ * Record a single stack sample in @a profile.
+ *
+ * @param profile The call tree in which the sample will be recorded.
+ * @param frames The sampled frames, ordered from the innermost frame to the outermost frame.
+ * @param count The number of elements in @a frames.
+ * @param truncated If true, @a frames does not include the sampled stack's outermost frames. The sample will be
+ * recorded beneath a synthetic root-level node with no image and an offset of 0.
+ *
+ * @par Async Safety
+ * This function is async-safe, and may be called concurrently with other calls to plcrash_async_profile_record()
+ * and with readers of @a profile.
+ */
+void plcrash_async_profile_record (plcrash_async_profile_t *profile, const plcrash_async_profile_frame_t frames[], size_t count, bool truncated) {
+    uint32_t node = 0;
+
+    OSAtomicIncrement64(&profile->sample_count);
+
+    if (truncated) {
+        OSAtomicIncrement64(&profile->truncated_count);
+        if ((node = plcrash_async_profile_child(profile, node, NULL, 0)) == PLCRASH_PROFILE_NODE_NONE) {
+            OSAtomicIncrement64(&profile->dropped_count);
+            return;
+        }
+    }
+
+    /* Walk the tree from the outermost frame inwards */
+    for (size_t i = count; i > 0; i--) {
+        const plcrash_async_profile_frame_t *frame = &frames[i - 1];
+        if ((node = plcrash_async_profile_child(profile, node, frame->image, frame->offset)) == PLCRASH_PROFILE_NODE_NONE) {
+            OSAtomicIncrement64(&profile->dropped_count);
+            return;
+        }
+    }
+
+    OSAtomicIncrement64(&profile->nodes[node].samples);
+}
+
+/**
+ * Free all resources associated with @a profile.
+ *
+ * @warning This method is not async-safe, and must not be called concurrently with any other access to @a profile.
+ */
+void plcrash_nasync_profile_free (plcrash_async_profile_t *profile) {
+    free(profile->nodes);
+    free((void *) profile->images);
+}
+
+/**
+ * @} plcrash_profiler_profile
+ */
+
+/**
+ * Initialize a new sampling profiler.
+ *
+ * @param profiler The profiler to initialize.
+ * @param task The task to be sampled. A reference to this port will be held for the lifetime of the profiler.
+ * @param image_list The list of images loaded in @a task. This is a borrowed reference, and must remain valid until
+ * the profiler is freed.
+ * @param interval_usec The sampling interval, in microseconds.
+ * @param node_capacity The maximum number of distinct call tree nodes to be recorded.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_ENOMEM if the profiler's storage could not be allocated.
+ *
+ * @warning This method is not async-safe.
+ */
+plcrash_error_t plcrash_nasync_profiler_init (plcrash_profiler_t *profiler,
+                                              task_t task,
+                                              plcrash_async_image_list_t *image_list,
+                                              uint32_t interval_usec,
+                                              uint32_t node_capacity)
+{
+    plcrash_error_t err;
+
+    memset(profiler, 0, sizeof(*profiler));
+
+    /* Images are never removed from the table; leave room for every image likely to be loaded */
+    if ((err = plcrash_nasync_profile_init(&profiler->profile, node_capacity, PLCRASH_PROFILER_MAX_IMAGES)) != PLCRASH_ESUCCESS)
+        return err;
+
+    mach_port_mod_refs(mach_task_self(), task, MACH_PORT_RIGHT_SEND, 1);
+    profiler->task = task;
+    profiler->image_list = image_list;
+    profiler->interval_usec = interval_usec;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Sample a single suspended thread.
+ *
+ * @param profiler The profiler.
+ * @param thread The thread to sample. The thread must be suspended.
+ * @param frames Frame storage, with room for PLCRASH_PROFILER_MAX_FRAMES entries.
+ * @param count On return, the number of frames written to @a frames.
+ * @param truncated On return, set to true if the thread's stack exceeded PLCRASH_PROFILER_MAX_FRAMES.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or an error if the thread's state could not be fetched.
+ */
+static plcrash_error_t plcrash_profiler_unwind_thread (plcrash_profiler_t *profiler,
+                                                       thread_t thread,
+                                                       plcrash_async_profile_frame_t frames[],
+                                                       size_t *count,
+                                                       bool *truncated)
+{
+    plframe_cursor_t cursor;
+    plframe_error_t ferr;
+
+    *count = 0;
+    *truncated = false;
+
+    if ((ferr = plframe_cursor_thread_init(&cursor, profiler->task, thread, profiler->image_list)) != PLFRAME_ESUCCESS) {
+        PLCF_DEBUG("Failed to initialize frame cursor for thread: %s", plframe_strerror(ferr));
+        return PLCRASH_EINTERNAL;
+    }
+
+    plcrash_async_image_list_set_reading(profiler->image_list, true);
+
+    while ((ferr = plframe_cursor_next(&cursor)) == PLFRAME_ESUCCESS) {
+        if (*count == PLCRASH_PROFILER_MAX_FRAMES) {
+            *truncated = true;
+            break;
+        }
+
+        plcrash_greg_t pc;
+        if (plframe_cursor_get_reg(&cursor, PLCRASH_REG_IP, &pc) != PLFRAME_ESUCCESS)
+            break;
+
+        /* Record the frame relative to its containing image, if any */
+        plcrash_async_profile_frame_t *frame = &frames[*count];
+        frame->image = plcrash_async_image_containing_address(profiler->image_list, (pl_vm_address_t) pc);
+        if (frame->image != NULL)
+            frame->offset = (pl_vm_address_t) pc - frame->image->macho_image.header_addr;
+        else
+            frame->offset = (pl_vm_address_t) pc;
+
+        (*count)++;
+    }
+
+    plcrash_async_image_list_set_reading(profiler->image_list, false);
+    plframe_cursor_free(&cursor);
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Perform a single sampling pass, suspending and unwinding each thread in the profiled task other than the calling
+ * thread, and recording the results.
+ *
+ * This function is called periodically by the profiler's sampling thread, but may also be called directly; this
+ * allows the cost of sampling to be measured via plcrash_profiler_get_stats() without a running sampling thread.
+ *
+ * @param profiler The profiler.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or an error if the task's threads could not be fetched.
+ *
+ * @warning This method is not async-safe.
+ */
+plcrash_error_t plcrash_profiler_sample (plcrash_profiler_t *profiler) {
+    thread_act_array_t threads;
+    mach_msg_type_number_t thread_count;
+    thread_t self = pl_mach_thread_self();
+    kern_return_t kr;
+
+    uint64_t start = mach_absolute_time();
+    uint64_t suspended = 0;
+    int64_t sampled = 0;
+
+    if ((kr = task_threads(profiler->task, &threads, &thread_count)) != KERN_SUCCESS) {
+        PLCF_DEBUG("Fetching thread list failed: %d", kr);
+        return PLCRASH_EINTERNAL;
+    }
+
+    for (mach_msg_type_number_t i = 0; i < thread_count; i++) {
+        thread_t thread = threads[i];
+        plcrash_async_profile_frame_t frames[PLCRASH_PROFILER_MAX_FRAMES];
+        size_t count;
+        bool truncated;
+        plcrash_error_t err;
+
+        if (thread == self || thread_suspend(thread) != KERN_SUCCESS) {
+            mach_port_deallocate(mach_task_self(), thread);
+            continue;
+        }
+
+        /* Unwind while suspended; the frames are recorded once the thread has been resumed */
+        uint64_t suspend_start = mach_absolute_time();
+        err = plcrash_profiler_unwind_thread(profiler, thread, frames, &count, &truncated);
+        thread_resume(thread);
+        suspended += mach_absolute_time() - suspend_start;
+
+        mach_port_deallocate(mach_task_self(), thread);
+
+        if (err != PLCRASH_ESUCCESS)
+            continue;
+
+        plcrash_async_profile_record(&profiler->profile, frames, count, truncated);
+        sampled++;
+    }
+
+    vm_deallocate(mach_task_self(), (vm_address_t) threads, sizeof(thread_t) * thread_count);
+
+    OSAtomicIncrement64(&profiler->stats.pass_count);
+    OSAtomicAdd64(sampled, &profiler->stats.thread_sample_count);
+    OSAtomicAdd64((int64_t) (mach_absolute_time() - start), &profiler->stats.sample_time);
+    OSAtomicAdd64((int64_t) suspended, &profiler->stats.suspended_time);
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Fetch the profiler's sampling cost statistics.
+ *
+ * @param profiler The profiler.
+ * @param stats On return, the profiler's current statistics.
+ */
+void plcrash_profiler_get_stats (plcrash_profiler_t *profiler, plcrash_profiler_stats_t *stats) {
+    mach_timebase_info_data_t timebase;
+    if (mach_timebase_info(&timebase) != KERN_SUCCESS || timebase.denom == 0) {
+        timebase.numer = 1;
+        timebase.denom = 1;
+    }
+
+    stats->pass_count = (uint64_t) profiler->stats.pass_count;
+    stats->thread_sample_count = (uint64_t) profiler->stats.thread_sample_count;
+    stats->sample_time_ns = (uint64_t) profiler->stats.sample_time * timebase.numer / timebase.denom;
+    stats->suspended_time_ns = (uint64_t) profiler->stats.suspended_time * timebase.numer / timebase.denom;
+}
+
+/**
+ * The sampling thread's entry point.
+ */
+static void *plcrash_profiler_thread (void *arg) {
+    plcrash_profiler_t *profiler = arg;
+
+    while (!profiler->stop_requested) {
+        plcrash_profiler_sample(profiler);
+        usleep(profiler->interval_usec);
+    }
+
+    return NULL;
+}
+
+/**
+ * Start periodic sampling on a new background thread.
+ *
+ * @param profiler The profiler to start. The profiler must not already be running.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_EINTERNAL if the sampling thread could not be started.
+ *
+ * @warning This method is not async-safe.
+ */
+plcrash_error_t plcrash_nasync_profiler_start (plcrash_profiler_t *profiler) {
+    PLCF_ASSERT(!profiler->running);
+
+    profiler->stop_requested = false;
+    OSMemoryBarrier();
+
+    if (pthread_create(&profiler->thread, NULL, plcrash_profiler_thread, profiler) != 0) {
+        PLCF_DEBUG("Failed to start the profiler sampling thread");
+        return PLCRASH_EINTERNAL;
+    }
+
+    profiler->running = true;
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Stop periodic sampling, waiting for the sampling thread to exit. If the profiler is not running, this is a no-op.
+ *
+ * @param profiler The profiler to stop.
+ *
+ * @warning This method is not async-safe.
+ */
+void plcrash_nasync_profiler_stop (plcrash_profiler_t *profiler) {
+    if (!profiler->running)
+        return;
+
+    profiler->stop_requested = true;
+    OSMemoryBarrier();
+
+    pthread_join(profiler->thread, NULL);
+    profiler->running = false;
+}
+
+/**
+ * @internal
+ *
+ * Write a call tree node message.
+ *
+ * @param file Output file, or NULL to compute the message size.
+ * @param profile The call tree.
+ * @param idx The index of the node to be written.
+ */
+static size_t plcrash_profiler_write_node (plcrash_async_file_t *file, plcrash_async_profile_t *profile, uint32_t idx) {
+    plcrash_async_profile_node_t *node = &profile->nodes[idx];
+    size_t rv = 0;
+    uint64_t offset = 0;
+    uint64_t samples = 0;
+
+    if (idx == 0) {
+        /* Root node; has no parent and no PC */
+        samples = (uint64_t) node->samples;
+    } else if (!node->linked) {
+        /* The node is either still being initialized, or was abandoned after losing an insertion race. In either
+         * case it is unreachable; write a placeholder so that the indices of subsequent nodes are preserved. The
+         * placeholder's parent is set to PLCRASH_PROFILE_NODE_NONE, which is never a valid node index, allowing
+         * readers to distinguish it from the root-level node of truncated samples. */
+        uint32_t parent = PLCRASH_PROFILE_NODE_NONE;
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_NODE_PARENT_ID, PLPROTOBUF_C_TYPE_UINT32, &parent);
+    } else {
+        uint32_t parent = node->parent;
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_NODE_PARENT_ID, PLPROTOBUF_C_TYPE_UINT32, &parent);
+
+        offset = node->offset;
+        if (node->image_index != PLCRASH_PROFILE_NODE_NONE) {
+            uint32_t image_index = node->image_index;
+            rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_NODE_IMAGE_ID, PLPROTOBUF_C_TYPE_UINT32, &image_index);
+        } else if (node->image != NULL) {
+            /* The image table was full; fall back to the absolute PC */
+            offset += node->image->macho_image.header_addr;
+        }
+
+        samples = (uint64_t) node->samples;
+    }
+
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_NODE_OFFSET_ID, PLPROTOBUF_C_TYPE_UINT64, &offset);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_NODE_SAMPLES_ID, PLPROTOBUF_C_TYPE_UINT64, &samples);
+
+    return rv;
+}
+
+/**
+ * @internal
+ *
+ * Write a binary image message. This is only used for images without a pre-encoded report record, and writes only
+ * the fields required to resolve node offsets.
+ *
+ * @param file Output file, or NULL to compute the message size.
+ * @param image The image to be written.
+ */
+static size_t plcrash_profiler_write_image (plcrash_async_file_t *file, plcrash_async_macho_t *image) {
+    size_t rv = 0;
+    uint64_t u64;
+
+    u64 = image->header_addr;
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_IMAGE_ADDR_ID, PLPROTOBUF_C_TYPE_UINT64, &u64);
+
+    u64 = image->text_size;
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_IMAGE_SIZE_ID, PLPROTOBUF_C_TYPE_UINT64, &u64);
+
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_IMAGE_NAME_ID, PLPROTOBUF_C_TYPE_STRING, image->name);
+
+    return rv;
+}
+
+/**
+ * Write the profiler's aggregated samples to @a file as a Profile message (see crash_report.proto), preceded by
+ * the PLCRASH_PROFILE_FILE_MAGIC header.
+ *
+ * Images are written using their pre-encoded report records where available (see
+ * plcrash_nasync_image_set_report_record()), and so the images written are identical to those of a crash report
+ * written by the same process.
+ *
+ * @param profiler The profiler to be written. Sampling may continue while the profile is written; samples recorded
+ * concurrently may or may not be included.
+ * @param file The output file. The caller is responsible for flushing and closing the file.
+ *
+ * @par Async Safety
+ * This function is async-safe, and may be called from a crash handler.
+ */
+plcrash_error_t plcrash_async_profiler_write (plcrash_profiler_t *profiler, plcrash_async_file_t *file) {
+    plcrash_async_profile_t *profile = &profiler->profile;
+
+    /* Write the file header */
+    {
+        uint8_t version = PLCRASH_PROFILE_FILE_VERSION;
+
+        /* Write the magic string (with no trailing NULL) and the version number */
+        plcrash_async_file_write(file, PLCRASH_PROFILE_FILE_MAGIC, strlen(PLCRASH_PROFILE_FILE_MAGIC));
+        plcrash_async_file_write(file, &version, sizeof(version));
+    }
+
+    /* Sample counts */
+    uint64_t u64 = (uint64_t) profile->sample_count;
+    plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_SAMPLE_COUNT_ID, PLPROTOBUF_C_TYPE_UINT64, &u64);
+
+    uint32_t interval = profiler->interval_usec;
+    plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_SAMPLE_INTERVAL_ID, PLPROTOBUF_C_TYPE_UINT32, &interval);
+
+    u64 = (uint64_t) profile->dropped_count;
+    plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_DROPPED_COUNT_ID, PLPROTOBUF_C_TYPE_UINT64, &u64);
+
+    u64 = (uint64_t) profile->truncated_count;
+    plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_TRUNCATED_COUNT_ID, PLPROTOBUF_C_TYPE_UINT64, &u64);
+
+    /* Nodes. The count is fetched once; any nodes allocated after this point are not written. The count may exceed
+     * the capacity if allocations have failed. */
+    uint32_t node_count = (uint32_t) profile->node_count;
+    if (node_count > profile->node_capacity)
+        node_count = profile->node_capacity;
+    OSMemoryBarrier();
+
+    for (uint32_t i = 0; i < node_count; i++) {
+        uint32_t size = (uint32_t) plcrash_profiler_write_node(NULL, profile, i);
+        plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_NODES_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+        plcrash_profiler_write_node(file, profile, i);
+    }
+
+    /* Images. Every image referenced by a written node was added to the table before that node was linked. */
+    for (uint32_t i = 0; i < profile->image_capacity; i++) {
+        plcrash_async_image_t *image = profile->images[i];
+        if (image == NULL)
+            break;
+
+        /* Use the pre-encoded record, if available. CrashReport.images and Profile.images share the same field
+         * number, and so the record may be written as-is. */
+        void *record = image->report_record.data;
+        if (record != NULL) {
+            plcrash_async_file_write(file, record, image->report_record.length);
+            continue;
+        }
+
+        uint32_t size = (uint32_t) plcrash_profiler_write_image(NULL, &image->macho_image);
+        plcrash_writer_pack(file, PLCRASH_PROTO_PROFILE_IMAGES_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+        plcrash_profiler_write_image(file, &image->macho_image);
+    }
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Free all resources associated with @a profiler, stopping the sampling thread if it is running.
+ *
+ * @warning This method is not async-safe.
+ */
+void plcrash_nasync_profiler_free (plcrash_profiler_t *profiler) {
+    plcrash_nasync_profiler_stop(profiler);
+    plcrash_nasync_profile_free(&profiler->profile);
+    mach_port_mod_refs(mach_task_self(), profiler->task, MACH_PORT_RIGHT_SEND, -1);
+}
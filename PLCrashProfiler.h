@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2013 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_PROFILER_H
+#define PLCRASH_PROFILER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "PLCrashAsync.h"
+#include "PLCrashAsyncImageList.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @internal
+ * @ingroup plcrash_internal
+ * @defgroup plcrash_profiler Sampling Profiler
+ *
+ * Implements a low-overhead CPU sampling profiler, using the same frame readers used to unwind crashed threads.
+ * Threads are periodically suspended and unwound, and the resulting stacks are aggregated into a lock-free call tree
+ * that may be written as a protobuf-encoded Profile message (see crash_report.proto).
+ * @{
+ */
+
+/** The maximum number of frames recorded for a single thread sample. Deeper stacks are truncated, retaining the
+ * innermost frames. */
+#define PLCRASH_PROFILER_MAX_FRAMES 128
+
+/** The maximum number of distinct images recorded by a profiler. Frames within additional images are recorded
+ * using their absolute PC. */
+#define PLCRASH_PROFILER_MAX_IMAGES 1024
+
+/** Call tree node index value used to designate the absence of a node. */
+#define PLCRASH_PROFILE_NODE_NONE UINT32_MAX
+
+/** Profile file magic identifier. Profile files start with this 7 byte identifier, followed by a single unsigned
+ * byte version number (#PLCRASH_PROFILE_FILE_VERSION) and the encoded Profile message. */
+#define PLCRASH_PROFILE_FILE_MAGIC "plprofl"
+
+/** Profile format version byte identifier. */
+#define PLCRASH_PROFILE_FILE_VERSION 1
+
+/**
+ * @internal
+ *
+ * A call tree node.
+ */
+typedef struct plcrash_async_profile_node {
+    /** The image containing the node's PC, or NULL if no containing image was found. Images are never deallocated
+     * prior to their image list, and so this reference remains valid after the image has been unloaded. */
+    plcrash_async_image_t *image;
+
+    /** The node's PC, relative to @a image's header address, or the absolute PC if @a image is NULL. */
+    pl_vm_address_t offset;
+
+    /** The index of this node's parent node, or PLCRASH_PROFILE_NODE_NONE if this is the root node. */
+    uint32_t parent;
+
+    /** The index of @a image within the profile's image table, or PLCRASH_PROFILE_NODE_NONE if the image was not
+     * recorded. */
+    uint32_t image_index;
+
+    /** The index of this node's most recently added child, or PLCRASH_PROFILE_NODE_NONE. */
+    volatile uint32_t first_child;
+
+    /** The index of this node's next sibling, or PLCRASH_PROFILE_NODE_NONE. */
+    volatile uint32_t next_sibling;
+
+    /** The number of samples in which this node was the innermost frame. */
+    volatile int64_t samples;
+
+    /** True once the node has been linked into its parent's child list. */
+    volatile bool linked;
+} plcrash_async_profile_node_t;
+
+/**
+ * @internal
+ *
+ * A lock-free call tree of sampled stacks, keyed by (image, offset) at each level. All storage is preallocated;
+ * once the node storage is exhausted, further samples requiring new nodes are counted as dropped.
+ *
+ * Insertion and reading are async-safe, and may be performed concurrently.
+ */
+typedef struct plcrash_async_profile {
+    /** Node storage. The first node is the root. */
+    plcrash_async_profile_node_t *nodes;
+
+    /** The total number of nodes available in @a nodes. */
+    uint32_t node_capacity;
+
+    /** The number of nodes allocated from @a nodes. May exceed @a node_capacity if allocations have failed. */
+    volatile int32_t node_count;
+
+    /** Images referenced by the call tree, in the order they were first referenced. Entries are claimed in order
+     * and never cleared; the first NULL entry marks the end of the table. */
+    plcrash_async_image_t * volatile *images;
+
+    /** The total number of entries available in @a images. */
+    uint32_t image_capacity;
+
+    /** The total number of samples recorded. */
+    volatile int64_t sample_count;
+
+    /** The number of samples dropped due to node exhaustion. */
+    volatile int64_t dropped_count;
+
+    /** The number of samples that exceeded PLCRASH_PROFILER_MAX_FRAMES. */
+    volatile int64_t truncated_count;
+} plcrash_async_profile_t;
+
+/**
+ * @internal
+ *
+ * A single sampled stack frame.
+ */
+typedef struct plcrash_async_profile_frame {
+    /** The image containing @a pc, or NULL. */
+    plcrash_async_image_t *image;
+
+    /** The frame's PC, relative to @a image's header address, or the absolute PC if @a image is NULL. */
+    pl_vm_address_t offset;
+} plcrash_async_profile_frame_t;
+
+plcrash_error_t plcrash_nasync_profile_init (plcrash_async_profile_t *profile, uint32_t node_capacity, uint32_t image_capacity);
+void plcrash_async_profile_record (plcrash_async_profile_t *profile, const plcrash_async_profile_frame_t frames[], size_t count, bool truncated);
+void plcrash_nasync_profile_free (plcrash_async_profile_t *profile);
+
+/**
+ * @internal
+ *
+ * Sampling cost statistics.
+ */
+typedef struct plcrash_profiler_stats {
+    /** The number of sampling passes performed. */
+    uint64_t pass_count;
+
+    /** The number of threads sampled. */
+    uint64_t thread_sample_count;
+
+    /** The total time spent sampling, in nanoseconds, including thread suspension, unwinding, and recording. */
+    uint64_t sample_time_ns;
+
+    /** The total time sampled threads spent suspended, in nanoseconds. */
+    uint64_t suspended_time_ns;
+} plcrash_profiler_stats_t;
+
+/**
+ * @internal
+ *
+ * A sampling profiler.
+ */
+typedef struct plcrash_profiler {
+    /** The task to be sampled. */
+    task_t task;
+
+    /** The task's image list. This is a borrowed reference, and must remain valid for the lifetime of the profiler. */
+    plcrash_async_image_list_t *image_list;
+
+    /** The sampling interval, in microseconds. */
+    uint32_t interval_usec;
+
+    /** The aggregated samples. */
+    plcrash_async_profile_t profile;
+
+    /** Sampling cost statistics, in mach_absolute_time() units. */
+    struct {
+        volatile int64_t pass_count;
+        volatile int64_t thread_sample_count;
+        volatile int64_t sample_time;
+        volatile int64_t suspended_time;
+    } stats;
+
+    /** The sampling thread, valid if @a running is true. */
+    pthread_t thread;
+
+    /** True if the sampling thread is running. */
+    volatile bool running;
+
+    /** Set to request termination of the sampling thread. */
+    volatile bool stop_requested;
+} plcrash_profiler_t;
+
+plcrash_error_t plcrash_nasync_profiler_init (plcrash_profiler_t *profiler,
+                                              task_t task,
+                                              plcrash_async_image_list_t *image_list,
+                                              uint32_t interval_usec,
+                                              uint32_t node_capacity);
+
+plcrash_error_t plcrash_nasync_profiler_start (plcrash_profiler_t *profiler);
+void plcrash_nasync_profiler_stop (plcrash_profiler_t *profiler);
+
+plcrash_error_t plcrash_profiler_sample (plcrash_profiler_t *profiler);
+void plcrash_profiler_get_stats (plcrash_profiler_t *profiler, plcrash_profiler_stats_t *stats);
+
+plcrash_error_t plcrash_async_profiler_write (plcrash_profiler_t *profiler, plcrash_async_file_t *file);
+
+void plcrash_nasync_profiler_free (plcrash_profiler_t *profiler);
+
+/**
+ * @} plcrash_profiler
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_PROFILER_H */
@@ -74,6 +74,30 @@ struct PLCrashReportFileHeader {
 } __attribute__((packed));
 
 
+/**
+ * @ingroup enums
+ *
+ * The level of detail written to a crash report. If a report could not be written within the configured
+ * PLCrashReporterConfig::timeBudget, detail is progressively omitted; each level implies the omissions of the
+ * levels preceding it.
+ *
+ * @internal
+ * These enum values match the protobuf values. Keep them synchronized.
+ */
+typedef enum {
+    /** All available detail was written. */
+    PLCrashReportDetailLevelFull = 0,
+
+    /** Symbols were resolved using only the image symbol tables; Objective-C metadata was not consulted. */
+    PLCrashReportDetailLevelSymbolTableOnly = 1,
+
+    /** No symbols were resolved. */
+    PLCrashReportDetailLevelPCOnly = 2,
+
+    /** Threads other than the crashed thread were omitted. */
+    PLCrashReportDetailLevelCrashedThreadOnly = 3,
+} PLCrashReportDetailLevel;
+
 /**
  * @internal
  * Private decoder instance variables (used to hide the underlying protobuf parser).
@@ -114,12 +138,23 @@ typedef struct _PLCrashReportDecoder _PLCrashReportDecoder;
 
     /** Report UUID */
     CFUUIDRef _uuid;
+
+    /** Report detail level */
+    PLCrashReportDetailLevel _detailLevel;
+
+    /** YES if the report was truncated */
+    BOOL _truncated;
+
+    /** The number of omitted binary images */
+    NSUInteger _omittedImageCount;
 }
 
 - (id) initWithData: (NSData *) encodedData error: (NSError **) outError;
 
 - (PLCrashReportBinaryImageInfo *) imageForAddress: (uint64_t) address;
 
+- (NSArray *) postMortemStackFramesForThread: (PLCrashReportThreadInfo *) thread error: (NSError **) outError;
+
 /**
  * System information.
  */
@@ -197,4 +232,23 @@ typedef struct _PLCrashReportDecoder _PLCrashReportDecoder;
  */
 @property(nonatomic, readonly) CFUUIDRef uuidRef;
 
+/**
+ * The level of detail written to the report. Reports written within their time budget, or without a time budget,
+ * will return PLCrashReportDetailLevelFull.
+ */
+@property(nonatomic, readonly) PLCrashReportDetailLevel detailLevel;
+
+/**
+ * YES if the report was truncated prior to completion. Only reports written with the
+ * PLCrashReporterOptionCrashedThreadFirst option may be decoded after truncation; these always contain the signal
+ * information, but any of the remaining threads, images, and exception information may be missing.
+ */
+@property(nonatomic, readonly) BOOL truncated;
+
+/**
+ * The number of loaded binary images that were omitted from the report, as no stack frame referenced them. This will
+ * be 0 unless the report was written with the PLCrashReporterOptionReferencedImagesOnly option.
+ */
+@property(nonatomic, readonly) NSUInteger omittedImageCount;
+
 @end
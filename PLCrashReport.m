@@ -31,12 +31,24 @@
 
 #import "crash_report.pb-c.h"
 
+#import "PLCrashFrameWalker.h"
+
 struct _PLCrashReportDecoder {
     Plcrash__CrashReport *crashReport;
 };
 
 #define IMAGE_UUID_DIGEST_LEN 16
 
+/** Maximum number of frames that the folded stack frames of a single thread may expand to. Used as a safety
+ * measure against malformed reports. */
+#define PLCRASH_MAX_EXPANDED_FRAMES (64 * 1024)
+
+/** CrashReport.commit_marker field number */
+#define PLCRASH_REPORT_COMMIT_MARKER_FIELD 11
+
+/** CrashReport.complete field number */
+#define PLCRASH_REPORT_COMPLETE_FIELD 12
+
 @interface PLCrashReport (PrivateMethods)
 
 - (Plcrash__CrashReport *) decodeCrashData: (NSData *) data error: (NSError **) outError;
@@ -55,6 +67,7 @@ struct _PLCrashReportDecoder {
 
 
 static void populate_nserror (NSError **error, PLCrashReporterError code, NSString *description);
+static bool scan_commit_markers (const uint8_t *data, size_t length, size_t *committed_length, bool *complete);
 
 /**
  * Provides decoding of crash logs generated by the PLCrashReporter framework.
@@ -112,6 +125,16 @@ static void populate_nserror (NSError **error, PLCrashReporterError code, NSStri
         }
     }
 
+    /* Detail level (optional) */
+    _detailLevel = PLCrashReportDetailLevelFull;
+    if (_decoder->crashReport->has_detail_level)
+        _detailLevel = (PLCrashReportDetailLevel) _decoder->crashReport->detail_level;
+
+    /* Omitted image count (optional) */
+    _omittedImageCount = 0;
+    if (_decoder->crashReport->has_omitted_binary_image_count)
+        _omittedImageCount = _decoder->crashReport->omitted_binary_image_count;
+
     /* System info */
     _systemInfo = [[self extractSystemInfo: _decoder->crashReport->system_info error: outError] retain];
     if (!_systemInfo)
@@ -216,6 +239,73 @@ error:
     return nil;
 }
 
+/**
+ * Unwind @a thread's captured stack memory, returning the thread's backtrace as an array of
+ * PLCrashReportStackFrameInfo instances. This allows a backtrace to be recovered post-mortem from a report
+ * written with the PLCrashReporterOptionCaptureStackMemory option, without relying on the unwinding performed
+ * at crash time.
+ *
+ * Frames are recovered by following the thread's frame pointers within the captured memory, and the returned frames
+ * are not symbolicated. Unwinding terminates at the first frame that lies outside of the captured memory.
+ *
+ * @param thread A thread from this report.
+ * @param outError A pointer to an NSError object variable. If an error occurs, this pointer
+ * will contain an error object indicating why the stack could not be unwound. If no error occurs, this parameter
+ * will be left unmodified. You may specify nil for this parameter, and no error information will be provided.
+ *
+ * @return Returns the unwound frames, or nil if the thread's stack memory, registers, or the report's machine
+ * information are unavailable.
+ */
+- (NSArray *) postMortemStackFramesForThread: (PLCrashReportThreadInfo *) thread error: (NSError **) outError {
+    plcrash_async_thread_state_t thread_state;
+    plcrash_async_mobject_t stack_memory;
+    plframe_cursor_t cursor;
+    plframe_error_t ferr;
+
+    if (thread.stackMemory == nil || [thread.registers count] == 0 || _machineInfo == nil) {
+        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, @"The thread's stack memory was not captured");
+        return nil;
+    }
+
+    /* Reconstruct the thread state from the report's registers */
+    if (plcrash_async_thread_state_init(&thread_state, (cpu_type_t) _machineInfo.processorInfo.type) != PLCRASH_ESUCCESS) {
+        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, @"The report's processor type is not supported");
+        return nil;
+    }
+
+    size_t regcount = plcrash_async_thread_state_get_reg_count(&thread_state);
+    for (PLCrashReportRegisterInfo *reg in thread.registers) {
+        for (plcrash_regnum_t regnum = 0; regnum < regcount; regnum++) {
+            const char *name = plcrash_async_thread_state_get_reg_name(&thread_state, regnum);
+            if (name != NULL && strcmp(name, [reg.registerName UTF8String]) == 0) {
+                plcrash_async_thread_state_set_reg(&thread_state, regnum, (plcrash_greg_t) reg.registerValue);
+                break;
+            }
+        }
+    }
+
+    /* Walk the captured stack */
+    if (plcrash_async_mobject_init_buffer(&stack_memory, [thread.stackMemory bytes], thread.stackMemoryAddress, [thread.stackMemory length]) != PLCRASH_ESUCCESS) {
+        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, @"Invalid stack memory address");
+        return nil;
+    }
+
+    NSMutableArray *frames = [NSMutableArray array];
+    plframe_cursor_init_post_mortem(&cursor, &stack_memory, &thread_state);
+    while ((ferr = plframe_cursor_next(&cursor)) == PLFRAME_ESUCCESS && [frames count] < PLCRASH_MAX_EXPANDED_FRAMES) {
+        plcrash_greg_t pc;
+        if (plframe_cursor_get_reg(&cursor, PLCRASH_REG_IP, &pc) != PLFRAME_ESUCCESS)
+            break;
+
+        [frames addObject: [[[PLCrashReportStackFrameInfo alloc] initWithInstructionPointer: pc symbolInfo: nil] autorelease]];
+    }
+
+    plframe_cursor_free(&cursor);
+    plcrash_async_mobject_free(&stack_memory);
+
+    return frames;
+}
+
 // property getter. Returns YES if machine information is available.
 - (BOOL) hasMachineInfo {
     if (_machineInfo != nil)
@@ -247,6 +337,9 @@ error:
 @synthesize images = _images;
 @synthesize exceptionInfo = _exceptionInfo;
 @synthesize uuidRef = _uuid;
+@synthesize detailLevel = _detailLevel;
+@synthesize truncated = _truncated;
+@synthesize omittedImageCount = _omittedImageCount;
 
 @end
 
@@ -291,7 +384,19 @@ error:
         return NULL;
     }
 
-    Plcrash__CrashReport *crashReport = plcrash__crash_report__unpack(&protobuf_c_system_allocator, [data length] - sizeof(struct PLCrashReportFileHeader), header->data);
+    /* Reports written in crashed-thread-first order may have been truncated; only the data preceding the last
+     * commit marker is decoded. */
+    size_t length = [data length] - sizeof(struct PLCrashReportFileHeader);
+    size_t committed_length;
+    bool complete;
+
+    _truncated = NO;
+    if (scan_commit_markers(header->data, length, &committed_length, &complete)) {
+        _truncated = (!complete || committed_length != length);
+        length = committed_length;
+    }
+
+    Plcrash__CrashReport *crashReport = plcrash__crash_report__unpack(&protobuf_c_system_allocator, length, header->data);
     if (crashReport == NULL) {
         populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, NSLocalizedString(@"An unknown error occured decoding the crash report", 
                                                                                              @"Crash log decoding error message"));
@@ -518,6 +623,56 @@ error:
                                                                  symbolInfo: symbolInfo] autorelease];
 }
 
+/**
+ * Extract the stack frames of @a thread, expanding any folded groups of repeated frames. Returns nil on error.
+ */
+- (NSArray *) extractStackFrames: (Plcrash__CrashReport__Thread *) thread error: (NSError **) outError {
+    NSMutableArray *frames = [NSMutableArray arrayWithCapacity: thread->n_frames];
+    for (size_t frame_idx = 0; frame_idx < thread->n_frames;) {
+        Plcrash__CrashReport__Thread__StackFrame *frame = thread->frames[frame_idx];
+        size_t repeat_count = 1;
+        size_t repeat_length = 1;
+
+        if (frame != NULL && frame->has_repeat_count && frame->repeat_count > 1) {
+            repeat_count = frame->repeat_count;
+            if (frame->has_repeat_length)
+                repeat_length = frame->repeat_length;
+
+            if (repeat_length == 0 || repeat_length > thread->n_frames - frame_idx) {
+                populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, @"Invalid repeated stack frame group");
+                return nil;
+            }
+        }
+
+        /* Enforce the per-thread expansion limit. The product of the repeat count and length may overflow, and so
+         * the remaining limit is divided instead. */
+        size_t remaining = PLCRASH_MAX_EXPANDED_FRAMES - [frames count];
+        if (repeat_length > remaining || repeat_count > remaining / repeat_length) {
+            populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, @"Repeated stack frames exceed the maximum expanded frame count");
+            return nil;
+        }
+
+        /* Extract the group */
+        NSRange groupRange = NSMakeRange([frames count], repeat_length);
+        for (size_t i = 0; i < repeat_length; i++) {
+            PLCrashReportStackFrameInfo *frameInfo = [self extractStackFrameInfo: thread->frames[frame_idx + i] error: outError];
+            if (frameInfo == nil)
+                return nil;
+
+            [frames addObject: frameInfo];
+        }
+
+        /* Append the remaining occurrences */
+        NSArray *group = [frames subarrayWithRange: groupRange];
+        for (size_t i = 1; i < repeat_count; i++)
+            [frames addObjectsFromArray: group];
+
+        frame_idx += repeat_length;
+    }
+
+    return frames;
+}
+
 /**
  * Extract thread information from the crash log. Returns nil on error, or an array of PLCrashLogThreadInfo
  * instances on success.
@@ -531,20 +686,32 @@ error:
         return nil;
     }
 
+    /* Fetch the stack frames of all threads that include their own frames, keyed by thread number. These are
+     * shared with any threads that reference them. */
+    NSMutableDictionary *threadFrames = [NSMutableDictionary dictionaryWithCapacity: crashReport->n_threads];
+    for (size_t thr_idx = 0; thr_idx < crashReport->n_threads; thr_idx++) {
+        Plcrash__CrashReport__Thread *thread = crashReport->threads[thr_idx];
+        if (thread->has_frames_thread_number)
+            continue;
+
+        NSArray *frames = [self extractStackFrames: thread error: outError];
+        if (frames == nil)
+            return nil;
+
+        [threadFrames setObject: frames forKey: [NSNumber numberWithUnsignedInt: thread->thread_number]];
+    }
+
     /* Handle all threads */
     NSMutableArray *threadResult = [NSMutableArray arrayWithCapacity: crashReport->n_threads];
     for (size_t thr_idx = 0; thr_idx < crashReport->n_threads; thr_idx++) {
         Plcrash__CrashReport__Thread *thread = crashReport->threads[thr_idx];
         
-        /* Fetch stack frames for this thread */
-        NSMutableArray *frames = [NSMutableArray arrayWithCapacity: thread->n_frames];
-        for (size_t frame_idx = 0; frame_idx < thread->n_frames; frame_idx++) {
-            Plcrash__CrashReport__Thread__StackFrame *frame = thread->frames[frame_idx];
-            PLCrashReportStackFrameInfo *frameInfo = [self extractStackFrameInfo: frame error: outError];
-            if (frameInfo == nil)
-                return nil;
-
-            [frames addObject: frameInfo];
+        /* Fetch stack frames for this thread, resolving a reference to another thread's identical stack */
+        uint32_t frames_thread_number = thread->has_frames_thread_number ? thread->frames_thread_number : thread->thread_number;
+        NSArray *frames = [threadFrames objectForKey: [NSNumber numberWithUnsignedInt: frames_thread_number]];
+        if (frames == nil || (thread->has_frames_thread_number && thread->n_frames != 0)) {
+            populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, @"Invalid stack frame thread reference");
+            return nil;
         }
 
         /* Fetch registers for this thread */
@@ -564,11 +731,21 @@ error:
             [registers addObject: regInfo];
         }
 
+        /* Fetch the captured stack memory, if any */
+        NSData *stackMemory = nil;
+        uint64_t stackMemoryAddress = 0;
+        if (thread->stack_memory != NULL) {
+            stackMemory = [NSData dataWithBytes: thread->stack_memory->data.data length: thread->stack_memory->data.len];
+            stackMemoryAddress = thread->stack_memory->address;
+        }
+
         /* Create the thread info instance */
         PLCrashReportThreadInfo *threadInfo = [[[PLCrashReportThreadInfo alloc] initWithThreadNumber: thread->thread_number
                                                                                    stackFrames: frames 
                                                                                        crashed: thread->crashed 
-                                                                                     registers: registers] autorelease];
+                                                                                     registers: registers
+                                                                                   stackMemory: stackMemory
+                                                                            stackMemoryAddress: stackMemoryAddress] autorelease];
         [threadResult addObject: threadInfo];
     }
     
@@ -782,3 +959,98 @@ static void populate_nserror (NSError **error, PLCrashReporterError code, NSStri
     
     *error = [NSError errorWithDomain: PLCrashReporterErrorDomain code: code userInfo: userInfo];
 }
+
+/**
+ * @internal
+ *
+ * Read a base 128 varint from @a data at @a offset, advancing @a offset past the varint.
+ *
+ * @return Returns true on success, or false if the varint is malformed or extends beyond @a length.
+ */
+static bool read_varint (const uint8_t *data, size_t length, size_t *offset, uint64_t *value) {
+    *value = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7) {
+        if (*offset >= length)
+            return false;
+
+        uint8_t byte = data[(*offset)++];
+        *value |= (uint64_t) (byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * @internal
+ *
+ * Scan the top-level fields of an encoded CrashReport message for commit markers. Scanning stops at the first
+ * truncated or malformed field.
+ *
+ * @param data The encoded message.
+ * @param length The length of @a data, in bytes.
+ * @param[out] committed_length On return, the length of the data up to and including the last commit marker.
+ * @param[out] complete On return, true if the CrashReport.complete field was set prior to the last commit marker.
+ *
+ * @return Returns true if at least one commit marker was found, otherwise false.
+ */
+static bool scan_commit_markers (const uint8_t *data, size_t length, size_t *committed_length, bool *complete) {
+    size_t offset = 0;
+    bool found = false;
+    bool complete_seen = false;
+
+    *committed_length = 0;
+    *complete = false;
+
+    while (offset < length) {
+        uint64_t key;
+        uint64_t value = 0;
+
+        if (!read_varint(data, length, &offset, &key))
+            break;
+
+        /* Skip the field's value */
+        switch (key & 0x7) {
+            case 0: /* varint */
+                if (!read_varint(data, length, &offset, &value))
+                    return found;
+                break;
+
+            case 1: /* 64-bit */
+                if (length - offset < 8)
+                    return found;
+                offset += 8;
+                break;
+
+            case 2: /* length-delimited */
+                if (!read_varint(data, length, &offset, &value) || value > length - offset)
+                    return found;
+                offset += value;
+                break;
+
+            case 5: /* 32-bit */
+                if (length - offset < 4)
+                    return found;
+                offset += 4;
+                break;
+
+            default:
+                return found;
+        }
+
+        /* Only varint-encoded commit fields are recognized */
+        if ((key & 0x7) != 0)
+            continue;
+
+        if ((key >> 3) == PLCRASH_REPORT_COMPLETE_FIELD) {
+            complete_seen = (value != 0);
+        } else if ((key >> 3) == PLCRASH_REPORT_COMMIT_MARKER_FIELD) {
+            found = true;
+            *committed_length = offset;
+            *complete = complete_seen;
+        }
+    }
+
+    return found;
+}
@@ -44,6 +44,12 @@
 
     /** List of PLCrashReportRegister instances. Will be empty if _crashed is NO. */
     NSArray *_registers;
+
+    /** The captured stack memory, or nil. */
+    NSData *_stackMemory;
+
+    /** The target address of _stackMemory. */
+    uint64_t _stackMemoryAddress;
 }
 
 - (id) initWithThreadNumber: (NSInteger) threadNumber
@@ -51,6 +57,13 @@
                     crashed: (BOOL) crashed
                   registers: (NSArray *) registers;
 
+- (id) initWithThreadNumber: (NSInteger) threadNumber
+                stackFrames: (NSArray *) stackFrames
+                    crashed: (BOOL) crashed
+                  registers: (NSArray *) registers
+                stackMemory: (NSData *) stackMemory
+         stackMemoryAddress: (uint64_t) stackMemoryAddress;
+
 /**
  * Application thread number.
  */
@@ -74,4 +87,16 @@
  */
 @property(nonatomic, readonly) NSArray *registers;
 
+/**
+ * A raw copy of the thread's stack, beginning at stackMemoryAddress, or nil if stack memory was not captured. Stack
+ * memory is only captured if the report was written with the PLCrashReporterOptionCaptureStackMemory option; in
+ * that case, registers are available for all threads.
+ */
+@property(nonatomic, readonly) NSData *stackMemory;
+
+/**
+ * The target address of the first byte of stackMemory.
+ */
+@property(nonatomic, readonly) uint64_t stackMemoryAddress;
+
 @end
@@ -42,6 +42,19 @@
                 stackFrames: (NSArray *) stackFrames
                     crashed: (BOOL) crashed
                   registers: (NSArray *) registers
+{
+    return [self initWithThreadNumber: threadNumber stackFrames: stackFrames crashed: crashed registers: registers stackMemory: nil stackMemoryAddress: 0];
+}
+
+/**
+ * Initialize the crash log thread information, including the thread's captured stack memory.
+ */
+- (id) initWithThreadNumber: (NSInteger) threadNumber
+                stackFrames: (NSArray *) stackFrames
+                    crashed: (BOOL) crashed
+                  registers: (NSArray *) registers
+                stackMemory: (NSData *) stackMemory
+         stackMemoryAddress: (uint64_t) stackMemoryAddress
 {
     if ((self = [super init]) == nil)
         return nil;
@@ -50,6 +63,8 @@
     _stackFrames = [stackFrames retain];
     _crashed = crashed;
     _registers = [registers retain];
+    _stackMemory = [stackMemory retain];
+    _stackMemoryAddress = stackMemoryAddress;
 
     return self;
 }
@@ -57,6 +72,7 @@
 - (void) dealloc {
     [_stackFrames release];
     [_registers release];
+    [_stackMemory release];
     [super dealloc];
 }
 
@@ -64,6 +80,8 @@
 @synthesize stackFrames = _stackFrames;
 @synthesize crashed = _crashed;
 @synthesize registers = _registers;
+@synthesize stackMemory = _stackMemory;
+@synthesize stackMemoryAddress = _stackMemoryAddress;
 
 
 @end
@@ -105,6 +105,12 @@ typedef struct PLCrashReporterCallbacks {
 
     /** Path to the crash reporter internal data directory */
     NSString *_crashReportDirectory;
+
+    /** The hang watchdog state, or NULL if the hang watchdog is not enabled. */
+    void *_hangWatchdog;
+
+    /** The sampling profiler state, or NULL if the profiler has never been enabled. */
+    void *_profiler;
 }
 
 + (PLCrashReporter *) sharedReporter;
@@ -130,4 +136,23 @@ typedef struct PLCrashReporterCallbacks {
 
 - (void) setCrashCallbacks: (PLCrashReporterCallbacks *) callbacks;
 
+- (BOOL) enableOutOfProcessReportingWithServicePort: (mach_port_t) servicePort timeout: (NSTimeInterval) timeout error: (NSError **) outError;
+
+- (BOOL) enableHangWatchdogWithThreshold: (NSTimeInterval) threshold
+                   minimumReportInterval: (NSTimeInterval) minimumReportInterval
+                              allThreads: (BOOL) allThreads
+                                   error: (NSError **) outError;
+- (void) disableHangWatchdog;
+
+- (NSArray *) queuedHangReportPaths;
+
+- (BOOL) enableProfilerWithSampleInterval: (NSTimeInterval) interval error: (NSError **) outError;
+- (void) disableProfiler;
+
+- (NSData *) generateProfileDataAndReturnError: (NSError **) outError;
+
+- (BOOL) hasPendingProfile;
+- (NSData *) loadPendingProfileDataAndReturnError: (NSError **) outError;
+- (BOOL) purgePendingProfileAndReturnError: (NSError **) outError;
+
 @end
@@ -37,16 +37,24 @@
 #import "PLCrashFeatureConfig.h"
 
 #import "PLCrashAsync.h"
+#import "PLCrashAsyncAllocator.h"
 #import "PLCrashLogWriter.h"
 #import "PLCrashFrameWalker.h"
 
 #import "PLCrashAsyncMachExceptionInfo.h"
+#import "PLCrashHangWatchdog.h"
+#import "PLCrashOutOfProcess.h"
+#import "PLCrashProfiler.h"
 
 #import "PLCrashReporterNSError.h"
 
 #import <fcntl.h>
 #import <dlfcn.h>
+#import <dirent.h>
+#import <inttypes.h>
+#import <sys/mman.h>
 #import <mach-o/dyld.h>
+#import <libkern/OSAtomic.h>
 
 #define NSDEBUG(msg, args...) {\
     NSLog(@"[PLCrashReporter] " msg, ## args); \
@@ -60,10 +68,31 @@ static NSString *PLCRASH_CACHE_DIR = @"com.plausiblelabs.crashreporter.data";
  * Crash Report file name. */
 static NSString *PLCRASH_LIVE_CRASHREPORT = @"live_report.plcrash";
 
+/** @internal
+ * Preallocated crash report file name, used when PLCrashReporterOptionPreallocateReportFile is enabled. */
+static NSString *PLCRASH_PREALLOCATED_CRASHREPORT = @"live_report.plcrash.mapped";
+
+/** @internal
+ * Profile file name, written alongside the crash report when the sampling profiler is enabled. */
+static NSString *PLCRASH_LIVE_PROFILE = @"live_report.plprofile";
+
+/** @internal
+ * Preallocated profile file name, mapped when the sampling profiler is exported to the crash handler. */
+static NSString *PLCRASH_PREALLOCATED_PROFILE = @"live_report.plprofile.mapped";
+
 /** @internal
  * Directory containing crash reports queued for sending. */
 static NSString *PLCRASH_QUEUED_DIR = @"queued_reports";
 
+/** @internal
+ * File name prefix of hang reports queued within PLCRASH_QUEUED_DIR. */
+static const char PLCRASH_HANG_REPORT_PREFIX[] = "hang_";
+
+/** @internal
+ * Maximum number of hang reports that will be queued; additional hangs are not reported until queued reports
+ * have been removed. */
+#define PLCRASH_MAX_QUEUED_HANG_REPORTS 8
+
 /** @internal
  * Maximum number of bytes that will be written to the crash report.
  * Used as a safety measure in case of implementation malfunction.
@@ -73,6 +102,40 @@ static NSString *PLCRASH_QUEUED_DIR = @"queued_reports";
  */
 #define MAX_REPORT_BYTES (64 * 1024)
 
+/** @internal
+ * Maximum number of bytes that will be written to a profile. A fully populated call tree of
+ * PLCRASH_PROFILER_NODE_CAPACITY nodes requires approximately 200k.
+ */
+#define MAX_PROFILE_BYTES (512 * 1024)
+
+/** @internal
+ * Maximum number of call tree nodes recorded by the sampling profiler. */
+#define PLCRASH_PROFILER_NODE_CAPACITY 8192
+
+/** @internal
+ * Size of the crash report output buffer. The buffer is allocated when the crash reporter is enabled,
+ * and allows the majority of reports to be written with only a handful of write() calls.
+ */
+#define PLCRASH_OUTPUT_BUFFER_BYTES (16 * 1024)
+
+/** @internal
+ * Magic value marking a committed report within a preallocated report file ('PLCR'). */
+#define PLCRASH_MAPPED_REPORT_COMMIT_MAGIC 0x504c4352
+
+/**
+ * @internal
+ *
+ * Trailer of a preallocated report or profile file. The trailer is located immediately after the MAX_REPORT_BYTES
+ * (or MAX_PROFILE_BYTES) data region, and is only populated once the data has been completely written.
+ */
+typedef struct plcrash_mapped_report_trailer {
+    /** PLCRASH_MAPPED_REPORT_COMMIT_MAGIC if a report has been committed, otherwise 0. */
+    uint32_t magic;
+
+    /** The length of the committed report data, in bytes. */
+    uint32_t length;
+} plcrash_mapped_report_trailer_t;
+
 /**
  * @internal
  * Fatal signals to be monitored.
@@ -101,6 +164,27 @@ typedef struct signal_handler_ctx {
     /** Path to the output file */
     const char *path;
 
+    /** The preallocated, memory-mapped output file, or NULL if PLCrashReporterOptionPreallocateReportFile is not
+     * enabled. The mapping consists of MAX_REPORT_BYTES of report data, followed by a plcrash_mapped_report_trailer_t. */
+    void *mapped_report;
+
+    /** The crash report output buffer, or NULL if allocation failed; in that case, the file's small
+     * default buffer will be used. */
+    void *output_buffer;
+
+    /** Out-of-process reporting state. If the client's service port is MACH_PORT_NULL, reports are always written
+     * in-process. */
+    plcrash_oop_client_t oop_client;
+
+    /** The sampling profiler, or NULL if the profiler has not been enabled. Once set, the profiler is never
+     * deallocated. */
+    plcrash_profiler_t * volatile profiler;
+
+    /** The preallocated, memory-mapped profile output file, or NULL if the profiler has not been exported to the
+     * crash handler. The mapping consists of MAX_PROFILE_BYTES of profile data, followed by a
+     * plcrash_mapped_report_trailer_t. Always set prior to @a profiler. */
+    void *mapped_profile;
+
 #if PLCRASH_FEATURE_MACH_EXCEPTIONS
     /* Previously registered Mach exception ports, if any. Will be left uninitialized if PLCrashReporterSignalHandlerTypeMach
      * is not enabled. */
@@ -123,6 +207,13 @@ static plcrash_async_image_list_t shared_image_list;
  */
 static plcrashreporter_handler_ctx_t signal_handler_context;
 
+/**
+ * @internal
+ *
+ * Allocator backing the signal handler context's output buffer. The allocation is never released.
+ */
+static plcrash_async_allocator_t *output_allocator = NULL;
+
 
 /**
  * @internal
@@ -135,6 +226,63 @@ static PLCrashReporterCallbacks crashCallbacks = {
     .handleSignal = NULL
 };
 
+/**
+ * @internal
+ *
+ * Log writer commit callback for preallocated report files. Publishes the committed length of a report written in
+ * crashed-thread-first order, allowing the committed portion to be recovered should the crash handler be terminated
+ * before the report is complete.
+ *
+ * @param file The memory-backed output file.
+ * @param context The preallocated report file's trailer.
+ */
+static void mapped_report_commit_callback (plcrash_async_file_t *file, void *context) {
+    plcrash_mapped_report_trailer_t *trailer = context;
+
+    /* The length must be visible before the commit marker is set. */
+    trailer->length = (uint32_t) file->buflen;
+    OSMemoryBarrier();
+    trailer->magic = PLCRASH_MAPPED_REPORT_COMMIT_MAGIC;
+}
+
+/**
+ * Write a report directly to a preallocated report file's mapping, and commit it via the file's trailer.
+ *
+ * @param writer The log writer to be used; the writer will be closed.
+ * @param mapped_report The preallocated report file's mapping, as returned by
+ * -[PLCrashReporter mapPreallocatedCrashReportAndReturnError:].
+ * @param crashed_thread The crashed thread.
+ * @param thread_state The crashed thread's state.
+ * @param siginfo The signal information.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or an appropriate error value if the report could not be written.
+ */
+static plcrash_error_t plcrash_write_mapped_report (plcrash_log_writer_t *writer, void *mapped_report, thread_t crashed_thread, plcrash_async_thread_state_t *thread_state, plcrash_log_signal_info_t *siginfo) {
+    plcrash_mapped_report_trailer_t *trailer = (plcrash_mapped_report_trailer_t *) ((uint8_t *) mapped_report + MAX_REPORT_BYTES);
+    plcrash_async_file_t file;
+    plcrash_error_t err;
+
+    plcrash_async_file_init_memory(&file, mapped_report, MAX_REPORT_BYTES);
+    err = plcrash_log_writer_write(writer, crashed_thread, &shared_image_list, &file, siginfo, thread_state);
+
+    if (plcrash_log_writer_close(writer) != PLCRASH_ESUCCESS) {
+        PLCF_DEBUG("Failed to close the log writer");
+        return PLCRASH_EINTERNAL;
+    }
+
+    /* If any write failed, the output following the failed write is incomplete; retain the length published at
+     * the last successful commit point, if any. */
+    if (file.mem_overflow) {
+        PLCF_DEBUG("The report exceeded the preallocated report file; only committed sections were retained");
+        return PLCRASH_OUTPUT_ERR;
+    }
+
+    /* Commit the report */
+    mapped_report_commit_callback(&file, trailer);
+
+    return err;
+}
+
 /**
  * Write a fatal crash report.
  *
@@ -149,6 +297,21 @@ static plcrash_error_t plcrash_write_report (plcrashreporter_handler_ctx_t *sigc
     plcrash_async_file_t file;
     plcrash_error_t err;
 
+    /* Delegate to the out-of-process helper, if available. Uncaught exception reports are written in-process, as the
+     * exception is not supplied to the helper. If the helper can not be reached, fall back on in-process writing; a
+     * helper that has timed out writes to a temporary file, and can not interleave its output with ours. */
+    if (sigctx->oop_client.service_port != MACH_PORT_NULL && sigctx->mapped_report == NULL && !sigctx->writer.uncaught_exception.has_exception) {
+        err = plcrash_async_oop_client_report(&sigctx->oop_client, &sigctx->writer, sigctx->path, crashed_thread, siginfo, pl_mach_thread_self(), thread_state);
+        if (err == PLCRASH_ESUCCESS)
+            return PLCRASH_ESUCCESS;
+
+        PLCF_DEBUG("Out-of-process report generation failed, writing the report in-process: %d", err);
+    }
+
+    /* Write directly to the preallocated output file, if available */
+    if (sigctx->mapped_report != NULL)
+        return plcrash_write_mapped_report(&sigctx->writer, sigctx->mapped_report, crashed_thread, thread_state, siginfo);
+
     /* Open the output file */
     int fd = open(sigctx->path, O_RDWR|O_CREAT|O_TRUNC, 0644);
     if (fd < 0) {
@@ -157,7 +320,11 @@ static plcrash_error_t plcrash_write_report (plcrashreporter_handler_ctx_t *sigc
     }
     
     /* Initialize the output context */
-    plcrash_async_file_init(&file, fd, MAX_REPORT_BYTES);
+    if (sigctx->output_buffer != NULL) {
+        plcrash_async_file_init_with_buffer(&file, fd, MAX_REPORT_BYTES, sigctx->output_buffer, PLCRASH_OUTPUT_BUFFER_BYTES);
+    } else {
+        plcrash_async_file_init(&file, fd, MAX_REPORT_BYTES);
+    }
     
     /* Write the crash log using the already-initialized writer */
     err = plcrash_log_writer_write(&sigctx->writer, crashed_thread, &shared_image_list, &file, siginfo, thread_state);
@@ -184,6 +351,40 @@ static plcrash_error_t plcrash_write_report (plcrashreporter_handler_ctx_t *sigc
     return err;
 }
 
+/**
+ * Write the sampling profiler's aggregated samples alongside a fatal crash report, directly to the preallocated
+ * profile file's mapping. If the profiler is not enabled, this is a no-op.
+ *
+ * @param sigctx Fatal handler context.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or an appropriate error value if the profile could not be written.
+ */
+static plcrash_error_t plcrash_write_profile (plcrashreporter_handler_ctx_t *sigctx) {
+    plcrash_profiler_t *profiler = sigctx->profiler;
+    plcrash_async_file_t file;
+
+    if (profiler == NULL)
+        return PLCRASH_ESUCCESS;
+
+    /* Ensure that the profiler's initialized state, and the mapping published before it, are visible */
+    OSMemoryBarrier();
+
+    plcrash_async_file_init_memory(&file, sigctx->mapped_profile, MAX_PROFILE_BYTES);
+    plcrash_error_t err = plcrash_async_profiler_write(profiler, &file);
+    if (err != PLCRASH_ESUCCESS)
+        return err;
+
+    /* A profile that exceeded the preallocated file is missing data, and can not be decoded */
+    if (file.mem_overflow) {
+        PLCF_DEBUG("The profile exceeded the preallocated profile file");
+        return PLCRASH_OUTPUT_ERR;
+    }
+
+    /* Commit the profile */
+    mapped_report_commit_callback(&file, (uint8_t *) sigctx->mapped_profile + MAX_PROFILE_BYTES);
+    return PLCRASH_ESUCCESS;
+}
+
 /**
  * @internal
  *
@@ -233,6 +434,10 @@ static bool signal_handler_callback (int signal, siginfo_t *info, pl_ucontext_t
     if (plcrash_write_report(sigctx, pl_mach_thread_self(), &thread_state, &signal_info) != PLCRASH_ESUCCESS)
         return false;
 
+    /* Write the profile; failure is non-fatal, as the report has already been written */
+    if (plcrash_write_profile(sigctx) != PLCRASH_ESUCCESS)
+        PLCF_DEBUG("Failed to write the profile");
+
     /* Call any post-crash callback */
     if (crashCallbacks.handleSignal != NULL)
         crashCallbacks.handleSignal(info, uap, crashCallbacks.context);
@@ -294,6 +499,10 @@ static kern_return_t mach_exception_callback (task_t task, thread_t thread, exce
         return false;
     }
 
+    /* Write the profile; failure is non-fatal, as the report has already been written */
+    if (plcrash_write_profile(sigctx) != PLCRASH_ESUCCESS)
+        PLCF_DEBUG("Failed to write the profile");
+
     /* Call any post-crash callback */
     if (crashCallbacks.handleSignal != NULL) {
         /*
@@ -319,11 +528,61 @@ static kern_return_t mach_exception_callback (task_t task, thread_t thread, exce
 }
 #endif /* PLCRASH_FEATURE_MACH_EXCEPTIONS */
 
+/**
+ * @internal
+ *
+ * Pre-encode @a image's report record; if this fails, the image will be encoded at crash time.
+ */
+static void image_encode_record (plcrash_async_image_t *image, void *context) {
+    void *record;
+    size_t record_length;
+    if (plcrash_log_writer_encode_binary_image(&image->macho_image, &record, &record_length) == PLCRASH_ESUCCESS)
+        plcrash_nasync_image_set_report_record(image, record, record_length);
+}
+
+#if PLCRASH_FEATURE_DEFERRED_IMAGE_INIT
+/** The maximum number of deferred images initialized by a single background batch. */
+#define DEFERRED_IMAGE_BATCH_SIZE 32
+
+/** Non-zero if a background batch of deferred image initialization has been scheduled. */
+static volatile int32_t deferred_image_batch_scheduled = 0;
+
+static void deferred_image_schedule_batch (void);
+
+/**
+ * @internal
+ *
+ * Initialize a batch of deferred images on a background queue, rescheduling if further images remain.
+ */
+static void deferred_image_init_batch (void *context) {
+    /* Allow images registered from this point forward to schedule a new batch */
+    OSAtomicCompareAndSwap32Barrier(1, 0, &deferred_image_batch_scheduled);
+
+    if (plcrash_nasync_image_list_init_pending(&shared_image_list, DEFERRED_IMAGE_BATCH_SIZE, image_encode_record, NULL) == DEFERRED_IMAGE_BATCH_SIZE)
+        deferred_image_schedule_batch();
+}
+
+/**
+ * @internal
+ *
+ * Schedule a background batch of deferred image initialization, if one is not already scheduled.
+ */
+static void deferred_image_schedule_batch (void) {
+    if (OSAtomicCompareAndSwap32Barrier(0, 1, &deferred_image_batch_scheduled))
+        dispatch_async_f(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), NULL, deferred_image_init_batch);
+}
+#endif /* PLCRASH_FEATURE_DEFERRED_IMAGE_INIT */
+
 /**
  * @internal
  * dyld image add notification callback.
  */
 static void image_add_callback (const struct mach_header *mh, intptr_t vmaddr_slide) {
+#if PLCRASH_FEATURE_DEFERRED_IMAGE_INIT
+    /* Record the image; it will be initialized in the background, or on demand at crash time. */
+    if (plcrash_nasync_image_list_append_deferred(&shared_image_list, (pl_vm_address_t) mh) != NULL)
+        deferred_image_schedule_batch();
+#else
     Dl_info info;
     
     /* Look up the image info */
@@ -333,7 +592,12 @@ static void image_add_callback (const struct mach_header *mh, intptr_t vmaddr_sl
     }
 
     /* Register the image */
-    plcrash_nasync_image_list_append(&shared_image_list, (pl_vm_address_t) mh, info.dli_fname);
+    plcrash_async_image_t *image = plcrash_nasync_image_list_append(&shared_image_list, (pl_vm_address_t) mh, info.dli_fname);
+    if (image == NULL)
+        return;
+
+    image_encode_record(image, NULL);
+#endif /* PLCRASH_FEATURE_DEFERRED_IMAGE_INIT */
 }
 
 /**
@@ -345,19 +609,162 @@ static void image_remove_callback (const struct mach_header *mh, intptr_t vmaddr
 }
 
 
+/**
+ * @internal
+ *
+ * Hang watchdog reporting context.
+ */
+typedef struct plcrash_hang_report_ctx {
+    /** The backing watchdog. */
+    plcrash_hang_watchdog_t watchdog;
+
+    /** The log writer, initialized when the watchdog is enabled and reused for each report. */
+    plcrash_log_writer_t writer;
+
+    /** Path to the directory in which reports are queued. */
+    char *queue_path;
+
+    /** Preallocated report output buffer of MAX_REPORT_BYTES. */
+    void *output_buffer;
+} plcrash_hang_report_ctx_t;
+
+/**
+ * @internal
+ *
+ * Return the number of hang reports currently queued within @a queue_path.
+ */
+static size_t hang_report_queued_count (const char *queue_path) {
+    DIR *dir = opendir(queue_path);
+    struct dirent *entry;
+    size_t count = 0;
+
+    if (dir == NULL)
+        return 0;
+
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, PLCRASH_HANG_REPORT_PREFIX, strlen(PLCRASH_HANG_REPORT_PREFIX)) == 0)
+            count++;
+    }
+
+    closedir(dir);
+    return count;
+}
+
+/**
+ * @internal
+ *
+ * Hang watchdog callback. Captures a report for the stalled thread into the preallocated output buffer using the
+ * preallocated writer, and queues the result.
+ *
+ * @return Returns true if the report was queued, or false if it was dropped.
+ */
+static bool hang_watchdog_callback (thread_t thread, uint64_t stall_ns, void *context) {
+    plcrash_hang_report_ctx_t *ctx = context;
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    plcrash_log_writer_t *writer = &ctx->writer;
+    plcrash_async_file_t file;
+    plcrash_error_t err;
+    bool queued = false;
+
+    /* Enforce the queue limit */
+    if (hang_report_queued_count(ctx->queue_path) >= PLCRASH_MAX_QUEUED_HANG_REPORTS) {
+        PLCF_DEBUG("Hang report queue is full; discarding report for %" PRIu64 "ns stall", stall_ns);
+        [pool drain];
+        return false;
+    }
+
+    /* Mock up a SIGTRAP-based signal info, as per live reports */
+    plcrash_log_bsd_signal_info_t bsd_signal_info;
+    plcrash_log_signal_info_t signal_info;
+    bsd_signal_info.signo = SIGTRAP;
+    bsd_signal_info.code = TRAP_TRACE;
+    bsd_signal_info.address = NULL;
+
+    signal_info.bsd_info = &bsd_signal_info;
+    signal_info.mach_info = NULL;
+
+    /* Write the report to the preallocated buffer. Each report requires a unique UUID; the timestamp is assigned
+     * by the writer. */
+    plcrash_log_writer_regenerate_uuid(writer);
+
+    plcrash_async_file_init_memory(&file, ctx->output_buffer, MAX_REPORT_BYTES);
+    err = plcrash_log_writer_write(writer, thread, &shared_image_list, &file, &signal_info, NULL);
+    plcrash_log_writer_close(writer);
+
+    if (err != PLCRASH_ESUCCESS) {
+        PLCF_DEBUG("Failed to write hang report: %s", plcrash_async_strerror(err));
+        goto cleanup;
+    }
+
+    /* A report that exceeded the output buffer is missing data, and can not be decoded */
+    if (file.mem_overflow) {
+        PLCF_DEBUG("Hang report exceeded %d bytes; discarding report for %" PRIu64 "ns stall", MAX_REPORT_BYTES, stall_ns);
+        goto cleanup;
+    }
+
+    /* Queue the report; it is written to a temporary path and then moved into place, so that a partially written
+     * report is never visible within the queue. */
+    {
+        uuid_string_t uuid_str;
+        uuid_unparse(writer->report_info.uuid_bytes, uuid_str);
+
+        NSString *name = [NSString stringWithFormat: @"%s%s.plcrash", PLCRASH_HANG_REPORT_PREFIX, uuid_str];
+        NSString *path = [[NSString stringWithUTF8String: ctx->queue_path] stringByAppendingPathComponent: name];
+        NSString *tmpPath = [[NSString stringWithUTF8String: ctx->queue_path] stringByAppendingPathComponent: [@"." stringByAppendingString: name]];
+
+        int fd = open([tmpPath fileSystemRepresentation], O_WRONLY|O_CREAT|O_TRUNC, 0644);
+        if (fd < 0) {
+            PLCF_DEBUG("Could not open the hang report output file: %s", strerror(errno));
+            goto cleanup;
+        }
+
+        const uint8_t *data = ctx->output_buffer;
+        size_t remaining = file.buflen;
+        while (remaining > 0) {
+            ssize_t written = write(fd, data, remaining);
+            if (written < 0 && errno == EINTR)
+                continue;
+
+            if (written <= 0) {
+                PLCF_DEBUG("Failed to write the hang report: %s", strerror(errno));
+                close(fd);
+                unlink([tmpPath fileSystemRepresentation]);
+                goto cleanup;
+            }
+
+            data += written;
+            remaining -= written;
+        }
+        close(fd);
+
+        if (rename([tmpPath fileSystemRepresentation], [path fileSystemRepresentation]) != 0) {
+            PLCF_DEBUG("Failed to queue the hang report: %s", strerror(errno));
+            unlink([tmpPath fileSystemRepresentation]);
+            goto cleanup;
+        }
+
+        queued = true;
+    }
+
+cleanup:
+    [pool drain];
+    return queued;
+}
+
 /**
  * @internal
  *
  * Uncaught exception handler. Sets the plcrash_log_writer_t's uncaught exception
  * field, and then triggers a SIGTRAP (synchronous exception) to cause a normal
- * exception dump.
+ * exception dump. The exception's call stack is symbolicated here, outside of the
+ * signal handler.
  *
  * XXX: It is possible that another crash may occur between setting the uncaught 
  * exception field, and triggering the signal handler.
  */
 static void uncaught_exception_handler (NSException *exception) {
     /* Set the uncaught exception */
-    plcrash_log_writer_set_exception(&signal_handler_context.writer, exception);
+    plcrash_log_writer_set_exception(&signal_handler_context.writer, exception, &shared_image_list);
 
     /* Synchronously trigger the crash handler */
     abort();
@@ -380,6 +787,18 @@ static void uncaught_exception_handler (NSException *exception) {
 - (NSString *) crashReportDirectory;
 - (NSString *) queuedCrashReportDirectory;
 - (NSString *) crashReportPath;
+- (NSString *) preallocatedCrashReportPath;
+- (NSString *) profilePath;
+
+- (NSString *) preallocatedProfilePath;
+
+- (void *) mapPreallocatedFileAtPath: (NSString *) path capacity: (size_t) capacity error: (NSError **) outError;
+- (void) promotePreallocatedFileAtPath: (NSString *) path capacity: (size_t) capacity destination: (NSString *) destination;
+- (void *) mapPreallocatedCrashReportAndReturnError: (NSError **) outError;
+- (void) promotePreallocatedCrashReport;
+- (void) promotePreallocatedProfile;
+- (void) exportProfilerToCrashHandler;
+- (BOOL) writeLiveReportToPreallocatedCrashReport: (void *) mappedReport error: (NSError **) outError;
 
 @end
 
@@ -446,6 +865,9 @@ static PLCrashReporter *sharedReporter = nil;
  * an pending crash report is available.
  */
 - (BOOL) hasPendingCrashReport {
+    /* Pick up any report committed to the preallocated report file */
+    [self promotePreallocatedCrashReport];
+
     /* Check for a live crash report file */
     return [[NSFileManager defaultManager] fileExistsAtPath: [self crashReportPath]];
 }
@@ -480,6 +902,9 @@ static PLCrashReporter *sharedReporter = nil;
  * @return Returns nil if the crash report data could not be loaded.
  */
 - (NSData *) loadPendingCrashReportDataAndReturnError: (NSError **) outError {
+    /* Pick up any report committed to the preallocated report file */
+    [self promotePreallocatedCrashReport];
+
     /* Load the (memory mapped) data */
     return [NSData dataWithContentsOfFile: [self crashReportPath] options: NSMappedRead error: outError];
 }
@@ -576,6 +1001,36 @@ static PLCrashReporter *sharedReporter = nil;
     assert(_applicationIdentifier != nil);
     assert(_applicationVersion != nil);
     plcrash_log_writer_init(&signal_handler_context.writer, _applicationIdentifier, _applicationVersion, [self mapToAsyncSymbolicationStrategy: _config.symbolicationStrategy], false);
+    plcrash_log_writer_set_time_budget(&signal_handler_context.writer, (uint64_t) (_config.timeBudget * NSEC_PER_SEC));
+    signal_handler_context.writer.report_info.crashed_thread_first = (_config.options & PLCrashReporterOptionCrashedThreadFirst) != 0;
+    signal_handler_context.writer.report_info.referenced_images_only = (_config.options & PLCrashReporterOptionReferencedImagesOnly) != 0;
+    signal_handler_context.writer.report_info.dedup_identical_stacks = (_config.options & PLCrashReporterOptionDeduplicateThreadStacks) != 0;
+    signal_handler_context.writer.report_info.capture_stack_memory = (_config.options & PLCrashReporterOptionCaptureStackMemory) != 0;
+    signal_handler_context.writer.report_info.fold_repeated_frames = (_config.options & PLCrashReporterOptionFoldRepeatedFrames) != 0;
+
+    /* Set up the preallocated output file. Any report committed by a previous process must be promoted
+     * before the file is reused. */
+    if (_config.options & PLCrashReporterOptionPreallocateReportFile) {
+        [self promotePreallocatedCrashReport];
+
+        signal_handler_context.mapped_report = [self mapPreallocatedCrashReportAndReturnError: outError];
+        if (signal_handler_context.mapped_report == NULL)
+            return NO;
+
+        /* Publish each commit point of a crashed-thread-first report */
+        signal_handler_context.writer.commit.callback = mapped_report_commit_callback;
+        signal_handler_context.writer.commit.context = (uint8_t *) signal_handler_context.mapped_report + MAX_REPORT_BYTES;
+    }
+
+    /* Allocate the output buffer from a guarded pool, isolating it from any heap corruption that may occur
+     * prior to a crash. */
+    if (_config.options & PLCrashReporterOptionPreallocateReportFile) {
+        /* Reports are written directly to the mapped file; no output buffer is required */
+    } else if (plcrash_async_allocator_new(&output_allocator, PLCRASH_OUTPUT_BUFFER_BYTES, PLCrashAsyncGuardLowPage|PLCrashAsyncGuardHighPage) == PLCRASH_ESUCCESS) {
+        signal_handler_context.output_buffer = plcrash_async_allocator_alloc(output_allocator, PLCRASH_OUTPUT_BUFFER_BYTES, true);
+    } else {
+        PLCF_DEBUG("Failed to allocate the crash report output buffer; falling back on the default buffer");
+    }
     
     
     /* Enable the signal handler */
@@ -634,6 +1089,10 @@ static PLCrashReporter *sharedReporter = nil;
     /* Set the uncaught exception handler */
     NSSetUncaughtExceptionHandler(&uncaught_exception_handler);
 
+    /* Export any already-enabled profiler with crash reports */
+    if (_profiler != NULL)
+        [self exportProfilerToCrashHandler];
+
     /* Success */
     _enabled = YES;
     return YES;
@@ -701,6 +1160,12 @@ static plcrash_error_t plcr_live_report_callback (plcrash_async_thread_state_t *
 
     /* Initialize the output context */
     plcrash_log_writer_init(&writer, _applicationIdentifier, _applicationVersion, [self mapToAsyncSymbolicationStrategy: _config.symbolicationStrategy], true);
+    plcrash_log_writer_set_time_budget(&writer, (uint64_t) (_config.timeBudget * NSEC_PER_SEC));
+    writer.report_info.crashed_thread_first = (_config.options & PLCrashReporterOptionCrashedThreadFirst) != 0;
+    writer.report_info.referenced_images_only = (_config.options & PLCrashReporterOptionReferencedImagesOnly) != 0;
+    writer.report_info.dedup_identical_stacks = (_config.options & PLCrashReporterOptionDeduplicateThreadStacks) != 0;
+    writer.report_info.capture_stack_memory = (_config.options & PLCrashReporterOptionCaptureStackMemory) != 0;
+    writer.report_info.fold_repeated_frames = (_config.options & PLCrashReporterOptionFoldRepeatedFrames) != 0;
     plcrash_async_file_init(&file, fd, MAX_REPORT_BYTES);
     
     /* Mock up a SIGTRAP-based signal info */
@@ -815,6 +1280,343 @@ cleanup:
     crashCallbacks.handleSignal = callbacks->handleSignal;
 }
 
+/**
+ * Enable out-of-process crash reporting. Once enabled, fatal crash reports are written by a helper process
+ * serving @a servicePort, rather than from within the crashed process' signal or exception handler. The helper
+ * suspends the crashed process, and may unwind and symbolicate its threads without the constraints imposed on
+ * in-process crash handling.
+ *
+ * Spawning the helper, and supplying the crashed process with a send right for the helper's service port, are the
+ * responsibility of the caller. The helper should service requests via plcrash_nasync_oop_server_handle_request().
+ *
+ * If the helper can not be reached, or does not complete the report within @a timeout, the report will be
+ * written in-process. Reports for uncaught exceptions, and reports written to a preallocated report file, are
+ * always written in-process.
+ *
+ * @param servicePort A send right for the helper's service port. An additional reference to this right will be
+ * held by the receiver.
+ * @param timeout The maximum time, in seconds, to wait for the helper to write a report. This bounds both sending
+ * the request and awaiting the helper's reply.
+ * @param outError A pointer to an NSError object variable. If an error occurs, this pointer
+ * will contain an error in the PLCrashReporterErrorDomain indicating why out-of-process reporting could not be enabled.
+ * If no error occurs, this parameter will be left unmodified. You may specify nil for this parameter, and no error
+ * information will be provided.
+ *
+ * @return Returns YES on success, or NO if out-of-process reporting could not be enabled.
+ *
+ * @note This method must be called prior to PLCrashReporter::enableCrashReporter or
+ * PLCrashReporter::enableCrashReporterAndReturnError:
+ */
+- (BOOL) enableOutOfProcessReportingWithServicePort: (mach_port_t) servicePort timeout: (NSTimeInterval) timeout error: (NSError **) outError {
+    /* Check for programmer error; the signal handler must never observe a partially initialized client. */
+    if (_enabled)
+        [NSException raise: PLCrashReporterException format: @"The crash reporter has alread been enabled"];
+
+    if (signal_handler_context.oop_client.service_port != MACH_PORT_NULL)
+        plcrash_nasync_oop_client_free(&signal_handler_context.oop_client);
+
+    if (plcrash_nasync_oop_client_init(&signal_handler_context.oop_client, servicePort, (mach_msg_timeout_t) (timeout * 1000)) != PLCRASH_ESUCCESS) {
+        plcrash_populate_error(outError, PLCrashReporterErrorOperatingSystem, @"Failed to initialize out-of-process reporting", nil);
+        return NO;
+    }
+
+    return YES;
+}
+
+/**
+ * Enable the hang watchdog. Once enabled, the main thread is periodically pinged via the main dispatch queue; if
+ * a ping remains unanswered for longer than @a threshold, a live report of the main thread is captured and queued.
+ * Queued reports may be fetched via PLCrashReporter::queuedHangReportPaths.
+ *
+ * Reports are written to a preallocated buffer by a log writer initialized when the watchdog is enabled, from a
+ * dedicated watchdog thread; only the report UUID and timestamp are regenerated per report. Unless @a allThreads is YES,
+ * only the stalled main thread is suspended and written, and the remainder of the process continues to run while
+ * the report is captured.
+ *
+ * In the steady state, the watchdog's overhead is a single timed wakeup and main queue dispatch per poll; polls
+ * are issued four times per @a threshold interval.
+ *
+ * @param threshold The time, in seconds, after which an unresponsive main thread is considered stalled.
+ * @param minimumReportInterval The minimum time, in seconds, between reported stalls. At most one report is captured
+ * per stall, regardless of the stall's duration.
+ * @param allThreads If YES, all threads will be written to hang reports.
+ * @param outError A pointer to an NSError object variable. If an error occurs, this pointer
+ * will contain an error in the PLCrashReporterErrorDomain indicating why the hang watchdog could not be enabled.
+ * If no error occurs, this parameter will be left unmodified. You may specify nil for this parameter, and no error
+ * information will be provided.
+ *
+ * @return Returns YES on success, or NO if the hang watchdog could not be enabled.
+ */
+- (BOOL) enableHangWatchdogWithThreshold: (NSTimeInterval) threshold
+                   minimumReportInterval: (NSTimeInterval) minimumReportInterval
+                              allThreads: (BOOL) allThreads
+                                   error: (NSError **) outError
+{
+    plcrash_hang_report_ctx_t *ctx;
+
+    /* Check for programmer error */
+    if (_hangWatchdog != NULL)
+        [NSException raise: PLCrashReporterException format: @"The hang watchdog has already been enabled"];
+
+    /* Create the directory tree */
+    if (![self populateCrashReportDirectoryAndReturnError: outError])
+        return NO;
+
+    if ((ctx = calloc(1, sizeof(*ctx))) == NULL || (ctx->output_buffer = malloc(MAX_REPORT_BYTES)) == NULL) {
+        free(ctx);
+        plcrash_populate_error(outError, PLCrashReporterErrorOperatingSystem, @"Failed to allocate the hang report buffer", nil);
+        return NO;
+    }
+
+    ctx->queue_path = strdup([[self queuedCrashReportDirectory] fileSystemRepresentation]);
+
+    /* Initialize the writer once; only the UUID and timestamp differ between reports */
+    plcrash_error_t err = plcrash_log_writer_init(&ctx->writer, _applicationIdentifier, _applicationVersion, [self mapToAsyncSymbolicationStrategy: _config.symbolicationStrategy], true);
+    if (err != PLCRASH_ESUCCESS) {
+        plcrash_log_writer_free(&ctx->writer);
+        free(ctx->queue_path);
+        free(ctx->output_buffer);
+        free(ctx);
+
+        plcrash_populate_error(outError, PLCrashReporterErrorOperatingSystem, @"Failed to initialize the hang report writer", nil);
+        return NO;
+    }
+    ctx->writer.report_info.crashed_thread_only = !allThreads;
+    plcrash_log_writer_set_time_budget(&ctx->writer, (uint64_t) (_config.timeBudget * NSEC_PER_SEC));
+
+    /* Initialize and start the watchdog */
+    thread_t mainThread = pthread_mach_thread_np(pthread_main_thread_np());
+    err = plcrash_nasync_hang_watchdog_init(&ctx->watchdog,
+                                                           mainThread,
+                                                           dispatch_get_main_queue(),
+                                                           (uint64_t) (threshold * NSEC_PER_SEC),
+                                                           (uint64_t) (minimumReportInterval * NSEC_PER_SEC),
+                                                           hang_watchdog_callback,
+                                                           ctx);
+    if (err == PLCRASH_ESUCCESS && (err = plcrash_nasync_hang_watchdog_start(&ctx->watchdog)) != PLCRASH_ESUCCESS)
+        plcrash_nasync_hang_watchdog_free(&ctx->watchdog);
+
+    if (err != PLCRASH_ESUCCESS) {
+        plcrash_log_writer_free(&ctx->writer);
+        free(ctx->queue_path);
+        free(ctx->output_buffer);
+        free(ctx);
+
+        plcrash_populate_error(outError, PLCrashReporterErrorOperatingSystem, @"Failed to start the hang watchdog", nil);
+        return NO;
+    }
+
+    _hangWatchdog = ctx;
+    return YES;
+}
+
+/**
+ * Disable the hang watchdog, waiting for any in-progress report capture to complete. If the hang watchdog is
+ * not enabled, this method does nothing.
+ */
+- (void) disableHangWatchdog {
+    plcrash_hang_report_ctx_t *ctx = _hangWatchdog;
+    if (ctx == NULL)
+        return;
+
+    plcrash_nasync_hang_watchdog_free(&ctx->watchdog);
+
+    plcrash_log_writer_free(&ctx->writer);
+    free(ctx->queue_path);
+    free(ctx->output_buffer);
+    free(ctx);
+
+    _hangWatchdog = NULL;
+}
+
+/**
+ * Return the paths of all queued hang reports. Callers are responsible for removing reports once they have been
+ * processed; no further reports will be queued while PLCRASH_MAX_QUEUED_HANG_REPORTS reports remain.
+ */
+- (NSArray *) queuedHangReportPaths {
+    NSString *queueDir = [self queuedCrashReportDirectory];
+    NSString *prefix = [NSString stringWithUTF8String: PLCRASH_HANG_REPORT_PREFIX];
+    NSMutableArray *paths = [NSMutableArray array];
+
+    for (NSString *name in [[NSFileManager defaultManager] contentsOfDirectoryAtPath: queueDir error: NULL]) {
+        if ([name hasPrefix: prefix])
+            [paths addObject: [queueDir stringByAppendingPathComponent: name]];
+    }
+
+    return paths;
+}
+
+/**
+ * Enable the sampling profiler. Once enabled, every thread in the process other than the profiler's own sampling
+ * thread is periodically suspended and unwound, and the resulting stacks are aggregated into a call tree.
+ *
+ * If the crash reporter is enabled, the aggregated samples are written alongside the crash report when a crash
+ * occurs, and may be fetched via PLCrashReporter::loadPendingProfileDataAndReturnError:. The profile output file is
+ * preallocated and memory mapped ahead of time, and is not opened from within the crash handler. The current samples
+ * may be fetched at any time via PLCrashReporter::generateProfileDataAndReturnError:.
+ *
+ * Profile data consists of a PLCRASH_PROFILE_FILE_MAGIC header followed by a protobuf-encoded Profile message
+ * (see crash_report.proto).
+ *
+ * If the profiler was previously disabled via PLCrashReporter::disableProfiler, sampling is resumed, and new
+ * samples are added to those already recorded.
+ *
+ * @param interval The time, in seconds, between sampling passes.
+ * @param outError A pointer to an NSError object variable. If an error occurs, this pointer
+ * will contain an error in the PLCrashReporterErrorDomain indicating why the profiler could not be enabled.
+ * If no error occurs, this parameter will be left unmodified. You may specify nil for this parameter, and no error
+ * information will be provided.
+ *
+ * @return Returns YES on success, or NO if the profiler could not be enabled.
+ */
+- (BOOL) enableProfilerWithSampleInterval: (NSTimeInterval) interval error: (NSError **) outError {
+    plcrash_profiler_t *profiler = _profiler;
+    uint32_t interval_usec = (uint32_t) (interval * USEC_PER_SEC);
+
+    /* Resume a previously disabled profiler */
+    if (profiler != NULL) {
+        if (profiler->running)
+            [NSException raise: PLCrashReporterException format: @"The profiler has already been enabled"];
+
+        profiler->interval_usec = interval_usec;
+        if (plcrash_nasync_profiler_start(profiler) != PLCRASH_ESUCCESS) {
+            plcrash_populate_error(outError, PLCrashReporterErrorOperatingSystem, @"Failed to start the profiler", nil);
+            return NO;
+        }
+
+        return YES;
+    }
+
+    /* Create the directory tree */
+    if (![self populateCrashReportDirectoryAndReturnError: outError])
+        return NO;
+
+    if ((profiler = malloc(sizeof(*profiler))) == NULL) {
+        plcrash_populate_error(outError, PLCrashReporterErrorOperatingSystem, @"Failed to allocate the profiler", nil);
+        return NO;
+    }
+
+    plcrash_error_t err = plcrash_nasync_profiler_init(profiler, mach_task_self(), &shared_image_list, interval_usec, PLCRASH_PROFILER_NODE_CAPACITY);
+    if (err != PLCRASH_ESUCCESS) {
+        free(profiler);
+        plcrash_populate_error(outError, PLCrashReporterErrorOperatingSystem, @"Failed to allocate the profiler's call tree", nil);
+        return NO;
+    }
+
+    if (plcrash_nasync_profiler_start(profiler) != PLCRASH_ESUCCESS) {
+        plcrash_nasync_profiler_free(profiler);
+        free(profiler);
+        plcrash_populate_error(outError, PLCrashReporterErrorOperatingSystem, @"Failed to start the profiler", nil);
+        return NO;
+    }
+
+    _profiler = profiler;
+
+    /* If the crash reporter is already enabled, publish the fully initialized profiler to the crash handler */
+    if (_enabled)
+        [self exportProfilerToCrashHandler];
+
+    return YES;
+}
+
+/**
+ * Disable the sampling profiler, waiting for any in-progress sampling pass to complete. Samples recorded prior to
+ * disabling the profiler are retained, and will continue to be written alongside crash reports. If the profiler is
+ * not enabled, this method does nothing.
+ */
+- (void) disableProfiler {
+    if (_profiler == NULL)
+        return;
+
+    plcrash_nasync_profiler_stop(_profiler);
+}
+
+/**
+ * Generate profile data from the samples recorded since the profiler was enabled.
+ *
+ * @param outError A pointer to an NSError object variable. If an error occurs, this pointer
+ * will contain an error object indicating why the profile could not be generated. If no error occurs, this
+ * parameter will be left unmodified. You may specify nil for this parameter, and no error information will be
+ * provided.
+ *
+ * @return Returns nil if the profile data could not be generated, or if the profiler has never been enabled.
+ */
+- (NSData *) generateProfileDataAndReturnError: (NSError **) outError {
+    plcrash_async_file_t file;
+    NSData *data;
+
+    if (_profiler == NULL) {
+        plcrash_populate_error(outError, PLCrashReporterErrorUnknown, @"The profiler has not been enabled", nil);
+        return nil;
+    }
+
+    /* Open the output file */
+    NSString *templateStr = [NSTemporaryDirectory() stringByAppendingPathComponent: @"live_profile.XXXXXX"];
+    char *path = strdup([templateStr fileSystemRepresentation]);
+
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        plcrash_populate_posix_error(outError, errno, NSLocalizedString(@"Failed to create temporary path", @"Error opening temporary output path"));
+        free(path);
+        return nil;
+    }
+
+    plcrash_async_file_init(&file, fd, MAX_PROFILE_BYTES);
+    plcrash_error_t err = plcrash_async_profiler_write(_profiler, &file);
+    plcrash_async_file_flush(&file);
+    plcrash_async_file_close(&file);
+
+    if (err != PLCRASH_ESUCCESS) {
+        plcrash_populate_error(outError, PLCrashReporterErrorUnknown, @"Failed to write the profile to disk", nil);
+        data = nil;
+    } else if ((data = [NSData dataWithContentsOfFile: [NSString stringWithUTF8String: path]]) == nil) {
+        plcrash_populate_error(outError, PLCrashReporterErrorUnknown, NSLocalizedString(@"Unable to open live profile for reading", nil), nil);
+    }
+
+    if (unlink(path) != 0)
+        NSLog(@"Failure occured deleting live profile: %s", strerror(errno));
+
+    free(path);
+    return data;
+}
+
+/**
+ * Returns YES if the application has previously crashed with the profiler enabled, and a pending profile is
+ * available.
+ */
+- (BOOL) hasPendingProfile {
+    /* Pick up any profile committed to the preallocated profile file */
+    [self promotePreallocatedProfile];
+
+    return [[NSFileManager defaultManager] fileExistsAtPath: [self profilePath]];
+}
+
+/**
+ * If the application has a pending profile, this method returns the profile data.
+ *
+ * @param outError A pointer to an NSError object variable. If an error occurs, this pointer
+ * will contain an error object indicating why the pending profile could not be loaded. If no error occurs, this
+ * parameter will be left unmodified. You may specify nil for this parameter, and no error information will be
+ * provided.
+ *
+ * @return Returns nil if the profile data could not be loaded.
+ */
+- (NSData *) loadPendingProfileDataAndReturnError: (NSError **) outError {
+    /* Pick up any profile committed to the preallocated profile file */
+    [self promotePreallocatedProfile];
+
+    return [NSData dataWithContentsOfFile: [self profilePath] options: NSMappedRead error: outError];
+}
+
+/**
+ * Purge a pending profile.
+ *
+ * @return Returns YES on success, or NO on error.
+ */
+- (BOOL) purgePendingProfileAndReturnError: (NSError **) outError {
+    return [[NSFileManager defaultManager] removeItemAtPath: [self profilePath] error: outError];
+}
+
 
 @end
 
@@ -968,6 +1770,17 @@ cleanup:
 #endif /* PLCRASH_FEATURE_MACH_EXCEPTIONS */
 
 - (void) dealloc {
+    [self disableHangWatchdog];
+
+    /* The profiler may only be freed if it has not been published to the crash handler */
+    if (_profiler != NULL) {
+        if (signal_handler_context.profiler != _profiler) {
+            plcrash_nasync_profiler_free(_profiler);
+            free(_profiler);
+        } else {
+            plcrash_nasync_profiler_stop(_profiler);
+        }
+    }
     [_config release];
 
 #if PLCRASH_FEATURE_MACH_EXCEPTIONS
@@ -1051,6 +1864,229 @@ cleanup:
     return [[self crashReportDirectory] stringByAppendingPathComponent: PLCRASH_LIVE_CRASHREPORT];
 }
 
+/**
+ * Return the path to the live profile (which may not yet, or ever, exist).
+ */
+- (NSString *) profilePath {
+    return [[self crashReportDirectory] stringByAppendingPathComponent: PLCRASH_LIVE_PROFILE];
+}
+
+/**
+ * Return the path to the preallocated crash report output file (which may not yet, or ever, exist).
+ */
+- (NSString *) preallocatedCrashReportPath {
+    return [[self crashReportDirectory] stringByAppendingPathComponent: PLCRASH_PREALLOCATED_CRASHREPORT];
+}
+
+/**
+ * Return the path to the preallocated profile output file (which may not yet, or ever, exist).
+ */
+- (NSString *) preallocatedProfilePath {
+    return [[self crashReportDirectory] stringByAppendingPathComponent: PLCRASH_PREALLOCATED_PROFILE];
+}
+
+/**
+ * Create, preallocate, and map a preallocated output file of @a capacity bytes, followed by a
+ * plcrash_mapped_report_trailer_t, discarding any existing contents.
+ *
+ * @param path The output file path.
+ * @param capacity The number of bytes available for output data.
+ * @param outError A pointer to an NSError object variable. If an error occurs, this pointer
+ * will contain an error object indicating why the file could not be mapped. If no error occurs, this parameter
+ * will be left unmodified. You may specify nil for this parameter, and no error information will be provided.
+ *
+ * @return Returns the base address of the writable, shared mapping, or NULL on failure. The mapping is never
+ * unmapped.
+ */
+- (void *) mapPreallocatedFileAtPath: (NSString *) path capacity: (size_t) capacity error: (NSError **) outError {
+    size_t size = capacity + sizeof(plcrash_mapped_report_trailer_t);
+    void *base;
+    int fd;
+
+    /* Open the output file; truncation discards any existing (uncommitted) data and trailer */
+    fd = open([path fileSystemRepresentation], O_RDWR|O_CREAT|O_TRUNC, 0644);
+    if (fd < 0) {
+        plcrash_populate_posix_error(outError, errno, @"Failed to open the preallocated output file");
+        return NULL;
+    }
+
+    /* Reserve backing storage up-front, so that writes to the mapping can not fail for lack of disk space at
+     * crash time. Not all file systems support preallocation, in which case we simply rely on ftruncate(). */
+    fstore_t store = {
+        .fst_flags = F_ALLOCATEALL,
+        .fst_posmode = F_PEOFPOSMODE,
+        .fst_offset = 0,
+        .fst_length = size
+    };
+    if (fcntl(fd, F_PREALLOCATE, &store) == -1)
+        NSDEBUG(@"Could not preallocate the output file: %s", strerror(errno));
+
+    if (ftruncate(fd, size) != 0) {
+        plcrash_populate_posix_error(outError, errno, @"Failed to size the preallocated output file");
+        close(fd);
+        return NULL;
+    }
+
+    /* Map the file; the mapping remains valid after the descriptor is closed. */
+    base = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        plcrash_populate_posix_error(outError, errno, @"Failed to map the preallocated output file");
+        close(fd);
+        return NULL;
+    }
+
+    close(fd);
+    return base;
+}
+
+/**
+ * If the preallocated output file at @a path contains committed data, truncate the file to the data's length and
+ * move it to @a destination. Files without committed data are left as-is.
+ *
+ * @param path The preallocated output file path.
+ * @param capacity The number of bytes available for output data, as supplied to
+ * mapPreallocatedFileAtPath:capacity:error:.
+ * @param destination The path to which committed data will be moved.
+ */
+- (void) promotePreallocatedFileAtPath: (NSString *) path capacity: (size_t) capacity destination: (NSString *) destination {
+    plcrash_mapped_report_trailer_t trailer;
+    int fd;
+
+    if ((fd = open([path fileSystemRepresentation], O_RDWR)) < 0)
+        return;
+
+    /* Check for committed data */
+    if (pread(fd, &trailer, sizeof(trailer), capacity) != sizeof(trailer) ||
+        trailer.magic != PLCRASH_MAPPED_REPORT_COMMIT_MAGIC ||
+        trailer.length > capacity)
+    {
+        close(fd);
+        return;
+    }
+
+    /* Strip the unused space and trailer, and move the data into place */
+    if (ftruncate(fd, trailer.length) != 0) {
+        NSDEBUG(@"Failed to truncate the preallocated output file: %s", strerror(errno));
+    } else if (rename([path fileSystemRepresentation], [destination fileSystemRepresentation]) != 0) {
+        NSDEBUG(@"Failed to move the preallocated output file into place: %s", strerror(errno));
+    }
+
+    close(fd);
+}
+
+/**
+ * Create, preallocate, and map the preallocated crash report output file, discarding any existing contents.
+ *
+ * @param outError A pointer to an NSError object variable. If an error occurs, this pointer
+ * will contain an error object indicating why the file could not be mapped. If no error occurs, this parameter
+ * will be left unmodified. You may specify nil for this parameter, and no error information will be provided.
+ *
+ * @return Returns the base address of the writable, shared mapping, or NULL on failure. The mapping is never
+ * unmapped.
+ */
+- (void *) mapPreallocatedCrashReportAndReturnError: (NSError **) outError {
+    return [self mapPreallocatedFileAtPath: [self preallocatedCrashReportPath] capacity: MAX_REPORT_BYTES error: outError];
+}
+
+/**
+ * If the preallocated crash report output file contains a committed report, truncate the file to the report's
+ * length and move it into place as the pending crash report. Files without a committed report are left as-is.
+ */
+- (void) promotePreallocatedCrashReport {
+    if (!(_config.options & PLCrashReporterOptionPreallocateReportFile))
+        return;
+
+    [self promotePreallocatedFileAtPath: [self preallocatedCrashReportPath] capacity: MAX_REPORT_BYTES destination: [self crashReportPath]];
+}
+
+/**
+ * If the preallocated profile output file contains a committed profile, truncate the file to the profile's
+ * length and move it into place as the pending profile. Files without a committed profile are left as-is.
+ */
+- (void) promotePreallocatedProfile {
+    [self promotePreallocatedFileAtPath: [self preallocatedProfilePath] capacity: MAX_PROFILE_BYTES destination: [self profilePath]];
+}
+
+/**
+ * Publish the profiler to the crash handler, first mapping the preallocated profile output file to which the
+ * profile will be written at crash time. Any profile committed by a previous process is promoted before the file
+ * is reused. If the file can not be mapped, the profile will not be written alongside crash reports.
+ */
+- (void) exportProfilerToCrashHandler {
+    NSError *error;
+
+    [self promotePreallocatedProfile];
+
+    void *mapped_profile = [self mapPreallocatedFileAtPath: [self preallocatedProfilePath] capacity: MAX_PROFILE_BYTES error: &error];
+    if (mapped_profile == NULL) {
+        NSLog(@"Could not map the profile output file; profiles will not be written with crash reports: %@", error);
+        return;
+    }
+
+    /* The mapping must be visible before the fully initialized profiler is published */
+    signal_handler_context.mapped_profile = mapped_profile;
+    OSMemoryBarrier();
+    signal_handler_context.profiler = _profiler;
+}
+
+/* State and callback used to write a live report for the calling thread to a preallocated report file. */
+struct plcr_mapped_live_report_context {
+    plcrash_log_writer_t *writer;
+    void *mapped_report;
+    plcrash_log_signal_info_t *info;
+};
+
+static plcrash_error_t plcr_mapped_live_report_callback (plcrash_async_thread_state_t *state, void *ctx) {
+    struct plcr_mapped_live_report_context *plcr_ctx = ctx;
+    return plcrash_write_mapped_report(plcr_ctx->writer, plcr_ctx->mapped_report, pl_mach_thread_self(), state, plcr_ctx->info);
+}
+
+/**
+ * Write and commit a live report for the calling thread to a preallocated crash report file, using the same
+ * code path as a crash-time report. This is used to verify the preallocated report file's handling without
+ * triggering an actual crash condition.
+ *
+ * @param mappedReport The preallocated report file's mapping, as returned by
+ * mapPreallocatedCrashReportAndReturnError:.
+ * @param outError A pointer to an NSError object variable. If an error occurs, this pointer
+ * will contain an error object indicating why the report could not be written. If no error occurs, this parameter
+ * will be left unmodified. You may specify nil for this parameter, and no error information will be provided.
+ *
+ * @return Returns YES on success, or NO on failure.
+ */
+- (BOOL) writeLiveReportToPreallocatedCrashReport: (void *) mappedReport error: (NSError **) outError {
+    plcrash_log_writer_t writer;
+    plcrash_error_t err;
+
+    plcrash_log_writer_init(&writer, _applicationIdentifier, _applicationVersion, [self mapToAsyncSymbolicationStrategy: _config.symbolicationStrategy], true);
+
+    /* Mock up a SIGTRAP-based signal info */
+    plcrash_log_bsd_signal_info_t bsd_signal_info = {
+        .signo = SIGTRAP,
+        .code = TRAP_TRACE,
+        .address = __builtin_return_address(0)
+    };
+    plcrash_log_signal_info_t signal_info = {
+        .bsd_info = &bsd_signal_info,
+        .mach_info = NULL
+    };
+
+    struct plcr_mapped_live_report_context ctx = {
+        .writer = &writer,
+        .mapped_report = mappedReport,
+        .info = &signal_info
+    };
+    err = plcrash_async_thread_state_current(plcr_mapped_live_report_callback, &ctx);
+    plcrash_log_writer_free(&writer);
+
+    if (err != PLCRASH_ESUCCESS) {
+        plcrash_populate_error(outError, PLCrashReporterErrorUnknown, @"Failed to write the preallocated crash report", nil);
+        return NO;
+    }
+
+    return YES;
+}
+
 
 
 @end
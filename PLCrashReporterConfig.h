@@ -139,6 +139,65 @@ typedef NS_OPTIONS(NSUInteger, PLCrashReporterSymbolicationStrategy) {
     PLCrashReporterSymbolicationStrategyAll = (PLCrashReporterSymbolicationStrategySymbolTable|PLCrashReporterSymbolicationStrategyObjC)
 };
 
+/**
+ * @ingroup enums
+ * Optional crash reporting behaviors.
+ */
+typedef NS_OPTIONS(NSUInteger, PLCrashReporterOptions) {
+    /** No optional behaviors. */
+    PLCrashReporterOptionNone = 0,
+
+    /**
+     * Open, preallocate, and memory map the crash report output file when the crash reporter is enabled. At crash
+     * time, the report is written directly to the mapped pages and committed via a trailing length marker, rather
+     * than opening, truncating, and writing to the output file from within the crash handler.
+     *
+     * The preallocated file is only promoted to a pending crash report once a committed report is found; this is
+     * performed transparently by PLCrashReporter.
+     */
+    PLCrashReporterOptionPreallocateReportFile = 1 << 0,
+
+    /**
+     * Write the signal, the crashed thread, and the binary images referenced by the crashed thread ahead of all
+     * other report data, and flush the report after each top-level section. Should the crash handler be terminated
+     * before the report is complete, the sections written prior to termination may still be decoded;
+     * refer to PLCrashReport::truncated.
+     */
+    PLCrashReporterOptionCrashedThreadFirst = 1 << 1,
+
+    /**
+     * Only write the binary images that contain at least one of the report's stack frames. This reduces the size of
+     * the report and the time required to write it, at the cost of omitting images that may be required to
+     * symbolicate register values or other addresses. The number of omitted images is available via
+     * PLCrashReport::omittedImageCount.
+     */
+    PLCrashReporterOptionReferencedImagesOnly = 1 << 2,
+
+    /**
+     * Write the stack frames of threads with identical stacks only once. Later threads with an identical stack
+     * reference the frames of the first, reducing the size of the report and the time required to write it when
+     * many threads are parked in the same location (eg, thread pool workers). The references are expanded by
+     * PLCrashReport, and are not visible to API clients.
+     */
+    PLCrashReporterOptionDeduplicateThreadStacks = 1 << 3,
+
+    /**
+     * Include registers and a bounded raw copy of the stack for every thread, allowing stacks to be unwound
+     * post-mortem via PLCrashReport::postMortemStackFramesForThread:error:. Each thread's stack is captured with a
+     * single bulk read. Up to 16KB of the crashed thread's stack is captured; the remaining threads share an
+     * additional 8KB, and threads beyond that budget are written without stack memory.
+     */
+    PLCrashReporterOptionCaptureStackMemory = 1 << 4,
+
+    /**
+     * Write consecutive repetitions of a group of stack frames, such as those produced by deep recursion, only once
+     * along with a repeat count. This reduces the size of the report and the time required to write it. Repeated
+     * groups are expanded by PLCrashReport; decoders that do not support folding will only see the first
+     * repetition of each group.
+     */
+    PLCrashReporterOptionFoldRepeatedFrames = 1 << 5,
+};
+
 @interface PLCrashReporterConfig : NSObject {
 @private
     /** The configured signal handler type. */
@@ -146,6 +205,12 @@ typedef NS_OPTIONS(NSUInteger, PLCrashReporterSymbolicationStrategy) {
     
     /** The configured symbolication strategy. */
     PLCrashReporterSymbolicationStrategy _symbolicationStrategy;
+
+    /** The configured optional behaviors. */
+    PLCrashReporterOptions _options;
+
+    /** The configured crash report time budget, or 0 if unlimited. */
+    NSTimeInterval _timeBudget;
 }
 
 + (instancetype) defaultConfiguration;
@@ -153,6 +218,13 @@ typedef NS_OPTIONS(NSUInteger, PLCrashReporterSymbolicationStrategy) {
 - (instancetype) init;
 - (instancetype) initWithSignalHandlerType: (PLCrashReporterSignalHandlerType) signalHandlerType
                      symbolicationStrategy: (PLCrashReporterSymbolicationStrategy) symbolicationStrategy;
+- (instancetype) initWithSignalHandlerType: (PLCrashReporterSignalHandlerType) signalHandlerType
+                     symbolicationStrategy: (PLCrashReporterSymbolicationStrategy) symbolicationStrategy
+                                   options: (PLCrashReporterOptions) options;
+- (instancetype) initWithSignalHandlerType: (PLCrashReporterSignalHandlerType) signalHandlerType
+                     symbolicationStrategy: (PLCrashReporterSymbolicationStrategy) symbolicationStrategy
+                                   options: (PLCrashReporterOptions) options
+                                timeBudget: (NSTimeInterval) timeBudget;
 
 /** The configured signal handler type. */
 @property(nonatomic, readonly) PLCrashReporterSignalHandlerType signalHandlerType;
@@ -160,6 +232,16 @@ typedef NS_OPTIONS(NSUInteger, PLCrashReporterSymbolicationStrategy) {
 /** The configured symbolication strategy. */
 @property(nonatomic, readonly) PLCrashReporterSymbolicationStrategy symbolicationStrategy;
 
+/** The configured optional behaviors. */
+@property(nonatomic, readonly) PLCrashReporterOptions options;
+
+/**
+ * The target time within which a crash report should be written, or 0 if unlimited. As the budget is approached,
+ * the level of detail written is progressively reduced; the level reached is available via
+ * PLCrashReport::detailLevel.
+ */
+@property(nonatomic, readonly) NSTimeInterval timeBudget;
+
 
 @end
 
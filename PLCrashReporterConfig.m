@@ -37,6 +37,8 @@
 
 @synthesize signalHandlerType = _signalHandlerType;
 @synthesize symbolicationStrategy = _symbolicationStrategy;
+@synthesize options = _options;
+@synthesize timeBudget = _timeBudget;
 
 /**
  * Return the default local configuration.
@@ -61,12 +63,45 @@
  */
 - (instancetype) initWithSignalHandlerType: (PLCrashReporterSignalHandlerType) signalHandlerType
                      symbolicationStrategy: (PLCrashReporterSymbolicationStrategy) symbolicationStrategy
+{
+    return [self initWithSignalHandlerType: signalHandlerType symbolicationStrategy: symbolicationStrategy options: PLCrashReporterOptionNone];
+}
+
+/**
+ * Initialize a new PLCrashReporterConfig instance.
+ *
+ * @param signalHandlerType The requested signal handler type.
+ * @param symbolicationStrategy A local symbolication strategy.
+ * @param options Optional crash reporting behaviors to be enabled.
+ */
+- (instancetype) initWithSignalHandlerType: (PLCrashReporterSignalHandlerType) signalHandlerType
+                     symbolicationStrategy: (PLCrashReporterSymbolicationStrategy) symbolicationStrategy
+                                   options: (PLCrashReporterOptions) options
+{
+    return [self initWithSignalHandlerType: signalHandlerType symbolicationStrategy: symbolicationStrategy options: options timeBudget: 0];
+}
+
+/**
+ * Initialize a new PLCrashReporterConfig instance.
+ *
+ * @param signalHandlerType The requested signal handler type.
+ * @param symbolicationStrategy A local symbolication strategy.
+ * @param options Optional crash reporting behaviors to be enabled.
+ * @param timeBudget The target time within which a crash report should be written, or 0 if unlimited. If writing a
+ * report approaches this budget, symbolication and non-crashed threads will be progressively omitted.
+ */
+- (instancetype) initWithSignalHandlerType: (PLCrashReporterSignalHandlerType) signalHandlerType
+                     symbolicationStrategy: (PLCrashReporterSymbolicationStrategy) symbolicationStrategy
+                                   options: (PLCrashReporterOptions) options
+                                timeBudget: (NSTimeInterval) timeBudget
 {
     if ((self = [super init]) == nil)
         return nil;
 
     _signalHandlerType = signalHandlerType;
     _symbolicationStrategy = symbolicationStrategy;
+    _options = options;
+    _timeBudget = timeBudget;
 
     return self;
 }
@@ -31,10 +31,39 @@
 #import "PLCrashReport.h"
 #import "PLCrashReporter.h"
 #import "PLCrashFrameWalker.h"
+#import "PLCrashHangWatchdog.h"
+#import "PLCrashAsyncMachOImage.h"
+#import "PLCrashAsyncMObject.h"
+#import "PLCrashAsyncImageList.h"
+#import "PLCrashAsyncSymbolication.h"
+#import "PLCrashAsyncCompactUnwindEncoding.h"
+#import "PLCrashOutOfProcess.h"
+#import "PLCrashProfiler.h"
+
+#import "crash_report.pb-c.h"
+
+#import <libkern/OSAtomic.h>
+#import <inttypes.h>
+#import <dlfcn.h>
+#import <fcntl.h>
+#import <mach-o/dyld.h>
+#import <mach/mach_time.h>
+#import <sys/mman.h>
 
 @interface PLCrashReporterTests : SenTestCase
 @end
 
+/* Private PLCrashReporter methods used to exercise the preallocated report file */
+@interface PLCrashReporter (PreallocatedReportTests)
+- (id) initWithApplicationIdentifier: (NSString *) applicationIdentifier appVersion: (NSString *) applicationVersion configuration: (PLCrashReporterConfig *) configuration;
+- (BOOL) populateCrashReportDirectoryAndReturnError: (NSError **) outError;
+- (NSString *) crashReportDirectory;
+- (NSString *) crashReportPath;
+- (NSString *) preallocatedCrashReportPath;
+- (void *) mapPreallocatedCrashReportAndReturnError: (NSError **) outError;
+- (BOOL) writeLiveReportToPreallocatedCrashReport: (void *) mappedReport error: (NSError **) outError;
+@end
+
 @implementation PLCrashReporterTests
 
 - (void) testSingleton {
@@ -81,4 +110,1808 @@
     STAssertEqualStrings([[report signalInfo] code], @"TRAP_TRACE", @"Incorrect signal code");
 }
 
+/**
+ * Write a report for the current thread to @a path, using @a buffer as the output buffer if non-NULL, and return
+ * the number of write(2)/writev(2) calls issued.
+ */
+static size_t write_report_counting_writes (NSString *path, plcrash_async_image_list_t *image_list, void *buffer, size_t bufsize) {
+    plcrash_log_writer_t writer;
+    plcrash_async_file_t file;
+
+    plcrash_log_bsd_signal_info_t bsd_info = { .signo = SIGTRAP, .code = TRAP_TRACE, .address = (void *) 0x0 };
+    plcrash_log_signal_info_t siginfo = { .bsd_info = &bsd_info, .mach_info = NULL };
+
+    int fd = open([path fileSystemRepresentation], O_RDWR|O_CREAT|O_TRUNC, 0644);
+    if (fd < 0)
+        return 0;
+
+    if (buffer != NULL)
+        plcrash_async_file_init_with_buffer(&file, fd, 1024 * 1024, buffer, bufsize);
+    else
+        plcrash_async_file_init(&file, fd, 1024 * 1024);
+
+    plcrash_log_writer_init(&writer, @"test.id", @"1.0", PLCRASH_ASYNC_SYMBOL_STRATEGY_NONE, true);
+    plcrash_log_writer_write(&writer, pl_mach_thread_self(), image_list, &file, &siginfo, NULL);
+    plcrash_async_file_close(&file);
+    plcrash_log_writer_free(&writer);
+
+    return file.write_calls;
+}
+
+/**
+ * Report the number of write calls issued per report with the default and the preallocated output buffer.
+ */
+- (void) testOutputBufferWriteCallsBenchmark {
+    plcrash_async_image_list_t image_list;
+    const size_t bufsize = 16 * 1024;
+    void *buffer = malloc(bufsize);
+
+    plcrash_nasync_image_list_init(&image_list, mach_task_self());
+    STAssertEquals(plcrash_nasync_image_list_append_task_images(&image_list), PLCRASH_ESUCCESS, @"Failed to populate the image list");
+
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]];
+    size_t default_calls = write_report_counting_writes(path, &image_list, NULL, 0);
+    size_t buffered_calls = write_report_counting_writes(path, &image_list, buffer, bufsize);
+    unsigned long long report_size = [[[NSFileManager defaultManager] attributesOfItemAtPath: path error: NULL] fileSize];
+
+    NSLog(@"%llu byte report: %zu write calls with the %d byte default buffer, %zu with a %zu byte buffer",
+          report_size, default_calls, PLCRASH_ASYNC_FILE_DEFAULT_BUFSIZE, buffered_calls, bufsize);
+
+    STAssertTrue(default_calls > 0 && buffered_calls > 0, @"No writes were counted");
+    STAssertTrue(buffered_calls <= default_calls, @"The larger buffer issued more write calls");
+
+    [[NSFileManager defaultManager] removeItemAtPath: path error: NULL];
+    plcrash_nasync_image_list_free(&image_list);
+    free(buffer);
+}
+
+/**
+ * Write a report for the current thread with @a writer to @a path, and return the parsed report.
+ */
+static PLCrashReport *write_report_with_writer (plcrash_log_writer_t *writer, plcrash_async_image_list_t *image_list, NSString *path, NSError **outError) {
+    plcrash_async_file_t file;
+
+    plcrash_log_bsd_signal_info_t bsd_info = { .signo = SIGTRAP, .code = TRAP_TRACE, .address = (void *) 0x0 };
+    plcrash_log_signal_info_t siginfo = { .bsd_info = &bsd_info, .mach_info = NULL };
+
+    int fd = open([path fileSystemRepresentation], O_RDWR|O_CREAT|O_TRUNC, 0644);
+    if (fd < 0)
+        return nil;
+
+    plcrash_async_file_init(&file, fd, 1024 * 1024);
+    plcrash_log_writer_write(writer, pl_mach_thread_self(), image_list, &file, &siginfo, NULL);
+    plcrash_async_file_flush(&file);
+    plcrash_async_file_close(&file);
+
+    return [[[PLCrashReport alloc] initWithData: [NSData dataWithContentsOfFile: path] error: outError] autorelease];
+}
+
+/**
+ * Verify that a reused writer assigns each report the UUID generated by plcrash_log_writer_regenerate_uuid().
+ */
+- (void) testWriterRegenerateUUID {
+    NSError *error;
+    plcrash_log_writer_t writer;
+    plcrash_async_image_list_t image_list;
+
+    plcrash_nasync_image_list_init(&image_list, mach_task_self());
+    STAssertEquals(plcrash_log_writer_init(&writer, @"test.id", @"1.0", PLCRASH_ASYNC_SYMBOL_STRATEGY_NONE, true), PLCRASH_ESUCCESS, @"Failed to initialize the writer");
+    STAssertTrue(writer.static_sections.data != NULL, @"Static sections were not pre-encoded");
+
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]];
+    PLCrashReport *first = write_report_with_writer(&writer, &image_list, path, &error);
+    STAssertNotNil(first, @"Could not parse the first report: %@", error);
+
+    plcrash_log_writer_regenerate_uuid(&writer);
+    PLCrashReport *second = write_report_with_writer(&writer, &image_list, path, &error);
+    STAssertNotNil(second, @"Could not parse the second report: %@", error);
+
+    CFUUIDBytes firstBytes = CFUUIDGetUUIDBytes(first.uuidRef);
+    CFUUIDBytes secondBytes = CFUUIDGetUUIDBytes(second.uuidRef);
+    STAssertTrue(memcmp(&firstBytes, &secondBytes, sizeof(firstBytes)) != 0, @"The UUID was not regenerated");
+    STAssertTrue(memcmp(&secondBytes, writer.report_info.uuid_bytes, sizeof(secondBytes)) == 0, @"The report does not contain the regenerated UUID");
+
+    [[NSFileManager defaultManager] removeItemAtPath: path error: NULL];
+    plcrash_log_writer_free(&writer);
+    plcrash_nasync_image_list_free(&image_list);
+}
+
+/**
+ * Verify that plcrash_async_writevn() reports the total number of bytes written, matching plcrash_async_writen().
+ */
+- (void) testWritevnReturnsBytesWritten {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]];
+    int fd = open([path fileSystemRepresentation], O_RDWR|O_CREAT|O_TRUNC, 0644);
+    STAssertTrue(fd >= 0, @"Failed to open the output file");
+
+    char first[] = "hello, ";
+    char second[] = "world";
+    struct iovec iov[2] = {
+        { .iov_base = first, .iov_len = strlen(first) },
+        { .iov_base = second, .iov_len = strlen(second) }
+    };
+    STAssertEquals(plcrash_async_writevn(fd, iov, 2), (ssize_t) (strlen(first) + strlen(second)), @"Incorrect byte count");
+    STAssertEquals(plcrash_async_writen(fd, first, strlen(first)), (ssize_t) strlen(first), @"Incorrect byte count");
+
+    close(fd);
+    NSData *data = [NSData dataWithContentsOfFile: path];
+    STAssertEqualStrings([[NSString alloc] initWithData: data encoding: NSUTF8StringEncoding], @"hello, worldhello, ", @"Incorrect file contents");
+    [[NSFileManager defaultManager] removeItemAtPath: path error: NULL];
+}
+
+/**
+ * Verify that once a memory-backed write overflows, all subsequent writes (and flushes) fail, rather than leaving
+ * a hole in the output.
+ */
+- (void) testMemoryFileOverflowIsSticky {
+    plcrash_async_file_t file;
+    uint8_t buffer[8];
+
+    plcrash_async_file_init_memory(&file, buffer, sizeof(buffer));
+    STAssertTrue(plcrash_async_file_write(&file, "abcd", 4), @"Write failed");
+    STAssertTrue(plcrash_async_file_flush(&file), @"Flush failed");
+
+    STAssertFalse(plcrash_async_file_write(&file, "efghij", 6), @"Overflowing write succeeded");
+    STAssertTrue(file.mem_overflow, @"Overflow was not recorded");
+
+    /* This write would fit, but must not be appended after the dropped write */
+    STAssertFalse(plcrash_async_file_write(&file, "ef", 2), @"Write after overflow succeeded");
+    STAssertFalse(plcrash_async_file_write_nocopy(&file, "ef", 2), @"Write after overflow succeeded");
+    STAssertEquals(file.buflen, (size_t) 4, @"Output was appended after the overflow");
+
+    STAssertFalse(plcrash_async_file_flush(&file), @"Flush after overflow succeeded");
+    STAssertFalse(plcrash_async_file_close(&file), @"Close after overflow succeeded");
+}
+
+/**
+ * Exercise the aligned, word-at-a-time path of plcrash_async_memcpy() alongside the unaligned byte path.
+ */
+- (void) testAsyncMemcpy {
+    uint8_t src[64];
+    uint8_t dest[64];
+
+    for (size_t i = 0; i < sizeof(src); i++)
+        src[i] = (uint8_t) i;
+
+    for (size_t offset = 0; offset < sizeof(uintptr_t); offset++) {
+        memset(dest, 0xFF, sizeof(dest));
+        plcrash_async_memcpy(dest + offset, src + 1, sizeof(src) - sizeof(uintptr_t));
+        STAssertTrue(memcmp(dest + offset, src + 1, sizeof(src) - sizeof(uintptr_t)) == 0, @"Copy mismatch at offset %zu", offset);
+        STAssertEquals(dest[offset + sizeof(src) - sizeof(uintptr_t)], (uint8_t) 0xFF, @"Copy overran the destination");
+    }
+}
+
+/**
+ * Verify that image capabilities reflect the unwind and ObjC sections present in the image.
+ */
+- (void) testMachOImageCapabilities {
+    Dl_info info;
+    plcrash_async_macho_t image;
+
+    /* Use the image containing this test */
+    STAssertTrue(dladdr((void *) [self methodForSelector: _cmd], &info) != 0, @"Could not find the test image");
+    STAssertEquals(plcrash_nasync_macho_init(&image, mach_task_self(), info.dli_fname, (pl_vm_address_t) info.dli_fbase), PLCRASH_ESUCCESS, @"Failed to initialize the image");
+
+    plcrash_async_mobject_t mobj;
+    bool has_unwind = plcrash_async_macho_map_section(&image, SEG_TEXT, "__unwind_info", &mobj) == PLCRASH_ESUCCESS;
+    if (has_unwind)
+        plcrash_async_mobject_free(&mobj);
+
+    STAssertEquals(plcrash_async_macho_has_capability(&image, PLCRASH_ASYNC_MACHO_CAP_COMPACT_UNWIND), has_unwind, @"Incorrect compact unwind capability");
+    STAssertTrue(plcrash_async_macho_has_capability(&image, PLCRASH_ASYNC_MACHO_CAP_OBJC1) || plcrash_async_macho_has_capability(&image, PLCRASH_ASYNC_MACHO_CAP_OBJC2),
+                 @"ObjC class data was not found");
+
+    plcrash_nasync_macho_free(&image);
+}
+
+/**
+ * Verify that the indexed segment and section accessors return the same results as the name-based lookups.
+ */
+- (void) testMachOIndexedLookups {
+    static const char *segnames[PLCRASH_ASYNC_MACHO_INDEX_SEG_COUNT] = { "__TEXT", "__DATA", "__LINKEDIT", "__OBJC", "__DWARF" };
+    static const struct { plcrash_async_macho_index_seg_t segment; const char *sectname; } sections[PLCRASH_ASYNC_MACHO_INDEX_SECT_COUNT] = {
+        { PLCRASH_ASYNC_MACHO_INDEX_SEG_TEXT,   "__unwind_info" },
+        { PLCRASH_ASYNC_MACHO_INDEX_SEG_TEXT,   "__eh_frame" },
+        { PLCRASH_ASYNC_MACHO_INDEX_SEG_DWARF,  "__debug_frame" },
+        { PLCRASH_ASYNC_MACHO_INDEX_SEG_DATA,   "__objc_const" },
+        { PLCRASH_ASYNC_MACHO_INDEX_SEG_DATA,   "__objc_classlist" },
+        { PLCRASH_ASYNC_MACHO_INDEX_SEG_DATA,   "__objc_catlist" },
+        { PLCRASH_ASYNC_MACHO_INDEX_SEG_DATA,   "__objc_data" },
+        { PLCRASH_ASYNC_MACHO_INDEX_SEG_OBJC,   "__module_info" },
+    };
+    Dl_info info;
+    plcrash_async_macho_t image;
+
+    STAssertTrue(dladdr((void *) [self methodForSelector: _cmd], &info) != 0, @"Could not find the test image");
+    STAssertEquals(plcrash_nasync_macho_init(&image, mach_task_self(), info.dli_fname, (pl_vm_address_t) info.dli_fbase), PLCRASH_ESUCCESS, @"Failed to initialize the image");
+    STAssertTrue(image.cmd_index.valid, @"The load commands were not indexed");
+
+    for (int i = 0; i < PLCRASH_ASYNC_MACHO_INDEX_SEG_COUNT; i++) {
+        void *indexed = plcrash_async_macho_find_indexed_segment_cmd(&image, (plcrash_async_macho_index_seg_t) i);
+        STAssertEquals(indexed, plcrash_async_macho_find_segment_cmd(&image, segnames[i]), @"Indexed lookup of %s did not match", segnames[i]);
+    }
+    STAssertTrue(plcrash_async_macho_find_indexed_segment_cmd(&image, PLCRASH_ASYNC_MACHO_INDEX_SEG_TEXT) != NULL, @"__TEXT was not found");
+
+    for (int i = 0; i < PLCRASH_ASYNC_MACHO_INDEX_SECT_COUNT; i++) {
+        plcrash_async_mobject_t indexed_mobj;
+        plcrash_async_mobject_t named_mobj;
+
+        plcrash_error_t indexed_err = plcrash_async_macho_map_indexed_section(&image, (plcrash_async_macho_index_sect_t) i, &indexed_mobj);
+        plcrash_error_t named_err = plcrash_async_macho_map_section(&image, segnames[sections[i].segment], sections[i].sectname, &named_mobj);
+        STAssertEquals(indexed_err, named_err, @"Indexed mapping of %s returned a different result", sections[i].sectname);
+
+        if (indexed_err == PLCRASH_ESUCCESS) {
+            STAssertEquals(indexed_mobj.task_address, named_mobj.task_address, @"Indexed mapping of %s returned a different address", sections[i].sectname);
+            STAssertEquals(indexed_mobj.length, named_mobj.length, @"Indexed mapping of %s returned a different length", sections[i].sectname);
+            plcrash_async_mobject_free(&indexed_mobj);
+        }
+
+        if (named_err == PLCRASH_ESUCCESS)
+            plcrash_async_mobject_free(&named_mobj);
+    }
+
+    plcrash_nasync_macho_free(&image);
+}
+
+/**
+ * Verify that an image containing a truncated segment load command is still initialized, falling back on unindexed
+ * lookups with conservatively enabled capabilities.
+ */
+- (void) testMachOTruncatedSegmentFallsBackToLinearLookup {
+    struct {
+        struct mach_header_64 header;
+        struct segment_command_64 text;
+        struct load_command truncated;
+    } macho;
+    plcrash_async_macho_t image;
+
+    memset(&macho, 0, sizeof(macho));
+    macho.header.magic = MH_MAGIC_64;
+    macho.header.ncmds = 2;
+    macho.header.sizeofcmds = sizeof(macho.text) + sizeof(macho.truncated);
+
+    macho.text.cmd = LC_SEGMENT_64;
+    macho.text.cmdsize = sizeof(macho.text);
+    strlcpy(macho.text.segname, SEG_TEXT, sizeof(macho.text.segname));
+    macho.text.vmsize = sizeof(macho);
+
+    /* A segment command too short to contain its segment_command_64 header */
+    macho.truncated.cmd = LC_SEGMENT_64;
+    macho.truncated.cmdsize = sizeof(macho.truncated);
+
+    STAssertEquals(plcrash_nasync_macho_init(&image, mach_task_self(), "truncated", (pl_vm_address_t) &macho), PLCRASH_ESUCCESS, @"Failed to initialize the image");
+    STAssertFalse(image.cmd_index.valid, @"The truncated load commands were indexed");
+    STAssertEquals(plcrash_async_macho_find_indexed_segment_cmd(&image, PLCRASH_ASYNC_MACHO_INDEX_SEG_TEXT), (void *) (image.load_cmds.address), @"__TEXT was not found");
+    STAssertEquals((uint64_t) image.text_size, (uint64_t) sizeof(macho), @"Incorrect __TEXT size");
+    STAssertTrue(plcrash_async_macho_has_capability(&image, PLCRASH_ASYNC_MACHO_CAP_COMPACT_UNWIND), @"Capabilities were not conservatively enabled");
+    STAssertTrue(plcrash_async_macho_has_capability(&image, PLCRASH_ASYNC_MACHO_CAP_DWARF_UNWIND), @"Capabilities were not conservatively enabled");
+
+    plcrash_nasync_macho_free(&image);
+}
+
+static void symbol_lookup_benchmark_cb (pl_vm_address_t address, const char *name, void *ctx) {
+    *((pl_vm_address_t *) ctx) = address;
+}
+
+/**
+ * Benchmark PC-based symbol lookup against a large system symbol table.
+ */
+- (void) testSymbolLookupBenchmark {
+    const uint32_t iterations = 100;
+    plcrash_async_macho_t image;
+    Dl_info info;
+
+    STAssertTrue(dladdr((void *) NSLog, &info) != 0 && info.dli_saddr != NULL, @"Could not find NSLog");
+    STAssertEquals(plcrash_nasync_macho_init(&image, mach_task_self(), info.dli_fname, (pl_vm_address_t) info.dli_fbase), PLCRASH_ESUCCESS, @"Failed to initialize the image");
+
+    plcrash_async_macho_symtab_reader_t reader;
+    STAssertEquals(plcrash_async_macho_symtab_reader_init(&reader, &image), PLCRASH_ESUCCESS, @"Failed to initialize the symtab reader");
+    uint32_t nsyms = reader.nsyms;
+    plcrash_async_macho_symtab_reader_free(&reader);
+
+    pl_vm_address_t found = 0;
+    uint64_t start = mach_absolute_time();
+    for (uint32_t i = 0; i < iterations; i++)
+        STAssertEquals(plcrash_async_macho_find_symbol_by_pc(&image, (pl_vm_address_t) info.dli_saddr, symbol_lookup_benchmark_cb, &found), PLCRASH_ESUCCESS, @"Symbol lookup failed");
+    uint64_t elapsed = mach_absolute_time() - start;
+
+    STAssertEquals(found, (pl_vm_address_t) info.dli_saddr, @"Incorrect symbol address");
+    NSLog(@"%" PRIu32 " lookups over %" PRIu32 " symbols in %s: %" PRIu64 " mach_absolute_time units", iterations, nsyms, info.dli_fname, elapsed);
+
+    plcrash_nasync_macho_free(&image);
+}
+
+/** The number of entries in each page of a synthetic CFE section. */
+#define CFE_TEST_PAGE_ENTRIES 64
+
+/** The function offset range covered by each page of a synthetic CFE section. */
+#define CFE_TEST_PAGE_RANGE 0x10000
+
+/** The function offset distance between entries of a synthetic CFE section. */
+#define CFE_TEST_ENTRY_STRIDE (CFE_TEST_PAGE_RANGE / CFE_TEST_PAGE_ENTRIES)
+
+/**
+ * Return the encoding assigned to @a entry of @a page within a synthetic CFE section tagged with @a tag.
+ */
+static uint32_t cfe_test_encoding (uint32_t tag, uint32_t page, uint32_t entry) {
+    return (tag << 24) | (page << 12) | entry;
+}
+
+/**
+ * Build a synthetic, little-endian CFE section containing @a page_count regular second-level pages. The caller is
+ * responsible for freeing the returned buffer.
+ */
+static void *cfe_test_section (uint32_t tag, uint32_t page_count, size_t *length) {
+    struct unwind_info_section_header *header;
+    struct unwind_info_section_header_index_entry *index;
+
+    size_t index_off = sizeof(*header);
+    size_t pages_off = index_off + (page_count + 1) * sizeof(*index);
+    size_t page_len = sizeof(struct unwind_info_regular_second_level_page_header) + CFE_TEST_PAGE_ENTRIES * sizeof(struct unwind_info_regular_second_level_entry);
+
+    *length = pages_off + page_count * page_len;
+    uint8_t *buffer = calloc(1, *length);
+
+    header = (struct unwind_info_section_header *) buffer;
+    header->version = 1;
+    header->indexSectionOffset = (uint32_t) index_off;
+    header->indexCount = page_count + 1;
+
+    index = (struct unwind_info_section_header_index_entry *) (buffer + index_off);
+    for (uint32_t p = 0; p < page_count; p++) {
+        size_t off = pages_off + p * page_len;
+        struct unwind_info_regular_second_level_page_header *page = (struct unwind_info_regular_second_level_page_header *) (buffer + off);
+        struct unwind_info_regular_second_level_entry *entries = (struct unwind_info_regular_second_level_entry *) (page + 1);
+
+        index[p].functionOffset = p * CFE_TEST_PAGE_RANGE;
+        index[p].secondLevelPagesSectionOffset = (uint32_t) off;
+
+        page->kind = UNWIND_SECOND_LEVEL_REGULAR;
+        page->entryPageOffset = sizeof(*page);
+        page->entryCount = CFE_TEST_PAGE_ENTRIES;
+        for (uint32_t i = 0; i < CFE_TEST_PAGE_ENTRIES; i++) {
+            entries[i].functionOffset = p * CFE_TEST_PAGE_RANGE + i * CFE_TEST_ENTRY_STRIDE;
+            entries[i].encoding = cfe_test_encoding(tag, p, i);
+        }
+    }
+
+    /* Sentinel entry */
+    index[page_count].functionOffset = page_count * CFE_TEST_PAGE_RANGE;
+
+    return buffer;
+}
+
+/**
+ * Return true if @a cache holds a valid decoded page for @a index within the section at @a section_addr.
+ */
+static bool cfe_test_page_cached (plcrash_async_cfe_page_cache_t *cache, pl_vm_address_t section_addr, uint32_t index) {
+    for (size_t i = 0; i < PLCRASH_ASYNC_CFE_PAGE_CACHE_SIZE; i++) {
+        if (cache->pages[i].valid && cache->pages[i].section_addr == section_addr && cache->pages[i].index == index)
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * Verify that cached lookups return the same results as uncached lookups, and that pages are retained across lookups.
+ */
+- (void) testCFEPageCacheLookup {
+    const uint32_t page_count = 3;
+    plcrash_async_cfe_page_cache_t *cache = calloc(1, sizeof(*cache));
+    plcrash_async_cfe_reader_t cached, uncached;
+    plcrash_async_mobject_t mobj;
+    size_t length;
+
+    void *section = cfe_test_section(1, page_count, &length);
+    STAssertEquals(plcrash_async_mobject_init_local(&mobj, (pl_vm_address_t) section, length), PLCRASH_ESUCCESS, @"Failed to map the section");
+    STAssertEquals(plcrash_async_cfe_reader_init(&cached, &mobj, CPU_TYPE_X86_64, cache), PLCRASH_ESUCCESS, @"Failed to initialize the reader");
+    STAssertEquals(plcrash_async_cfe_reader_init(&uncached, &mobj, CPU_TYPE_X86_64, NULL), PLCRASH_ESUCCESS, @"Failed to initialize the reader");
+
+    /* The first pass misses and populates the cache; the second is answered from the cache */
+    for (int pass = 0; pass < 2; pass++) {
+        for (uint32_t p = 0; p < page_count; p++) {
+            for (uint32_t i = 0; i < CFE_TEST_PAGE_ENTRIES; i++) {
+                pl_vm_address_t pc = p * CFE_TEST_PAGE_RANGE + i * CFE_TEST_ENTRY_STRIDE + 0x10;
+                pl_vm_address_t base, expected_base;
+                uint32_t encoding, expected_encoding;
+
+                STAssertEquals(plcrash_async_cfe_reader_find_pc(&uncached, pc, &expected_base, &expected_encoding), PLCRASH_ESUCCESS, @"Uncached lookup failed");
+                STAssertEquals(plcrash_async_cfe_reader_find_pc(&cached, pc, &base, &encoding), PLCRASH_ESUCCESS, @"Cached lookup failed");
+                STAssertEquals(base, expected_base, @"Incorrect function base");
+                STAssertEquals(encoding, expected_encoding, @"Incorrect encoding");
+                STAssertEquals(encoding, cfe_test_encoding(1, p, i), @"Incorrect encoding");
+            }
+
+            STAssertTrue(cfe_test_page_cached(cache, (pl_vm_address_t) section, p), @"Page %" PRIu32 " was not cached", p);
+        }
+    }
+
+    /* Invalidation must discard all pages */
+    plcrash_nasync_cfe_page_cache_invalidate(cache);
+    for (uint32_t p = 0; p < page_count; p++)
+        STAssertFalse(cfe_test_page_cached(cache, (pl_vm_address_t) section, p), @"Page survived invalidation");
+
+    plcrash_async_cfe_reader_free(&cached);
+    plcrash_async_cfe_reader_free(&uncached);
+    plcrash_async_mobject_free(&mobj);
+    free(section);
+    free(cache);
+}
+
+/**
+ * Verify that the least recently used page is evicted once the cache is full.
+ */
+- (void) testCFEPageCacheEviction {
+    const uint32_t page_count = PLCRASH_ASYNC_CFE_PAGE_CACHE_SIZE + 2;
+    plcrash_async_cfe_page_cache_t *cache = calloc(1, sizeof(*cache));
+    plcrash_async_cfe_reader_t reader;
+    plcrash_async_mobject_t mobj;
+    pl_vm_address_t base;
+    uint32_t encoding;
+    size_t length;
+
+    void *section = cfe_test_section(1, page_count, &length);
+    STAssertEquals(plcrash_async_mobject_init_local(&mobj, (pl_vm_address_t) section, length), PLCRASH_ESUCCESS, @"Failed to map the section");
+    STAssertEquals(plcrash_async_cfe_reader_init(&reader, &mobj, CPU_TYPE_X86_64, cache), PLCRASH_ESUCCESS, @"Failed to initialize the reader");
+
+    /* Touch every page, keeping page 0 hot */
+    for (uint32_t p = 0; p < page_count; p++) {
+        STAssertEquals(plcrash_async_cfe_reader_find_pc(&reader, p * CFE_TEST_PAGE_RANGE, &base, &encoding), PLCRASH_ESUCCESS, @"Lookup failed");
+        STAssertEquals(encoding, cfe_test_encoding(1, p, 0), @"Incorrect encoding");
+
+        STAssertEquals(plcrash_async_cfe_reader_find_pc(&reader, 0, &base, &encoding), PLCRASH_ESUCCESS, @"Lookup failed");
+        STAssertEquals(encoding, cfe_test_encoding(1, 0, 0), @"Incorrect encoding");
+    }
+
+    /* The hot page and the most recently decoded pages are retained; the others were evicted */
+    STAssertTrue(cfe_test_page_cached(cache, (pl_vm_address_t) section, 0), @"The most recently used page was evicted");
+    STAssertFalse(cfe_test_page_cached(cache, (pl_vm_address_t) section, 1), @"The least recently used page was not evicted");
+    STAssertTrue(cfe_test_page_cached(cache, (pl_vm_address_t) section, page_count - 1), @"The most recently decoded page was not cached");
+
+    plcrash_async_cfe_reader_free(&reader);
+    plcrash_async_mobject_free(&mobj);
+    free(section);
+    free(cache);
+}
+
+/**
+ * Verify that pages are keyed by their section; identical function offsets within distinct images sharing a
+ * cache must not alias.
+ */
+- (void) testCFEPageCacheCrossImageKeying {
+    plcrash_async_cfe_page_cache_t *cache = calloc(1, sizeof(*cache));
+    plcrash_async_cfe_reader_t first_reader, second_reader;
+    plcrash_async_mobject_t first_mobj, second_mobj;
+    size_t first_length, second_length;
+
+    void *first = cfe_test_section(1, 1, &first_length);
+    void *second = cfe_test_section(2, 1, &second_length);
+
+    STAssertEquals(plcrash_async_mobject_init_local(&first_mobj, (pl_vm_address_t) first, first_length), PLCRASH_ESUCCESS, @"Failed to map the section");
+    STAssertEquals(plcrash_async_mobject_init_local(&second_mobj, (pl_vm_address_t) second, second_length), PLCRASH_ESUCCESS, @"Failed to map the section");
+    STAssertEquals(plcrash_async_cfe_reader_init(&first_reader, &first_mobj, CPU_TYPE_X86_64, cache), PLCRASH_ESUCCESS, @"Failed to initialize the reader");
+    STAssertEquals(plcrash_async_cfe_reader_init(&second_reader, &second_mobj, CPU_TYPE_X86_64, cache), PLCRASH_ESUCCESS, @"Failed to initialize the reader");
+
+    for (uint32_t i = 0; i < CFE_TEST_PAGE_ENTRIES; i++) {
+        pl_vm_address_t pc = i * CFE_TEST_ENTRY_STRIDE;
+        pl_vm_address_t base;
+        uint32_t encoding;
+
+        STAssertEquals(plcrash_async_cfe_reader_find_pc(&first_reader, pc, &base, &encoding), PLCRASH_ESUCCESS, @"Lookup failed");
+        STAssertEquals(encoding, cfe_test_encoding(1, 0, i), @"Encoding returned from the wrong section");
+
+        STAssertEquals(plcrash_async_cfe_reader_find_pc(&second_reader, pc, &base, &encoding), PLCRASH_ESUCCESS, @"Lookup failed");
+        STAssertEquals(encoding, cfe_test_encoding(2, 0, i), @"Encoding returned from the wrong section");
+    }
+
+    STAssertTrue(cfe_test_page_cached(cache, (pl_vm_address_t) first, 0), @"Page was not cached");
+    STAssertTrue(cfe_test_page_cached(cache, (pl_vm_address_t) second, 0), @"Page was not cached");
+
+    plcrash_async_cfe_reader_free(&first_reader);
+    plcrash_async_cfe_reader_free(&second_reader);
+    plcrash_async_mobject_free(&first_mobj);
+    plcrash_async_mobject_free(&second_mobj);
+    free(first);
+    free(second);
+    free(cache);
+}
+
+/**
+ * Report the cost of hot CFE lookups with and without the page cache.
+ */
+- (void) testCFEPageCacheBenchmark {
+    const uint32_t page_count = 3;
+    const uint32_t iterations = 40000;
+    plcrash_async_cfe_page_cache_t *cache = calloc(1, sizeof(*cache));
+    plcrash_async_cfe_reader_t readers[2];
+    plcrash_async_mobject_t mobj;
+    uint64_t elapsed[2];
+    size_t length;
+
+    void *section = cfe_test_section(1, page_count, &length);
+    STAssertEquals(plcrash_async_mobject_init_local(&mobj, (pl_vm_address_t) section, length), PLCRASH_ESUCCESS, @"Failed to map the section");
+    STAssertEquals(plcrash_async_cfe_reader_init(&readers[0], &mobj, CPU_TYPE_X86_64, NULL), PLCRASH_ESUCCESS, @"Failed to initialize the reader");
+    STAssertEquals(plcrash_async_cfe_reader_init(&readers[1], &mobj, CPU_TYPE_X86_64, cache), PLCRASH_ESUCCESS, @"Failed to initialize the reader");
+
+    for (int r = 0; r < 2; r++) {
+        uint64_t start = mach_absolute_time();
+        for (uint32_t n = 0; n < iterations; n++) {
+            pl_vm_address_t pc = (n % page_count) * CFE_TEST_PAGE_RANGE + (n % CFE_TEST_PAGE_ENTRIES) * CFE_TEST_ENTRY_STRIDE;
+            pl_vm_address_t base;
+            uint32_t encoding;
+
+            if (plcrash_async_cfe_reader_find_pc(&readers[r], pc, &base, &encoding) != PLCRASH_ESUCCESS || encoding != cfe_test_encoding(1, n % page_count, n % CFE_TEST_PAGE_ENTRIES)) {
+                STFail(@"Lookup of pc=%" PRIx64 " failed", (uint64_t) pc);
+                break;
+            }
+        }
+        elapsed[r] = mach_absolute_time() - start;
+    }
+
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    NSLog(@"%" PRIu32 " CFE lookups over %" PRIu32 " pages: %" PRIu64 "ns uncached, %" PRIu64 "ns cached", iterations, page_count,
+          elapsed[0] * timebase.numer / timebase.denom, elapsed[1] * timebase.numer / timebase.denom);
+
+    plcrash_async_cfe_reader_free(&readers[0]);
+    plcrash_async_cfe_reader_free(&readers[1]);
+    plcrash_async_mobject_free(&mobj);
+    free(section);
+    free(cache);
+}
+
+/**
+ * Verify that lookups of PCs within previously found functions are answered from the symbol cache's memo table.
+ */
+- (void) testSymbolCacheMemoization {
+    const void *functions[] = { (const void *) NSStringFromSelector, (const void *) NSLog, (const void *) NSStringFromClass, (const void *) NSSelectorFromString };
+    const size_t function_count = sizeof(functions) / sizeof(functions[0]);
+    plcrash_async_symbol_cache_t cache;
+    plcrash_async_symbol_cache_stats_t stats;
+    plcrash_async_symbol_memo_t *memo = malloc(sizeof(*memo));
+    pl_vm_address_t starts[function_count];
+    plcrash_async_macho_t image;
+    Dl_info info;
+
+    STAssertTrue(dladdr((void *) NSLog, &info) != 0 && info.dli_saddr != NULL, @"Could not find NSLog");
+    STAssertEquals(plcrash_nasync_macho_init(&image, mach_task_self(), info.dli_fname, (pl_vm_address_t) info.dli_fbase), PLCRASH_ESUCCESS, @"Failed to initialize the image");
+    STAssertEquals(plcrash_async_symbol_cache_init_with_memo(&cache, memo), PLCRASH_ESUCCESS, @"Failed to initialize the symbol cache");
+
+    /* Look up a PC within each function; these populate the memo table out of address order */
+    for (size_t i = 0; i < function_count; i++) {
+        Dl_info fn_info;
+        STAssertTrue(dladdr(functions[i], &fn_info) != 0 && fn_info.dli_fbase == info.dli_fbase, @"Function is not in the expected image");
+        starts[i] = (pl_vm_address_t) fn_info.dli_saddr;
+
+        pl_vm_address_t found = 0;
+        STAssertEquals(plcrash_async_find_symbol(&image, PLCRASH_ASYNC_SYMBOL_STRATEGY_SYMBOL_TABLE, &cache, starts[i] + 4, symbol_lookup_benchmark_cb, &found), PLCRASH_ESUCCESS, @"Symbol lookup failed");
+        STAssertEquals(found, starts[i], @"Incorrect symbol address");
+    }
+
+    plcrash_async_symbol_cache_get_stats(&cache, &stats);
+    STAssertEquals(stats.lookup_count, (uint64_t) function_count, @"Incorrect lookup count");
+    STAssertEquals(stats.memo_hit_count, (uint64_t) 0, @"Unexpected memo table hit");
+    STAssertEquals(memo->count, (uint32_t) function_count, @"Functions were not memoized");
+
+    /* Repeated lookups, and lookups of lower PCs within the same functions, are answered from the memo table */
+    for (size_t i = 0; i < function_count; i++) {
+        pl_vm_address_t found = 0;
+        STAssertEquals(plcrash_async_find_symbol(&image, PLCRASH_ASYNC_SYMBOL_STRATEGY_SYMBOL_TABLE, &cache, starts[i] + 4, symbol_lookup_benchmark_cb, &found), PLCRASH_ESUCCESS, @"Symbol lookup failed");
+        STAssertEquals(found, starts[i], @"Incorrect symbol address");
+
+        found = 0;
+        STAssertEquals(plcrash_async_find_symbol(&image, PLCRASH_ASYNC_SYMBOL_STRATEGY_SYMBOL_TABLE, &cache, starts[i], symbol_lookup_benchmark_cb, &found), PLCRASH_ESUCCESS, @"Symbol lookup failed");
+        STAssertEquals(found, starts[i], @"Incorrect symbol address");
+    }
+
+    plcrash_async_symbol_cache_get_stats(&cache, &stats);
+    STAssertEquals(stats.lookup_count, (uint64_t) function_count * 3, @"Incorrect lookup count");
+    STAssertEquals(stats.memo_hit_count, (uint64_t) function_count * 2, @"Lookups within memoized functions were not answered from the memo table");
+    STAssertEquals(memo->count, (uint32_t) function_count, @"Functions were memoized more than once");
+
+    /* The sorted index must be ordered by symbol address */
+    for (uint32_t i = 1; i < memo->count; i++)
+        STAssertTrue(memo->entries[memo->sorted[i - 1]].symbol_address < memo->entries[memo->sorted[i]].symbol_address, @"Memo index is not sorted");
+
+    plcrash_async_symbol_cache_free(&cache);
+    plcrash_nasync_macho_free(&image);
+    free(memo);
+}
+
+/**
+ * Verify that memory objects backed by local memory, a snapshot buffer, and a file all resolve target addresses
+ * to the same data.
+ */
+- (void) testMObjectMemorySources {
+    const plcrash_async_byteorder_t *byteorder = &plcrash_async_byteorder_direct;
+    const pl_vm_address_t target = 0x100000;
+    plcrash_async_mobject_t mobj;
+    uint32_t data[64];
+    uint32_t value;
+
+    for (uint32_t i = 0; i < 64; i++)
+        data[i] = i * 7;
+
+    /* Local memory */
+    STAssertEquals(plcrash_async_mobject_init_local(&mobj, (pl_vm_address_t) data, sizeof(data)), PLCRASH_ESUCCESS, @"Failed to initialize local mobject");
+    STAssertEquals(plcrash_async_mobject_read_uint32(&mobj, byteorder, (pl_vm_address_t) data, 8 * sizeof(uint32_t), &value), PLCRASH_ESUCCESS, @"Local read failed");
+    STAssertEquals(value, (uint32_t) 56, @"Incorrect local value");
+    plcrash_async_mobject_free(&mobj);
+
+    /* Snapshot buffer, relocated to the target address */
+    STAssertEquals(plcrash_async_mobject_init_buffer(&mobj, data, target, sizeof(data)), PLCRASH_ESUCCESS, @"Failed to initialize buffer mobject");
+    STAssertEquals(plcrash_async_mobject_read_uint32(&mobj, byteorder, target, 8 * sizeof(uint32_t), &value), PLCRASH_ESUCCESS, @"Buffer read failed");
+    STAssertEquals(value, (uint32_t) 56, @"Incorrect buffer value");
+    STAssertTrue(plcrash_async_mobject_read_uint32(&mobj, byteorder, target, sizeof(data), &value) != PLCRASH_ESUCCESS, @"Out-of-range read succeeded");
+    STAssertEquals(plcrash_async_mobject_task(&mobj), (task_t) MACH_PORT_NULL, @"Buffer mobject reported a backing task");
+    plcrash_async_mobject_free(&mobj);
+
+    /* File, mapped from a non page-aligned offset */
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]];
+    STAssertTrue([[NSData dataWithBytes: data length: sizeof(data)] writeToFile: path atomically: NO], @"Failed to write test file");
+
+    int fd = open([path fileSystemRepresentation], O_RDONLY);
+    STAssertTrue(fd >= 0, @"Failed to open test file");
+    STAssertEquals(plcrash_nasync_mobject_init_file(&mobj, fd, 4 * sizeof(uint32_t), target, sizeof(data) - 4 * sizeof(uint32_t)), PLCRASH_ESUCCESS, @"Failed to initialize file mobject");
+
+    /* Ranges extending past the end of the file must be rejected, rather than faulting on access */
+    plcrash_async_mobject_t eof_mobj;
+    STAssertEquals(plcrash_nasync_mobject_init_file(&eof_mobj, fd, 4 * sizeof(uint32_t), target, sizeof(data)), PLCRASH_EINVAL, @"Mapped a range past the end of the file");
+    STAssertEquals(plcrash_nasync_mobject_init_file(&eof_mobj, fd, sizeof(data) + 1, target, 1), PLCRASH_EINVAL, @"Mapped an offset past the end of the file");
+    close(fd);
+
+    STAssertEquals(plcrash_async_mobject_read_uint32(&mobj, byteorder, target, 4 * sizeof(uint32_t), &value), PLCRASH_ESUCCESS, @"File read failed");
+    STAssertEquals(value, (uint32_t) 56, @"Incorrect file value");
+    plcrash_async_mobject_free(&mobj);
+
+    [[NSFileManager defaultManager] removeItemAtPath: path error: NULL];
+}
+
+/**
+ * Compare the launch-time cost of registering every loaded image with and without deferred initialization, and
+ * verify that deferred images are initialized on demand.
+ */
+- (void) testDeferredImageRegistrationBenchmark {
+    uint32_t count = _dyld_image_count();
+    plcrash_async_image_list_t eager;
+    plcrash_async_image_list_t deferred;
+
+    plcrash_nasync_image_list_init(&eager, mach_task_self());
+    plcrash_nasync_image_list_init(&deferred, mach_task_self());
+
+    /* Eager registration, matching the work performed by the dyld add-image callback */
+    uint64_t start = mach_absolute_time();
+    for (uint32_t i = 0; i < count; i++) {
+        const struct mach_header *mh = _dyld_get_image_header(i);
+        Dl_info info;
+
+        if (dladdr(mh, &info) != 0)
+            plcrash_nasync_image_list_append(&eager, (pl_vm_address_t) mh, info.dli_fname);
+    }
+    uint64_t eager_time = mach_absolute_time() - start;
+
+    /* Deferred registration */
+    plcrash_async_image_t **records = calloc(count, sizeof(plcrash_async_image_t *));
+    start = mach_absolute_time();
+    for (uint32_t i = 0; i < count; i++)
+        records[i] = plcrash_nasync_image_list_append_deferred(&deferred, (pl_vm_address_t) _dyld_get_image_header(i));
+    uint64_t deferred_time = mach_absolute_time() - start;
+
+    NSLog(@"Registered %" PRIu32 " images; eager: %" PRIu64 ", deferred: %" PRIu64 " (mach_absolute_time units)", count, eager_time, deferred_time);
+
+    /* The image containing this test must be initialized on demand, without initializing any other image */
+    plcrash_async_image_list_set_reading(&deferred, true); {
+        plcrash_async_image_t *image = plcrash_async_image_containing_address(&deferred, (pl_vm_address_t) [self methodForSelector: _cmd]);
+        STAssertTrue(image != NULL, @"Deferred image was not initialized on demand");
+        if (image != NULL)
+            STAssertTrue(image->macho_image.name != NULL, @"Deferred image name was not resolved");
+
+        uint32_t ready_count = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            if (records[i] != NULL && records[i]->state == PLCRASH_ASYNC_IMAGE_STATE_READY)
+                ready_count++;
+        }
+        STAssertEquals(ready_count, (uint32_t) 1, @"Images other than the containing image were initialized");
+    } plcrash_async_image_list_set_reading(&deferred, false);
+
+    /* An image left mid-initialization by an interrupted plcrash_nasync_image_list_init_pending() is initialized
+     * in place, and named from the path snapshot */
+    plcrash_async_image_t *stalled = NULL;
+    for (uint32_t i = 0; i < count && stalled == NULL; i++) {
+        if (records[i] != NULL && records[i]->state == PLCRASH_ASYNC_IMAGE_STATE_PENDING)
+            stalled = records[i];
+    }
+    STAssertTrue(stalled != NULL, @"No pending image was found");
+    stalled->state = PLCRASH_ASYNC_IMAGE_STATE_INITIALIZING;
+
+    plcrash_async_image_paths_t paths;
+    STAssertEquals(plcrash_nasync_image_paths_init(&paths, count), PLCRASH_ESUCCESS, @"Failed to allocate the path snapshot");
+    plcrash_async_image_paths_read(&paths, &deferred);
+    STAssertTrue(paths.count > 0, @"No image paths were read");
+
+    uint32_t found_count = 0;
+    bool found_stalled = false;
+    plcrash_async_image_list_set_reading(&deferred, true); {
+        plcrash_async_image_t *image = NULL;
+        while ((image = plcrash_async_image_list_next_with_paths(&deferred, image, &paths)) != NULL) {
+            found_count++;
+            if (image == stalled)
+                found_stalled = true;
+
+            Dl_info info;
+            if (dladdr((const void *) image->macho_image.header_addr, &info) != 0 && info.dli_fname != NULL)
+                STAssertTrue(strcmp(image->macho_image.name, "???") != 0, @"Image %s was not named", info.dli_fname);
+        }
+    } plcrash_async_image_list_set_reading(&deferred, false);
+
+    STAssertTrue(found_stalled, @"The stalled image was omitted");
+    STAssertEquals((int32_t) stalled->state, (int32_t) PLCRASH_ASYNC_IMAGE_STATE_READY, @"The stalled image was not initialized");
+    NSLog(@"Iterated %" PRIu32 " deferred images using a %" PRIu32 " entry path snapshot", found_count, paths.count);
+
+    free(records);
+
+    /* Any remaining images are initialized in batches */
+    while (plcrash_nasync_image_list_init_pending(&deferred, 32, NULL, NULL) > 0);
+
+    /* Once no images are pending, the task's image information is not read */
+    plcrash_async_image_paths_read(&paths, &deferred);
+    STAssertEquals(paths.count, (uint32_t) 0, @"Image paths were read with no pending images");
+    plcrash_nasync_image_paths_free(&paths);
+
+    plcrash_nasync_image_list_free(&eager);
+    plcrash_nasync_image_list_free(&deferred);
+}
+
+/**
+ * Return a new reporter with a unique crash report directory and the preallocated report file enabled.
+ */
+static PLCrashReporter *preallocated_test_reporter (void) {
+    PLCrashReporterConfig *config = [[[PLCrashReporterConfig alloc] initWithSignalHandlerType: PLCrashReporterSignalHandlerTypeBSD
+                                                                        symbolicationStrategy: PLCrashReporterSymbolicationStrategyNone
+                                                                                      options: PLCrashReporterOptionPreallocateReportFile] autorelease];
+    NSString *appId = [@"test.id." stringByAppendingString: [[NSProcessInfo processInfo] globallyUniqueString]];
+    return [[[PLCrashReporter alloc] initWithApplicationIdentifier: appId appVersion: @"1.0" configuration: config] autorelease];
+}
+
+/**
+ * Map @a reporter's preallocated report file, write and commit a live report to it, and return the mapping. The
+ * mapping's size is returned via @a size.
+ */
+- (void *) writePreallocatedReportWithReporter: (PLCrashReporter *) reporter size: (size_t *) size {
+    NSError *error;
+
+    STAssertTrue([reporter populateCrashReportDirectoryAndReturnError: &error], @"Failed to create the report directory: %@", error);
+
+    void *base = [reporter mapPreallocatedCrashReportAndReturnError: &error];
+    STAssertTrue(base != NULL, @"Failed to map the preallocated report file: %@", error);
+
+    *size = [[[NSFileManager defaultManager] attributesOfItemAtPath: [reporter preallocatedCrashReportPath] error: NULL] fileSize];
+    STAssertTrue([reporter writeLiveReportToPreallocatedCrashReport: base error: &error], @"Failed to write the report: %@", error);
+
+    return base;
+}
+
+/**
+ * Verify that a report committed to the preallocated report file is promoted to the pending crash report.
+ */
+- (void) testPreallocatedReportCommitted {
+    NSError *error;
+    PLCrashReporter *reporter = preallocated_test_reporter();
+    size_t size;
+    void *base = [self writePreallocatedReportWithReporter: reporter size: &size];
+
+    STAssertTrue([reporter hasPendingCrashReport], @"The committed report was not picked up");
+    STAssertFalse([[NSFileManager defaultManager] fileExistsAtPath: [reporter preallocatedCrashReportPath]], @"The preallocated file was not moved into place");
+
+    NSData *data = [reporter loadPendingCrashReportDataAndReturnError: &error];
+    STAssertNotNil(data, @"Failed to load the pending report: %@", error);
+    STAssertTrue([data length] < size, @"The report was not truncated to its committed length");
+
+    PLCrashReport *report = [[[PLCrashReport alloc] initWithData: data error: &error] autorelease];
+    STAssertNotNil(report, @"Could not parse the committed report: %@", error);
+    STAssertEqualStrings([[report signalInfo] name], @"SIGTRAP", @"Incorrect signal name");
+    STAssertEqualStrings(report.applicationInfo.applicationVersion, @"1.0", @"Incorrect application version");
+
+    munmap(base, size);
+    [[NSFileManager defaultManager] removeItemAtPath: [reporter crashReportDirectory] error: NULL];
+}
+
+/**
+ * Verify that a preallocated report file lacking a commit marker, or with a torn trailer, is ignored.
+ */
+- (void) testPreallocatedReportUncommittedOrTorn {
+    PLCrashReporter *reporter = preallocated_test_reporter();
+    size_t size;
+    void *base = [self writePreallocatedReportWithReporter: reporter size: &size];
+
+    /* The trailer consists of the 32-bit commit marker, followed by the 32-bit length */
+    uint32_t *magic = (uint32_t *) ((uint8_t *) base + size - (2 * sizeof(uint32_t)));
+    uint32_t *length = magic + 1;
+    uint32_t committed_magic = *magic;
+    STAssertTrue(committed_magic != 0, @"The report was not committed");
+
+    /* An uncommitted report */
+    *magic = 0;
+    msync(base, size, MS_SYNC);
+    STAssertFalse([reporter hasPendingCrashReport], @"An uncommitted report was picked up");
+    STAssertTrue([[NSFileManager defaultManager] fileExistsAtPath: [reporter preallocatedCrashReportPath]], @"The uncommitted file was moved");
+
+    /* A torn trailer, with a length exceeding the report data */
+    *magic = committed_magic;
+    *length = (uint32_t) size;
+    msync(base, size, MS_SYNC);
+    STAssertFalse([reporter hasPendingCrashReport], @"A report with a torn trailer was picked up");
+    STAssertTrue([[NSFileManager defaultManager] fileExistsAtPath: [reporter preallocatedCrashReportPath]], @"The torn file was moved");
+
+    munmap(base, size);
+    [[NSFileManager defaultManager] removeItemAtPath: [reporter crashReportDirectory] error: NULL];
+}
+
+/**
+ * Verify that a preallocated report file too small to contain a trailer is ignored, and that a report written via
+ * the regular output path is picked up instead.
+ */
+- (void) testPreallocatedReportTooSmall {
+    NSError *error;
+    PLCrashReporter *reporter = preallocated_test_reporter();
+
+    STAssertTrue([reporter populateCrashReportDirectoryAndReturnError: &error], @"Failed to create the report directory: %@", error);
+
+    /* A truncated preallocated file */
+    uint8_t bytes[16] = { 0 };
+    STAssertTrue([[NSData dataWithBytes: bytes length: sizeof(bytes)] writeToFile: [reporter preallocatedCrashReportPath] atomically: NO], @"Failed to write the preallocated file");
+    STAssertFalse([reporter hasPendingCrashReport], @"A truncated preallocated file was picked up");
+
+    /* A report written via the regular output path */
+    NSData *reportData = [reporter generateLiveReportAndReturnError: &error];
+    STAssertNotNil(reportData, @"Failed to generate live report: %@", error);
+    STAssertTrue([reportData writeToFile: [reporter crashReportPath] atomically: NO], @"Failed to write the report");
+
+    STAssertTrue([reporter hasPendingCrashReport], @"The regular report was not picked up");
+    STAssertEqualObjects([reporter loadPendingCrashReportDataAndReturnError: &error], reportData, @"The regular report was replaced");
+    STAssertTrue([[NSFileManager defaultManager] fileExistsAtPath: [reporter preallocatedCrashReportPath]], @"The truncated file was moved");
+
+    [[NSFileManager defaultManager] removeItemAtPath: [reporter crashReportDirectory] error: NULL];
+}
+
+/**
+ * Verify that report detail is reduced, and the reduction recorded, when the time budget is exceeded.
+ */
+- (void) testGenerateLiveReportExceedingTimeBudget {
+    NSError *error;
+    PLCrashReporterConfig *config = [[[PLCrashReporterConfig alloc] initWithSignalHandlerType: PLCrashReporterSignalHandlerTypeBSD
+                                                                        symbolicationStrategy: PLCrashReporterSymbolicationStrategyAll
+                                                                                      options: PLCrashReporterOptionNone
+                                                                                   timeBudget: 1e-9] autorelease];
+    PLCrashReporter *reporter = [[[PLCrashReporter alloc] initWithConfiguration: config] autorelease];
+    plframe_test_thead_t thr;
+
+    /* Spawn an additional thread, which should be omitted from the report */
+    plframe_test_thread_spawn(&thr);
+    NSData *reportData = [reporter generateLiveReportAndReturnError: &error];
+    plframe_test_thread_stop(&thr);
+    STAssertNotNil(reportData, @"Failed to generate live report: %@", error);
+
+    PLCrashReport *report = [[[PLCrashReport alloc] initWithData: reportData error: &error] autorelease];
+    STAssertNotNil(report, @"Could not parse geneated live report: %@", error);
+
+    STAssertEquals(report.detailLevel, PLCrashReportDetailLevelCrashedThreadOnly, @"Detail level was not reduced");
+    STAssertEquals([report.threads count], (NSUInteger) 1, @"Non-crashed threads were not omitted");
+    STAssertTrue([[report.threads objectAtIndex: 0] crashed], @"The crashed thread was not written");
+}
+
+/**
+ * Verify that a crashed-thread-first report may be decoded after truncation.
+ */
+- (void) testDecodeTruncatedCrashedThreadFirstReport {
+    NSError *error;
+    PLCrashReporterConfig *config = [[[PLCrashReporterConfig alloc] initWithSignalHandlerType: PLCrashReporterSignalHandlerTypeBSD
+                                                                        symbolicationStrategy: PLCrashReporterSymbolicationStrategyNone
+                                                                                      options: PLCrashReporterOptionCrashedThreadFirst] autorelease];
+    PLCrashReporter *reporter = [[[PLCrashReporter alloc] initWithConfiguration: config] autorelease];
+
+    NSData *reportData = [reporter generateLiveReportAndReturnError: &error];
+    STAssertNotNil(reportData, @"Failed to generate live report: %@", error);
+
+    /* The complete report */
+    PLCrashReport *report = [[[PLCrashReport alloc] initWithData: reportData error: &error] autorelease];
+    STAssertNotNil(report, @"Could not parse generated live report: %@", error);
+    STAssertFalse(report.truncated, @"Complete report marked as truncated");
+    STAssertTrue([[report.threads objectAtIndex: 0] crashed], @"The crashed thread was not written first");
+
+    /* Every image must be written exactly once, split between the crashed thread's images and all others */
+    NSMutableSet *imageAddresses = [NSMutableSet set];
+    for (PLCrashReportBinaryImageInfo *image in report.images)
+        [imageAddresses addObject: [NSNumber numberWithUnsignedLongLong: image.imageBaseAddress]];
+    STAssertEquals([imageAddresses count], [report.images count], @"An image was written more than once");
+    STAssertTrue([report.images count] > 0, @"No images were written");
+
+    /* The crashed thread's images are written with the crashed thread, and all others following the remaining
+     * threads; both must be present */
+    for (PLCrashReportStackFrameInfo *frame in [[report.threads objectAtIndex: 0] stackFrames]) {
+        if (frame.instructionPointer != 0)
+            STAssertNotNil([report imageForAddress: frame.instructionPointer], @"Missing image for crashed thread frame 0x%" PRIx64, frame.instructionPointer);
+    }
+
+    /* Truncate the report mid-way through; the committed crashed thread and signal data must remain available */
+    NSData *truncatedData = [reportData subdataWithRange: NSMakeRange(0, [reportData length] / 2)];
+    report = [[[PLCrashReport alloc] initWithData: truncatedData error: &error] autorelease];
+    STAssertNotNil(report, @"Could not parse truncated report: %@", error);
+    STAssertTrue(report.truncated, @"Truncated report not marked as truncated");
+    STAssertEqualStrings([[report signalInfo] name], @"SIGTRAP", @"Incorrect signal name");
+    STAssertTrue([report.threads count] >= 1, @"The crashed thread was not decoded");
+    STAssertTrue([[report.threads objectAtIndex: 0] crashed], @"The crashed thread was not decoded");
+}
+
+/**
+ * Verify that only referenced images are written when requested.
+ */
+- (void) testGenerateLiveReportReferencedImagesOnly {
+    NSError *error;
+    PLCrashReporterConfig *config = [[[PLCrashReporterConfig alloc] initWithSignalHandlerType: PLCrashReporterSignalHandlerTypeBSD
+                                                                        symbolicationStrategy: PLCrashReporterSymbolicationStrategyNone
+                                                                                      options: PLCrashReporterOptionReferencedImagesOnly] autorelease];
+    PLCrashReporter *reporter = [[[PLCrashReporter alloc] initWithConfiguration: config] autorelease];
+
+    NSData *reportData = [reporter generateLiveReportAndReturnError: &error];
+    STAssertNotNil(reportData, @"Failed to generate live report: %@", error);
+
+    PLCrashReport *report = [[[PLCrashReport alloc] initWithData: reportData error: &error] autorelease];
+    STAssertNotNil(report, @"Could not parse generated live report: %@", error);
+    STAssertTrue(report.omittedImageCount > 0, @"No images were omitted");
+
+    /* Every frame must be covered by a written image */
+    for (PLCrashReportThreadInfo *thread in report.threads) {
+        for (PLCrashReportStackFrameInfo *frame in thread.stackFrames) {
+            if (frame.instructionPointer == 0)
+                continue;
+
+            STAssertNotNil([report imageForAddress: frame.instructionPointer], @"Missing image for frame 0x%" PRIx64, frame.instructionPointer);
+        }
+    }
+}
+
+/* Identical-stack worker; parks in the same location until the supplied semaphore is signaled */
+static void *identical_stack_worker (void *context) {
+    dispatch_semaphore_wait((dispatch_semaphore_t) context, DISPATCH_TIME_FOREVER);
+    return NULL;
+}
+
+/**
+ * Verify that threads with identical stacks are written once and expanded when decoded.
+ */
+- (void) testGenerateLiveReportDeduplicateThreadStacks {
+    const size_t worker_count = 8;
+    dispatch_semaphore_t sem = dispatch_semaphore_create(0);
+    pthread_t workers[worker_count];
+    NSError *error;
+
+    for (size_t i = 0; i < worker_count; i++)
+        STAssertEquals(pthread_create(&workers[i], NULL, identical_stack_worker, sem), 0, @"Failed to start worker thread");
+
+    /* Give the workers time to park */
+    usleep(100 * 1000);
+
+    PLCrashReporterConfig *config = [[[PLCrashReporterConfig alloc] initWithSignalHandlerType: PLCrashReporterSignalHandlerTypeBSD
+                                                                        symbolicationStrategy: PLCrashReporterSymbolicationStrategyAll
+                                                                                      options: PLCrashReporterOptionDeduplicateThreadStacks] autorelease];
+    NSData *dedupData = [[[[PLCrashReporter alloc] initWithConfiguration: config] autorelease] generateLiveReportAndReturnError: &error];
+    STAssertNotNil(dedupData, @"Failed to generate live report: %@", error);
+
+    config = [[[PLCrashReporterConfig alloc] initWithSignalHandlerType: PLCrashReporterSignalHandlerTypeBSD
+                                                 symbolicationStrategy: PLCrashReporterSymbolicationStrategyAll] autorelease];
+    NSData *fullData = [[[[PLCrashReporter alloc] initWithConfiguration: config] autorelease] generateLiveReportAndReturnError: &error];
+    STAssertNotNil(fullData, @"Failed to generate live report: %@", error);
+
+    for (size_t i = 0; i < worker_count; i++)
+        dispatch_semaphore_signal(sem);
+    for (size_t i = 0; i < worker_count; i++)
+        pthread_join(workers[i], NULL);
+    dispatch_release(sem);
+
+    STAssertTrue([dedupData length] < [fullData length], @"Deduplication did not reduce the report size");
+
+    /* The worker stacks must be expanded to identical, non-empty frame lists */
+    PLCrashReport *report = [[[PLCrashReport alloc] initWithData: dedupData error: &error] autorelease];
+    STAssertNotNil(report, @"Could not parse generated live report: %@", error);
+
+    NSCountedSet *stacks = [NSCountedSet set];
+    for (PLCrashReportThreadInfo *thread in report.threads) {
+        STAssertTrue([thread.stackFrames count] > 0, @"Thread %ld has no frames", (long) thread.threadNumber);
+
+        NSMutableArray *pcs = [NSMutableArray arrayWithCapacity: [thread.stackFrames count]];
+        for (PLCrashReportStackFrameInfo *frame in thread.stackFrames)
+            [pcs addObject: [NSNumber numberWithUnsignedLongLong: frame.instructionPointer]];
+        [stacks addObject: pcs];
+    }
+
+    NSUInteger largest = 0;
+    for (NSArray *pcs in stacks)
+        largest = MAX(largest, [stacks countForObject: pcs]);
+    STAssertTrue(largest >= worker_count, @"Identical worker stacks were not decoded");
+}
+
+/* Recursion depth of fold_test_recurse() */
+#define FOLD_TEST_DEPTH 64
+
+/* Recurse to the given depth, and then park until the supplied semaphore is signaled. The addition following the
+ * recursive call prevents tail call optimization, ensuring that each level produces an identical frame. */
+static __attribute__((noinline)) uint32_t fold_test_recurse (dispatch_semaphore_t sem, uint32_t depth) {
+    if (depth == 0) {
+        dispatch_semaphore_wait(sem, DISPATCH_TIME_FOREVER);
+        return 0;
+    }
+
+    return fold_test_recurse(sem, depth - 1) + 1;
+}
+
+static void *fold_test_worker (void *context) {
+    fold_test_recurse((dispatch_semaphore_t) context, FOLD_TEST_DEPTH);
+    return NULL;
+}
+
+/* Return the instruction pointers of the thread with the most stack frames in @a report */
+static NSArray *fold_test_deepest_stack (PLCrashReport *report) {
+    NSMutableArray *deepest = nil;
+    for (PLCrashReportThreadInfo *thread in report.threads) {
+        if (deepest != nil && [thread.stackFrames count] <= [deepest count])
+            continue;
+
+        deepest = [NSMutableArray arrayWithCapacity: [thread.stackFrames count]];
+        for (PLCrashReportStackFrameInfo *frame in thread.stackFrames)
+            [deepest addObject: [NSNumber numberWithUnsignedLongLong: frame.instructionPointer]];
+    }
+
+    return deepest;
+}
+
+/* Generate a live report, with or without frame folding, while a worker is parked within fold_test_recurse() */
+static NSData *fold_test_generate_report (PLCrashReporterOptions options, NSError **outError) {
+    dispatch_semaphore_t sem = dispatch_semaphore_create(0);
+    pthread_t worker;
+
+    if (pthread_create(&worker, NULL, fold_test_worker, sem) != 0) {
+        dispatch_release(sem);
+        return nil;
+    }
+
+    /* Give the worker time to park */
+    usleep(100 * 1000);
+
+    PLCrashReporterConfig *config = [[[PLCrashReporterConfig alloc] initWithSignalHandlerType: PLCrashReporterSignalHandlerTypeBSD
+                                                                        symbolicationStrategy: PLCrashReporterSymbolicationStrategyNone
+                                                                                      options: options] autorelease];
+    NSData *data = [[[[PLCrashReporter alloc] initWithConfiguration: config] autorelease] generateLiveReportAndReturnError: outError];
+
+    dispatch_semaphore_signal(sem);
+    pthread_join(worker, NULL);
+    dispatch_release(sem);
+
+    return data;
+}
+
+/* Return the first stack frame beginning a folded group in @a report, or NULL */
+static Plcrash__CrashReport__Thread__StackFrame *fold_test_find_group (Plcrash__CrashReport *report, Plcrash__CrashReport__Thread **outThread, size_t *outIndex) {
+    for (size_t i = 0; i < report->n_threads; i++) {
+        Plcrash__CrashReport__Thread *thread = report->threads[i];
+        for (size_t j = 0; j < thread->n_frames; j++) {
+            if (thread->frames[j]->has_repeat_count) {
+                if (outThread != NULL)
+                    *outThread = thread;
+                if (outIndex != NULL)
+                    *outIndex = j;
+                return thread->frames[j];
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/* Decode the encoded report in @a data, excluding the file header */
+static Plcrash__CrashReport *fold_test_unpack (NSData *data) {
+    size_t header_length = sizeof(struct PLCrashReportFileHeader);
+    return plcrash__crash_report__unpack(&protobuf_c_system_allocator, [data length] - header_length, (const uint8_t *) [data bytes] + header_length);
+}
+
+/**
+ * Verify that recursive frames are only folded when PLCrashReporterOptionFoldRepeatedFrames is enabled, and that
+ * folded frames are expanded to the original stack when decoded.
+ */
+- (void) testGenerateLiveReportFoldRepeatedFrames {
+    NSError *error;
+
+    NSData *foldedData = fold_test_generate_report(PLCrashReporterOptionFoldRepeatedFrames, &error);
+    STAssertNotNil(foldedData, @"Failed to generate folded live report: %@", error);
+
+    NSData *fullData = fold_test_generate_report(PLCrashReporterOptionNone, &error);
+    STAssertNotNil(fullData, @"Failed to generate live report: %@", error);
+
+    STAssertTrue([foldedData length] < [fullData length], @"Folding did not reduce the report size");
+
+    /* Folding must only be applied when enabled */
+    Plcrash__CrashReport *folded = fold_test_unpack(foldedData);
+    Plcrash__CrashReport *full = fold_test_unpack(fullData);
+    STAssertTrue(folded != NULL && full != NULL, @"Failed to decode reports");
+    if (folded != NULL && full != NULL) {
+        Plcrash__CrashReport__Thread__StackFrame *group = fold_test_find_group(folded, NULL, NULL);
+        STAssertTrue(group != NULL, @"Recursive frames were not folded");
+        if (group != NULL)
+            STAssertTrue(group->repeat_count >= FOLD_TEST_DEPTH, @"Incorrect repeat count %" PRIu32, group->repeat_count);
+
+        STAssertTrue(fold_test_find_group(full, NULL, NULL) == NULL, @"Frames were folded without PLCrashReporterOptionFoldRepeatedFrames");
+    }
+    if (folded != NULL)
+        plcrash__crash_report__free_unpacked(folded, &protobuf_c_system_allocator);
+    if (full != NULL)
+        plcrash__crash_report__free_unpacked(full, &protobuf_c_system_allocator);
+
+    /* The folded frames must be expanded to the complete recursive stack */
+    PLCrashReport *foldedReport = [[[PLCrashReport alloc] initWithData: foldedData error: &error] autorelease];
+    STAssertNotNil(foldedReport, @"Could not parse folded report: %@", error);
+
+    PLCrashReport *fullReport = [[[PLCrashReport alloc] initWithData: fullData error: &error] autorelease];
+    STAssertNotNil(fullReport, @"Could not parse report: %@", error);
+
+    NSArray *foldedStack = fold_test_deepest_stack(foldedReport);
+    NSArray *fullStack = fold_test_deepest_stack(fullReport);
+    STAssertTrue([fullStack count] > FOLD_TEST_DEPTH, @"Recursive stack was not captured");
+    STAssertEquals([foldedStack count], [fullStack count], @"Folded stack was not fully expanded");
+
+    /* The outermost frames may differ; compare the recursive frames, which are innermost */
+    for (NSUInteger i = 0; i < FOLD_TEST_DEPTH && i < [foldedStack count] && i < [fullStack count]; i++)
+        STAssertEqualObjects([foldedStack objectAtIndex: i], [fullStack objectAtIndex: i], @"Expanded frame %lu differs", (unsigned long) i);
+}
+
+/**
+ * Verify that folded groups whose expansion would exceed the decoder's limit, including those whose expanded
+ * size overflows a 32-bit size_t, are rejected.
+ */
+- (void) testDecodeFoldedFramesExceedingLimit {
+    const struct {
+        uint32_t repeat_count;
+        uint32_t repeat_length;
+    } cases[] = {
+        /* Exceeds the limit */
+        { UINT32_MAX, 1 },
+
+        /* The expanded size wraps to 2 in 32-bit arithmetic */
+        { 0x80000001, 2 },
+    };
+    NSError *error;
+
+    NSData *data = fold_test_generate_report(PLCrashReporterOptionFoldRepeatedFrames, &error);
+    STAssertNotNil(data, @"Failed to generate folded live report: %@", error);
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        Plcrash__CrashReport *decoded = fold_test_unpack(data);
+        STAssertTrue(decoded != NULL, @"Failed to decode report");
+        if (decoded == NULL)
+            return;
+
+        Plcrash__CrashReport__Thread *thread = NULL;
+        size_t index = 0;
+        Plcrash__CrashReport__Thread__StackFrame *group = fold_test_find_group(decoded, &thread, &index);
+        STAssertTrue(group != NULL, @"Recursive frames were not folded");
+
+        if (group != NULL && cases[i].repeat_length <= thread->n_frames - index) {
+            group->repeat_count = cases[i].repeat_count;
+            group->has_repeat_length = true;
+            group->repeat_length = cases[i].repeat_length;
+
+            /* Re-encode the report with the original file header */
+            size_t header_length = sizeof(struct PLCrashReportFileHeader);
+            NSMutableData *modified = [NSMutableData dataWithBytes: [data bytes] length: header_length];
+            [modified setLength: header_length + plcrash__crash_report__get_packed_size(decoded)];
+            plcrash__crash_report__pack(decoded, (uint8_t *) [modified mutableBytes] + header_length);
+
+            error = nil;
+            PLCrashReport *report = [[[PLCrashReport alloc] initWithData: modified error: &error] autorelease];
+            STAssertNil(report, @"Report with a %" PRIu32 "x%" PRIu32 " group was accepted", cases[i].repeat_count, cases[i].repeat_length);
+            STAssertNotNil(error, @"No error was returned");
+        }
+
+        plcrash__crash_report__free_unpacked(decoded, &protobuf_c_system_allocator);
+    }
+}
+
+/* Hang watchdog callback; increments the int32_t counter supplied as the context */
+static bool hang_watchdog_count_cb (thread_t thread, uint64_t stall_ns, void *context) {
+    OSAtomicIncrement32Barrier((volatile int32_t *) context);
+    return true;
+}
+
+/* Hang watchdog callback; increments the int32_t counter supplied as the context, dropping the first report */
+static bool hang_watchdog_drop_first_cb (thread_t thread, uint64_t stall_ns, void *context) {
+    return OSAtomicIncrement32Barrier((volatile int32_t *) context) > 1;
+}
+
+/* Run the current run loop for the given interval, servicing the main queue */
+static void run_main_loop (NSTimeInterval interval) {
+    NSDate *end = [NSDate dateWithTimeIntervalSinceNow: interval];
+    while ([end timeIntervalSinceNow] > 0)
+        [[NSRunLoop currentRunLoop] runMode: NSDefaultRunLoopMode beforeDate: [NSDate dateWithTimeIntervalSinceNow: 0.01]];
+}
+
+/**
+ * Verify that captured stack memory allows the crashed thread to be unwound post-mortem.
+ */
+- (void) testGenerateLiveReportCaptureStackMemory {
+    NSError *error;
+    PLCrashReporterConfig *config = [[[PLCrashReporterConfig alloc] initWithSignalHandlerType: PLCrashReporterSignalHandlerTypeBSD
+                                                                        symbolicationStrategy: PLCrashReporterSymbolicationStrategyNone
+                                                                                      options: PLCrashReporterOptionCaptureStackMemory] autorelease];
+    PLCrashReporter *reporter = [[[PLCrashReporter alloc] initWithConfiguration: config] autorelease];
+
+    NSData *reportData = [reporter generateLiveReportAndReturnError: &error];
+    STAssertNotNil(reportData, @"Failed to generate live report: %@", error);
+
+    PLCrashReport *report = [[[PLCrashReport alloc] initWithData: reportData error: &error] autorelease];
+    STAssertNotNil(report, @"Could not parse generated live report: %@", error);
+
+    /* The captured memory must remain within the report's budget, and the crashed thread must always be captured */
+    NSUInteger total = 0;
+    for (PLCrashReportThreadInfo *thread in report.threads) {
+        if (thread.stackMemory != nil) {
+            total += [thread.stackMemory length];
+            STAssertTrue([thread.registers count] > 0, @"Registers were not written for thread %ld", (long) thread.threadNumber);
+        }
+
+        if (!thread.crashed)
+            continue;
+
+        STAssertNotNil(thread.stackMemory, @"Stack memory was not captured for the crashed thread");
+        STAssertTrue([thread.stackMemory length] <= PLCRASH_LOG_WRITER_MAX_STACK_MEMORY_BYTES, @"Crashed thread capture exceeds the per-thread limit");
+
+        /* The post-mortem backtrace must begin with the frames unwound at crash time */
+        NSArray *frames = [report postMortemStackFramesForThread: thread error: &error];
+        STAssertNotNil(frames, @"Failed to unwind stack memory: %@", error);
+        STAssertTrue([frames count] >= 2, @"Post-mortem unwinding found too few frames");
+        for (NSUInteger i = 0; i < 2 && i < [frames count]; i++) {
+            STAssertEquals([[frames objectAtIndex: i] instructionPointer], [[thread.stackFrames objectAtIndex: i] instructionPointer],
+                           @"Post-mortem frame %lu does not match", (unsigned long) i);
+        }
+    }
+
+    STAssertTrue(total <= PLCRASH_LOG_WRITER_MAX_TOTAL_STACK_MEMORY_BYTES, @"Captured %lu bytes of stack memory, exceeding the report budget", (unsigned long) total);
+}
+
+/**
+ * Context for guard_page_test_write().
+ */
+struct guard_page_test_ctx {
+    plcrash_log_writer_t *writer;
+    plcrash_async_image_list_t *image_list;
+    plcrash_async_file_t *file;
+    pl_vm_address_t sp;
+};
+
+/**
+ * Write a report for the current thread, with its stack pointer replaced by the context's stack pointer.
+ */
+static plcrash_error_t guard_page_test_write (plcrash_async_thread_state_t *state, void *context) {
+    struct guard_page_test_ctx *ctx = context;
+    plcrash_log_bsd_signal_info_t bsd_info = { .signo = SIGSEGV, .code = SEGV_ACCERR, .address = (void *) 0x0 };
+    plcrash_log_signal_info_t siginfo = { .bsd_info = &bsd_info, .mach_info = NULL };
+
+    plcrash_async_thread_state_set_reg(state, PLCRASH_REG_SP, ctx->sp);
+    return plcrash_log_writer_write(ctx->writer, pl_mach_thread_self(), ctx->image_list, ctx->file, &siginfo, state);
+}
+
+/**
+ * Verify that stack memory is captured for a crashed thread whose stack pointer lies immediately above an unreadable
+ * guard page, as following a stack overflow.
+ */
+- (void) testCaptureStackMemoryAboveGuardPage {
+    NSError *error;
+    plcrash_log_writer_t writer;
+    plcrash_async_image_list_t image_list;
+    plcrash_async_file_t file;
+
+    /* A guard page, followed by a readable stack */
+    vm_address_t base;
+    vm_size_t size = PAGE_SIZE + round_page(PLCRASH_LOG_WRITER_MAX_STACK_MEMORY_BYTES);
+    STAssertEquals(vm_allocate(mach_task_self(), &base, size, VM_FLAGS_ANYWHERE), KERN_SUCCESS, @"Failed to allocate the test stack");
+    STAssertEquals(vm_protect(mach_task_self(), base, PAGE_SIZE, false, VM_PROT_NONE), KERN_SUCCESS, @"Failed to protect the guard page");
+
+    plcrash_nasync_image_list_init(&image_list, mach_task_self());
+    STAssertEquals(plcrash_log_writer_init(&writer, @"test.id", @"1.0", PLCRASH_ASYNC_SYMBOL_STRATEGY_NONE, false), PLCRASH_ESUCCESS, @"Failed to initialize the writer");
+    writer.report_info.capture_stack_memory = true;
+
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]];
+    int fd = open([path fileSystemRepresentation], O_RDWR|O_CREAT|O_TRUNC, 0644);
+    STAssertTrue(fd >= 0, @"Failed to open the output file");
+    plcrash_async_file_init(&file, fd, 1024 * 1024);
+
+    /* The red zone below the stack pointer lies within the guard page */
+    struct guard_page_test_ctx ctx = { .writer = &writer, .image_list = &image_list, .file = &file, .sp = base + PAGE_SIZE + 16 };
+    STAssertEquals(plcrash_async_thread_state_current(guard_page_test_write, &ctx), PLCRASH_ESUCCESS, @"Failed to write the report");
+    plcrash_async_file_close(&file);
+
+    PLCrashReport *report = [[[PLCrashReport alloc] initWithData: [NSData dataWithContentsOfFile: path] error: &error] autorelease];
+    STAssertNotNil(report, @"Could not parse the report: %@", error);
+
+    for (PLCrashReportThreadInfo *thread in report.threads) {
+        if (!thread.crashed)
+            continue;
+
+        STAssertNotNil(thread.stackMemory, @"Stack memory was not captured for the crashed thread");
+        STAssertEquals(thread.stackMemoryAddress, (uint64_t) (base + PAGE_SIZE), @"Capture should begin at the first readable page");
+        STAssertTrue([thread.stackMemory length] >= 1024, @"Too little stack memory was captured");
+    }
+
+    [[NSFileManager defaultManager] removeItemAtPath: path error: NULL];
+    plcrash_log_writer_free(&writer);
+    plcrash_nasync_image_list_free(&image_list);
+    vm_deallocate(mach_task_self(), base, size);
+}
+
+/**
+ * Verify that an uncaught exception's call stack is symbolicated when the exception is set, and that the
+ * pre-encoded frames are written to the report.
+ */
+- (void) testWriteReportPreEncodedExceptionFrames {
+    NSError *error;
+    plcrash_log_writer_t writer;
+    plcrash_async_image_list_t image_list;
+    plcrash_async_file_t file;
+    NSException *exception = nil;
+
+    /* The call stack is only populated once the exception has been raised */
+    @try {
+        [NSException raise: @"TestException" format: @"Test exception"];
+    } @catch (NSException *e) {
+        exception = [[e retain] autorelease];
+    }
+
+    plcrash_nasync_image_list_init(&image_list, mach_task_self());
+    STAssertEquals(plcrash_nasync_image_list_append_task_images(&image_list), PLCRASH_ESUCCESS, @"Failed to populate the image list");
+
+    STAssertEquals(plcrash_log_writer_init(&writer, @"test.id", @"1.0", PLCRASH_ASYNC_SYMBOL_STRATEGY_ALL, true), PLCRASH_ESUCCESS, @"Failed to initialize the writer");
+    plcrash_log_writer_set_exception(&writer, exception, &image_list);
+    STAssertTrue(writer.uncaught_exception.frames_data != NULL, @"Exception frames were not pre-encoded");
+
+    /* Write the report */
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]];
+    int fd = open([path fileSystemRepresentation], O_RDWR|O_CREAT|O_TRUNC, 0644);
+    STAssertTrue(fd >= 0, @"Could not open the output file");
+
+    plcrash_log_bsd_signal_info_t bsd_info = { .signo = SIGTRAP, .code = TRAP_TRACE, .address = (void *) 0x0 };
+    plcrash_log_signal_info_t siginfo = { .bsd_info = &bsd_info, .mach_info = NULL };
+
+    plcrash_async_file_init(&file, fd, 1024 * 1024);
+    STAssertEquals(plcrash_log_writer_write(&writer, pl_mach_thread_self(), &image_list, &file, &siginfo, NULL), PLCRASH_ESUCCESS, @"Failed to write the report");
+    plcrash_async_file_close(&file);
+
+    /* Verify the exception frames */
+    PLCrashReport *report = [[[PLCrashReport alloc] initWithData: [NSData dataWithContentsOfFile: path] error: &error] autorelease];
+    STAssertNotNil(report, @"Could not parse the report: %@", error);
+    STAssertEqualStrings(report.exceptionInfo.exceptionName, @"TestException", @"Incorrect exception name");
+
+    NSArray *frames = report.exceptionInfo.stackFrames;
+    STAssertEquals([frames count], [[exception callStackReturnAddresses] count], @"Incorrect exception frame count");
+    for (NSUInteger i = 0; i < [frames count]; i++) {
+        PLCrashReportStackFrameInfo *frame = [frames objectAtIndex: i];
+        STAssertEquals(frame.instructionPointer, (uint64_t) [[[exception callStackReturnAddresses] objectAtIndex: i] unsignedLongLongValue], @"Incorrect PC for frame %lu", (unsigned long) i);
+    }
+    STAssertNotNil([[frames objectAtIndex: 0] symbolInfo], @"The exception's first frame was not symbolicated");
+
+    [[NSFileManager defaultManager] removeItemAtPath: path error: NULL];
+    plcrash_log_writer_free(&writer);
+    plcrash_nasync_image_list_free(&image_list);
+}
+
+/**
+ * Verify that a report requested by a client is written by the out-of-process server. The server is run within
+ * the test process, and writes a report for the test task.
+ */
+- (void) testOutOfProcessReport {
+    NSError *error;
+    plcrash_oop_server_t server;
+    plcrash_oop_client_t client;
+    plcrash_log_writer_t writer;
+
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]];
+
+    STAssertEquals(plcrash_nasync_oop_server_init(&server, 1024 * 1024), PLCRASH_ESUCCESS, @"Failed to initialize the server");
+    STAssertEquals(plcrash_nasync_oop_client_init(&client, server.service_port, 10000), PLCRASH_ESUCCESS, @"Failed to initialize the client");
+    STAssertEquals(plcrash_log_writer_init(&writer, @"test.id", @"1.0", PLCRASH_ASYNC_SYMBOL_STRATEGY_NONE, false), PLCRASH_ESUCCESS, @"Failed to initialize the writer");
+
+    /* Service a single request */
+    __block plcrash_error_t serverResult = PLCRASH_EUNKNOWN;
+    dispatch_semaphore_t done = dispatch_semaphore_create(0);
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        serverResult = plcrash_nasync_oop_server_handle_request(&server, 10000);
+        dispatch_semaphore_signal(done);
+    });
+
+    /* Request the report */
+    plcrash_log_bsd_signal_info_t bsd_info = { .signo = SIGTRAP, .code = TRAP_TRACE, .address = (void *) 0x0 };
+    plcrash_log_signal_info_t siginfo = { .bsd_info = &bsd_info, .mach_info = NULL };
+    plcrash_error_t err = plcrash_async_oop_client_report(&client, &writer, [path fileSystemRepresentation], pl_mach_thread_self(), &siginfo, pl_mach_thread_self(), NULL);
+
+    dispatch_semaphore_wait(done, DISPATCH_TIME_FOREVER);
+    dispatch_release(done);
+
+    STAssertEquals(err, PLCRASH_ESUCCESS, @"Report request failed");
+    STAssertEquals(serverResult, PLCRASH_ESUCCESS, @"Server failed to write the report");
+
+    /* Verify the report */
+    NSData *reportData = [NSData dataWithContentsOfFile: path];
+    STAssertNotNil(reportData, @"No report was written");
+
+    PLCrashReport *report = [[[PLCrashReport alloc] initWithData: reportData error: &error] autorelease];
+    STAssertNotNil(report, @"Could not parse the out-of-process report: %@", error);
+    STAssertEqualStrings(report.applicationInfo.applicationIdentifier, @"test.id", @"Incorrect application identifier");
+    STAssertEqualStrings([[report signalInfo] name], @"SIGTRAP", @"Incorrect signal name");
+    STAssertEquals(report.processInfo.processID, (NSUInteger) getpid(), @"Incorrect process ID");
+    STAssertTrue([report.threads count] > 1, @"Not all threads were written");
+
+    [[NSFileManager defaultManager] removeItemAtPath: path error: NULL];
+    plcrash_log_writer_free(&writer);
+    plcrash_nasync_oop_client_free(&client);
+    plcrash_nasync_oop_server_free(&server);
+}
+
+/**
+ * Verify that a helper completing its report after the client has timed out does not replace the report written
+ * in-process by the client.
+ */
+- (void) testOutOfProcessReportDoesNotReplaceFallback {
+    plcrash_oop_server_t server;
+    plcrash_oop_client_t client;
+    plcrash_log_writer_t writer;
+
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]];
+
+    STAssertEquals(plcrash_nasync_oop_server_init(&server, 1024 * 1024), PLCRASH_ESUCCESS, @"Failed to initialize the server");
+    STAssertEquals(plcrash_nasync_oop_client_init(&client, server.service_port, 50), PLCRASH_ESUCCESS, @"Failed to initialize the client");
+    STAssertEquals(plcrash_log_writer_init(&writer, @"test.id", @"1.0", PLCRASH_ASYNC_SYMBOL_STRATEGY_NONE, false), PLCRASH_ESUCCESS, @"Failed to initialize the writer");
+
+    /* The request is queued, but not serviced before the client times out */
+    plcrash_log_bsd_signal_info_t bsd_info = { .signo = SIGTRAP, .code = TRAP_TRACE, .address = (void *) 0x0 };
+    plcrash_log_signal_info_t siginfo = { .bsd_info = &bsd_info, .mach_info = NULL };
+    plcrash_error_t err = plcrash_async_oop_client_report(&client, &writer, [path fileSystemRepresentation], pl_mach_thread_self(), &siginfo, pl_mach_thread_self(), NULL);
+    STAssertEquals(err, PLCRASH_EINTERNAL, @"The report request should have timed out");
+
+    /* Stand in for the client's in-process fallback report */
+    NSData *fallback = [@"in-process report" dataUsingEncoding: NSUTF8StringEncoding];
+    STAssertTrue([fallback writeToFile: path atomically: NO], @"Failed to write the fallback report");
+
+    /* Service the stale request */
+    __block plcrash_error_t serverResult = PLCRASH_EUNKNOWN;
+    dispatch_semaphore_t done = dispatch_semaphore_create(0);
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        serverResult = plcrash_nasync_oop_server_handle_request(&server, 10000);
+        dispatch_semaphore_signal(done);
+    });
+    dispatch_semaphore_wait(done, DISPATCH_TIME_FOREVER);
+    dispatch_release(done);
+
+    STAssertEquals(serverResult, PLCRASH_EINTERNAL, @"The helper should have discarded its report");
+    STAssertEqualObjects([NSData dataWithContentsOfFile: path], fallback, @"The fallback report was replaced");
+
+    [[NSFileManager defaultManager] removeItemAtPath: path error: NULL];
+    plcrash_log_writer_free(&writer);
+    plcrash_nasync_oop_client_free(&client);
+    plcrash_nasync_oop_server_free(&server);
+}
+
+/**
+ * Verify that the hang watchdog reports a stalled main thread exactly once per stall.
+ */
+- (void) testHangWatchdogDetectsStall {
+    plcrash_hang_watchdog_t watchdog;
+    plcrash_hang_watchdog_stats_t stats;
+    volatile int32_t hangs = 0;
+
+    STAssertTrue([NSThread isMainThread], @"Test must be run on the main thread");
+
+    STAssertEquals(plcrash_nasync_hang_watchdog_init(&watchdog, pl_mach_thread_self(), dispatch_get_main_queue(), 100 * NSEC_PER_MSEC, 0, hang_watchdog_count_cb, (void *) &hangs), PLCRASH_ESUCCESS, @"Failed to initialize watchdog");
+    STAssertEquals(plcrash_nasync_hang_watchdog_start(&watchdog), PLCRASH_ESUCCESS, @"Failed to start watchdog");
+
+    /* Let a ping complete, and then stall the main thread well beyond the threshold */
+    run_main_loop(0.1);
+    usleep(500 * 1000);
+    run_main_loop(0.1);
+
+    plcrash_nasync_hang_watchdog_stop(&watchdog);
+    plcrash_hang_watchdog_get_stats(&watchdog, &stats);
+    plcrash_nasync_hang_watchdog_free(&watchdog);
+
+    int32_t reported = hangs;
+    STAssertEquals(reported, (int32_t) 1, @"Stall was not reported exactly once");
+    STAssertEquals(stats.hang_count, (uint64_t) 1, @"Incorrect hang count");
+}
+
+/**
+ * Verify that a dropped hang report does not suppress the report of a subsequent stall.
+ */
+- (void) testHangWatchdogDroppedReportNotRateLimited {
+    plcrash_hang_watchdog_t watchdog;
+    plcrash_hang_watchdog_stats_t stats;
+    volatile int32_t hangs = 0;
+
+    STAssertTrue([NSThread isMainThread], @"Test must be run on the main thread");
+
+    /* The minimum report interval would suppress the second stall, were the first report not dropped */
+    STAssertEquals(plcrash_nasync_hang_watchdog_init(&watchdog, pl_mach_thread_self(), dispatch_get_main_queue(), 100 * NSEC_PER_MSEC, 60 * NSEC_PER_SEC, hang_watchdog_drop_first_cb, (void *) &hangs), PLCRASH_ESUCCESS, @"Failed to initialize watchdog");
+    STAssertEquals(plcrash_nasync_hang_watchdog_start(&watchdog), PLCRASH_ESUCCESS, @"Failed to start watchdog");
+
+    /* Two distinct stalls, separated by an answered ping */
+    run_main_loop(0.1);
+    usleep(500 * 1000);
+    run_main_loop(0.2);
+    usleep(500 * 1000);
+    run_main_loop(0.1);
+
+    plcrash_nasync_hang_watchdog_stop(&watchdog);
+    plcrash_hang_watchdog_get_stats(&watchdog, &stats);
+    plcrash_nasync_hang_watchdog_free(&watchdog);
+
+    STAssertEquals(stats.hang_count, (uint64_t) 2, @"Incorrect hang count");
+    STAssertEquals(stats.suppressed_count, (uint64_t) 0, @"Stall following a dropped report was suppressed");
+    STAssertEquals(stats.report_count, (uint64_t) 1, @"Dropped report was counted as reported");
+}
+
+/**
+ * Benchmark the hang watchdog's steady-state overhead with a responsive main thread. The watchdog thread's CPU
+ * time must remain below 0.1% of the elapsed wall time.
+ */
+- (void) testHangWatchdogOverhead {
+    plcrash_hang_watchdog_t watchdog;
+    plcrash_hang_watchdog_stats_t stats;
+    volatile int32_t hangs = 0;
+
+    STAssertTrue([NSThread isMainThread], @"Test must be run on the main thread");
+
+    STAssertEquals(plcrash_nasync_hang_watchdog_init(&watchdog, pl_mach_thread_self(), dispatch_get_main_queue(), 250 * NSEC_PER_MSEC, 0, hang_watchdog_count_cb, (void *) &hangs), PLCRASH_ESUCCESS, @"Failed to initialize watchdog");
+
+    NSTimeInterval elapsed = [NSDate timeIntervalSinceReferenceDate];
+    STAssertEquals(plcrash_nasync_hang_watchdog_start(&watchdog), PLCRASH_ESUCCESS, @"Failed to start watchdog");
+    run_main_loop(3.0);
+    plcrash_nasync_hang_watchdog_stop(&watchdog);
+    elapsed = [NSDate timeIntervalSinceReferenceDate] - elapsed;
+
+    plcrash_hang_watchdog_get_stats(&watchdog, &stats);
+    plcrash_nasync_hang_watchdog_free(&watchdog);
+
+    double overhead = (stats.cpu_time_usec / 1e6) / elapsed;
+    NSLog(@"Hang watchdog: %" PRIu64 " polls, %" PRIu64 "us CPU over %.2fs (%.4f%%)", stats.poll_count, stats.cpu_time_usec, elapsed, overhead * 100);
+
+    STAssertTrue(stats.poll_count > 0, @"Watchdog did not poll");
+    int32_t reported = hangs;
+    STAssertEquals(reported, (int32_t) 0, @"Unexpected hang reported");
+    STAssertTrue(overhead < 0.001, @"Watchdog overhead of %.4f%% exceeds 0.1%%", overhead * 100);
+}
+
+/**
+ * Decode profile data, verifying the PLCRASH_PROFILE_FILE_MAGIC header. The caller is responsible for freeing the
+ * returned message via plcrash__profile__free_unpacked().
+ */
+static Plcrash__Profile *profile_decode (const void *data, size_t length) {
+    size_t header_length = strlen(PLCRASH_PROFILE_FILE_MAGIC) + 1;
+    const uint8_t *bytes = data;
+
+    if (length < header_length || memcmp(bytes, PLCRASH_PROFILE_FILE_MAGIC, header_length - 1) != 0)
+        return NULL;
+
+    if (bytes[header_length - 1] != PLCRASH_PROFILE_FILE_VERSION)
+        return NULL;
+
+    return plcrash__profile__unpack(&protobuf_c_system_allocator, length - header_length, bytes + header_length);
+}
+
+/**
+ * Write @a profiler to @a buffer, returning the decoded Profile message.
+ */
+static Plcrash__Profile *profile_write_and_decode (plcrash_profiler_t *profiler, void *buffer, size_t size) {
+    plcrash_async_file_t file;
+
+    plcrash_async_file_init_memory(&file, buffer, size);
+    if (plcrash_async_profiler_write(profiler, &file) != PLCRASH_ESUCCESS)
+        return NULL;
+
+    return profile_decode(buffer, file.buflen);
+}
+
+/**
+ * Verify that identical stacks are aggregated, and that diverging stacks share their common outer frames.
+ */
+- (void) testProfileCallTreeAggregation {
+    plcrash_async_profile_t profile;
+    plcrash_async_profile_frame_t ab[] = { { NULL, 0xB }, { NULL, 0xA } };
+    plcrash_async_profile_frame_t ac[] = { { NULL, 0xC }, { NULL, 0xA } };
+
+    STAssertEquals(plcrash_nasync_profile_init(&profile, 16, 4), PLCRASH_ESUCCESS, @"Failed to initialize profile");
+
+    plcrash_async_profile_record(&profile, ab, 2, false);
+    plcrash_async_profile_record(&profile, ab, 2, false);
+    plcrash_async_profile_record(&profile, ac, 2, false);
+
+    /* root, A, B, C */
+    STAssertEquals(profile.node_count, (int32_t) 4, @"Common outer frames were not shared");
+    STAssertEquals(profile.sample_count, (int64_t) 3, @"Incorrect sample count");
+    STAssertEquals(profile.dropped_count, (int64_t) 0, @"Unexpected dropped samples");
+
+    for (int32_t i = 1; i < profile.node_count; i++) {
+        plcrash_async_profile_node_t *node = &profile.nodes[i];
+        STAssertTrue(node->linked, @"Node %d was not linked", i);
+
+        if (node->offset == 0xA) {
+            STAssertEquals(node->parent, (uint32_t) 0, @"Outermost frame is not a child of the root");
+            STAssertEquals(node->samples, (int64_t) 0, @"Non-leaf node was attributed samples");
+        } else if (node->offset == 0xB) {
+            STAssertEquals(node->samples, (int64_t) 2, @"Identical stacks were not aggregated");
+        } else {
+            STAssertEquals(node->offset, (pl_vm_address_t) 0xC, @"Unexpected node");
+            STAssertEquals(node->samples, (int64_t) 1, @"Incorrect sample count");
+        }
+    }
+
+    plcrash_nasync_profile_free(&profile);
+}
+
+/**
+ * Verify that samples requiring more nodes than are available are counted as dropped, without consuming node
+ * storage beyond the profile's capacity.
+ */
+- (void) testProfileNodeExhaustion {
+    plcrash_async_profile_t profile;
+    plcrash_async_profile_frame_t frames[] = { { NULL, 0x3 }, { NULL, 0x2 }, { NULL, 0x1 } };
+
+    STAssertEquals(plcrash_nasync_profile_init(&profile, 3, 0), PLCRASH_ESUCCESS, @"Failed to initialize profile");
+
+    plcrash_async_profile_record(&profile, frames, 3, false);
+    plcrash_async_profile_record(&profile, frames, 3, false);
+
+    STAssertEquals(profile.sample_count, (int64_t) 2, @"Incorrect sample count");
+    STAssertEquals(profile.dropped_count, (int64_t) 2, @"Samples exceeding the node capacity were not dropped");
+    STAssertTrue((uint32_t) profile.node_count <= profile.node_capacity, @"Node count exceeded capacity");
+
+    /* A sample fitting within the already-allocated nodes is still recorded */
+    plcrash_async_profile_record(&profile, &frames[1], 2, false);
+    STAssertEquals(profile.dropped_count, (int64_t) 2, @"Sample within the existing nodes was dropped");
+
+    plcrash_nasync_profile_free(&profile);
+}
+
+/**
+ * Verify that the root-level node of truncated samples and abandoned placeholder nodes are written distinctly.
+ */
+- (void) testProfileWriteTruncatedAndPlaceholderNodes {
+    plcrash_async_image_list_t image_list;
+    plcrash_profiler_t profiler;
+    plcrash_async_profile_frame_t frames[] = { { NULL, 0x1000 } };
+    size_t buflen = 4096;
+    void *buffer = malloc(buflen);
+
+    plcrash_nasync_image_list_init(&image_list, mach_task_self());
+    STAssertEquals(plcrash_nasync_profiler_init(&profiler, mach_task_self(), &image_list, 1000, 16), PLCRASH_ESUCCESS, @"Failed to initialize profiler");
+
+    /* root -> truncated marker -> 0x1000 */
+    plcrash_async_profile_record(&profiler.profile, frames, 1, true);
+
+    /* Simulate a node abandoned after losing an insertion race; it is allocated, but never linked */
+    OSAtomicIncrement32(&profiler.profile.node_count);
+
+    Plcrash__Profile *decoded = profile_write_and_decode(&profiler, buffer, buflen);
+    STAssertTrue(decoded != NULL, @"Failed to decode profile");
+    if (decoded != NULL) {
+        STAssertEquals(decoded->sample_count, (uint64_t) 1, @"Incorrect sample count");
+        STAssertEquals(decoded->truncated_sample_count, (uint64_t) 1, @"Incorrect truncated sample count");
+        STAssertEquals(decoded->n_nodes, (size_t) 4, @"Incorrect node count");
+
+        if (decoded->n_nodes == 4) {
+            Plcrash__Profile__Node *truncated = decoded->nodes[1];
+            STAssertTrue(truncated->has_parent && truncated->parent == 0, @"Truncation marker is not a child of the root");
+            STAssertFalse(truncated->has_image, @"Truncation marker has an image");
+            STAssertEquals(truncated->offset, (uint64_t) 0, @"Truncation marker has a PC");
+
+            Plcrash__Profile__Node *leaf = decoded->nodes[2];
+            STAssertEquals(leaf->parent, (uint32_t) 1, @"Truncated frames were not recorded beneath the marker");
+            STAssertEquals(leaf->offset, (uint64_t) 0x1000, @"Incorrect leaf PC");
+            STAssertEquals(leaf->samples, (uint64_t) 1, @"Incorrect leaf sample count");
+
+            Plcrash__Profile__Node *placeholder = decoded->nodes[3];
+            STAssertTrue(placeholder->has_parent, @"Placeholder has no parent");
+            STAssertEquals(placeholder->parent, (uint32_t) PLCRASH_PROFILE_NODE_NONE, @"Placeholder is indistinguishable from a linked node");
+            STAssertEquals(placeholder->samples, (uint64_t) 0, @"Placeholder was attributed samples");
+        }
+
+        plcrash__profile__free_unpacked(decoded, &protobuf_c_system_allocator);
+    }
+
+    plcrash_nasync_profiler_free(&profiler);
+    plcrash_nasync_image_list_free(&image_list);
+    free(buffer);
+}
+
+/**
+ * Benchmark the cost of a synchronous sampling pass over the test process' threads, and verify that the sampled
+ * stacks are recorded against their containing images.
+ */
+- (void) testProfilerSampleBenchmark {
+    plcrash_async_image_list_t image_list;
+    plcrash_profiler_t profiler;
+    plcrash_profiler_stats_t stats;
+    plframe_test_thead_t thr[4];
+    const uint32_t passes = 100;
+
+    /* Register every loaded image */
+    plcrash_nasync_image_list_init(&image_list, mach_task_self());
+    for (uint32_t i = 0; i < _dyld_image_count(); i++) {
+        const struct mach_header *mh = _dyld_get_image_header(i);
+        Dl_info info;
+
+        if (dladdr(mh, &info) != 0)
+            plcrash_nasync_image_list_append(&image_list, (pl_vm_address_t) mh, info.dli_fname);
+    }
+
+    STAssertEquals(plcrash_nasync_profiler_init(&profiler, mach_task_self(), &image_list, 1000, 4096), PLCRASH_ESUCCESS, @"Failed to initialize profiler");
+
+    for (size_t i = 0; i < sizeof(thr) / sizeof(thr[0]); i++)
+        plframe_test_thread_spawn(&thr[i]);
+
+    for (uint32_t i = 0; i < passes; i++)
+        STAssertEquals(plcrash_profiler_sample(&profiler), PLCRASH_ESUCCESS, @"Sampling pass failed");
+
+    for (size_t i = 0; i < sizeof(thr) / sizeof(thr[0]); i++)
+        plframe_test_thread_stop(&thr[i]);
+
+    plcrash_profiler_get_stats(&profiler, &stats);
+    NSLog(@"Profiler: %" PRIu64 " passes, %" PRIu64 " thread samples; %" PRIu64 "ns per thread sample, %" PRIu64 "ns suspended per thread sample",
+          stats.pass_count, stats.thread_sample_count,
+          stats.sample_time_ns / (stats.thread_sample_count ? stats.thread_sample_count : 1),
+          stats.suspended_time_ns / (stats.thread_sample_count ? stats.thread_sample_count : 1));
+
+    STAssertEquals(stats.pass_count, (uint64_t) passes, @"Incorrect pass count");
+    STAssertTrue(stats.thread_sample_count >= passes * (sizeof(thr) / sizeof(thr[0])), @"Not all threads were sampled");
+    STAssertEquals((uint64_t) profiler.profile.sample_count, stats.thread_sample_count, @"Not all thread samples were recorded");
+    STAssertTrue(profiler.profile.images[0] != NULL, @"No sampled frames were attributed to an image");
+
+    plcrash_nasync_profiler_free(&profiler);
+    plcrash_nasync_image_list_free(&image_list);
+}
+
+/**
+ * Verify that an enabled profiler's samples may be exported via the PLCrashReporter API.
+ */
+- (void) testGenerateProfileData {
+    NSError *error;
+    PLCrashReporter *reporter = [[[PLCrashReporter alloc] initWithConfiguration: [PLCrashReporterConfig defaultConfiguration]] autorelease];
+
+    STAssertNil([reporter generateProfileDataAndReturnError: NULL], @"Profile data was generated without an enabled profiler");
+
+    STAssertTrue([reporter enableProfilerWithSampleInterval: 0.001 error: &error], @"Failed to enable the profiler: %@", error);
+    usleep(100 * 1000);
+    [reporter disableProfiler];
+
+    NSData *data = [reporter generateProfileDataAndReturnError: &error];
+    STAssertNotNil(data, @"Failed to generate profile data: %@", error);
+
+    Plcrash__Profile *decoded = profile_decode([data bytes], [data length]);
+    STAssertTrue(decoded != NULL, @"Failed to decode profile data");
+    if (decoded != NULL) {
+        STAssertTrue(decoded->sample_count > 0, @"No samples were recorded");
+        STAssertEquals(decoded->sample_interval_usec, (uint32_t) 1000, @"Incorrect sample interval");
+        STAssertTrue(decoded->n_nodes > 1, @"No call tree nodes were written");
+        STAssertTrue(decoded->n_images > 0, @"No images were written");
+
+        /* Every linked node must reference a preceding node, and every image index must be valid */
+        for (size_t i = 1; i < decoded->n_nodes; i++) {
+            Plcrash__Profile__Node *node = decoded->nodes[i];
+            if (node->parent == PLCRASH_PROFILE_NODE_NONE)
+                continue;
+
+            STAssertTrue(node->parent < i, @"Node %zu does not follow its parent", i);
+            if (node->has_image)
+                STAssertTrue(node->image < decoded->n_images, @"Node %zu references an invalid image", i);
+        }
+
+        plcrash__profile__free_unpacked(decoded, &protobuf_c_system_allocator);
+    }
+}
+
 @end